@@ -0,0 +1,190 @@
+#include "audio/channelmidi.hh"
+#include "audio/mixer.hh"
+#include "audio/resampler.hh"
+#include "core/config.hh"
+
+#include <SDL.h>
+#include <adlmidi.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* Measures the audio path on SDL's dummy driver, so no sound card is needed:
+ * OPL synthesis for each emulator, the compiled-in resampler, and the mixer
+ * callback with music and repeated effects playing, plus the longest time
+ * the render thread or the main thread held the mixer locks.
+ * Usage: audio_mixer_bench [--config config.toml] [--seconds n] <music.mid|xmi> [effect.wav] */
+
+namespace {
+
+struct Options {
+    std::string config;
+    std::string music;
+    std::string effect;
+    int seconds = 10;
+};
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--config") == 0 && i + 1 < argc) {
+            options.config = argv[++i];
+        } else if (std::strcmp(arg, "--seconds") == 0 && i + 1 < argc) {
+            options.seconds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            return false;
+        } else if (options.music.empty()) {
+            options.music = arg;
+        } else if (options.effect.empty()) {
+            options.effect = arg;
+        } else {
+            return false;
+        }
+    }
+    return !options.music.empty();
+}
+
+template<typename F>
+double measure(F &&func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+/* Synthesis alone: the channel is not started, so nothing is resampled */
+void benchEmulators(hojy::audio::Mixer &mixer, const Options &options) {
+    const auto frameSize = 2 * hojy::audio::Mixer::dataTypeToSize(mixer.dataType());
+    std::vector<std::uint8_t> buffer(4096 * frameSize);
+    std::printf("OPL synthesis, %d s of music at %d Hz:\n", options.seconds, ADL_CHIP_SAMPLE_RATE);
+    for (const char *emulator: {"dosbox", "nuked", "nuked174"}) {
+        hojy::core::config.setOplEmulator(emulator);
+        hojy::audio::ChannelMIDI channel(&mixer, options.music);
+        if (!channel.ok()) {
+            std::printf("  %-9s unable to open %s\n", emulator, options.music.c_str());
+            continue;
+        }
+        channel.setRepeat(true);
+        const auto total = std::size_t(options.seconds) * ADL_CHIP_SAMPLE_RATE * frameSize;
+        std::size_t produced = 0;
+        const auto elapsed = measure([&]() {
+            while (produced < total) {
+                const auto size = channel.readData(buffer.data(), std::min(buffer.size(), total - produced));
+                if (size == 0) { break; }
+                produced += size;
+            }
+        });
+        const auto seconds = double(produced) / double(frameSize) / ADL_CHIP_SAMPLE_RATE;
+        std::printf("  %-9s %9.0f us per second of audio, %6.1fx realtime\n", emulator,
+                    elapsed / seconds, seconds * 1000000. / elapsed);
+    }
+}
+
+void benchResampler(hojy::audio::Mixer &mixer, const Options &options) {
+#if defined(USE_SOXR)
+    const char *name = "soxr";
+    const auto typeIn = hojy::audio::Mixer::I16, typeOut = mixer.dataType();
+#else
+    const char *name = "zita-resampler";
+    const auto typeIn = hojy::audio::Mixer::F32, typeOut = hojy::audio::Mixer::F32;
+#endif
+    /* A second of a 440 Hz tone, fed over and over */
+    const auto sizeIn = hojy::audio::Mixer::dataTypeToSize(typeIn);
+    std::vector<std::uint8_t> input(std::size_t(ADL_CHIP_SAMPLE_RATE) * 2 * sizeIn);
+    for (int i = 0; i < ADL_CHIP_SAMPLE_RATE * 2; ++i) {
+        const auto value = 0.5 * std::sin(double(i / 2) * 2. * 3.14159265358979 * 440. / ADL_CHIP_SAMPLE_RATE);
+        if (typeIn == hojy::audio::Mixer::I16) {
+            const auto sample = std::int16_t(value * 32767.);
+            std::memcpy(input.data() + i * sizeIn, &sample, sizeIn);
+        } else {
+            const auto sample = float(value);
+            std::memcpy(input.data() + i * sizeIn, &sample, sizeIn);
+        }
+    }
+    std::size_t offset = 0;
+    hojy::audio::Resampler resampler(2, ADL_CHIP_SAMPLE_RATE, mixer.sampleRate(), typeIn, typeOut);
+    resampler.setInputCallback([&](const void **data, size_t size)->size_t {
+        if (offset >= input.size()) { offset = 0; }
+        const auto count = std::min(size / (2 * sizeIn) * 2 * sizeIn, input.size() - offset);
+        *data = input.data() + offset;
+        offset += count;
+        return count;
+    });
+    const auto frameSize = 2 * hojy::audio::Mixer::dataTypeToSize(typeOut);
+    std::vector<std::uint8_t> buffer(4096 * frameSize);
+    const auto total = std::size_t(options.seconds) * mixer.sampleRate() * frameSize;
+    std::size_t produced = 0;
+    const auto elapsed = measure([&]() {
+        while (produced < total) {
+            const auto size = resampler.read(buffer.data(), std::min(buffer.size(), total - produced));
+            if (size == 0) { break; }
+            produced += size;
+        }
+    });
+    const auto seconds = double(produced) / double(frameSize) / mixer.sampleRate();
+    std::printf("Resampler %s, %d Hz to %u Hz:\n  %9.0f us per second of audio, %6.1fx realtime\n",
+                name, ADL_CHIP_SAMPLE_RATE, mixer.sampleRate(), elapsed / seconds, seconds * 1000000. / elapsed);
+}
+
+/* The whole path in real time: the dummy device pulls buffers at the output rate */
+void benchMixer(hojy::audio::Mixer &mixer, const Options &options, int channels) {
+    mixer.setProfiling(true);
+    mixer.play(0, options.music, true);
+    const auto start = std::chrono::steady_clock::now();
+    const auto end = start + std::chrono::seconds(options.seconds);
+    auto nextEffect = start;
+    size_t nextChannel = 1;
+    while (std::chrono::steady_clock::now() < end) {
+        if (!options.effect.empty() && std::chrono::steady_clock::now() >= nextEffect) {
+            mixer.play(nextChannel, options.effect, false);
+            nextChannel = nextChannel + 1 < size_t(channels) ? nextChannel + 1 : 1;
+            nextEffect += std::chrono::milliseconds(200);
+        }
+        mixer.service();
+        std::this_thread::sleep_for(std::chrono::milliseconds(16));
+    }
+    const auto profile = mixer.profile();
+    mixer.setProfiling(false);
+    mixer.play(0, nullptr);
+    const auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    std::printf("Mixer callback, %d s of music%s:\n", options.seconds,
+                options.effect.empty() ? "" : " with an effect every 200 ms");
+    std::printf("  %llu buffers, %.1f us each on average, %.1f us at most, %.0f us of audio per buffer\n",
+                static_cast<unsigned long long>(profile.callbacks), profile.callbackAverage, profile.callbackMax,
+                profile.callbacks ? elapsed / double(profile.callbacks) : 0.);
+    std::printf("  longest lock hold: render thread %.1f us, main thread %.1f us\n",
+                profile.renderHoldMax, profile.playHoldMax);
+    std::printf("  underruns: %u\n", profile.underruns);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "Usage: %s [--config config.toml] [--seconds n] <music.mid|xmi> [effect.wav]\n",
+                     argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!options.config.empty() && !hojy::core::config.load(options.config)) { return EXIT_FAILURE; }
+    SDL_setenv("SDL_AUDIODRIVER", "dummy", 1);
+    constexpr int Channels = 4;
+    hojy::audio::Mixer mixer;
+    if (!mixer.init(Channels)) { return EXIT_FAILURE; }
+    mixer.pause(false);
+
+    const auto emulator = hojy::core::config.oplEmulator();
+    benchEmulators(mixer, options);
+    hojy::core::config.setOplEmulator(emulator);
+    benchResampler(mixer, options);
+    benchMixer(mixer, options, Channels);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,135 @@
+#include "battle/movement.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <vector>
+
+/* Compares the std::function movement entry points with the templated
+ * searches on a battlefield shaped like the original 64x64 warfields.
+ * Usage: battle_movement_bench [rounds] */
+
+namespace {
+
+constexpr int Width = 64;
+constexpr int Height = 64;
+
+struct Field {
+    std::vector<std::uint8_t> blocked, occupied, sameSide;
+    hojy::battle::CellGrid grid;
+    std::vector<std::pair<int, int>> actors;
+};
+
+Field makeField() {
+    Field field;
+    field.blocked.assign(Width * Height, 0);
+    field.occupied.assign(Width * Height, 0);
+    field.sameSide.assign(Width * Height, 0);
+    field.grid.reset(Width, Height);
+    std::uint32_t seed = 1;
+    const auto next = [&seed](std::uint32_t range) {
+        seed = seed * 1664525U + 1013904223U;
+        return (seed >> 8) % range;
+    };
+    for (int i = 0; i < Width * Height; ++i) {
+        if (next(100) < 18) {
+            field.blocked[i] = 1;
+            field.grid.bits[i] |= hojy::battle::CellGrid::Blocked;
+        }
+    }
+    /* two sides of twelve characters around the middle of the map */
+    while (field.actors.size() < 24) {
+        const int x = 20 + int(next(24)), y = 20 + int(next(24));
+        const auto index = y * Width + x;
+        if (field.blocked[index] || field.occupied[index]) { continue; }
+        field.occupied[index] = 1;
+        field.grid.bits[index] |= hojy::battle::CellGrid::Occupied;
+        if (field.actors.size() % 2) {
+            field.sameSide[index] = 1;
+            field.grid.bits[index] |= hojy::battle::CellGrid::SameSide;
+        }
+        field.actors.emplace_back(x, y);
+    }
+    return field;
+}
+
+template<typename F>
+double measure(int rounds, F &&func) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; ++round) {
+        func();
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    const int rounds = argc > 1 ? std::atoi(argv[1]) : 200;
+    const auto field = makeField();
+    const auto blockedLambda = [&field](int x, int y) { return field.blocked[y * Width + x] != 0; };
+    const auto occupiedLambda = [&field](int x, int y) { return field.occupied[y * Width + x] != 0; };
+    const auto sameSideLambda = [&field](int x, int y) { return field.sameSide[y * Width + x] != 0; };
+    const std::function<bool(int, int)> blocked = blockedLambda, occupied = occupiedLambda, sameSide = sameSideLambda;
+
+    hojy::battle::SelectableCells cells;
+    long long checksum[3] = {0, 0, 0};
+    const auto areaFunction = measure(rounds, [&]() {
+        for (const auto &actor: field.actors) {
+            hojy::battle::getSelectableArea(Width, Height, actor, 10, 4, cells, blocked, occupied, sameSide);
+            checksum[0] += static_cast<long long>(cells.size());
+        }
+    });
+    const auto areaTemplate = measure(rounds, [&]() {
+        for (const auto &actor: field.actors) {
+            hojy::battle::getSelectableArea(Width, Height, actor, 10, 4, cells,
+                                            blockedLambda, occupiedLambda, sameSideLambda);
+            checksum[1] += static_cast<long long>(cells.size());
+        }
+    });
+    const auto areaGrid = measure(rounds, [&]() {
+        for (const auto &actor: field.actors) {
+            hojy::battle::getSelectableArea(field.grid, actor, 10, 4, cells);
+            checksum[2] += static_cast<long long>(cells.size());
+        }
+    });
+    std::printf("selectable area  std::function %8.2f ms  template %8.2f ms  grid %8.2f ms\n",
+                areaFunction, areaTemplate, areaGrid);
+
+    long long distances[3] = {0, 0, 0};
+    const auto pathRounds = std::max(1, rounds / 10);
+    const auto pathFunction = measure(pathRounds, [&]() {
+        for (const auto &from: field.actors) {
+            for (const auto &to: field.actors) {
+                distances[0] += hojy::battle::shortestPathDistance(Width, Height, from, to, blocked, occupied);
+            }
+        }
+    });
+    const auto pathTemplate = measure(pathRounds, [&]() {
+        for (const auto &from: field.actors) {
+            for (const auto &to: field.actors) {
+                distances[1] += hojy::battle::shortestPathDistance(Width, Height, from, to,
+                                                                   blockedLambda, occupiedLambda);
+            }
+        }
+    });
+    const auto pathGrid = measure(pathRounds, [&]() {
+        for (const auto &from: field.actors) {
+            for (const auto &to: field.actors) {
+                distances[2] += hojy::battle::shortestPathDistance(field.grid, from, to);
+            }
+        }
+    });
+    std::printf("shortest path    std::function %8.2f ms  template %8.2f ms  grid %8.2f ms\n",
+                pathFunction, pathTemplate, pathGrid);
+
+    if (checksum[0] != checksum[1] || checksum[0] != checksum[2]
+        || distances[0] != distances[1] || distances[0] != distances[2]) {
+        std::fprintf(stderr, "results differ between implementations\n");
+        return 1;
+    }
+    return 0;
+}
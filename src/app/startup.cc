@@ -0,0 +1,111 @@
+#include "startup.hh"
+
+#include "content/contentpack.hh"
+#include "content/event.hh"
+#include "content/factors.hh"
+#include "content/warfielddata.hh"
+#include "core/config.hh"
+#include "scene/colorpalette.hh"
+#include "scene/effect.hh"
+#include "util/taskgraph.hh"
+#include "util/threadpool.hh"
+#include "world/strings.hh"
+
+#include <fmt/format.h>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <utility>
+
+namespace hojy::app {
+
+namespace {
+
+/* Writes a new pack for the next start while this one runs from the source files */
+std::thread packRebuild;
+
+std::string packSourcePath(const std::string &name) {
+    return core::config.dataFilePath(name);
+}
+
+}
+
+bool loadStartupData() {
+    content::Factors factors;
+    content::Event events;
+    content::WarfieldData warfields;
+
+    util::TaskGraph graph;
+    /* Falling back to the source files keeps the game starting without a pack */
+    const auto packReady = graph.add("content pack", []() {
+        if (!core::config.contentPack()) { return true; }
+        std::string error;
+        const auto filename = core::config.dataFilePath(content::ContentPack::DefaultName);
+        if (!content::gContentPack.load(filename, packSourcePath, error)) {
+            fmt::print(stderr, "Content pack unavailable, loading source files ({}), "
+                               "rebuilding it for the next start\n", error);
+            packRebuild = std::thread([filename]() {
+                std::string error;
+                if (!content::ContentPack::rebuild(filename, packSourcePath, error)) {
+                    fmt::print(stderr, "Content pack rebuild failed: {}\n", error);
+                }
+            });
+        }
+        return true;
+    });
+    const auto strings = graph.add("strings", []() {
+        if (content::gContentPack.loaded()) {
+            return world::state::gStrings.load(content::gContentPack);
+        }
+        return world::state::gStrings.load("strings.toml");
+    }, {packReady});
+    graph.add("default name", []() {
+        core::config.fixOnTextLoaded();
+        return true;
+    }, {strings});
+    const auto factorsLoaded = graph.add("Z.DAT", [&factors]() { return factors.load("Z.DAT"); });
+    const auto eventsLoaded = graph.add("KDEF/TALK", [&events]() {
+        if (content::gContentPack.loaded()) { return events.load(content::gContentPack); }
+        return events.load("KDEF", "TALK");
+    }, {packReady});
+    const auto warfieldsLoaded = graph.add("WAR.STA/WARFLD", [&warfields]() {
+        return warfields.load("WAR.STA", "WARFLD");
+    });
+    const auto contentReady = graph.add("content", [&]() {
+        content::gFactors = std::move(factors);
+        content::gEvent = std::move(events);
+        content::gWarfieldData = std::move(warfields);
+        return true;
+    }, {factorsLoaded, eventsLoaded, warfieldsLoaded});
+    graph.add("palettes", []() {
+        const auto &pack = content::gContentPack;
+        std::array<std::uint32_t, 256> normal, end;
+        if (pack.palette(content::ContentPack::NormalPalette, normal)
+            && pack.palette(content::ContentPack::EndPalette, end)) {
+            scene::gNormalPalette.create(normal);
+            scene::gEndPalette.create(end);
+            return true;
+        }
+        return scene::gNormalPalette.load("MMAP") && scene::gEndPalette.load("ENDCOL");
+    }, {packReady});
+    /* Effect frame counts come from Z.DAT */
+    graph.add("EFT", []() { return scene::gEffect.load("EFT"); }, {contentReady});
+
+    util::ThreadPool pool(util::ThreadPool::defaultThreads(4));
+    const auto ok = graph.run(pool);
+    if (core::config.startupTimings()) {
+        for (const auto &timing: graph.timings()) {
+            fmt::print("{:>16} {:8.2f} ms +{:8.2f} ms{}\n", timing.name, timing.start, timing.duration,
+                       timing.ok ? "" : " failed");
+        }
+        fmt::print("{:>16} {:8.2f} ms\n", "total", graph.elapsed());
+    }
+    return ok;
+}
+
+void finishStartupData() {
+    if (packRebuild.joinable()) { packRebuild.join(); }
+}
+
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace hojy::app {
+
+/* Loads strings, game data, palettes and effects before the window opens,
+ * running independent loads concurrently.  Expects the config to be loaded. */
+[[nodiscard]] bool loadStartupData();
+/* Waits for a content pack rebuild loadStartupData() started, call before exiting */
+void finishStartupData();
+
+}
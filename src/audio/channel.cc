@@ -20,12 +20,17 @@
 #include "channel.hh"
 
 #include <util/file.hh>
+#include <cstring>
 #include <map>
+#include <mutex>
 
 namespace hojy::audio {
 
+/* Music is opened on the mixer's loader thread */
+static std::mutex dataCacheMutex_;
 static std::map<std::string, std::vector<std::uint8_t>> dataCache_;
-static const std::vector<std::uint8_t> &loadDataFromCacheOrFile(const std::string &filename) {
+static std::vector<std::uint8_t> loadDataFromCacheOrFile(const std::string &filename) {
+    std::scoped_lock lk(dataCacheMutex_);
     auto &data = dataCache_[filename];
     if (!data.empty()) {
         return data;
@@ -33,8 +38,7 @@ static const std::vector<std::uint8_t> &loadDataFromCacheOrFile(const std::strin
     if (util::File::getFileContent(filename, data)) {
         return data;
     }
-    static const std::vector<std::uint8_t> dummy;
-    return dummy;
+    return {};
 }
 
 Channel::Channel(Mixer *mixer, const std::string &filename): sampleRateOut_(mixer->sampleRate()), typeOut_(mixer->dataType()), data_(loadDataFromCacheOrFile(filename)), ok_(!data_.empty()) {
@@ -46,6 +50,9 @@ Channel::Channel(Mixer *mixer, const void *data, size_t size): sampleRateOut_(mi
     memcpy(data_.data(), data, size);
 }
 
+Channel::Channel(Mixer *mixer): sampleRateIn_(mixer->sampleRate()), sampleRateOut_(mixer->sampleRate()), typeIn_(mixer->dataType()), typeOut_(mixer->dataType()) {
+}
+
 void Channel::load(const std::string &filename) {
     resampler_.reset();
     data_.clear();
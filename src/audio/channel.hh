@@ -49,6 +49,9 @@ public:
     virtual void reset() {}
 
 protected:
+    /* For subclasses that already hold PCM data in the mixer's output format */
+    explicit Channel(Mixer *mixer);
+
     virtual size_t readPCMData(const void **data, size_t size, bool convType) { return 0; }
 
 protected:
@@ -0,0 +1,89 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "channelcached.hh"
+
+#include "musiccache.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace hojy::audio {
+
+ChannelCached::ChannelCached(Mixer *mixer, const std::string &cacheFile, std::uint64_t sourceSize,
+                             std::int64_t sourceTime): Channel(mixer) {
+    if (!file_.open(cacheFile) || file_.size() < sizeof(MusicCacheHeader)) { return; }
+    MusicCacheHeader header;
+    std::memcpy(&header, file_.data(), sizeof(header));
+    const auto frameSize = 2 * sizeof(std::int16_t);
+    if (std::memcmp(header.magic, MusicCacheMagic, sizeof(header.magic)) != 0
+        || header.version != MusicCacheVersion
+        || header.sampleRate != mixer->sampleRate()
+        || header.sourceSize != sourceSize || header.sourceTime != sourceTime
+        || header.frames == 0
+        || header.frames > (file_.size() - sizeof(header)) / frameSize
+        || header.loopStart >= header.loopEnd || header.loopEnd > header.frames) {
+        file_.close();
+        return;
+    }
+    frames_ = file_.data() + sizeof(header);
+    frameCount_ = header.frames;
+    loopStart_ = header.loopStart;
+    loopEnd_ = header.loopEnd;
+    ok_ = true;
+}
+
+size_t ChannelCached::readPCMData(const void **data, size_t size, bool convType) {
+    (void)convType;
+    if (!frames_) { return 0; }
+    const auto end = repeat_ ? loopEnd_ : frameCount_;
+    if (pos_ >= end) {
+        if (!repeat_) { return 0; }
+        pos_ = loopStart_;
+    }
+    const auto outSize = 2 * Mixer::dataTypeToSize(typeOut_);
+    const auto count = std::min<std::uint64_t>(size / outSize, end - pos_);
+    const auto *input = reinterpret_cast<const std::int16_t*>(frames_) + pos_ * 2;
+    pos_ += count;
+    switch (typeOut_) {
+    case Mixer::I16:
+        *data = input;
+        return count * outSize;
+    case Mixer::I32: {
+        cache_.resize(count * outSize);
+        auto *output = reinterpret_cast<std::int32_t*>(cache_.data());
+        for (std::uint64_t i = 0; i < count * 2; ++i) {
+            output[i] = std::int32_t(input[i]) * 65536;
+        }
+        break;
+    }
+    default: {
+        cache_.resize(count * outSize);
+        auto *output = reinterpret_cast<float*>(cache_.data());
+        for (std::uint64_t i = 0; i < count * 2; ++i) {
+            output[i] = float(input[i]) / 32768.f;
+        }
+        break;
+    }
+    }
+    *data = cache_.data();
+    return count * outSize;
+}
+
+}
@@ -0,0 +1,46 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "channel.hh"
+#include "util/mappedfile.hh"
+
+namespace hojy::audio {
+
+/* Streams a track pre-rendered by renderMusicCache() from a memory mapping,
+ * not ok() unless it was rendered from a track of this size and time */
+class ChannelCached final: public Channel {
+public:
+    ChannelCached(Mixer *mixer, const std::string &cacheFile, std::uint64_t sourceSize, std::int64_t sourceTime);
+
+    void reset() override { pos_ = 0; }
+
+protected:
+    size_t readPCMData(const void **data, size_t size, bool convType) override;
+
+private:
+    util::MappedFile file_;
+    const std::uint8_t *frames_ = nullptr;
+    std::uint64_t frameCount_ = 0, loopStart_ = 0, loopEnd_ = 0;
+    std::uint64_t pos_ = 0;
+    std::vector<std::uint8_t> cache_;
+};
+
+}
@@ -58,6 +58,14 @@ void ChannelMIDI::setRepeat(bool r) {
     adl_setLoopEnabled(static_cast<ADL_MIDIPlayer*>(midiplayer_), r ? 1 : 0);
 }
 
+double ChannelMIDI::loopStartTime() const {
+    return midiplayer_ ? adl_loopStartTime(static_cast<ADL_MIDIPlayer*>(midiplayer_)) : -1.;
+}
+
+double ChannelMIDI::loopEndTime() const {
+    return midiplayer_ ? adl_loopEndTime(static_cast<ADL_MIDIPlayer*>(midiplayer_)) : -1.;
+}
+
 size_t ChannelMIDI::readPCMData(const void **data, size_t size, bool convType) {
     bool needConv = convType && typeIn_ != typeOut_;
     int count;
@@ -88,31 +96,27 @@ size_t ChannelMIDI::readPCMData(const void **data, size_t size, bool convType) {
         *data = cache_.data();
         return sampleBytes;
     }
-    SDL_AudioCVT cvt{};
-    const auto built = SDL_BuildAudioCVT(&cvt, Mixer::convertType(typeIn_), 2,
-                                         int(sampleRateIn_), Mixer::convertType(typeOut_),
-                                         2, int(sampleRateIn_));
-    if (built < 0) { return 0; }
-    if (built == 0) {
+    if (!cvt_) { return 0; }
+    if (!cvt_->needed) {
         *data = cache_.data();
-        return static_cast<size_t>(res * sizeof(short));
+        return sampleBytes;
     }
     int isize = 0;
     if (!detail::checkedAudioCvtLength(sampleBytes, isize)
-        || cvt.len_mult <= 0
+        || cvt_->len_mult <= 0
         || sampleBytes > std::numeric_limits<size_t>::max()
-            / static_cast<size_t>(cvt.len_mult)) {
+            / static_cast<size_t>(cvt_->len_mult)) {
         return 0;
     }
-    const auto osize = sampleBytes * static_cast<size_t>(cvt.len_mult);
+    const auto osize = sampleBytes * static_cast<size_t>(cvt_->len_mult);
     if (cache_.size() < std::max(sampleBytes, osize)) {
         cache_.resize(std::max(sampleBytes, osize));
     }
-    cvt.len = isize;
-    cvt.buf = cache_.data();
-    if (SDL_ConvertAudio(&cvt) < 0 || cvt.len_cvt < 0) { return 0; }
+    cvt_->len = isize;
+    cvt_->buf = cache_.data();
+    if (SDL_ConvertAudio(cvt_.get()) < 0 || cvt_->len_cvt < 0) { return 0; }
     *data = cache_.data();
-    return static_cast<size_t>(cvt.len_cvt);
+    return static_cast<size_t>(cvt_->len_cvt);
 }
 
 void ChannelMIDI::loadFromData() {
@@ -139,6 +143,13 @@ void ChannelMIDI::loadFromData() {
     }
     sampleRateIn_ = ADL_CHIP_SAMPLE_RATE;
     typeIn_ = Mixer::I16;
+    if (!cvt_) {
+        cvt_ = std::make_unique<SDL_AudioCVT>();
+        if (SDL_BuildAudioCVT(cvt_.get(), Mixer::convertType(typeIn_), 2, int(sampleRateIn_),
+                              Mixer::convertType(typeOut_), 2, int(sampleRateIn_)) < 0) {
+            cvt_.reset();
+        }
+    }
     ok_ = true;
 }
 
@@ -21,6 +21,8 @@
 
 #include "channel.hh"
 
+struct SDL_AudioCVT;
+
 namespace hojy::audio {
 
 class ChannelMIDI final: public Channel {
@@ -32,6 +34,10 @@ public:
     void reset() override;
     void setRepeat(bool r) override;
 
+    /* Loop points of the track in seconds, negative if it has none */
+    [[nodiscard]] double loopStartTime() const;
+    [[nodiscard]] double loopEndTime() const;
+
 protected:
     size_t readPCMData(const void **data, size_t size, bool convType) override;
 
@@ -41,6 +47,8 @@ private:
 private:
     void *midiplayer_ = nullptr;
     std::vector<std::uint8_t> cache_;
+    /* Synthesizer output to the mixer's type, built once per track */
+    std::unique_ptr<SDL_AudioCVT> cvt_;
 };
 
 }
@@ -0,0 +1,45 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "channelsample.hh"
+
+#include <algorithm>
+#include <utility>
+
+namespace hojy::audio {
+
+ChannelSample::ChannelSample(Mixer *mixer, SampleCache::Sample sample): Channel(mixer), sample_(std::move(sample)) {
+    ok_ = sample_ && !sample_->empty();
+}
+
+size_t ChannelSample::readPCMData(const void **data, size_t size, bool convType) {
+    (void)convType;
+    if (!sample_) { return 0; }
+    const auto length = sample_->size();
+    if (pos_ >= length) {
+        if (!repeat_) { return 0; }
+        reset();
+    }
+    size = std::min(size, length - pos_);
+    *data = sample_->data() + pos_;
+    pos_ += size;
+    return size;
+}
+
+}
@@ -22,6 +22,7 @@
 #include <SDL.h>
 
 #include <algorithm>
+#include <cstring>
 #include <limits>
 
 namespace hojy::audio {
@@ -54,6 +55,10 @@ ChannelWav::ChannelWav(Mixer *mixer, const std::string &filename) : Channel(mixe
     if (ok_) { loadFromData(); }
 }
 
+ChannelWav::ChannelWav(Mixer *mixer, const void *data, size_t size) : Channel(mixer, data, size) {
+    if (ok_) { loadFromData(); }
+}
+
 ChannelWav::~ChannelWav() {
     clearBuffer();
 }
@@ -26,6 +26,7 @@ namespace hojy::audio {
 class ChannelWav final: public Channel {
 public:
     ChannelWav(Mixer *mixer, const std::string &filename);
+    ChannelWav(Mixer *mixer, const void *data, size_t size);
     ~ChannelWav() override;
 
     void load(const std::string &filename) override;
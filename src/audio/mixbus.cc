@@ -0,0 +1,119 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "mixbus.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace hojy::audio {
+
+namespace {
+
+/* Device data may sit at any byte offset of a ring, read it through memcpy */
+template<typename T>
+inline float loadSample(const std::uint8_t *data, std::size_t index, float scale) {
+    T value;
+    std::memcpy(&value, data + index * sizeof(T), sizeof(T));
+    return static_cast<float>(value) * scale;
+}
+
+template<typename T>
+void mixConstant(float *bus, const std::uint8_t *data, std::size_t samples, float gain) {
+    for (std::size_t i = 0; i < samples; ++i) {
+        bus[i] += loadSample<T>(data, i, gain);
+    }
+}
+
+template<typename T>
+float mixRamp(float *bus, const std::uint8_t *data, std::size_t frames, float scale, float gain, float step) {
+    for (std::size_t i = 0; i < frames; ++i) {
+        const auto frameGain = gain * scale;
+        bus[i * 2] += loadSample<T>(data, i * 2, frameGain);
+        bus[i * 2 + 1] += loadSample<T>(data, i * 2 + 1, frameGain);
+        gain += step;
+    }
+    return gain;
+}
+
+constexpr float I16Scale = 1.f / 32768.f;
+constexpr float I32Scale = 1.f / 2147483648.f;
+
+}
+
+void mixToBus(float *bus, const std::uint8_t *data, Mixer::DataType type, std::size_t frames, float gain) {
+    switch (type) {
+    case Mixer::F32:
+        mixConstant<float>(bus, data, frames * 2, gain);
+        break;
+    case Mixer::I16:
+        mixConstant<std::int16_t>(bus, data, frames * 2, gain * I16Scale);
+        break;
+    case Mixer::I32:
+        mixConstant<std::int32_t>(bus, data, frames * 2, gain * I32Scale);
+        break;
+    default:
+        break;
+    }
+}
+
+float mixToBusRamp(float *bus, const std::uint8_t *data, Mixer::DataType type, std::size_t frames,
+                   float gain, float step) {
+    switch (type) {
+    case Mixer::F32:
+        return mixRamp<float>(bus, data, frames, 1.f, gain, step);
+    case Mixer::I16:
+        return mixRamp<std::int16_t>(bus, data, frames, I16Scale, gain, step);
+    case Mixer::I32:
+        return mixRamp<std::int32_t>(bus, data, frames, I32Scale, gain, step);
+    default:
+        return gain + step * static_cast<float>(frames);
+    }
+}
+
+void busToOutput(std::uint8_t *stream, const float *bus, Mixer::DataType type, std::size_t frames) {
+    const auto samples = frames * 2;
+    switch (type) {
+    case Mixer::F32:
+        for (std::size_t i = 0; i < samples; ++i) {
+            const auto value = std::clamp(bus[i], -1.f, 1.f);
+            std::memcpy(stream + i * sizeof(float), &value, sizeof(float));
+        }
+        break;
+    case Mixer::I16:
+        for (std::size_t i = 0; i < samples; ++i) {
+            const auto value = static_cast<std::int16_t>(std::lrint(std::clamp(bus[i], -1.f, 1.f) * 32767.f));
+            std::memcpy(stream + i * sizeof(std::int16_t), &value, sizeof(std::int16_t));
+        }
+        break;
+    case Mixer::I32:
+        for (std::size_t i = 0; i < samples; ++i) {
+            /* float cannot hold 2^31 - 1, scale in double */
+            const auto value = static_cast<std::int32_t>(std::llrint(
+                static_cast<double>(std::clamp(bus[i], -1.f, 1.f)) * 2147483647.0));
+            std::memcpy(stream + i * sizeof(std::int32_t), &value, sizeof(std::int32_t));
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+}
@@ -0,0 +1,41 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mixer.hh"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace hojy::audio {
+
+/* Channels are summed into a float bus and clipped once when it is written
+ * out, so loud channels do not saturate each other mid-mix.  Counts are in
+ * frames of two samples. */
+
+/* Adds device-format audio to the bus at a fixed gain */
+void mixToBus(float *bus, const std::uint8_t *data, Mixer::DataType type, std::size_t frames, float gain);
+/* As mixToBus, with the gain moving by step after every frame; returns the gain reached */
+float mixToBusRamp(float *bus, const std::uint8_t *data, Mixer::DataType type, std::size_t frames,
+                   float gain, float step);
+/* Clips the bus to [-1, 1] and writes it in the device format */
+void busToOutput(std::uint8_t *stream, const float *bus, Mixer::DataType type, std::size_t frames);
+
+}
@@ -21,7 +21,10 @@
 
 #include "channel.hh"
 #include "channelmidi.hh"
-#include "channelwav.hh"
+#include "channelcached.hh"
+#include "channelsample.hh"
+#include "mixbus.hh"
+#include "musiccache.hh"
 #include "core/config.hh"
 #include <SDL.h>
 
@@ -35,8 +38,38 @@ namespace hojy::audio {
 
 Mixer gMixer;
 
+/* Opened tracks kept waiting for play() */
+constexpr std::size_t MaxPrefetched = 2;
+/* Volume changes outside of fades are spread over this, so they do not click */
+constexpr std::uint32_t VolumeRampMs = 10;
+
+/* Keeps the longest time seen; every profile counter has a single writer */
+static void recordMax(std::atomic<std::uint64_t> &max, std::uint64_t ticks) {
+    if (ticks > max.load(std::memory_order_relaxed)) {
+        max.store(ticks, std::memory_order_relaxed);
+    }
+}
+
+/* Measures how long the enclosing scope keeps the locks while profiling */
+class HoldTimer {
+public:
+    HoldTimer(const std::atomic<bool> &profiling, std::atomic<std::uint64_t> &max):
+        max_(profiling ? &max : nullptr), start_(max_ ? SDL_GetPerformanceCounter() : 0) {}
+    ~HoldTimer() {
+        if (max_) { recordMax(*max_, SDL_GetPerformanceCounter() - start_); }
+    }
+
+private:
+    std::atomic<std::uint64_t> *max_;
+    std::uint64_t start_;
+};
+
+Mixer::Voice::Voice(std::unique_ptr<Channel> channel): ch(std::move(channel)) {
+}
+
+Mixer::Voice::~Voice() = default;
+
 void Mixer::ChannelInfo::reset() {
-    ch.reset();
     volume = 0;
     fadeInStart = fadeIn = 0;
     fadeOutStart = fadeOut = 0;
@@ -45,13 +78,13 @@ void Mixer::ChannelInfo::reset() {
     volumeNext = 0;
     fadeInNext = 0;
     repeatNext = false;
-    ended = false;
-    sourceEnded = false;
-    readyPos = 0;
-    readySize = 0;
 }
 
 Mixer::~Mixer() {
+    cacheCancel_ = true;
+    cacheRenderer_.reset();
+    loader_.reset();
+    stopRenderThread();
     if (audioDevice_ != 0) {
         SDL_CloseAudioDevice(audioDevice_);
     }
@@ -103,43 +136,69 @@ bool Mixer::init(int channels) {
         return false;
     }
     std::vector<ChannelInfo> newChannels;
-    std::vector<std::uint8_t> newCache;
+    std::vector<MixSlot> newSlots;
+    std::vector<float> newBus;
     try {
-        newChannels.resize(static_cast<std::size_t>(channels));
-        newCache.assign(static_cast<std::size_t>(obtained.size), 0);
+        newChannels = std::vector<ChannelInfo>(static_cast<std::size_t>(channels));
+        newSlots.resize(static_cast<std::size_t>(channels));
+        newBus.resize(static_cast<std::size_t>(obtained.samples) * 2);
     } catch (const std::bad_alloc &) {
         SDL_CloseAudioDevice(newDevice);
         return false;
     }
     {
+        std::scoped_lock rk(renderMutex_);
         std::scoped_lock lk(playMutex_);
         if (audioDevice_ != 0) {
             SDL_PauseAudioDevice(audioDevice_, SDL_TRUE);
             SDL_CloseAudioDevice(audioDevice_);
         }
+        /* Neither device runs the callback now, its side can be replaced too */
         audioDevice_ = newDevice;
         sampleRate_ = obtained.freq;
         format_ = obtained.format;
+        chunkSize_ = std::max<std::size_t>(obtained.size, 4096);
         channels_.swap(newChannels);
-        cache_.swap(newCache);
+        slots_.swap(newSlots);
+        bus_.swap(newBus);
+        retired_.clear();
+        commands_.reset(256 * sizeof(Command));
+        commandsSent_ = 0;
+        commandsDone_ = 0;
+        /* Top the rings up twice per device buffer */
+        renderPeriod_ = std::chrono::milliseconds(std::max(1, obtained.samples * 500 / obtained.freq));
+    }
+    if (!loader_) {
+        loader_ = std::make_unique<util::ThreadPool>(1);
+    }
+    if (!cacheRenderer_ && !core::config.musicCachePath().empty()) {
+        cacheRenderer_ = std::make_unique<util::ThreadPool>(1);
+    }
+    if (!renderThread_.joinable()) {
+        renderQuit_ = false;
+        renderThread_ = std::thread(&Mixer::renderLoop, this);
     }
+    samples_.clear();
+    samples_.setCapacity(std::size_t(std::max(0, core::config.soundCacheSize())) * 1024 * 1024);
     return true;
 }
 
 void Mixer::play(size_t channelId, Channel *ch, int volume, std::uint32_t fadeOutMs, std::uint32_t fadeInMs) {
+    std::unique_ptr<Channel> channel(ch);
+    std::scoped_lock rk(renderMutex_);
     std::scoped_lock lk(playMutex_);
+    HoldTimer hold(profiling_, profilePlayHoldMax_);
     if (channelId >= channels_.size()) {
-        delete ch;
         return;
     }
     auto &chi = channels_[channelId];
-    if (ch) {
-        if (!ch->ok()) {
-            delete ch;
+    chi.loading = {};
+    if (channel) {
+        if (!channel->ok()) {
             return;
         }
-        if (fadeOutMs && chi.ch) {
-            chi.chNext.reset(ch);
+        if (fadeOutMs && chi.voice) {
+            chi.chNext = std::move(channel);
             chi.volumeNext = volume;
             chi.fadeInNext = fadeInMs;
             chi.fadeOutVolumeStart = chi.volume;
@@ -149,12 +208,9 @@ void Mixer::play(size_t channelId, Channel *ch, int volume, std::uint32_t fadeOu
             chi.fadeInStart = chi.fadeIn = 0;
         } else {
             chi.reset();
-            chi.ch.reset(ch);
-            chi.volume = fadeInMs ? 0 : volume;
+            channel->start();
+            if (!prepareChannelLocked(channelId, std::move(channel), fadeInMs ? 0 : volume)) { return; }
             chi.volumeNext = volume;
-            ch->start();
-            prepareChannelLocked(chi);
-            fillChannelLocked(chi);
             if (fadeInMs) {
                 const auto now = SDL_GetTicks();
                 chi.fadeInStart = now;
@@ -162,7 +218,7 @@ void Mixer::play(size_t channelId, Channel *ch, int volume, std::uint32_t fadeOu
             }
         }
     } else {
-        if (fadeOutMs && chi.ch) {
+        if (fadeOutMs && chi.voice) {
             chi.chNext.reset();
             chi.fadeInNext = 0;
             chi.fadeOutVolumeStart = chi.volume;
@@ -171,6 +227,7 @@ void Mixer::play(size_t channelId, Channel *ch, int volume, std::uint32_t fadeOu
             chi.fadeOut = fadeOutMs;
             chi.fadeInStart = chi.fadeIn = 0;
         } else {
+            stopChannelLocked(channelId);
             chi.reset();
         }
     }
@@ -184,14 +241,37 @@ bool iequals(const std::string &a, const std::string &b) {
                       });
 }
 
+bool isWavFile(const std::string &filename) {
+    const auto pos = filename.find_last_of('.');
+    return pos != std::string::npos && iequals(filename.substr(pos + 1), "WAV");
+}
+
 void Mixer::play(size_t channelId, const std::string &filename, bool repeat, int volume, std::uint32_t fadeOutMs, std::uint32_t fadeInMs) {
+    if (!isWavFile(filename)) {
+        std::scoped_lock lk(playMutex_);
+        if (channelId >= channels_.size()) {
+            return;
+        }
+        auto &chi = channels_[channelId];
+        chi.loading = loadMusicLocked(filename);
+        chi.loadingVolume = volume;
+        chi.loadingFadeOut = fadeOutMs;
+        chi.loadingFadeIn = fadeInMs;
+        chi.loadingRepeat = repeat;
+        return;
+    }
+    // Effects are read and decoded before taking the locks
+    auto sample = samples_.get(filename);
+    std::scoped_lock rk(renderMutex_);
     std::scoped_lock lk(playMutex_);
+    HoldTimer hold(profiling_, profilePlayHoldMax_);
     if (channelId >= channels_.size()) {
         return;
     }
     auto &chi = channels_[channelId];
-    if (fadeOutMs && chi.ch) {
-        std::unique_ptr<Channel> candidate = createChannelLocked(filename);
+    chi.loading = {};
+    if (fadeOutMs && chi.voice) {
+        std::unique_ptr<Channel> candidate = createChannel(filename, std::move(sample));
         if (!candidate) {
             return;
         }
@@ -207,10 +287,10 @@ void Mixer::play(size_t channelId, const std::string &filename, bool repeat, int
         chi.fadeOut = fadeOutMs;
         chi.fadeInStart = chi.fadeIn = 0;
     } else {
-        if (!loadFilenameLocked(chi, filename, repeat, volume)) { return; }
+        if (!loadFilenameLocked(channelId, filename, std::move(sample), repeat, fadeInMs ? 0 : volume)) { return; }
+        chi.volumeNext = volume;
         if (fadeInMs) {
             const auto now = SDL_GetTicks();
-            chi.volume = 0;
             chi.fadeInStart = now;
             chi.fadeIn = fadeInMs;
         }
@@ -224,7 +304,20 @@ void Mixer::pause(bool on) const {
     }
 }
 
-std::unique_ptr<Channel> Mixer::createChannelLocked(const std::string &filename) {
+void Mixer::prefetch(const std::string &filename) {
+    std::scoped_lock lk(playMutex_);
+    if (!loader_ || isWavFile(filename)) { return; }
+    for (const auto &track: prefetched_) {
+        if (track.filename == filename) { return; }
+    }
+    if (prefetched_.size() >= MaxPrefetched) {
+        prefetched_.erase(prefetched_.begin());
+    }
+    prefetched_.push_back(PrefetchedTrack {filename, loadMusicLocked(filename)});
+}
+
+/* Runs on the loader thread for music */
+std::unique_ptr<Channel> Mixer::createChannel(const std::string &filename, SampleCache::Sample sample) {
     const auto pos = filename.find_last_of('.');
     if (pos == std::string::npos) {
         return nullptr;
@@ -233,8 +326,8 @@ std::unique_ptr<Channel> Mixer::createChannelLocked(const std::string &filename)
     std::unique_ptr<Channel> channel;
     if (iequals(ext, "MID") || iequals(ext, "XMI")) {
         channel = std::make_unique<ChannelMIDI>(this, filename);
-    } else if (iequals(ext, "WAV")) {
-        channel = std::make_unique<ChannelWav>(this, filename);
+    } else if (iequals(ext, "WAV") && sample) {
+        channel = std::make_unique<ChannelSample>(this, std::move(sample));
     }
     if (!channel || !channel->ok()) {
         return nullptr;
@@ -242,119 +335,318 @@ std::unique_ptr<Channel> Mixer::createChannelLocked(const std::string &filename)
     return channel;
 }
 
-bool Mixer::loadFilenameLocked(ChannelInfo &chi, const std::string &filename,
+bool Mixer::loadFilenameLocked(size_t channelId, const std::string &filename, SampleCache::Sample sample,
                                 bool repeat, int volume) {
-    std::unique_ptr<Channel> candidate = createChannelLocked(filename);
+    std::unique_ptr<Channel> candidate = createChannel(filename, std::move(sample));
     if (!candidate) { return false; }
     candidate->start();
     candidate->setRepeat(repeat);
+    channels_[channelId].reset();
+    return prepareChannelLocked(channelId, std::move(candidate), volume);
+}
+
+std::future<std::unique_ptr<Channel>> Mixer::loadMusicLocked(const std::string &filename) {
+    for (auto ite = prefetched_.begin(); ite != prefetched_.end(); ++ite) {
+        if (ite->filename == filename) {
+            auto channel = std::move(ite->channel);
+            prefetched_.erase(ite);
+            return channel;
+        }
+    }
+    if (!loader_) { return {}; }
+    return loader_->submit([this, filename]() { return openMusic(filename); });
+}
+
+/* Runs on the loader thread: the cached rendering if there is one, live
+ * synthesis otherwise, queueing a rendering for the next time */
+std::unique_ptr<Channel> Mixer::openMusic(const std::string &filename) {
+    if (cacheRenderer_) {
+        auto cacheFile = musicCacheFile(core::config.musicCachePath(), filename,
+                                        core::config.oplEmulator(), sampleRate_);
+        std::uint64_t sourceSize = 0;
+        std::int64_t sourceTime = 0;
+        const auto stamped = musicSourceStamp(filename, sourceSize, sourceTime);
+        auto cached = std::make_unique<ChannelCached>(this, cacheFile, sourceSize, sourceTime);
+        if (stamped && cached->ok()) {
+            cached->start();
+            return cached;
+        }
+        std::scoped_lock lk(cacheMutex_);
+        if (std::find(cacheRendering_.begin(), cacheRendering_.end(), cacheFile) == cacheRendering_.end()) {
+            cacheRendering_.push_back(cacheFile);
+            cacheRenderer_->post([this, filename, cacheFile]() {
+                if (!renderMusicCache(this, filename, cacheFile, cacheCancel_)) {
+                    /* Stays listed, so a failing track is not tried again */
+                    if (!cacheCancel_) { SDL_Log("Unable to render %s into the music cache", filename.c_str()); }
+                    return;
+                }
+                std::scoped_lock lk(cacheMutex_);
+                cacheRendering_.erase(std::find(cacheRendering_.begin(), cacheRendering_.end(), cacheFile));
+            });
+        }
+    }
+    auto channel = createChannel(filename, nullptr);
+    if (channel) { channel->start(); }
+    return channel;
+}
+
+/* Takes over a finished load: crossfades to it if something plays, starts it otherwise; needs both locks */
+void Mixer::armLoadedLocked(size_t channelId, std::uint32_t now) {
+    auto &chi = channels_[channelId];
+    auto channel = chi.loading.get();
+    if (!channel) { return; }
+    channel->setRepeat(chi.loadingRepeat);
+    if (chi.voice && chi.loadingFadeOut) {
+        chi.chNext = std::move(channel);
+        chi.volumeNext = chi.loadingVolume;
+        chi.repeatNext = chi.loadingRepeat;
+        chi.fadeInNext = chi.loadingFadeIn;
+        chi.fadeOutVolumeStart = chi.volume;
+        chi.fadeOutStart = now;
+        chi.fadeOut = chi.loadingFadeOut;
+        chi.fadeInStart = chi.fadeIn = 0;
+        return;
+    }
     chi.reset();
-    chi.ch = std::move(candidate);
-    chi.volume = volume;
-    chi.volumeNext = volume;
-    chi.ended = false;
-    prepareChannelLocked(chi);
-    fillChannelLocked(chi);
+    if (!prepareChannelLocked(channelId, std::move(channel), chi.loadingFadeIn ? 0 : chi.loadingVolume)) { return; }
+    chi.volumeNext = chi.loadingVolume;
+    if (chi.loadingFadeIn) {
+        chi.fadeInStart = now;
+        chi.fadeIn = chi.loadingFadeIn;
+    }
+}
+
+bool Mixer::sendLocked(const Command &command) {
+    if (commands_.writable() < sizeof(Command)) {
+        return false;
+    }
+    commands_.write(&command, sizeof(Command));
+    ++commandsSent_;
     return true;
 }
 
-void Mixer::prepareChannelLocked(ChannelInfo &channel) {
-    if (!channel.ch) {
-        return;
+void Mixer::setVolumeLocked(size_t channelId, int volume) {
+    channels_[channelId].volume = volume;
+    rampVolumeLocked(channelId, volume, VolumeRampMs);
+}
+
+/* Lets the callback move to volume over rampMs, leaves chi.volume to the caller */
+void Mixer::rampVolumeLocked(size_t channelId, int volume, std::uint32_t rampMs) {
+    auto &chi = channels_[channelId];
+    const auto ramp = std::uint32_t(std::uint64_t(rampMs) * sampleRate_ / 1000);
+    /* A full queue only delays the change to the next service() */
+    if (chi.voice && chi.volumeSent != volume
+        && sendLocked(Command {Command::Volume, channelId, nullptr, volume, ramp})) {
+        chi.volumeSent = volume;
     }
-    const auto chunk = std::max<std::size_t>(cache_.size(), 4096);
-    const auto capacity = chunk > std::numeric_limits<std::size_t>::max() / 4
+}
+
+/* Replaces what the channel plays; needs both locks */
+bool Mixer::prepareChannelLocked(size_t channelId, std::unique_ptr<Channel> channel, int volume) {
+    auto &chi = channels_[channelId];
+    auto voice = std::make_unique<Voice>(std::move(channel));
+    const auto capacity = chunkSize_ > std::numeric_limits<std::size_t>::max() / 4
         ? std::numeric_limits<std::size_t>::max()
-        : chunk * 4;
+        : chunkSize_ * 4;
     if (capacity == std::numeric_limits<std::size_t>::max()) {
-        return;
+        return false;
     }
-    if (channel.ready.size() < capacity) {
-        channel.ready.resize(capacity);
+    voice->ready.reset(capacity);
+    if (!sendLocked(Command {Command::Start, channelId, voice.get(), volume, 0})) {
+        return false;
+    }
+    if (chi.voice) {
+        retired_.push_back(RetiredVoice {commandsSent_, std::move(chi.voice)});
     }
+    chi.voice = std::move(voice);
+    chi.volume = chi.volumeSent = volume;
+    renderCond_.notify_one();
+    return true;
 }
 
-void Mixer::fillChannelLocked(ChannelInfo &channel) {
-    if (!channel.ch || channel.sourceEnded || channel.ready.empty()) {
-        return;
+/* Needs both locks */
+void Mixer::stopChannelLocked(size_t channelId) {
+    auto &chi = channels_[channelId];
+    if (!chi.voice) { return; }
+    if (!chi.voice->ended) {
+        /* Still in the callback's hands: keep it until the stop is seen */
+        if (!sendLocked(Command {Command::Stop, channelId, nullptr, 0, 0})) { return; }
+        retired_.push_back(RetiredVoice {commandsSent_, std::move(chi.voice)});
     }
-    if (channel.readyPos > 0
-        && (channel.readySize == 0
-            || channel.readyPos + channel.readySize == channel.ready.size())) {
-        if (channel.readySize > 0) {
-            std::memmove(channel.ready.data(), channel.ready.data() + channel.readyPos,
-                         channel.readySize);
-        }
-        channel.readyPos = 0;
+    chi.voice.reset();
+}
+
+void Mixer::collectRetiredLocked() {
+    const auto done = commandsDone_.load(std::memory_order_acquire);
+    retired_.erase(std::remove_if(retired_.begin(), retired_.end(), [done](const RetiredVoice &retired) {
+        return retired.command <= done || retired.voice->ended;
+    }), retired_.end());
+}
+
+/* Renders at most one chunk, returns false once the ring is full or the source ended */
+bool Mixer::fillChannelLocked(Voice &voice) {
+    if (voice.sourceEnded.load(std::memory_order_relaxed) || voice.ready.capacity() == 0) {
+        return false;
     }
-    const auto freeSize = channel.ready.size() - channel.readyPos - channel.readySize;
-    if (freeSize == 0) {
-        return;
+    std::size_t written = 0;
+    for (const auto &span: voice.ready.writeSpans(chunkSize_)) {
+        if (span.size == 0) { break; }
+        const auto received = std::min(voice.ch->readData(span.data, span.size), span.size);
+        written += received;
+        if (received < span.size) {
+            voice.ready.commitWrite(written);
+            if (received == 0) {
+                voice.sourceEnded.store(true, std::memory_order_release);
+            }
+            return received > 0;
+        }
     }
-    auto *destination = channel.ready.data() + channel.readyPos + channel.readySize;
-    const auto readSize = std::max<std::size_t>(cache_.size(), 4096);
-    const auto request = std::min(freeSize, readSize);
-    const auto received = channel.ch->readData(destination, request);
-    if (received == 0) {
-        channel.sourceEnded = true;
-        if (channel.readySize == 0) {
-            channel.ended = true;
+    voice.ready.commitWrite(written);
+    return written > 0;
+}
+
+void Mixer::renderLoop() {
+    std::unique_lock lk(renderMutex_);
+    while (!renderQuit_) {
+        const auto start = profiling_ ? SDL_GetPerformanceCounter() : 0;
+        bool busy = false;
+        for (auto &chi: channels_) {
+            if (chi.voice) {
+                busy = fillChannelLocked(*chi.voice) || busy;
+            }
+        }
+        if (start) { recordMax(profileRenderHoldMax_, SDL_GetPerformanceCounter() - start); }
+        if (busy) {
+            /* Let play() and service() in between chunks */
+            lk.unlock();
+            std::this_thread::yield();
+            lk.lock();
+        } else {
+            renderCond_.wait_for(lk, renderPeriod_);
         }
-        return;
     }
-    channel.readySize += std::min(received, request);
+}
+
+void Mixer::stopRenderThread() {
+    if (!renderThread_.joinable()) { return; }
+    {
+        std::scoped_lock rk(renderMutex_);
+        renderQuit_ = true;
+    }
+    renderCond_.notify_one();
+    renderThread_.join();
+}
+
+void Mixer::setProfiling(bool on) {
+    profiling_ = false;
+    profileCallbacks_ = 0;
+    profileCallbackTicks_ = 0;
+    profileCallbackMax_ = 0;
+    profileRenderHoldMax_ = 0;
+    profilePlayHoldMax_ = 0;
+    profileUnderrunsStart_ = underruns_;
+    profiling_ = on;
+}
+
+Mixer::Profile Mixer::profile() const {
+    const auto toUs = 1000000. / double(SDL_GetPerformanceFrequency());
+    Profile result;
+    result.callbacks = profileCallbacks_;
+    if (result.callbacks) {
+        result.callbackAverage = double(profileCallbackTicks_) * toUs / double(result.callbacks);
+    }
+    result.callbackMax = double(profileCallbackMax_) * toUs;
+    result.renderHoldMax = double(profileRenderHoldMax_) * toUs;
+    result.playHoldMax = double(profilePlayHoldMax_) * toUs;
+    result.underruns = underruns_ - profileUnderrunsStart_;
+    return result;
 }
 
 void Mixer::setVolume(size_t channelId, int volume) {
     std::scoped_lock lk(playMutex_);
     if (channelId >= channels_.size()) { return; }
     auto &chi = channels_[channelId];
-    if (!chi.ch) { return; }
-    chi.volume = chi.volumeNext = volume;
+    if (!chi.voice) { return; }
+    chi.volumeNext = volume;
+    /* A running fade heads for volumeNext by itself */
+    if (chi.fadeIn || chi.fadeOut) { return; }
+    setVolumeLocked(channelId, volume);
 }
 
 void Mixer::service() {
-    std::scoped_lock lk(playMutex_);
-    const auto now = SDL_GetTicks();
-    for (auto &chi : channels_) {
-        if (chi.ended) {
-            chi.reset();
-            continue;
-        }
-        if (chi.fadeOut) {
-            const auto delta = std::uint32_t(std::int32_t(now - chi.fadeOutStart));
-            if (delta >= chi.fadeOut) {
-                if (chi.chNext) {
-                    chi.ch = std::move(chi.chNext);
-                    chi.volume = chi.fadeInNext ? 0 : chi.volumeNext;
-                    chi.fadeInStart = chi.fadeInNext ? now : 0;
-                    chi.fadeIn = chi.fadeInNext;
-                    chi.fadeInNext = 0;
-                    chi.ch->setRepeat(chi.repeatNext);
-                    chi.ended = false;
-                    chi.sourceEnded = false;
-                    chi.readyPos = chi.readySize = 0;
-                    prepareChannelLocked(chi);
-                    fillChannelLocked(chi);
+    /* Fades only send volume ramps, the callback applies them per sample;
+     * swapping or dropping a channel also needs the render thread out of the way */
+    bool swap = false;
+    {
+        std::scoped_lock lk(playMutex_);
+        collectRetiredLocked();
+        const auto now = SDL_GetTicks();
+        for (size_t index = 0; index < channels_.size(); ++index) {
+            auto &chi = channels_[index];
+            if (chi.loading.valid()
+                && chi.loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+                swap = true;
+            }
+            if (chi.voice && chi.voice->ended) {
+                swap = true;
+                continue;
+            }
+            if (chi.fadeOut) {
+                const auto delta = std::uint32_t(std::int32_t(now - chi.fadeOutStart));
+                if (delta >= chi.fadeOut) {
+                    swap = true;
                 } else {
-                    chi.reset();
+                    chi.volume = int(chi.fadeOutVolumeStart * (chi.fadeOut - delta) / chi.fadeOut);
+                    rampVolumeLocked(index, 0, chi.fadeOut - delta);
                 }
-                chi.fadeOutStart = chi.fadeOut = 0;
-            } else {
-                chi.volume = int(chi.fadeOutVolumeStart
-                                  * (chi.fadeOut - delta) / chi.fadeOut);
                 continue;
             }
+            if (chi.fadeIn) {
+                const auto delta = std::uint32_t(std::int32_t(now - chi.fadeInStart));
+                if (delta >= chi.fadeIn) {
+                    chi.fadeInStart = chi.fadeIn = 0;
+                    setVolumeLocked(index, chi.volumeNext);
+                } else {
+                    chi.volume = int(chi.volumeNext * delta / chi.fadeIn);
+                    rampVolumeLocked(index, chi.volumeNext, chi.fadeIn - delta);
+                }
+            } else if (chi.volumeSent != chi.volume) {
+                setVolumeLocked(index, chi.volume);
+            }
+        }
+    }
+    if (!swap) { return; }
+
+    std::scoped_lock rk(renderMutex_);
+    std::scoped_lock lk(playMutex_);
+    HoldTimer hold(profiling_, profilePlayHoldMax_);
+    const auto now = SDL_GetTicks();
+    for (size_t index = 0; index < channels_.size(); ++index) {
+        auto &chi = channels_[index];
+        if (chi.voice && chi.voice->ended) {
+            stopChannelLocked(index);
+            chi.reset();
+        }
+        if (chi.loading.valid()
+            && chi.loading.wait_for(std::chrono::seconds(0)) == std::future_status::ready) {
+            armLoadedLocked(index, now);
+        }
+        if (!chi.fadeOut || std::uint32_t(std::int32_t(now - chi.fadeOutStart)) < chi.fadeOut) {
+            continue;
         }
-        if (chi.fadeIn) {
-            const auto delta = std::uint32_t(std::int32_t(now - chi.fadeInStart));
-            if (delta >= chi.fadeIn) {
-                chi.fadeInStart = chi.fadeIn = 0;
-            } else {
-                chi.volume = int(chi.volumeNext * delta / chi.fadeIn);
+        chi.fadeOutStart = chi.fadeOut = 0;
+        if (chi.chNext) {
+            chi.chNext->setRepeat(chi.repeatNext);
+            if (prepareChannelLocked(index, std::move(chi.chNext), chi.fadeInNext ? 0 : chi.volumeNext)) {
+                chi.fadeInStart = chi.fadeInNext ? now : 0;
+                chi.fadeIn = chi.fadeInNext;
             }
+            chi.fadeInNext = 0;
+            chi.chNext.reset();
+        } else {
+            stopChannelLocked(index);
+            chi.reset();
         }
-        fillChannelLocked(chi);
     }
 }
 
@@ -400,32 +692,91 @@ size_t Mixer::dataTypeToSize(Mixer::DataType type) {
 void Mixer::callback(void *userdata, std::uint8_t *stream, int len) {
     auto *mixer = static_cast<Mixer*>(userdata);
     if (!mixer || !stream || len <= 0) { return; }
-    std::scoped_lock lk(mixer->playMutex_);
-    auto &channels = mixer->channels_;
-    if (channels.empty()) {
-        memset(stream, 0, static_cast<size_t>(len));
-        return;
-    }
-    memset(stream, 0, len);
-    for (auto &chi: channels) {
-        if (!chi.ch || chi.ended) { continue; }
-        const auto rsize = std::min<std::size_t>(chi.readySize,
-                                                 static_cast<std::size_t>(len));
-        if (rsize && chi.volume) {
-            SDL_MixAudioFormat(stream, chi.ready.data() + chi.readyPos,
-                               mixer->format_, rsize, chi.volume);
-        }
-        chi.readyPos += rsize;
-        chi.readySize -= rsize;
-        if (chi.readySize == 0) {
-            chi.readyPos = 0;
-            if (chi.sourceEnded) {
-                chi.ended = true;
+    const auto start = mixer->profiling_ ? SDL_GetPerformanceCounter() : 0;
+    auto &slots = mixer->slots_;
+    Command command;
+    while (mixer->commands_.readable() >= sizeof(Command)) {
+        mixer->commands_.read(&command, sizeof(Command));
+        if (command.channel < slots.size()) {
+            auto &slot = slots[command.channel];
+            const auto gain = float(command.volume) / float(VolumeMax);
+            switch (command.type) {
+            case Command::Start:
+                slot.voice = command.voice;
+                slot.gain = slot.target = gain;
+                slot.rampLeft = 0;
+                slot.started = false;
+                break;
+            case Command::Stop:
+                slot.voice = nullptr;
+                break;
+            case Command::Volume:
+                slot.target = gain;
+                if (command.ramp) {
+                    slot.step = (gain - slot.gain) / float(command.ramp);
+                    slot.rampLeft = command.ramp;
+                } else {
+                    slot.gain = gain;
+                    slot.rampLeft = 0;
+                }
+                break;
             }
         }
-        if (rsize == 0 && chi.sourceEnded) {
-            chi.ended = true;
+        mixer->commandsDone_.fetch_add(1, std::memory_order_release);
+    }
+
+    const auto type = convertDataType(mixer->format_);
+    const auto frameSize = 2 * dataTypeToSize(type);
+    const auto frames = static_cast<std::size_t>(len) / frameSize;
+    auto *bus = mixer->bus_.data();
+    const auto busFrames = mixer->bus_.size() / 2;
+    std::memset(stream, 0, static_cast<size_t>(len));
+    for (std::size_t offset = 0; offset < frames && busFrames > 0; offset += busFrames) {
+        const auto count = std::min(busFrames, frames - offset);
+        std::fill(bus, bus + count * 2, 0.f);
+        for (auto &slot: slots) {
+            auto *voice = slot.voice;
+            if (!voice) { continue; }
+            /* Read the flag first: everything written before it is visible then */
+            const bool sourceEnded = voice->sourceEnded;
+            std::size_t mixed = 0;
+            for (const auto &span: voice->ready.readSpans(count * frameSize)) {
+                auto spanFrames = span.size / frameSize;
+                const auto *data = span.data;
+                auto *target = bus + mixed * 2;
+                if (slot.rampLeft && spanFrames) {
+                    const auto ramped = std::min<std::size_t>(slot.rampLeft, spanFrames);
+                    slot.gain = mixToBusRamp(target, data, type, ramped, slot.gain, slot.step);
+                    slot.rampLeft -= static_cast<std::uint32_t>(ramped);
+                    /* Land exactly on the target, the float steps drift */
+                    if (slot.rampLeft == 0) { slot.gain = slot.target; }
+                    data += ramped * frameSize;
+                    target += ramped * 2;
+                    mixed += ramped;
+                    spanFrames -= ramped;
+                }
+                if (spanFrames && slot.gain > 0.f) {
+                    mixToBus(target, data, type, spanFrames, slot.gain);
+                }
+                mixed += spanFrames;
+            }
+            voice->ready.commitRead(mixed * frameSize);
+            if (sourceEnded && voice->ready.readable() == 0) {
+                slot.voice = nullptr;
+                voice->ended = true;
+            } else if (mixed < count && slot.started) {
+                /* The first buffer after a start may still be rendering, that is latency */
+                mixer->underruns_.fetch_add(1, std::memory_order_relaxed);
+            }
+            slot.started = slot.started || mixed > 0;
         }
+        busToOutput(stream + offset * frameSize, bus, type, count);
+    }
+    if (start) {
+        const auto ticks = SDL_GetPerformanceCounter() - start;
+        mixer->profileCallbacks_.fetch_add(1, std::memory_order_relaxed);
+        mixer->profileCallbackTicks_.fetch_add(ticks, std::memory_order_relaxed);
+        recordMax(mixer->profileCallbackMax_, ticks);
     }
 }
 
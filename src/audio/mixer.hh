@@ -19,7 +19,16 @@
 
 #pragma once
 
+#include "samplecache.hh"
+#include "util/ringbuffer.hh"
+#include "util/threadpool.hh"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
 #include <mutex>
+#include <thread>
 #include <vector>
 #include <memory>
 #include <string>
@@ -30,13 +39,23 @@ namespace hojy::audio {
 class Channel;
 
 class Mixer final {
+    /* A channel being played: the render thread fills the ring, the device
+     * callback drains it.  Only the main thread creates or frees one. */
+    struct Voice {
+        explicit Voice(std::unique_ptr<Channel> channel);
+        ~Voice();
+        std::unique_ptr<Channel> ch;
+        util::RingBuffer ready;
+        std::atomic<bool> sourceEnded {false};
+        /* Set by the callback once it let go of the voice */
+        std::atomic<bool> ended {false};
+    };
     struct ChannelInfo {
         ChannelInfo() = default;
         ChannelInfo(const ChannelInfo&) = delete;
-        ChannelInfo(ChannelInfo&&) noexcept = default;
-        ChannelInfo& operator=(ChannelInfo&&) = default;
-        std::unique_ptr<Channel> ch;
+        std::unique_ptr<Voice> voice;
         int volume = 0;
+        int volumeSent = 0;
         std::uint32_t fadeInStart = 0, fadeIn = 0;
         std::uint32_t fadeOutStart = 0, fadeOut = 0;
         int fadeOutVolumeStart = 0;
@@ -44,14 +63,41 @@ class Mixer final {
         int volumeNext = 0;
         std::uint32_t fadeInNext = 0;
         bool repeatNext = false;
-        bool ended = false;
-        bool sourceEnded = false;
-        std::vector<std::uint8_t> ready;
-        std::size_t readyPos = 0;
-        std::size_t readySize = 0;
+        /* Music opened on the loader thread, service() arms it once ready */
+        std::future<std::unique_ptr<Channel>> loading;
+        int loadingVolume = 0;
+        std::uint32_t loadingFadeOut = 0, loadingFadeIn = 0;
+        bool loadingRepeat = false;
 
         void reset();
     };
+    /* Main thread to callback, through commands_ */
+    struct Command {
+        enum Type : std::uint8_t {
+            Start, Stop, Volume,
+        };
+        Type type;
+        std::size_t channel;
+        Voice *voice;
+        int volume;
+        /* Frames over which a volume change is spread */
+        std::uint32_t ramp;
+    };
+    /* Per-channel state owned by the callback */
+    struct MixSlot {
+        Voice *voice = nullptr;
+        float gain = 0.f, target = 0.f, step = 0.f;
+        std::uint32_t rampLeft = 0;
+        bool started = false;
+    };
+    struct PrefetchedTrack {
+        std::string filename;
+        std::future<std::unique_ptr<Channel>> channel;
+    };
+    struct RetiredVoice {
+        std::uint64_t command;
+        std::unique_ptr<Voice> voice;
+    };
 public:
     enum DataType {
         InvalidType = -1, F32 = 0,  F64,  I32,  I16,
@@ -59,17 +105,34 @@ public:
     enum {
         VolumeMax = 128,
     };
+    /* Collected while profiling is on, times in microseconds */
+    struct Profile {
+        std::uint64_t callbacks = 0;
+        double callbackAverage = 0., callbackMax = 0.;
+        /* Longest a render pass or a main-thread call kept renderMutex_ */
+        double renderHoldMax = 0., playHoldMax = 0.;
+        std::uint32_t underruns = 0;
+    };
 
     ~Mixer();
     [[nodiscard]] bool init(int channels);
 
     void play(size_t channelId, Channel *ch, int volume = VolumeMax, std::uint32_t fadeOutMs = 0, std::uint32_t fadeInMs = 0);
+    /* Music files are opened in the background, playback switches over once one is ready */
     void play(size_t channelId, const std::string &filename, bool repeat, int volume = VolumeMax, std::uint32_t fadeOutMs = 0, std::uint32_t fadeInMs = 0);
+    /* Starts opening a music file that is likely played soon */
+    void prefetch(const std::string &filename);
     void pause(bool on) const;
     [[nodiscard]] inline std::uint32_t sampleRate() const { return sampleRate_; }
     [[nodiscard]] inline DataType dataType() const { return convertDataType(format_); }
     void setVolume(size_t channelId, int volume);
-    // Main-thread maintenance for fades, file loading and channel cleanup.
+    [[nodiscard]] SampleCache &samples() { return samples_; }
+    /* Device buffers in which a playing channel had less audio ready than asked for */
+    [[nodiscard]] std::uint32_t underruns() const { return underruns_; }
+    /* Times callbacks and lock holds from now on, clearing earlier numbers */
+    void setProfiling(bool on);
+    [[nodiscard]] Profile profile() const;
+    // Main-thread maintenance for fades and channel cleanup, decoding runs on the render thread.
     void service();
 
     static DataType convertDataType(std::uint16_t type);
@@ -78,19 +141,61 @@ public:
 
 private:
     static void callback(void *userdata, std::uint8_t *stream, int len);
-    void prepareChannelLocked(ChannelInfo &channel);
-    void fillChannelLocked(ChannelInfo &channel);
-    std::unique_ptr<Channel> createChannelLocked(const std::string &filename);
-    bool loadFilenameLocked(ChannelInfo &channel, const std::string &filename,
+    void renderLoop();
+    void stopRenderThread();
+    bool sendLocked(const Command &command);
+    void setVolumeLocked(size_t channelId, int volume);
+    void rampVolumeLocked(size_t channelId, int volume, std::uint32_t rampMs);
+    bool prepareChannelLocked(size_t channelId, std::unique_ptr<Channel> channel, int volume);
+    void stopChannelLocked(size_t channelId);
+    void collectRetiredLocked();
+    bool fillChannelLocked(Voice &voice);
+    std::unique_ptr<Channel> createChannel(const std::string &filename, SampleCache::Sample sample);
+    std::unique_ptr<Channel> openMusic(const std::string &filename);
+    std::future<std::unique_ptr<Channel>> loadMusicLocked(const std::string &filename);
+    void armLoadedLocked(size_t channelId, std::uint32_t now);
+    bool loadFilenameLocked(size_t channelId, const std::string &filename, SampleCache::Sample sample,
                             bool repeat, int volume);
 
 private:
     std::uint32_t audioDevice_ = 0;
     std::uint32_t sampleRate_ = 0;
     std::uint16_t format_ = 0;
-    std::vector<ChannelInfo> channels_;
-    std::vector<std::uint8_t> cache_;
+    std::size_t chunkSize_ = 4096;
+    SampleCache samples_ {this};
+
+    /* Lock order: renderMutex_ before playMutex_.  renderMutex_ keeps voices
+     * alive for the render thread, playMutex_ guards the main-thread state
+     * below.  The callback takes neither. */
+    std::mutex renderMutex_;
     mutable std::mutex playMutex_;
+    std::vector<ChannelInfo> channels_;
+    std::vector<RetiredVoice> retired_;
+    std::uint64_t commandsSent_ = 0;
+    std::unique_ptr<util::ThreadPool> loader_;
+    std::vector<PrefetchedTrack> prefetched_;
+    /* Renders music into the cache, one track after another */
+    std::unique_ptr<util::ThreadPool> cacheRenderer_;
+    std::mutex cacheMutex_;
+    std::vector<std::string> cacheRendering_;
+    std::atomic<bool> cacheCancel_ {false};
+
+    std::vector<MixSlot> slots_;
+    /* Float accumulation bus, written out in one pass at the end */
+    std::vector<float> bus_;
+    util::RingBuffer commands_;
+    std::atomic<std::uint64_t> commandsDone_ {0};
+    std::atomic<std::uint32_t> underruns_ {0};
+    /* Performance counter ticks, each written by one thread only */
+    std::atomic<bool> profiling_ {false};
+    std::atomic<std::uint64_t> profileCallbacks_ {0}, profileCallbackTicks_ {0}, profileCallbackMax_ {0};
+    std::atomic<std::uint64_t> profileRenderHoldMax_ {0}, profilePlayHoldMax_ {0};
+    std::uint32_t profileUnderrunsStart_ = 0;
+
+    std::condition_variable renderCond_;
+    std::thread renderThread_;
+    std::chrono::milliseconds renderPeriod_ {10};
+    bool renderQuit_ = false;
 };
 
 extern Mixer gMixer;
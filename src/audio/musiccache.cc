@@ -0,0 +1,150 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "musiccache.hh"
+
+#include "channelmidi.hh"
+#include "util/file.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <system_error>
+#include <vector>
+
+namespace hojy::audio {
+
+namespace {
+
+void toInt16(const std::uint8_t *data, std::size_t frames, Mixer::DataType type, std::vector<std::int16_t> &output) {
+    const auto count = frames * 2;
+    output.resize(count);
+    switch (type) {
+    case Mixer::I16:
+        std::memcpy(output.data(), data, count * sizeof(std::int16_t));
+        break;
+    case Mixer::I32:
+        for (std::size_t i = 0; i < count; ++i) {
+            std::int32_t value;
+            std::memcpy(&value, data + i * sizeof(value), sizeof(value));
+            output[i] = std::int16_t(value >> 16);
+        }
+        break;
+    default:
+        for (std::size_t i = 0; i < count; ++i) {
+            float value;
+            std::memcpy(&value, data + i * sizeof(value), sizeof(value));
+            output[i] = std::int16_t(std::lround(std::clamp(value, -1.f, 1.f) * 32767.f));
+        }
+        break;
+    }
+}
+
+std::uint64_t secondsToFrames(double seconds, std::uint32_t sampleRate, std::uint64_t frames) {
+    if (seconds < 0.) { return std::numeric_limits<std::uint64_t>::max(); }
+    return std::min(frames, std::uint64_t(std::llround(seconds * sampleRate)));
+}
+
+}
+
+std::string musicCacheFile(const std::string &directory, const std::string &filename,
+                           const std::string &emulator, std::uint32_t sampleRate) {
+    const auto slash = filename.find_last_of("/\\");
+    auto name = slash == std::string::npos ? filename : filename.substr(slash + 1);
+    const auto dot = name.find_last_of('.');
+    if (dot != std::string::npos) { name.resize(dot); }
+    return directory + name + '-' + emulator + '-' + std::to_string(sampleRate) + ".pcm";
+}
+
+bool musicSourceStamp(const std::string &filename, std::uint64_t &size, std::int64_t &time) {
+    std::error_code ec;
+    size = std::filesystem::file_size(filename, ec);
+    if (ec) { return false; }
+    const auto writeTime = std::filesystem::last_write_time(filename, ec);
+    if (ec) { return false; }
+    time = static_cast<std::int64_t>(writeTime.time_since_epoch().count());
+    return true;
+}
+
+bool renderMusicCache(Mixer *mixer, const std::string &filename, const std::string &cacheFile,
+                      const std::atomic<bool> &cancel) {
+    /* Stamped before reading, a track changed meanwhile is rendered again next time */
+    std::uint64_t sourceSize;
+    std::int64_t sourceTime;
+    if (!musicSourceStamp(filename, sourceSize, sourceTime)) { return false; }
+    ChannelMIDI channel(mixer, filename);
+    if (!channel.ok()) { return false; }
+    channel.setRepeat(false);
+    channel.start();
+
+    std::error_code ec;
+    const auto parent = std::filesystem::path(cacheFile).parent_path();
+    if (!parent.empty()) { std::filesystem::create_directories(parent, ec); }
+    const auto temporary = cacheFile + ".tmp";
+    bool ok;
+    {
+        auto file = util::File::create(temporary);
+        if (!file) { return false; }
+
+        const auto sampleRate = mixer->sampleRate();
+        const auto type = mixer->dataType();
+        const auto frameSize = 2 * Mixer::dataTypeToSize(type);
+        MusicCacheHeader header {};
+        std::memcpy(header.magic, MusicCacheMagic, sizeof(header.magic));
+        header.version = MusicCacheVersion;
+        header.sampleRate = sampleRate;
+        header.sourceSize = sourceSize;
+        header.sourceTime = sourceTime;
+        ok = file.write(&header, sizeof(header)) == sizeof(header);
+
+        std::vector<std::uint8_t> buffer(16384 * frameSize);
+        std::vector<std::int16_t> pcm;
+        const auto maxFrames = std::uint64_t(sampleRate) * MusicCacheMaxSeconds;
+        while (ok && header.frames < maxFrames && !cancel.load(std::memory_order_relaxed)) {
+            const auto frames = channel.readData(buffer.data(), buffer.size()) / frameSize;
+            if (frames == 0) { break; }
+            toInt16(buffer.data(), frames, type, pcm);
+            ok = file.write(pcm.data(), pcm.size() * sizeof(std::int16_t)) == pcm.size() * sizeof(std::int16_t);
+            header.frames += frames;
+        }
+        ok = ok && header.frames > 0 && !cancel.load(std::memory_order_relaxed);
+        if (ok) {
+            header.loopStart = secondsToFrames(channel.loopStartTime(), sampleRate, header.frames);
+            header.loopEnd = secondsToFrames(channel.loopEndTime(), sampleRate, header.frames);
+            /* No loop points: the whole track repeats */
+            if (header.loopStart >= header.loopEnd || header.loopEnd > header.frames) {
+                header.loopStart = 0;
+                header.loopEnd = header.frames;
+            }
+            file.seek(0);
+            ok = file.write(&header, sizeof(header)) == sizeof(header);
+        }
+    }
+    if (ok) {
+        std::remove(cacheFile.c_str());
+        ok = std::rename(temporary.c_str(), cacheFile.c_str()) == 0;
+    }
+    if (!ok) { std::remove(temporary.c_str()); }
+    return ok;
+}
+
+}
@@ -0,0 +1,61 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "mixer.hh"
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+namespace hojy::audio {
+
+/* Music rendered once to 16-bit stereo PCM at the output sample rate, so
+ * later plays stream the file instead of running the OPL emulator.  Files are
+ * keyed by track, emulator and sample rate and remember the size and
+ * modification time of the track, a changed track is rendered again; lengths
+ * are in frames. */
+struct MusicCacheHeader {
+    char magic[4];
+    std::uint32_t version;
+    std::uint32_t sampleRate;
+    std::uint32_t reserved;
+    std::uint64_t frames;
+    /* Where a repeating track jumps back to, and from */
+    std::uint64_t loopStart, loopEnd;
+    std::uint64_t sourceSize;
+    std::int64_t sourceTime;
+};
+
+inline constexpr char MusicCacheMagic[4] = {'H', 'J', 'M', 'C'};
+inline constexpr std::uint32_t MusicCacheVersion = 2;
+/* Longest track that is rendered, anything longer is cut */
+inline constexpr std::uint32_t MusicCacheMaxSeconds = 15 * 60;
+
+std::string musicCacheFile(const std::string &directory, const std::string &filename,
+                           const std::string &emulator, std::uint32_t sampleRate);
+/* Size and modification time of a track, false when it cannot be read */
+bool musicSourceStamp(const std::string &filename, std::uint64_t &size, std::int64_t &time);
+/* Plays the track once without looping and writes it to cacheFile, stops
+ * early and writes nothing when cancel is set */
+bool renderMusicCache(Mixer *mixer, const std::string &filename, const std::string &cacheFile,
+                      const std::atomic<bool> &cancel);
+
+}
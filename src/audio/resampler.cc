@@ -24,10 +24,16 @@
 #else
 #include <zita-resampler/vresampler.h>
 #endif
+#include <algorithm>
 #include <cmath>
 
 namespace hojy::audio {
 
+#if !defined(USE_SOXR)
+/* Most input frames asked for at once, bounds what is left over in buffer_ */
+constexpr size_t MaxInputFrames = 4096;
+#endif
+
 Resampler::Resampler(std::uint32_t channels, double sampleRateIn, double sampleRateOut,
                      Mixer::DataType typeIn, Mixer::DataType typeOut):
                      rate_(sampleRateOut / sampleRateIn) {
@@ -44,7 +50,7 @@ Resampler::Resampler(std::uint32_t channels, double sampleRateIn, double sampleR
     sampleSizeIn_ *= channels;
     sampleSizeOut_ *= channels;
 #if !defined(USE_SOXR)
-    buffer_.setUnitSize(sampleSizeOut_);
+    buffer_.reset((size_t(std::ceil(double(MaxInputFrames) * rate_)) + 64) * sampleSizeOut_);
 #endif
 }
 
@@ -73,29 +79,31 @@ size_t Resampler::read(void *data, size_t size) {
     return soxr_output(static_cast<soxr_t>(resampler_), data, size / sampleSizeOut_) * sampleSizeOut_;
 #else
     auto sampleSize = sampleSizeOut_;
-    size = size / sampleSize * sampleSize;
     auto *resampler = static_cast<VResampler*>(resampler_);
-    auto osize = size / sampleSize;
     auto *ptr = (std::uint8_t*)data;
+    auto osize = buffer_.read(ptr, size / sampleSize * sampleSize) / sampleSize;
+    ptr += osize * sampleSize;
+    osize = size / sampleSize - osize;
     while (osize) {
-        auto rsize = buffer_.pop(ptr, osize, 0);
-        if (rsize) {
-            osize -= rsize;
-            ptr += rsize * sampleSize;
-            if (!osize) { break; }
-        }
-        auto psize = std::max<size_t>(osize * 2, size / sampleSize);
-        auto isize = size_t(double(psize) / rate_);
+        auto isize = std::min(MaxInputFrames, size_t(double(osize) / rate_) + 1);
         const void *pcmdata;
-        rsize = inputCB_(&pcmdata, isize * sampleSize) / sampleSize;
+        auto rsize = inputCB_(&pcmdata, isize * sampleSize) / sampleSize;
         if (!rsize) { break; }
-        auto *buf = buffer_.alloc(psize);
         resampler->inp_data = (float *)pcmdata;
         resampler->inp_count = rsize;
-        resampler->out_data = (float *)buf;
-        resampler->out_count = psize;
+        resampler->out_data = (float *)ptr;
+        resampler->out_count = osize;
         resampler->process();
-        buffer_.push(buf, psize - resampler->out_count);
+        ptr += (osize - resampler->out_count) * sampleSize;
+        osize = resampler->out_count;
+        /* The input is only valid until the next callback, keep what is left of it */
+        for (const auto &span: buffer_.writeSpans(buffer_.writable())) {
+            if (!resampler->inp_count) { break; }
+            resampler->out_data = (float *)span.data;
+            resampler->out_count = span.size / sampleSize;
+            resampler->process();
+            buffer_.commitWrite(span.size - resampler->out_count * sampleSize);
+        }
     }
     return ptr - (std::uint8_t*)data;
 #endif
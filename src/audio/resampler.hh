@@ -20,7 +20,7 @@
 #pragma once
 
 #include "mixer.hh"
-#include "util/fifobuffer.hh"
+#include "util/ringbuffer.hh"
 #include <functional>
 #include <cstdint>
 
@@ -43,7 +43,8 @@ private:
     double rate_ = 0.;
     size_t sampleSizeIn_ = 0, sampleSizeOut_ = 0;
 #if !defined(USE_SOXR)
-    util::FIFOBuffer buffer_;
+    /* Output of an input block that did not fit the caller's buffer */
+    util::RingBuffer buffer_;
 #endif
 };
 
@@ -0,0 +1,126 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "samplecache.hh"
+
+#include "channelwav.hh"
+#include "util/file.hh"
+
+#include <array>
+#include <new>
+
+namespace hojy::audio {
+
+void SampleCache::setCapacity(std::size_t bytes) {
+    std::scoped_lock lk(mutex_);
+    capacity_ = bytes;
+    trimLocked();
+}
+
+void SampleCache::clear() {
+    std::scoped_lock lk(mutex_);
+    entries_.clear();
+    index_.clear();
+    size_ = 0;
+}
+
+SampleCache::Sample SampleCache::get(const std::string &filename) {
+    {
+        std::scoped_lock lk(mutex_);
+        auto it = index_.find(filename);
+        if (it != index_.end()) {
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return it->second->sample;
+        }
+    }
+    auto sample = decode(filename);
+    if (!sample) { return nullptr; }
+    std::scoped_lock lk(mutex_);
+    if (sample->size() > capacity_) { return sample; }
+    auto it = index_.find(filename);
+    if (it != index_.end()) {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->sample;
+    }
+    try {
+        entries_.push_front(Entry {filename, sample});
+        index_.emplace(filename, entries_.begin());
+    } catch (const std::bad_alloc &) {
+        if (!entries_.empty() && entries_.front().filename == filename) { entries_.pop_front(); }
+        return sample;
+    }
+    size_ += sample->size();
+    trimLocked();
+    return sample;
+}
+
+void SampleCache::preload(const std::vector<std::string> &filenames) {
+    for (const auto &filename: filenames) {
+        (void)get(filename);
+    }
+}
+
+std::size_t SampleCache::capacity() const {
+    std::scoped_lock lk(mutex_);
+    return capacity_;
+}
+
+std::size_t SampleCache::size() const {
+    std::scoped_lock lk(mutex_);
+    return size_;
+}
+
+std::size_t SampleCache::count() const {
+    std::scoped_lock lk(mutex_);
+    return entries_.size();
+}
+
+SampleCache::Sample SampleCache::decode(const std::string &filename) const {
+    std::vector<std::uint8_t> file;
+    if (!util::File::getFileContent(filename, file) || file.empty()) { return nullptr; }
+    try {
+        ChannelWav channel(mixer_, file.data(), file.size());
+        if (!channel.ok()) { return nullptr; }
+        file = {};
+        channel.start();
+        auto pcm = std::make_shared<std::vector<std::uint8_t>>();
+        std::array<std::uint8_t, 16384> buffer;
+        while (true) {
+            const auto received = channel.readData(buffer.data(), buffer.size());
+            if (received == 0) { break; }
+            pcm->insert(pcm->end(), buffer.data(), buffer.data() + received);
+        }
+        if (pcm->empty()) { return nullptr; }
+        pcm->shrink_to_fit();
+        return pcm;
+    } catch (const std::bad_alloc &) {
+        return nullptr;
+    }
+}
+
+void SampleCache::trimLocked() {
+    while (size_ > capacity_ && !entries_.empty()) {
+        auto &last = entries_.back();
+        size_ -= last.sample->size();
+        index_.erase(last.filename);
+        entries_.pop_back();
+    }
+}
+
+}
@@ -0,0 +1,76 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace hojy::audio {
+
+class Mixer;
+
+/* Sound effects decoded once into the mixer's output format, so playing one
+ * again needs no file access, WAV parsing or conversion.  Channels share the
+ * decoded data; the least recently used samples are dropped from the cache
+ * once the total size goes over the capacity. */
+class SampleCache final {
+public:
+    using Sample = std::shared_ptr<const std::vector<std::uint8_t>>;
+
+    explicit SampleCache(Mixer *mixer) noexcept: mixer_(mixer) {}
+    SampleCache(const SampleCache&) = delete;
+    SampleCache &operator=(const SampleCache&) = delete;
+
+    /* 0 keeps nothing, every get() decodes the file again */
+    void setCapacity(std::size_t bytes);
+    void clear();
+
+    /* The decoded sample, nullptr if the file can not be read or decoded */
+    [[nodiscard]] Sample get(const std::string &filename);
+    void preload(const std::vector<std::string> &filenames);
+
+    [[nodiscard]] std::size_t capacity() const;
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] std::size_t count() const;
+
+private:
+    struct Entry {
+        std::string filename;
+        Sample sample;
+    };
+
+    [[nodiscard]] Sample decode(const std::string &filename) const;
+    void trimLocked();
+
+private:
+    Mixer *mixer_;
+    std::size_t capacity_ = 0;
+    std::size_t size_ = 0;
+    std::list<Entry> entries_;
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    mutable std::mutex mutex_;
+};
+
+}
@@ -0,0 +1,156 @@
+#include "action_log.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace hojy::battle {
+namespace {
+
+using ::hojy::world::state::CharacterData;
+
+static_assert(sizeof(CharacterData) % sizeof(std::uint16_t) == 0);
+constexpr std::size_t CharacterWords = sizeof(CharacterData) / sizeof(std::uint16_t);
+static_assert(CharacterWords <= std::numeric_limits<std::uint16_t>::max());
+
+std::uint16_t readWord(const CharacterData &character, std::size_t word) {
+    std::uint16_t value;
+    std::memcpy(&value, reinterpret_cast<const unsigned char *>(&character) + word * sizeof(value),
+                sizeof(value));
+    return value;
+}
+
+void writeWord(CharacterData &character, std::size_t word, std::uint16_t value) {
+    std::memcpy(reinterpret_cast<unsigned char *>(&character) + word * sizeof(value), &value,
+                sizeof(value));
+}
+
+const InventorySnapshot &emptyInventory() {
+    static const InventorySnapshot inventory;
+    return inventory;
+}
+
+}
+
+ActionLog::ActionLog(std::size_t keyframeInterval) noexcept:
+    keyframeInterval_(std::max<std::size_t>(keyframeInterval, 1)) {
+}
+
+void ActionLog::reset(std::vector<CharacterData> participants, InventorySnapshot inventory) {
+    clear();
+    participants_ = participants;
+    initialParticipants_ = std::move(participants);
+    inventories_.push_back(std::move(inventory));
+}
+
+void ActionLog::clear() noexcept {
+    initialParticipants_.clear();
+    participants_.clear();
+    entries_.clear();
+    deltas_.clear();
+    keyframes_.clear();
+    inventories_.clear();
+}
+
+const InventorySnapshot &ActionLog::initialInventory() const noexcept {
+    return inventories_.empty() ? emptyInventory() : inventories_.front();
+}
+
+const InventorySnapshot &ActionLog::inventory() const noexcept {
+    return inventories_.empty() ? emptyInventory() : inventories_.back();
+}
+
+void ActionLog::append(ActionRecord record) {
+    if (!canAppend(record)) {
+        throw std::length_error("action log is full");
+    }
+    if (inventories_.empty()) {
+        inventories_.emplace_back();
+    }
+    if (inventories_.back() != record.inventory) {
+        inventories_.push_back(std::move(record.inventory));
+    }
+    Entry entry {
+        std::move(record.action), record.integrity,
+        std::uint32_t(record.randomBegin), std::uint32_t(record.randomEnd),
+        std::uint32_t(deltas_.size()), std::uint32_t(inventories_.size() - 1), NoKeyframe,
+    };
+    auto &state = record.participants;
+    if ((entries_.size() + 1) % keyframeInterval_ == 0
+        || state.size() != participants_.size()
+        || state.size() > std::numeric_limits<std::uint16_t>::max()) {
+        entry.keyframe = std::uint32_t(keyframes_.size());
+        keyframes_.push_back(state);
+    } else {
+        for (std::size_t index = 0; index < state.size(); ++index) {
+            if (std::memcmp(&state[index], &participants_[index], sizeof(CharacterData)) == 0) {
+                continue;
+            }
+            for (std::size_t word = 0; word < CharacterWords; ++word) {
+                auto value = readWord(state[index], word);
+                if (value != readWord(participants_[index], word)) {
+                    deltas_.push_back(WordDelta {std::uint16_t(index), std::uint16_t(word), value});
+                }
+            }
+        }
+    }
+    entries_.push_back(std::move(entry));
+    participants_ = std::move(state);
+}
+
+bool ActionLog::canAppend(const ActionRecord &record) const noexcept {
+    constexpr std::size_t Limit = std::numeric_limits<std::uint32_t>::max();
+    return record.randomBegin <= record.randomEnd && record.randomEnd <= Limit
+        && record.participants.size() <= Limit / CharacterWords
+        && deltas_.size() <= Limit - CharacterWords * record.participants.size();
+}
+
+ActionRecord ActionLog::at(std::size_t index) const {
+    if (index >= entries_.size()) {
+        throw std::out_of_range("action log index out of range");
+    }
+    auto start = index;
+    while (start > 0 && entries_[start].keyframe == NoKeyframe) {
+        --start;
+    }
+    ActionRecord record;
+    if (entries_[start].keyframe == NoKeyframe) {
+        record.participants = initialParticipants_;
+    }
+    for (; start <= index; ++start) {
+        load(start, record);
+    }
+    return record;
+}
+
+void ActionLog::load(std::size_t index, ActionRecord &record) const {
+    const auto &entry = entries_[index];
+    record.action = entry.action;
+    record.randomBegin = entry.randomBegin;
+    record.randomEnd = entry.randomEnd;
+    record.inventory = inventories_[entry.inventory];
+    record.integrity = entry.integrity;
+    if (entry.keyframe != NoKeyframe) {
+        record.participants = keyframes_[entry.keyframe];
+        return;
+    }
+    const auto deltaEnd = index + 1 < entries_.size() ? entries_[index + 1].deltaBegin : deltas_.size();
+    for (auto delta = std::size_t(entry.deltaBegin); delta < deltaEnd; ++delta) {
+        const auto &change = deltas_[delta];
+        writeWord(record.participants[change.participant], change.word, change.value);
+    }
+}
+
+std::size_t ActionLog::storageBytes() const noexcept {
+    auto bytes = entries_.capacity() * sizeof(Entry) + deltas_.capacity() * sizeof(WordDelta)
+        + keyframes_.capacity() * sizeof(keyframes_[0]) + inventories_.capacity() * sizeof(inventories_[0]);
+    for (const auto &keyframe: keyframes_) {
+        bytes += keyframe.capacity() * sizeof(CharacterData);
+    }
+    for (const auto &inventory: inventories_) {
+        bytes += inventory.capacity() * sizeof(inventory[0]);
+    }
+    return bytes;
+}
+
+}
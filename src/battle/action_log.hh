@@ -0,0 +1,103 @@
+#pragma once
+
+#include "action.hh"
+#include "world/character.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+namespace hojy::battle {
+
+struct ActionRecord {
+    BattleAction action;
+    std::size_t randomBegin = 0;
+    std::size_t randomEnd = 0;
+    std::vector<::hojy::world::state::CharacterData> participants;
+    InventorySnapshot inventory;
+    std::uint64_t integrity = 0;
+};
+
+// Delta-compressed action history.  Each entry keeps its action, random
+// window and integrity hash, but the participant state after the action is
+// stored as the 16-bit words that changed against the previous entry, with a
+// full keyframe every keyframeInterval entries to bound random access.
+// Inventories are shared between entries until they change.  An interval of
+// 1 stores a full copy per action.
+class ActionLog final {
+public:
+    static constexpr std::size_t DefaultKeyframeInterval = 64;
+
+    ActionLog() = default;
+    explicit ActionLog(std::size_t keyframeInterval) noexcept;
+
+    void reset(std::vector<::hojy::world::state::CharacterData> participants,
+               InventorySnapshot inventory);
+    void clear() noexcept;
+    /* throws std::length_error unless canAppend(record) */
+    void append(ActionRecord record);
+    /* false when the record would overflow the 32-bit entry indices */
+    [[nodiscard]] bool canAppend(const ActionRecord &record) const noexcept;
+
+    [[nodiscard]] std::size_t size() const noexcept { return entries_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return entries_.empty(); }
+    [[nodiscard]] std::size_t keyframeInterval() const noexcept { return keyframeInterval_; }
+    [[nodiscard]] ActionRecord operator[](std::size_t index) const { return at(index); }
+    [[nodiscard]] ActionRecord at(std::size_t index) const;
+    [[nodiscard]] const std::vector<::hojy::world::state::CharacterData> &initialParticipants() const noexcept {
+        return initialParticipants_;
+    }
+    [[nodiscard]] const InventorySnapshot &initialInventory() const noexcept;
+    /* state after the last appended entry */
+    [[nodiscard]] const std::vector<::hojy::world::state::CharacterData> &participants() const noexcept {
+        return participants_;
+    }
+    [[nodiscard]] const InventorySnapshot &inventory() const noexcept;
+    [[nodiscard]] std::size_t storageBytes() const noexcept;
+
+    /* Rebuilds the entries in order, calling visitor(const ActionRecord &)
+     * for each one until it returns false. Cheaper than at() per index. */
+    template<typename Visitor>
+    bool forEach(Visitor &&visitor) const {
+        ActionRecord record;
+        record.participants = initialParticipants_;
+        for (std::size_t index = 0; index < entries_.size(); ++index) {
+            load(index, record);
+            if (!visitor(static_cast<const ActionRecord &>(record))) { return false; }
+        }
+        return true;
+    }
+
+private:
+    static constexpr std::uint32_t NoKeyframe = std::numeric_limits<std::uint32_t>::max();
+
+    struct WordDelta {
+        std::uint16_t participant;
+        std::uint16_t word;
+        std::uint16_t value;
+    };
+
+    struct Entry {
+        BattleAction action;
+        std::uint64_t integrity;
+        std::uint32_t randomBegin;
+        std::uint32_t randomEnd;
+        std::uint32_t deltaBegin;
+        std::uint32_t inventory;
+        std::uint32_t keyframe;
+    };
+
+    void load(std::size_t index, ActionRecord &record) const;
+
+    std::size_t keyframeInterval_ = DefaultKeyframeInterval;
+    std::vector<::hojy::world::state::CharacterData> initialParticipants_;
+    std::vector<::hojy::world::state::CharacterData> participants_;
+    std::vector<Entry> entries_;
+    std::vector<WordDelta> deltas_;
+    std::vector<std::vector<::hojy::world::state::CharacterData>> keyframes_;
+    std::vector<InventorySnapshot> inventories_;
+};
+
+}
@@ -1,5 +1,6 @@
 #include "engine.hh"
 
+#include "replay_file.hh"
 #include "content/constants.hh"
 
 #include <algorithm>
@@ -364,7 +365,8 @@ bool BattleEngine::begin(BattleSetup setup) {
     initialParticipants_ = std::move(initialParticipants);
     initialInventory_ = setup_.inventory;
     inventory_ = initialInventory_;
-    actions_.clear();
+    actions_ = ActionLog(setup_.keyframeInterval);
+    actions_.reset(initialParticipants_, initialInventory_);
     randomCalls_.clear();
     sourceRandomCursor_ = 0;
     if (const auto *calls = sourceRandomCalls()) {
@@ -514,10 +516,8 @@ bool BattleEngine::record(const BattleAction &action,
         status_ = EngineStatus::Faulted;
         return false;
     }
-    const auto &before = actions_.empty()
-        ? initialParticipants_ : actions_.back().participants;
-    const auto &beforeInventory = actions_.empty()
-        ? initialInventory_ : actions_.back().inventory;
+    const auto &before = actions_.participants();
+    const auto &beforeInventory = actions_.inventory();
     if (!validateAction(action, before)) {
         status_ = EngineStatus::Faulted;
         return false;
@@ -527,7 +527,7 @@ bool BattleEngine::record(const BattleAction &action,
         return false;
     }
 
-    const auto state = participantState();
+    auto state = participantState();
     if (!validParticipantTransition(action, before, state)) {
         restoreParticipants(before);
         status_ = EngineStatus::Faulted;
@@ -537,10 +537,12 @@ bool BattleEngine::record(const BattleAction &action,
     captureRandomCalls();
     const auto randomEnd = randomCalls_.size();
     inventory_ = std::move(inventory);
-    actions_.push_back(ActionRecord{
-        action, randomBegin, randomEnd, state, inventory_,
-        actionIntegrity(action, setup_.enemy, before, beforeInventory,
-                        state, inventory_, randomBegin, randomEnd),
+    const auto integrity = actionIntegrity(
+        action, setup_.enemy, before, beforeInventory, state, inventory_,
+        randomBegin, randomEnd);
+    actions_.append(ActionRecord{
+        action, randomBegin, randomEnd, std::move(state), inventory_,
+        integrity,
     });
     return true;
 }
@@ -630,7 +632,8 @@ BattleResult BattleEngine::finish(bool commit) {
     const auto finalParticipants = participantState();
     const auto finalInventory = inventory_;
     result.replay = BattleReplay{
-        initialParticipants_, setup_.enemy, initialInventory_, actions_,
+        initialParticipants_, setup_.enemy, initialInventory_,
+        std::move(actions_),
         randomCalls_, won_, finalParticipants, finalInventory,
         snapshotIntegrity(finalParticipants, setup_.enemy, finalInventory,
                           won_, randomCalls_, canCommit,
@@ -640,6 +643,13 @@ BattleResult BattleEngine::finish(bool commit) {
         canCommit,
         settlementRandomBegin,
     };
+    if (!setup_.replayFile.empty()) {
+        try {
+            result.replaySaved = saveReplay(setup_.replayFile, result.replay);
+        } catch (const std::exception &) {
+            result.replaySaved = false;
+        }
+    }
     if (canCommit) {
         for (auto *participant: setup_.participants) {
             if (participant) {
@@ -685,6 +695,19 @@ ReplayResult BattleEngine::replay(const BattleReplay &replayData) {
         return result;
     }
 
+    const auto randomMismatch = [&](const char *error) {
+        result.error = error;
+        std::size_t index = 0;
+        replayData.actions.forEach([&](const ActionRecord &record) {
+            if (result.failedRandomCall < record.randomEnd) {
+                result.failedAction = index;
+                return false;
+            }
+            ++index;
+            return true;
+        });
+        return result;
+    };
     try {
         std::vector<std::int64_t> rawValues;
         rawValues.reserve(replayData.randomCalls.size());
@@ -693,24 +716,24 @@ ReplayResult BattleEngine::replay(const BattleReplay &replayData) {
         }
         SequenceRandom random(std::move(rawValues));
         for (const auto &call: replayData.randomCalls) {
+            result.failedRandomCall = random.callCount();
             if (random.next(call.minimum, call.maximum) != call.result) {
-                result.error = "random replay mismatch";
-                return result;
+                return randomMismatch("random replay mismatch");
             }
             if (random.calls().empty() || !(random.calls().back() == call)) {
-                result.error = "random replay raw value mismatch";
-                return result;
+                return randomMismatch("random replay raw value mismatch");
             }
         }
+        result.failedRandomCall = ReplayResult::NoIndex;
     } catch (const std::exception &) {
-        result.error = "invalid random replay";
-        return result;
+        return randomMismatch("invalid random replay");
     }
 
     auto state = replayData.initialParticipants;
     auto inventory = replayData.initialInventory;
     std::size_t randomCursor = 0;
-    for (const auto &record: replayData.actions) {
+    std::size_t actionIndex = 0;
+    const bool actionsValid = replayData.actions.forEach([&](const ActionRecord &record) {
         if (record.randomBegin != randomCursor
             || record.randomEnd < record.randomBegin
             || record.randomEnd > replayData.randomCalls.size()
@@ -726,16 +749,24 @@ ReplayResult BattleEngine::replay(const BattleReplay &replayData) {
             || !validParticipantTransition(record.action, state,
                                            record.participants)
             || !validateAction(record.action, replayData.enemy, state)) {
-            result.error = "invalid action replay record";
-            return result;
+            result.failedAction = actionIndex;
+            result.failedRandomCall = randomCursor;
+            return false;
         }
         randomCursor = record.randomEnd;
         state = record.participants;
         inventory = record.inventory;
+        ++actionIndex;
+        return true;
+    });
+    if (!actionsValid) {
+        result.error = "invalid action replay record";
+        return result;
     }
     if (replayData.settlementRandomBegin != randomCursor
         || replayData.settlementRandomBegin > replayData.randomCalls.size()) {
         result.error = "invalid settlement random boundary";
+        result.failedRandomCall = randomCursor;
         return result;
     }
 
@@ -748,6 +779,7 @@ ReplayResult BattleEngine::replay(const BattleReplay &replayData) {
             replayData.randomCalls, replayData.committed,
             replayData.settlementRandomBegin)) {
         result.error = "replay final snapshot mismatch";
+        result.failedRandomCall = randomCursor;
         return result;
     }
     state = replayData.finalParticipants;
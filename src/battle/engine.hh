@@ -1,11 +1,14 @@
 #pragma once
 
 #include "action.hh"
+#include "action_log.hh"
 #include "battle_participant.hh"
 #include "random.hh"
 
 #include <cstddef>
+#include <limits>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace hojy::battle {
@@ -18,26 +21,28 @@ enum class EngineStatus {
 };
 
 struct BattleSetup {
+    BattleSetup() = default;
+    /* The rest keeps its defaults, set replayFile and the interval by name */
+    BattleSetup(std::vector<BattleParticipant *> participants, std::vector<bool> enemy,
+                RandomSource *random, InventorySnapshot inventory):
+        participants(std::move(participants)), enemy(std::move(enemy)), random(random),
+        inventory(std::move(inventory)) {
+    }
+
     std::vector<BattleParticipant *> participants;
     std::vector<bool> enemy;
     RandomSource *random = nullptr;
     InventorySnapshot inventory;
-};
-
-struct ActionRecord {
-    BattleAction action;
-    std::size_t randomBegin = 0;
-    std::size_t randomEnd = 0;
-    std::vector<::hojy::world::state::CharacterData> participants;
-    InventorySnapshot inventory;
-    std::uint64_t integrity = 0;
+    std::size_t keyframeInterval = ActionLog::DefaultKeyframeInterval;
+    /* finish() saves the replay here when set, see replay_file.hh */
+    std::string replayFile;
 };
 
 struct BattleReplay {
     std::vector<::hojy::world::state::CharacterData> initialParticipants;
     std::vector<bool> enemy;
     InventorySnapshot initialInventory;
-    std::vector<ActionRecord> actions;
+    ActionLog actions;
     std::vector<RandomCall> randomCalls;
     bool won = false;
     std::vector<::hojy::world::state::CharacterData> finalParticipants;
@@ -54,11 +59,13 @@ struct BattleSnapshot {
     std::size_t actions = 0;
     std::vector<::hojy::world::state::CharacterData> participants;
     InventorySnapshot inventory;
-    std::vector<ActionRecord> actionLog;
+    ActionLog actionLog;
     std::vector<RandomCall> randomCalls;
 };
 
 struct ReplayResult {
+    static constexpr std::size_t NoIndex = std::numeric_limits<std::size_t>::max();
+
     bool valid = false;
     bool won = false;
     std::size_t actions = 0;
@@ -66,6 +73,10 @@ struct ReplayResult {
     InventorySnapshot inventory;
     std::vector<RandomCall> randomCalls;
     std::string error;
+    /* first action and random call that failed to verify, NoIndex if the
+     * failure is not tied to one */
+    std::size_t failedAction = NoIndex;
+    std::size_t failedRandomCall = NoIndex;
 };
 
 struct BattleResult {
@@ -73,6 +84,7 @@ struct BattleResult {
     bool won = false;
     std::size_t actions = 0;
     BattleReplay replay;
+    bool replaySaved = false;
 };
 
 class BattleEngine final {
@@ -93,6 +105,7 @@ public:
     void abort() noexcept;
 
     [[nodiscard]] EngineStatus status() const noexcept { return status_; }
+    [[nodiscard]] bool won() const noexcept { return won_; }
     [[nodiscard]] static ReplayResult replay(const BattleReplay &replay);
 
 private:
@@ -121,7 +134,7 @@ private:
     std::vector<::hojy::world::state::CharacterData> initialParticipants_;
     InventorySnapshot initialInventory_;
     InventorySnapshot inventory_;
-    std::vector<ActionRecord> actions_;
+    ActionLog actions_;
     std::vector<RandomCall> randomCalls_;
     std::size_t sourceRandomCursor_ = 0;
     EngineStatus status_ = EngineStatus::Idle;
@@ -1,23 +1,16 @@
 #include "movement.hh"
 
 #include <algorithm>
-#include <array>
 #include <cstdlib>
 #include <limits>
-#include <queue>
 #include <vector>
 
 namespace hojy::battle {
 
 namespace {
 
-constexpr std::array<std::pair<int, int>, 4> kOriginalDirections{{
-    {0, -1}, {1, 0}, {-1, 0}, {0, 1},
-}};
-
-constexpr std::array<std::pair<int, int>, 4> kOriginalRangeDirections{{
-    {-1, 0}, {0, -1}, {1, 0}, {0, 1},
-}};
+using Predicate = std::function<bool(int, int)>;
+using detail::kOriginalDirections;
 
 }
 
@@ -27,82 +20,8 @@ void getSelectableArea(
     const std::function<bool(int, int)> &blocked,
     const std::function<bool(int, int)> &occupied,
     const std::function<bool(int, int)> &sameSide) {
-    cells.clear();
-    if (width <= 0 || height <= 0
-        || width > std::numeric_limits<int>::max() / height
-        || start.first < 0 || start.first >= width
-        || start.second < 0 || start.second >= height) {
-        return;
-    }
-    auto &origin = cells[start];
-    origin.x = start.first;
-    origin.y = start.second;
-    origin.moves = 0;
-    origin.ranges = 0;
-    if (steps > 0) {
-        std::queue<SelectableCell *> queue;
-        queue.push(&origin);
-        while (!queue.empty()) {
-            auto *current = queue.front();
-            queue.pop();
-            bool sameSideBlock = false;
-            std::array<std::pair<int, int>, 4> neighbors{};
-            int count = 0;
-            for (const auto [dx, dy]: kOriginalDirections) {
-                const auto x = current->x + dx;
-                const auto y = current->y + dy;
-                if (x >= 0 && x < width && y >= 0 && y < height) {
-                    neighbors[count++] = {x, y};
-                }
-            }
-            for (int i = 0; i < count; ++i) {
-                if (sameSide(neighbors[i].first, neighbors[i].second)) {
-                    sameSideBlock = true;
-                    break;
-                }
-            }
-            if (sameSideBlock) { continue; }
-            for (int i = 0; i < count; ++i) {
-                const auto [x, y] = neighbors[i];
-                if (occupied(x, y) || blocked(x, y)) { continue; }
-                if (cells.find({x, y}) != cells.end()) { continue; }
-                auto &cell = cells[{x, y}];
-                cell.x = x;
-                cell.y = y;
-                cell.moves = current->moves + 1;
-                cell.moveParent = current;
-                if (cell.moves < steps) { queue.push(&cell); }
-            }
-        }
-    }
-    if (ranges <= 0) { return; }
-    std::queue<SelectableCell *> queue;
-    for (auto &entry: cells) { queue.push(&entry.second); }
-    while (!queue.empty()) {
-        auto *current = queue.front();
-        queue.pop();
-        std::array<std::pair<int, int>, 4> neighbors{};
-        int count = 0;
-        for (const auto [dx, dy]: kOriginalRangeDirections) {
-            const auto x = current->x + dx;
-            const auto y = current->y + dy;
-            if (x >= 0 && x < width && y >= 0 && y < height) {
-                neighbors[count++] = {x, y};
-            }
-        }
-        for (int i = 0; i < count; ++i) {
-            const auto [x, y] = neighbors[i];
-            if (blocked(x, y)) { continue; }
-            if (cells.find({x, y}) != cells.end()) { continue; }
-            auto &cell = cells[{x, y}];
-            cell.x = x;
-            cell.y = y;
-            cell.moves = -1;
-            cell.ranges = current->ranges + 1;
-            cell.rangeParent = current;
-            if (cell.ranges < ranges) { queue.push(&cell); }
-        }
-    }
+    getSelectableArea<Predicate, Predicate, Predicate>(
+        width, height, start, steps, ranges, cells, blocked, occupied, sameSide);
 }
 
 void getReachableRangeArea(
@@ -110,55 +29,8 @@ void getReachableRangeArea(
     SelectableCells &cells,
     const std::function<bool(int, int)> &blocked,
     const std::function<bool(int, int)> &occupied) {
-    cells.clear();
-    if (width <= 0 || height <= 0
-        || width > std::numeric_limits<int>::max() / height
-        || target.first < 0 || target.first >= width
-        || target.second < 0 || target.second >= height
-        || blocked(target.first, target.second)) {
-        return;
-    }
-    range = std::max(0, range);
-    const auto indexOf = [width](int x, int y) {
-        return static_cast<std::size_t>(y * width + x);
-    };
-    std::vector<int> distances(static_cast<std::size_t>(width * height), -1);
-    std::queue<std::pair<int, int>> queue;
-    distances[indexOf(target.first, target.second)] = 0;
-    queue.push(target);
-    while (!queue.empty()) {
-        const auto current = queue.front();
-        queue.pop();
-        const auto currentDistance = distances[indexOf(current.first, current.second)];
-        if (currentDistance >= range) { continue; }
-        for (const auto [dx, dy]: kOriginalRangeDirections) {
-            const auto next = std::make_pair(current.first + dx, current.second + dy);
-            if (next.first < 0 || next.first >= width
-                || next.second < 0 || next.second >= height
-                || blocked(next.first, next.second)
-                || (next != target && occupied(next.first, next.second))) {
-                continue;
-            }
-            auto &distance = distances[indexOf(next.first, next.second)];
-            if (distance >= 0) { continue; }
-            distance = currentDistance + 1;
-            queue.push(next);
-        }
-    }
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            const auto distance = distances[indexOf(x, y)];
-            if (distance < 0 || distance > range
-                || (std::make_pair(x, y) != target && occupied(x, y))) {
-                continue;
-            }
-            auto &cell = cells[{x, y}];
-            cell.x = x;
-            cell.y = y;
-            cell.moves = -1;
-            cell.ranges = distance;
-        }
-    }
+    getReachableRangeArea<Predicate, Predicate>(
+        width, height, target, range, cells, blocked, occupied);
 }
 
 void getCastRangeArea(
@@ -166,55 +38,8 @@ void getCastRangeArea(
     SelectableCells &cells,
     const std::function<bool(int, int)> &blocked,
     const std::function<bool(int, int)> &occupied) {
-    cells.clear();
-    if (width <= 0 || height <= 0
-        || width > std::numeric_limits<int>::max() / height
-        || target.first < 0 || target.first >= width
-        || target.second < 0 || target.second >= height
-        || blocked(target.first, target.second)) {
-        return;
-    }
-    range = std::max(0, range);
-    const auto indexOf = [width](int x, int y) {
-        return static_cast<std::size_t>(y * width + x);
-    };
-    std::vector<int> distances(static_cast<std::size_t>(width * height), -1);
-    std::queue<std::pair<int, int>> queue;
-    distances[indexOf(target.first, target.second)] = 0;
-    queue.push(target);
-    while (!queue.empty()) {
-        const auto current = queue.front();
-        queue.pop();
-        const auto currentDistance = distances[indexOf(current.first, current.second)];
-        if (currentDistance >= range) { continue; }
-        for (const auto [dx, dy]: kOriginalRangeDirections) {
-            const auto next = std::make_pair(current.first + dx, current.second + dy);
-            if (next.first < 0 || next.first >= width
-                || next.second < 0 || next.second >= height
-                || blocked(next.first, next.second)) {
-                continue;
-            }
-            auto &distance = distances[indexOf(next.first, next.second)];
-            if (distance >= 0) { continue; }
-            distance = currentDistance + 1;
-            queue.push(next);
-        }
-    }
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            const auto distance = distances[indexOf(x, y)];
-            const auto position = std::make_pair(x, y);
-            if (distance < 0 || distance > range
-                || (position != target && occupied(x, y))) {
-                continue;
-            }
-            auto &cell = cells[position];
-            cell.x = x;
-            cell.y = y;
-            cell.moves = -1;
-            cell.ranges = distance;
-        }
-    }
+    getCastRangeArea<Predicate, Predicate>(
+        width, height, target, range, cells, blocked, occupied);
 }
 
 int shortestPathDistance(
@@ -222,55 +47,147 @@ int shortestPathDistance(
     std::pair<int, int> target,
     const std::function<bool(int, int)> &blocked,
     const std::function<bool(int, int)> &occupied) {
+    return shortestPathDistance<Predicate, Predicate>(
+        width, height, start, target, blocked, occupied);
+}
+
+int terrainPathDistance(
+    int width, int height, std::pair<int, int> start,
+    std::pair<int, int> target,
+    const std::function<bool(int, int)> &blocked) {
+    return terrainPathDistance<Predicate>(width, height, start, target, blocked);
+}
+
+void getSelectableArea(const CellGrid &grid, std::pair<int, int> start, int steps, int ranges,
+                       SelectableCells &cells) {
+    getSelectableArea(
+        grid.width, grid.height, start, steps, ranges, cells,
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::Blocked); },
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::Occupied); },
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::SameSide); });
+}
+
+void getReachableRangeArea(const CellGrid &grid, std::pair<int, int> target, int range,
+                           SelectableCells &cells) {
+    getReachableRangeArea(
+        grid.width, grid.height, target, range, cells,
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::Blocked); },
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::Occupied); });
+}
+
+void getCastRangeArea(const CellGrid &grid, std::pair<int, int> target, int range,
+                      SelectableCells &cells) {
+    getCastRangeArea(
+        grid.width, grid.height, target, range, cells,
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::Blocked); },
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::Occupied); });
+}
+
+int shortestPathDistance(const CellGrid &grid, std::pair<int, int> start, std::pair<int, int> target) {
+    return shortestPathDistance(
+        grid.width, grid.height, start, target,
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::Blocked); },
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::Occupied); });
+}
+
+int terrainPathDistance(const CellGrid &grid, std::pair<int, int> start, std::pair<int, int> target) {
+    return terrainPathDistance(
+        grid.width, grid.height, start, target,
+        [&grid](int x, int y) { return grid.test(x, y, CellGrid::Blocked); });
+}
+
+void DistanceFieldCache::setTerrain(int width, int height, const std::function<bool(int, int)> &blocked) {
     if (width <= 0 || height <= 0
         || width > std::numeric_limits<int>::max() / height) {
-        return -1;
+        width = height = 0;
+    }
+    width_ = width;
+    height_ = height;
+    const auto size = static_cast<std::size_t>(width * height);
+    blocked_.assign(size, 0);
+    occupied_.assign(size, 0);
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            blocked_[static_cast<std::size_t>(y * width + x)] = blocked(x, y) ? 1 : 0;
+        }
+    }
+    terrainFields_.resize(size);
+    occupancyFields_.resize(size);
+    ++terrainGeneration_;
+    ++occupancyGeneration_;
+    occupancySource_.reset();
+}
+
+void DistanceFieldCache::setOccupancy(std::uint32_t generation, const std::function<bool(int, int)> &occupied) {
+    if (occupancySource_ == generation) { return; }
+    occupancySource_ = generation;
+    for (int y = 0; y < height_; ++y) {
+        for (int x = 0; x < width_; ++x) {
+            occupied_[static_cast<std::size_t>(y * width_ + x)] = occupied(x, y) ? 1 : 0;
+        }
     }
-    const auto inBounds = [width, height](int x, int y) {
-        return x >= 0 && x < width && y >= 0 && y < height;
+    ++occupancyGeneration_;
+}
+
+int DistanceFieldCache::terrainDistance(std::pair<int, int> from, std::pair<int, int> target) {
+    return distance(terrainFields_, terrainGeneration_, false, from, target);
+}
+
+int DistanceFieldCache::shortestDistance(std::pair<int, int> from, std::pair<int, int> target) {
+    return distance(occupancyFields_, occupancyGeneration_, true, from, target);
+}
+
+int DistanceFieldCache::distance(std::vector<Field> &fields, std::uint32_t generation, bool useOccupancy,
+                                 std::pair<int, int> from, std::pair<int, int> target) {
+    const auto inBounds = [this](int x, int y) {
+        return x >= 0 && x < width_ && y >= 0 && y < height_;
     };
-    if (!inBounds(start.first, start.second)
-        || !inBounds(target.first, target.second)
-        || blocked(target.first, target.second)) {
+    if (!inBounds(from.first, from.second) || !inBounds(target.first, target.second)) {
         return -1;
     }
-    if (start == target) { return 0; }
+    const auto targetIndex = target.second * width_ + target.first;
+    if (blocked_[targetIndex]) { return -1; }
+    if (from == target) { return 0; }
 
-    std::vector<int> distances(static_cast<std::size_t>(width * height), -1);
-    const auto indexOf = [width](int x, int y) {
-        return static_cast<std::size_t>(y * width + x);
-    };
-    std::queue<std::pair<int, int>> queue;
-    distances[indexOf(start.first, start.second)] = 0;
-    queue.push(start);
-    while (!queue.empty()) {
-        const auto current = queue.front();
-        queue.pop();
-        const auto currentDistance = distances[indexOf(current.first, current.second)];
-        for (const auto [dx, dy]: kOriginalDirections) {
-            const auto next = std::make_pair(current.first + dx, current.second + dy);
-            if (!inBounds(next.first, next.second)
-                || blocked(next.first, next.second)
-                || (next != target && occupied(next.first, next.second))) {
-                continue;
+    /* Paths only cross passable cells besides their two ends, so the field is
+     * grown outwards from the target and read back from the start cell */
+    auto &field = fields[targetIndex];
+    if (field.generation != generation) {
+        field.generation = generation;
+        field.distances.assign(blocked_.size(), -1);
+        field.distances[targetIndex] = 0;
+        queue_.clear();
+        queue_.push_back(targetIndex);
+        for (std::size_t head = 0; head < queue_.size(); ++head) {
+            const auto current = queue_[head];
+            const auto x = current % width_, y = current / width_;
+            const auto next = field.distances[current] + 1;
+            for (const auto [dx, dy]: kOriginalDirections) {
+                if (!inBounds(x + dx, y + dy)) { continue; }
+                const auto index = current + dy * width_ + dx;
+                if (field.distances[index] >= 0 || !passable(index, useOccupancy)) { continue; }
+                field.distances[index] = next;
+                queue_.push_back(index);
             }
-            auto &distance = distances[indexOf(next.first, next.second)];
-            if (distance >= 0) { continue; }
-            distance = currentDistance + 1;
-            if (next == target) { return distance; }
-            queue.push(next);
         }
+        ++fieldsBuilt_;
     }
-    return -1;
-}
-
-int terrainPathDistance(
-    int width, int height, std::pair<int, int> start,
-    std::pair<int, int> target,
-    const std::function<bool(int, int)> &blocked) {
-    return shortestPathDistance(
-        width, height, start, target, blocked,
-        [](int, int) { return false; });
+    const auto fromIndex = from.second * width_ + from.first;
+    if (passable(fromIndex, useOccupancy)) {
+        return field.distances[fromIndex];
+    }
+    /* The start cell itself is never checked, step out of it first */
+    int result = -1;
+    for (const auto [dx, dy]: kOriginalDirections) {
+        if (!inBounds(from.first + dx, from.second + dy)) { continue; }
+        const auto index = fromIndex + dy * width_ + dx;
+        if (index == targetIndex) { return 1; }
+        const auto distance = field.distances[index];
+        if (distance >= 0 && passable(index, useOccupancy) && (result < 0 || distance + 1 < result)) {
+            result = distance + 1;
+        }
+    }
+    return result;
 }
 
 bool hasMoved(int initialSteps, int remainingSteps) noexcept {
@@ -315,9 +232,9 @@ std::optional<std::pair<int, int>> chooseMaximumCastPosition(
     int selectedDistance = std::numeric_limits<int>::max();
     for (const auto &[position, cell]: movementCells) {
         if (cell.moves < 0) { continue; }
-        const auto range = castRangeCells.find(position);
-        if (range == castRangeCells.end()) { continue; }
-        const auto castDistance = range->second.ranges;
+        const auto *range = castRangeCells.lookup(position);
+        if (!range) { continue; }
+        const auto castDistance = range->ranges;
         const auto distance = std::abs(position.first - origin.first)
             + std::abs(position.second - origin.second);
         if (!selected || castDistance > selectedRange
@@ -346,7 +263,7 @@ std::optional<std::pair<int, int>> chooseSupportPosition(
         }
     }
     if (!haveOrigin) { return std::nullopt; }
-    if (castRangeCells.find(origin) != castRangeCells.end()) {
+    if (castRangeCells.contains(origin)) {
         return origin;
     }
     return chooseMaximumCastPosition(movementCells, castRangeCells, origin);
@@ -394,10 +311,10 @@ std::optional<std::pair<int, int>> chooseAlignedSkillPosition(
     const auto aligned = [target](std::pair<int, int> position) {
         return position.first == target.first || position.second == target.second;
     };
-    const auto actorRange = castRangeCells.find(actor);
-    if (aligned(actor) && actorRange != castRangeCells.end()
-        && actorRange->second.ranges > 0
-        && actorRange->second.ranges <= range) {
+    const auto *actorRange = castRangeCells.lookup(actor);
+    if (aligned(actor) && actorRange
+        && actorRange->ranges > 0
+        && actorRange->ranges <= range) {
         return actor;
     }
     for (int wanted = range; wanted >= 1; --wanted) {
@@ -405,9 +322,8 @@ std::optional<std::pair<int, int>> chooseAlignedSkillPosition(
         int selectedCost = std::numeric_limits<int>::max();
         for (const auto &[position, cell]: movementCells) {
             if (cell.moves < 0 || !aligned(position)) { continue; }
-            const auto rangeCell = castRangeCells.find(position);
-            if (rangeCell == castRangeCells.end()
-                || rangeCell->second.ranges != wanted) {
+            const auto *rangeCell = castRangeCells.lookup(position);
+            if (!rangeCell || rangeCell->ranges != wanted) {
                 continue;
             }
             const auto cost = std::abs(position.first - actor.first)
@@ -1,22 +1,15 @@
 #pragma once
 
+#include "battle/movement_search.hh"
+
 #include <functional>
-#include <map>
 #include <optional>
 #include <utility>
+#include <vector>
+#include <cstdint>
 
 namespace hojy::battle {
 
-struct SelectableCell {
-    int x = 0;
-    int y = 0;
-    int moves = -1;
-    int ranges = 0;
-    SelectableCell *moveParent = nullptr;
-    SelectableCell *rangeParent = nullptr;
-};
-
-using SelectableCells = std::map<std::pair<int, int>, SelectableCell>;
 using PositionDistance = std::function<int(
     std::pair<int, int> from, std::pair<int, int> target)>;
 
@@ -69,6 +62,41 @@ int terrainPathDistance(
     std::pair<int, int> target,
     const std::function<bool(int, int)> &blocked);
 
+/* Answers terrainPathDistance() and shortestPathDistance() queries from BFS
+ * distance fields kept per target cell. A field is built on the first query
+ * for its target and reused until the terrain is replaced or the occupancy
+ * generation passed to setOccupancy() changes. */
+class DistanceFieldCache {
+public:
+    void setTerrain(int width, int height, const std::function<bool(int, int)> &blocked);
+    /* Snapshots occupancy again only when `generation` differs from the last call */
+    void setOccupancy(std::uint32_t generation, const std::function<bool(int, int)> &occupied);
+
+    [[nodiscard]] int terrainDistance(std::pair<int, int> from, std::pair<int, int> target);
+    [[nodiscard]] int shortestDistance(std::pair<int, int> from, std::pair<int, int> target);
+    [[nodiscard]] std::size_t fieldsBuilt() const noexcept { return fieldsBuilt_; }
+
+private:
+    struct Field {
+        std::uint32_t generation = 0;
+        std::vector<int> distances;
+    };
+    int distance(std::vector<Field> &fields, std::uint32_t generation, bool useOccupancy,
+                 std::pair<int, int> from, std::pair<int, int> target);
+    [[nodiscard]] bool passable(int index, bool useOccupancy) const noexcept {
+        return !blocked_[index] && !(useOccupancy && occupied_[index]);
+    }
+
+private:
+    int width_ = 0, height_ = 0;
+    std::vector<std::uint8_t> blocked_, occupied_;
+    std::vector<Field> terrainFields_, occupancyFields_;
+    std::vector<int> queue_;
+    std::uint32_t terrainGeneration_ = 0, occupancyGeneration_ = 0;
+    std::optional<std::uint32_t> occupancySource_;
+    std::size_t fieldsBuilt_ = 0;
+};
+
 bool hasMoved(int initialSteps, int remainingSteps) noexcept;
 bool shouldClearDeadPosition(int hp, int x, int y) noexcept;
 bool shouldContinueAfterMovement(bool playerControlled,
@@ -0,0 +1,320 @@
+#pragma once
+
+#include "battle/selectable_cells.hh"
+
+#include <algorithm>
+#include <array>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+#include <cstdint>
+
+/* Header-only movement searches. The blocked/occupied/sameSide checks can be
+ * any callable, so they are inlined into the BFS loops instead of going through
+ * std::function. movement.hh declares the std::function entry points on top. */
+
+namespace hojy::battle {
+
+namespace detail {
+
+inline constexpr std::array<std::pair<int, int>, 4> kOriginalDirections{{
+    {0, -1}, {1, 0}, {-1, 0}, {0, 1},
+}};
+
+inline constexpr std::array<std::pair<int, int>, 4> kOriginalRangeDirections{{
+    {-1, 0}, {0, -1}, {1, 0}, {0, 1},
+}};
+
+}
+
+/* Per-cell flags of a battlefield packed into one byte each */
+struct CellGrid {
+    enum : std::uint8_t {
+        Blocked = 1,
+        Occupied = 2,
+        SameSide = 4,
+    };
+
+    int width = 0;
+    int height = 0;
+    std::vector<std::uint8_t> bits;
+
+    void reset(int w, int h) {
+        width = std::max(0, w);
+        height = std::max(0, h);
+        bits.assign(static_cast<std::size_t>(width) * static_cast<std::size_t>(height), 0);
+    }
+    void set(int x, int y, std::uint8_t flags) {
+        bits[static_cast<std::size_t>(y * width + x)] |= flags;
+    }
+    [[nodiscard]] bool test(int x, int y, std::uint8_t flag) const {
+        return (bits[static_cast<std::size_t>(y * width + x)] & flag) != 0;
+    }
+};
+
+template<typename Blocked, typename Occupied, typename SameSide>
+void getSelectableArea(
+    int width, int height, std::pair<int, int> start, int steps, int ranges,
+    SelectableCells &cells,
+    const Blocked &blocked, const Occupied &occupied, const SameSide &sameSide) {
+    cells.clear();
+    if (width <= 0 || height <= 0
+        || width > std::numeric_limits<int>::max() / height
+        || start.first < 0 || start.first >= width
+        || start.second < 0 || start.second >= height) {
+        return;
+    }
+    cells.reset(width, height);
+    auto &origin = cells[start];
+    origin.x = start.first;
+    origin.y = start.second;
+    origin.moves = 0;
+    origin.ranges = 0;
+    if (steps > 0) {
+        std::queue<SelectableCell *> queue;
+        queue.push(&origin);
+        while (!queue.empty()) {
+            auto *current = queue.front();
+            queue.pop();
+            bool sameSideBlock = false;
+            std::array<std::pair<int, int>, 4> neighbors{};
+            int count = 0;
+            for (const auto &[dx, dy]: detail::kOriginalDirections) {
+                const auto x = current->x + dx;
+                const auto y = current->y + dy;
+                if (x >= 0 && x < width && y >= 0 && y < height) {
+                    neighbors[count++] = {x, y};
+                }
+            }
+            for (int i = 0; i < count; ++i) {
+                if (sameSide(neighbors[i].first, neighbors[i].second)) {
+                    sameSideBlock = true;
+                    break;
+                }
+            }
+            if (sameSideBlock) { continue; }
+            for (int i = 0; i < count; ++i) {
+                const auto [x, y] = neighbors[i];
+                if (occupied(x, y) || blocked(x, y)) { continue; }
+                if (cells.contains({x, y})) { continue; }
+                auto &cell = cells[{x, y}];
+                cell.x = x;
+                cell.y = y;
+                cell.moves = current->moves + 1;
+                cell.moveParent = {current->x, current->y};
+                if (cell.moves < steps) { queue.push(&cell); }
+            }
+        }
+    }
+    if (ranges <= 0) { return; }
+    std::queue<SelectableCell *> queue;
+    for (auto &entry: cells) { queue.push(&entry.second); }
+    while (!queue.empty()) {
+        auto *current = queue.front();
+        queue.pop();
+        std::array<std::pair<int, int>, 4> neighbors{};
+        int count = 0;
+        for (const auto &[dx, dy]: detail::kOriginalRangeDirections) {
+            const auto x = current->x + dx;
+            const auto y = current->y + dy;
+            if (x >= 0 && x < width && y >= 0 && y < height) {
+                neighbors[count++] = {x, y};
+            }
+        }
+        for (int i = 0; i < count; ++i) {
+            const auto [x, y] = neighbors[i];
+            if (blocked(x, y)) { continue; }
+            if (cells.contains({x, y})) { continue; }
+            auto &cell = cells[{x, y}];
+            cell.x = x;
+            cell.y = y;
+            cell.moves = -1;
+            cell.ranges = current->ranges + 1;
+            cell.rangeParent = {current->x, current->y};
+            if (cell.ranges < ranges) { queue.push(&cell); }
+        }
+    }
+}
+
+template<typename Blocked, typename Occupied>
+void getReachableRangeArea(
+    int width, int height, std::pair<int, int> target, int range,
+    SelectableCells &cells,
+    const Blocked &blocked, const Occupied &occupied) {
+    cells.clear();
+    if (width <= 0 || height <= 0
+        || width > std::numeric_limits<int>::max() / height
+        || target.first < 0 || target.first >= width
+        || target.second < 0 || target.second >= height
+        || blocked(target.first, target.second)) {
+        return;
+    }
+    cells.reset(width, height);
+    range = std::max(0, range);
+    const auto indexOf = [width](int x, int y) {
+        return static_cast<std::size_t>(y * width + x);
+    };
+    std::vector<int> distances(static_cast<std::size_t>(width * height), -1);
+    std::queue<std::pair<int, int>> queue;
+    distances[indexOf(target.first, target.second)] = 0;
+    queue.push(target);
+    while (!queue.empty()) {
+        const auto current = queue.front();
+        queue.pop();
+        const auto currentDistance = distances[indexOf(current.first, current.second)];
+        if (currentDistance >= range) { continue; }
+        for (const auto &[dx, dy]: detail::kOriginalRangeDirections) {
+            const auto next = std::make_pair(current.first + dx, current.second + dy);
+            if (next.first < 0 || next.first >= width
+                || next.second < 0 || next.second >= height
+                || blocked(next.first, next.second)
+                || (next != target && occupied(next.first, next.second))) {
+                continue;
+            }
+            auto &distance = distances[indexOf(next.first, next.second)];
+            if (distance >= 0) { continue; }
+            distance = currentDistance + 1;
+            queue.push(next);
+        }
+    }
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const auto distance = distances[indexOf(x, y)];
+            if (distance < 0 || distance > range
+                || (std::make_pair(x, y) != target && occupied(x, y))) {
+                continue;
+            }
+            auto &cell = cells[{x, y}];
+            cell.x = x;
+            cell.y = y;
+            cell.moves = -1;
+            cell.ranges = distance;
+        }
+    }
+}
+
+template<typename Blocked, typename Occupied>
+void getCastRangeArea(
+    int width, int height, std::pair<int, int> target, int range,
+    SelectableCells &cells,
+    const Blocked &blocked, const Occupied &occupied) {
+    cells.clear();
+    if (width <= 0 || height <= 0
+        || width > std::numeric_limits<int>::max() / height
+        || target.first < 0 || target.first >= width
+        || target.second < 0 || target.second >= height
+        || blocked(target.first, target.second)) {
+        return;
+    }
+    cells.reset(width, height);
+    range = std::max(0, range);
+    const auto indexOf = [width](int x, int y) {
+        return static_cast<std::size_t>(y * width + x);
+    };
+    std::vector<int> distances(static_cast<std::size_t>(width * height), -1);
+    std::queue<std::pair<int, int>> queue;
+    distances[indexOf(target.first, target.second)] = 0;
+    queue.push(target);
+    while (!queue.empty()) {
+        const auto current = queue.front();
+        queue.pop();
+        const auto currentDistance = distances[indexOf(current.first, current.second)];
+        if (currentDistance >= range) { continue; }
+        for (const auto &[dx, dy]: detail::kOriginalRangeDirections) {
+            const auto next = std::make_pair(current.first + dx, current.second + dy);
+            if (next.first < 0 || next.first >= width
+                || next.second < 0 || next.second >= height
+                || blocked(next.first, next.second)) {
+                continue;
+            }
+            auto &distance = distances[indexOf(next.first, next.second)];
+            if (distance >= 0) { continue; }
+            distance = currentDistance + 1;
+            queue.push(next);
+        }
+    }
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            const auto distance = distances[indexOf(x, y)];
+            const auto position = std::make_pair(x, y);
+            if (distance < 0 || distance > range
+                || (position != target && occupied(x, y))) {
+                continue;
+            }
+            auto &cell = cells[position];
+            cell.x = x;
+            cell.y = y;
+            cell.moves = -1;
+            cell.ranges = distance;
+        }
+    }
+}
+
+template<typename Blocked, typename Occupied>
+int shortestPathDistance(
+    int width, int height, std::pair<int, int> start,
+    std::pair<int, int> target,
+    const Blocked &blocked, const Occupied &occupied) {
+    if (width <= 0 || height <= 0
+        || width > std::numeric_limits<int>::max() / height) {
+        return -1;
+    }
+    const auto inBounds = [width, height](int x, int y) {
+        return x >= 0 && x < width && y >= 0 && y < height;
+    };
+    if (!inBounds(start.first, start.second)
+        || !inBounds(target.first, target.second)
+        || blocked(target.first, target.second)) {
+        return -1;
+    }
+    if (start == target) { return 0; }
+
+    std::vector<int> distances(static_cast<std::size_t>(width * height), -1);
+    const auto indexOf = [width](int x, int y) {
+        return static_cast<std::size_t>(y * width + x);
+    };
+    std::queue<std::pair<int, int>> queue;
+    distances[indexOf(start.first, start.second)] = 0;
+    queue.push(start);
+    while (!queue.empty()) {
+        const auto current = queue.front();
+        queue.pop();
+        const auto currentDistance = distances[indexOf(current.first, current.second)];
+        for (const auto &[dx, dy]: detail::kOriginalDirections) {
+            const auto next = std::make_pair(current.first + dx, current.second + dy);
+            if (!inBounds(next.first, next.second)
+                || blocked(next.first, next.second)
+                || (next != target && occupied(next.first, next.second))) {
+                continue;
+            }
+            auto &distance = distances[indexOf(next.first, next.second)];
+            if (distance >= 0) { continue; }
+            distance = currentDistance + 1;
+            if (next == target) { return distance; }
+            queue.push(next);
+        }
+    }
+    return -1;
+}
+
+template<typename Blocked>
+int terrainPathDistance(
+    int width, int height, std::pair<int, int> start,
+    std::pair<int, int> target,
+    const Blocked &blocked) {
+    return shortestPathDistance(
+        width, height, start, target, blocked,
+        [](int, int) { return false; });
+}
+
+void getSelectableArea(const CellGrid &grid, std::pair<int, int> start, int steps, int ranges,
+                       SelectableCells &cells);
+void getReachableRangeArea(const CellGrid &grid, std::pair<int, int> target, int range,
+                           SelectableCells &cells);
+void getCastRangeArea(const CellGrid &grid, std::pair<int, int> target, int range,
+                      SelectableCells &cells);
+int shortestPathDistance(const CellGrid &grid, std::pair<int, int> start, std::pair<int, int> target);
+int terrainPathDistance(const CellGrid &grid, std::pair<int, int> start, std::pair<int, int> target);
+
+}
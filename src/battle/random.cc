@@ -59,6 +59,31 @@ const std::vector<RandomCall> &SequenceRandom::calls() const noexcept {
     return calls_;
 }
 
+std::uint64_t SeededRandom::nextRaw() noexcept {
+    /* splitmix64 */
+    auto z = (state_ += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+int SeededRandom::next(int upperExclusive) {
+    if (upperExclusive <= 1 || upperExclusive > OriginalRandomBoundMax) {
+        return 0;
+    }
+    return static_cast<int>(nextRaw() % static_cast<std::uint64_t>(upperExclusive));
+}
+
+int SeededRandom::next(int minimum, int maximum) {
+    if (minimum > maximum) {
+        throw std::invalid_argument("minimum must not exceed maximum");
+    }
+    const auto width = static_cast<std::uint64_t>(
+        static_cast<std::int64_t>(maximum) - static_cast<std::int64_t>(minimum) + 1);
+    return static_cast<int>(static_cast<std::int64_t>(minimum)
+                            + static_cast<std::int64_t>(nextRaw() % width));
+}
+
 int RecordingRandom::next(int upperExclusive) {
     const int result = source_->next(upperExclusive);
     if (upperExclusive > 1 && upperExclusive <= OriginalRandomBoundMax) {
@@ -50,6 +50,23 @@ private:
     std::size_t index_ = 0;
 };
 
+/* Self-contained generator for headless runs. It follows GameRandom's bound
+ * rules, but owns its state so concurrent battles can be seeded and replayed
+ * independently of util::gRandom. */
+class SeededRandom final: public RandomSource {
+public:
+    explicit SeededRandom(std::uint64_t seed) noexcept: state_(seed) {
+    }
+
+    int next(int upperExclusive) override;
+    int next(int minimum, int maximum) override;
+
+private:
+    std::uint64_t nextRaw() noexcept;
+
+    std::uint64_t state_;
+};
+
 class RecordingRandom final: public RandomSource {
 public:
     explicit RecordingRandom(RandomSource &source): source_(&source) {
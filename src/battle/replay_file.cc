@@ -0,0 +1,512 @@
+#include "replay_file.hh"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <utility>
+
+namespace hojy::battle {
+namespace {
+
+using ::hojy::world::state::CharacterData;
+
+constexpr char Magic[4] = {'H', 'J', 'R', 'P'};
+constexpr std::size_t CharacterWords = sizeof(CharacterData) / sizeof(std::uint16_t);
+constexpr std::uint8_t FlagWon = 1;
+constexpr std::uint8_t FlagCommitted = 2;
+
+std::uint64_t checksum(const char *data, std::size_t size) {
+    std::uint64_t hash = 1469598103934665603ULL;
+    for (std::size_t index = 0; index < size; ++index) {
+        hash ^= static_cast<unsigned char>(data[index]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+std::uint16_t readWord(const CharacterData &character, std::size_t word) {
+    std::uint16_t value;
+    std::memcpy(&value, reinterpret_cast<const unsigned char *>(&character) + word * sizeof(value),
+                sizeof(value));
+    return value;
+}
+
+void writeWord(CharacterData &character, std::size_t word, std::uint16_t value) {
+    std::memcpy(reinterpret_cast<unsigned char *>(&character) + word * sizeof(value), &value,
+                sizeof(value));
+}
+
+class Writer final {
+public:
+    void byte(std::uint8_t value) { buffer_.push_back(static_cast<char>(value)); }
+    void bytes(const void *data, std::size_t size) {
+        buffer_.append(static_cast<const char *>(data), size);
+    }
+    void varint(std::uint64_t value) {
+        while (value >= 0x80) {
+            byte(static_cast<std::uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        byte(static_cast<std::uint8_t>(value));
+    }
+    void svarint(std::int64_t value) {
+        varint((static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63));
+    }
+    void fixed64(std::uint64_t value) {
+        for (int shift = 0; shift < 64; shift += 8) {
+            byte(static_cast<std::uint8_t>(value >> shift));
+        }
+    }
+    [[nodiscard]] std::string &buffer() { return buffer_; }
+
+private:
+    std::string buffer_;
+};
+
+class Reader final {
+public:
+    Reader(const char *data, std::size_t size): pos_(data), end_(data + size) {}
+
+    [[nodiscard]] bool ok() const { return ok_; }
+    [[nodiscard]] std::size_t remaining() const { return std::size_t(end_ - pos_); }
+    std::uint8_t byte() {
+        if (pos_ >= end_) {
+            ok_ = false;
+            return 0;
+        }
+        return static_cast<std::uint8_t>(*pos_++);
+    }
+    void bytes(void *data, std::size_t size) {
+        if (remaining() < size) {
+            ok_ = false;
+            return;
+        }
+        std::memcpy(data, pos_, size);
+        pos_ += size;
+    }
+    std::uint64_t varint() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const auto part = byte();
+            value |= std::uint64_t(part & 0x7F) << shift;
+            if (!(part & 0x80)) { return value; }
+        }
+        ok_ = false;
+        return 0;
+    }
+    std::int64_t svarint() {
+        const auto value = varint();
+        return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+    }
+    template<typename T>
+    T integer() {
+        static_assert(std::is_integral_v<T>);
+        if constexpr (std::is_signed_v<T>) {
+            const auto value = svarint();
+            if (value < std::numeric_limits<T>::min() || value > std::numeric_limits<T>::max()) {
+                ok_ = false;
+            }
+            return static_cast<T>(value);
+        } else {
+            const auto value = varint();
+            if (value > std::numeric_limits<T>::max()) { ok_ = false; }
+            return static_cast<T>(value);
+        }
+    }
+    std::uint64_t fixed64() {
+        std::uint64_t value = 0;
+        for (int shift = 0; shift < 64; shift += 8) {
+            value |= std::uint64_t(byte()) << shift;
+        }
+        return value;
+    }
+    /* Every element takes at least one byte, so a count beyond the remaining
+     * size can only come from a damaged file. */
+    std::size_t count() {
+        const auto value = varint();
+        if (value > remaining()) {
+            ok_ = false;
+            return 0;
+        }
+        return std::size_t(value);
+    }
+
+private:
+    const char *pos_;
+    const char *end_;
+    bool ok_ = true;
+};
+
+void writeInventory(Writer &writer, const InventorySnapshot &inventory) {
+    writer.varint(inventory.size());
+    for (const auto &[itemId, count]: inventory) {
+        writer.svarint(itemId);
+        writer.svarint(count);
+    }
+}
+
+bool readInventory(Reader &reader, InventorySnapshot &inventory) {
+    inventory.resize(reader.count());
+    for (auto &[itemId, count]: inventory) {
+        itemId = reader.integer<std::int16_t>();
+        count = reader.integer<std::int16_t>();
+    }
+    return reader.ok();
+}
+
+/* Changed words as (gap from the previous flat word index, value) pairs */
+void writeDeltas(Writer &writer, const std::vector<CharacterData> &before,
+                 const std::vector<CharacterData> &after) {
+    std::vector<std::pair<std::size_t, std::uint16_t>> changes;
+    for (std::size_t index = 0; index < after.size(); ++index) {
+        if (std::memcmp(&before[index], &after[index], sizeof(CharacterData)) == 0) {
+            continue;
+        }
+        for (std::size_t word = 0; word < CharacterWords; ++word) {
+            const auto value = readWord(after[index], word);
+            if (value != readWord(before[index], word)) {
+                changes.emplace_back(index * CharacterWords + word, value);
+            }
+        }
+    }
+    writer.varint(changes.size());
+    std::size_t last = 0;
+    for (const auto &[flat, value]: changes) {
+        writer.varint(flat - last);
+        writer.bytes(&value, sizeof(value));
+        last = flat;
+    }
+}
+
+bool readDeltas(Reader &reader, std::vector<CharacterData> &state) {
+    const auto changes = reader.count();
+    std::size_t flat = 0;
+    for (std::size_t change = 0; change < changes && reader.ok(); ++change) {
+        flat += reader.varint();
+        std::uint16_t value = 0;
+        reader.bytes(&value, sizeof(value));
+        if (flat >= state.size() * CharacterWords) { return false; }
+        writeWord(state[flat / CharacterWords], flat % CharacterWords, value);
+    }
+    return reader.ok();
+}
+
+void writeAction(Writer &writer, const BattleAction &action) {
+    writer.varint(action.actor);
+    writer.byte(static_cast<std::uint8_t>(action.payload.index()));
+    std::visit([&](const auto &payload) {
+        using T = std::decay_t<decltype(payload)>;
+        if constexpr (std::is_same_v<T, MoveAction>) {
+            writer.svarint(payload.from.x);
+            writer.svarint(payload.from.y);
+            writer.svarint(payload.to.x);
+            writer.svarint(payload.to.y);
+        } else if constexpr (std::is_same_v<T, SkillAction>) {
+            writer.svarint(payload.skillSlot);
+            writer.svarint(payload.skillId);
+            writer.svarint(payload.level);
+            writer.varint(payload.targets.size());
+            for (const auto &target: payload.targets) {
+                writer.varint(target.participant);
+                writer.svarint(target.distance);
+            }
+        } else if constexpr (std::is_same_v<T, TechniqueAction>) {
+            writer.byte(static_cast<std::uint8_t>(payload.technique));
+            writer.varint(payload.target);
+        } else if constexpr (std::is_same_v<T, ThrowAction>) {
+            writer.varint(payload.target);
+            writer.svarint(payload.itemId);
+            writer.byte(static_cast<std::uint8_t>(payload.source));
+            writer.svarint(payload.slot);
+        } else if constexpr (std::is_same_v<T, ItemAction>) {
+            writer.svarint(payload.itemId);
+            writer.byte(static_cast<std::uint8_t>(payload.source));
+            writer.svarint(payload.slot);
+        } else if constexpr (std::is_same_v<T, RestAction>) {
+            writer.byte(payload.moved ? 1 : 0);
+        } else if constexpr (std::is_same_v<T, RoundEndAction>) {
+            writer.byte(payload.inactive ? 1 : 0);
+        } else if constexpr (std::is_same_v<T, NoOpAction>) {
+            writer.svarint(payload.reason);
+        }
+    }, action.payload);
+}
+
+bool readAction(Reader &reader, BattleAction &action) {
+    action.actor = reader.integer<ParticipantId>();
+    switch (reader.byte()) {
+    case 0: {
+        MoveAction payload;
+        payload.from.x = reader.integer<std::int16_t>();
+        payload.from.y = reader.integer<std::int16_t>();
+        payload.to.x = reader.integer<std::int16_t>();
+        payload.to.y = reader.integer<std::int16_t>();
+        action.payload = payload;
+        break;
+    }
+    case 1: {
+        SkillAction payload;
+        payload.skillSlot = reader.integer<std::int16_t>();
+        payload.skillId = reader.integer<std::int16_t>();
+        payload.level = reader.integer<std::int16_t>();
+        payload.targets.resize(reader.count());
+        for (auto &target: payload.targets) {
+            target.participant = reader.integer<ParticipantId>();
+            target.distance = reader.integer<std::int16_t>();
+        }
+        action.payload = std::move(payload);
+        break;
+    }
+    case 2: {
+        TechniqueAction payload;
+        payload.technique = static_cast<Technique>(reader.byte());
+        payload.target = reader.integer<ParticipantId>();
+        action.payload = payload;
+        break;
+    }
+    case 3: {
+        ThrowAction payload;
+        payload.target = reader.integer<ParticipantId>();
+        payload.itemId = reader.integer<std::int16_t>();
+        payload.source = static_cast<InventorySource>(reader.byte());
+        payload.slot = reader.integer<std::int16_t>();
+        action.payload = payload;
+        break;
+    }
+    case 4: {
+        ItemAction payload;
+        payload.itemId = reader.integer<std::int16_t>();
+        payload.source = static_cast<InventorySource>(reader.byte());
+        payload.slot = reader.integer<std::int16_t>();
+        action.payload = payload;
+        break;
+    }
+    case 5:
+        action.payload = RestAction{reader.byte() != 0};
+        break;
+    case 6:
+        action.payload = RoundEndAction{reader.byte() != 0};
+        break;
+    case 7:
+        action.payload = NoOpAction{reader.integer<std::int8_t>()};
+        break;
+    default:
+        return false;
+    }
+    return reader.ok();
+}
+
+static_assert(std::variant_size_v<ActionPayload> == 8, "update writeAction/readAction");
+
+bool fail(std::string *error, const char *message) {
+    if (error) { *error = message; }
+    return false;
+}
+
+}
+
+bool writeReplay(std::ostream &stream, const BattleReplay &replay) {
+    const auto participants = replay.initialParticipants.size();
+    if (replay.enemy.size() != participants || replay.finalParticipants.size() != participants) {
+        return false;
+    }
+    Writer writer;
+    writer.bytes(Magic, sizeof(Magic));
+    writer.byte(ReplayFileVersion);
+    writer.varint(sizeof(CharacterData));
+    writer.varint(replay.actions.keyframeInterval());
+    writer.byte((replay.won ? FlagWon : 0) | (replay.committed ? FlagCommitted : 0));
+    writer.fixed64(replay.initialIntegrity);
+    writer.fixed64(replay.finalIntegrity);
+
+    writer.varint(participants);
+    for (std::size_t index = 0; index < participants; index += 8) {
+        std::uint8_t bits = 0;
+        for (std::size_t bit = 0; bit < 8 && index + bit < participants; ++bit) {
+            if (replay.enemy[index + bit]) { bits |= std::uint8_t(1U << bit); }
+        }
+        writer.byte(bits);
+    }
+    writer.bytes(replay.initialParticipants.data(), participants * sizeof(CharacterData));
+    writeInventory(writer, replay.initialInventory);
+
+    writer.varint(replay.randomCalls.size());
+    for (const auto &call: replay.randomCalls) {
+        writer.svarint(call.minimum);
+        writer.svarint(call.maximum);
+        writer.svarint(call.rawValue);
+        writer.svarint(call.result);
+    }
+    writer.varint(replay.settlementRandomBegin);
+
+    writer.varint(replay.actions.size());
+    auto state = replay.initialParticipants;
+    const auto *inventory = &replay.initialInventory;
+    InventorySnapshot lastInventory;
+    std::size_t randomCursor = 0;
+    const bool complete = replay.actions.forEach([&](const ActionRecord &record) {
+        if (record.participants.size() != participants) { return false; }
+        writeAction(writer, record.action);
+        writer.svarint(std::int64_t(record.randomBegin) - std::int64_t(randomCursor));
+        writer.svarint(std::int64_t(record.randomEnd) - std::int64_t(record.randomBegin));
+        randomCursor = record.randomEnd;
+        if (record.inventory == *inventory) {
+            writer.byte(0);
+        } else {
+            writer.byte(1);
+            writeInventory(writer, record.inventory);
+            lastInventory = record.inventory;
+            inventory = &lastInventory;
+        }
+        writeDeltas(writer, state, record.participants);
+        state = record.participants;
+        writer.fixed64(record.integrity);
+        return true;
+    });
+    if (!complete) { return false; }
+    writeDeltas(writer, state, replay.finalParticipants);
+    writeInventory(writer, replay.finalInventory);
+
+    auto &buffer = writer.buffer();
+    const auto sum = checksum(buffer.data(), buffer.size());
+    writer.fixed64(sum);
+    stream.write(buffer.data(), std::streamsize(buffer.size()));
+    return bool(stream);
+}
+
+bool readReplay(std::istream &stream, BattleReplay &replay, std::string *error) {
+    const std::string data{std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>()};
+    if (data.size() < sizeof(Magic) + 1 + sizeof(std::uint64_t)
+        || std::memcmp(data.data(), Magic, sizeof(Magic)) != 0) {
+        return fail(error, "not a replay file");
+    }
+    if (static_cast<std::uint8_t>(data[sizeof(Magic)]) != ReplayFileVersion) {
+        return fail(error, "unsupported replay version");
+    }
+    const auto bodySize = data.size() - sizeof(std::uint64_t);
+    Reader trailer(data.data() + bodySize, sizeof(std::uint64_t));
+    if (trailer.fixed64() != checksum(data.data(), bodySize)) {
+        return fail(error, "replay checksum mismatch");
+    }
+
+    Reader reader(data.data() + sizeof(Magic) + 1, bodySize - sizeof(Magic) - 1);
+    if (reader.varint() != sizeof(CharacterData)) {
+        return fail(error, "replay character layout mismatch");
+    }
+    BattleReplay result;
+    result.actions = ActionLog(reader.integer<std::size_t>());
+    const auto flags = reader.byte();
+    result.won = (flags & FlagWon) != 0;
+    result.committed = (flags & FlagCommitted) != 0;
+    result.initialIntegrity = reader.fixed64();
+    result.finalIntegrity = reader.fixed64();
+
+    const auto participants = reader.count();
+    result.enemy.resize(participants);
+    for (std::size_t index = 0; index < participants; index += 8) {
+        const auto bits = reader.byte();
+        for (std::size_t bit = 0; bit < 8 && index + bit < participants; ++bit) {
+            result.enemy[index + bit] = (bits >> bit) & 1;
+        }
+    }
+    if (!reader.ok() || reader.remaining() / sizeof(CharacterData) < participants) {
+        return fail(error, "truncated replay");
+    }
+    result.initialParticipants.resize(participants);
+    reader.bytes(result.initialParticipants.data(), participants * sizeof(CharacterData));
+    if (!readInventory(reader, result.initialInventory)) {
+        return fail(error, "truncated replay");
+    }
+
+    result.randomCalls.resize(reader.count());
+    for (auto &call: result.randomCalls) {
+        call.minimum = reader.integer<int>();
+        call.maximum = reader.integer<int>();
+        call.rawValue = reader.svarint();
+        call.result = reader.integer<int>();
+    }
+    result.settlementRandomBegin = reader.integer<std::size_t>();
+
+    const auto actions = reader.count();
+    result.actions.reset(result.initialParticipants, result.initialInventory);
+    ActionRecord record;
+    record.participants = result.initialParticipants;
+    record.inventory = result.initialInventory;
+    std::size_t randomCursor = 0;
+    for (std::size_t index = 0; index < actions; ++index) {
+        if (!readAction(reader, record.action)) {
+            return fail(error, "malformed replay action");
+        }
+        /* The cursor stays within 32 bits, so neither sum can overflow */
+        constexpr std::int64_t RandomLimit = std::numeric_limits<std::uint32_t>::max();
+        const auto beginDelta = reader.svarint();
+        const auto endDelta = reader.svarint();
+        if (beginDelta < -std::int64_t(randomCursor) || beginDelta > RandomLimit - std::int64_t(randomCursor)) {
+            return fail(error, "malformed replay action");
+        }
+        const auto begin = std::int64_t(randomCursor) + beginDelta;
+        if (endDelta < 0 || endDelta > RandomLimit - begin) {
+            return fail(error, "malformed replay action");
+        }
+        record.randomBegin = std::size_t(begin);
+        record.randomEnd = randomCursor = std::size_t(begin + endDelta);
+        if (reader.byte() != 0 && !readInventory(reader, record.inventory)) {
+            return fail(error, "truncated replay");
+        }
+        if (!readDeltas(reader, record.participants)) {
+            return fail(error, "malformed replay action");
+        }
+        record.integrity = reader.fixed64();
+        if (!reader.ok()) {
+            return fail(error, "truncated replay");
+        }
+        if (!result.actions.canAppend(record)) {
+            return fail(error, "malformed replay action");
+        }
+        result.actions.append(record);
+    }
+    result.finalParticipants = record.participants;
+    if (!readDeltas(reader, result.finalParticipants)
+        || !readInventory(reader, result.finalInventory)) {
+        return fail(error, "truncated replay");
+    }
+    if (reader.remaining() != 0) {
+        return fail(error, "trailing data in replay");
+    }
+    replay = std::move(result);
+    return true;
+}
+
+bool saveReplay(const std::string &filename, const BattleReplay &replay) {
+    const auto directory = std::filesystem::path(filename).parent_path();
+    std::error_code ec;
+    if (!directory.empty() && !std::filesystem::create_directories(directory, ec) && ec) {
+        return false;
+    }
+    /* a verifier scanning the directory never sees a half written file */
+    const auto temporary = filename + ".tmp";
+    bool written;
+    {
+        std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+        written = stream && writeReplay(stream, replay) && stream.flush();
+    }
+    if (!written || std::rename(temporary.c_str(), filename.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool loadReplay(const std::string &filename, BattleReplay &replay, std::string *error) {
+    std::ifstream stream(filename, std::ios::binary);
+    if (!stream) {
+        return fail(error, "cannot open replay");
+    }
+    return readReplay(stream, replay, error);
+}
+
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "engine.hh"
+
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+
+namespace hojy::battle {
+
+// Binary form of a BattleReplay.  Counts and small integers are varints, the
+// initial participants are stored once and every action after that carries
+// only the 16-bit words it changed, like ActionLog does in memory.  The file
+// ends with a checksum so a damaged file is told apart from a replay that no
+// longer verifies.  Character state is stored in host byte order, as in the
+// save files.
+inline constexpr std::uint8_t ReplayFileVersion = 1;
+inline constexpr const char *ReplayFileExtension = ".hjr";
+
+bool writeReplay(std::ostream &stream, const BattleReplay &replay);
+bool readReplay(std::istream &stream, BattleReplay &replay, std::string *error = nullptr);
+
+bool saveReplay(const std::string &filename, const BattleReplay &replay);
+bool loadReplay(const std::string &filename, BattleReplay &replay, std::string *error = nullptr);
+
+}
@@ -0,0 +1,145 @@
+#include "selectable_cells.hh"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace hojy::battle {
+
+void SelectableCells::reset(int width, int height) {
+    clear();
+    if (width <= 0 || height <= 0
+        || width > std::numeric_limits<int>::max() / height) {
+        return;
+    }
+    if (width != width_ || height != height_) {
+        width_ = width;
+        height_ = height;
+        const auto size = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+        stamps_.assign(size, 0);
+        slots_.resize(size);
+    }
+    entries_.reserve(stamps_.size());
+    order_.reserve(stamps_.size());
+}
+
+void SelectableCells::clear() {
+    entries_.clear();
+    order_.clear();
+    sorted_ = true;
+    positionsValid_ = false;
+    if (++generation_ == 0) {
+        std::fill(stamps_.begin(), stamps_.end(), 0);
+        generation_ = 1;
+    }
+}
+
+SelectableCell &SelectableCells::operator[](key_type key) {
+    if (auto *cell = lookup(key)) { return *cell; }
+    auto slot = slotOf(key);
+    if (slot < 0) {
+        grow(key);
+        slot = slotOf(key);
+    }
+    const auto index = static_cast<std::uint32_t>(entries_.size());
+    if (sorted_ && !order_.empty() && key < entries_[order_.back()].first) {
+        sorted_ = false;
+    }
+    entries_.emplace_back(key, SelectableCell{});
+    order_.push_back(index);
+    positionsValid_ = false;
+    stamps_[slot] = generation_;
+    slots_[slot] = index;
+    return entries_.back().second;
+}
+
+SelectableCell &SelectableCells::at(key_type key) {
+    if (auto *cell = lookup(key)) { return *cell; }
+    throw std::out_of_range("selectable cell not found");
+}
+
+const SelectableCell &SelectableCells::at(key_type key) const {
+    if (const auto *cell = lookup(key)) { return *cell; }
+    throw std::out_of_range("selectable cell not found");
+}
+
+SelectableCell *SelectableCells::lookup(key_type key) noexcept {
+    const auto slot = slotOf(key);
+    if (slot < 0 || stamps_[slot] != generation_) { return nullptr; }
+    return &entries_[slots_[slot]].second;
+}
+
+const SelectableCell *SelectableCells::lookup(key_type key) const noexcept {
+    const auto slot = slotOf(key);
+    if (slot < 0 || stamps_[slot] != generation_) { return nullptr; }
+    return &entries_[slots_[slot]].second;
+}
+
+SelectableCells::iterator SelectableCells::find(key_type key) {
+    const auto slot = slotOf(key);
+    if (slot < 0 || stamps_[slot] != generation_) { return end(); }
+    return {order_.data() + positionOf(slot), entries_.data()};
+}
+
+SelectableCells::const_iterator SelectableCells::find(key_type key) const {
+    const auto slot = slotOf(key);
+    if (slot < 0 || stamps_[slot] != generation_) { return end(); }
+    return {order_.data() + positionOf(slot), entries_.data()};
+}
+
+int SelectableCells::slotOf(key_type key) const noexcept {
+    if (key.first < 0 || key.first >= width_ || key.second < 0 || key.second >= height_) {
+        return -1;
+    }
+    return key.second * width_ + key.first;
+}
+
+void SelectableCells::grow(key_type key) {
+    if (key.first < 0 || key.second < 0
+        || key.first == std::numeric_limits<int>::max()
+        || key.second == std::numeric_limits<int>::max()) {
+        throw std::out_of_range("selectable cell out of range");
+    }
+    const auto width = std::max(width_, key.first + 1);
+    const auto height = std::max(height_, key.second + 1);
+    if (width > std::numeric_limits<int>::max() / height) {
+        throw std::out_of_range("selectable cell out of range");
+    }
+    /* Entries keep their storage, only the slot grid is rebuilt */
+    width_ = width;
+    height_ = height;
+    const auto size = static_cast<std::size_t>(width) * static_cast<std::size_t>(height);
+    stamps_.assign(size, 0);
+    slots_.resize(size);
+    entries_.reserve(size);
+    order_.reserve(size);
+    for (std::uint32_t index = 0; index < entries_.size(); ++index) {
+        const auto slot = slotOf(entries_[index].first);
+        stamps_[slot] = generation_;
+        slots_[slot] = index;
+    }
+}
+
+void SelectableCells::sort() const {
+    if (!sorted_) {
+        std::sort(order_.begin(), order_.end(), [this](std::uint32_t left, std::uint32_t right) {
+            return entries_[left].first < entries_[right].first;
+        });
+        sorted_ = true;
+        positionsValid_ = false;
+    }
+}
+
+std::uint32_t SelectableCells::positionOf(int slot) const {
+    sort();
+    if (!positionsValid_) {
+        positions_.resize(order_.size());
+        for (std::uint32_t pos = 0; pos < order_.size(); ++pos) {
+            positions_[order_[pos]] = pos;
+        }
+        positionsValid_ = true;
+    }
+    return positions_[slots_[slot]];
+}
+
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace hojy::battle {
+
+struct SelectableCell {
+    int x = 0;
+    int y = 0;
+    int moves = -1;
+    int ranges = 0;
+    /* Keys of the cells this one was reached from, NoParent for none */
+    std::pair<int, int> moveParent = NoParent;
+    std::pair<int, int> rangeParent = NoParent;
+
+    static constexpr std::pair<int, int> NoParent {-1, -1};
+};
+
+/* Grid-backed replacement for std::map<std::pair<int, int>, SelectableCell>.
+ * Slots are stamped with a generation so clear() is O(1), and iteration
+ * visits cells in (x, y) order like the map did, which the position choosers
+ * rely on for their tie breaks. Cell addresses stay valid while inserting
+ * inside the grid given to reset(); a key outside it grows the grid and may
+ * move every cell, which is why cells refer to their parents by key. */
+class SelectableCells {
+public:
+    using key_type = std::pair<int, int>;
+    using mapped_type = SelectableCell;
+    using value_type = std::pair<const key_type, SelectableCell>;
+    using size_type = std::size_t;
+
+    template<typename Value>
+    class Iterator {
+        friend class SelectableCells;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::remove_const_t<Value>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Value *;
+        using reference = Value &;
+
+        Iterator() = default;
+        template<typename Other, typename = std::enable_if_t<std::is_const_v<Value> && !std::is_const_v<Other>>>
+        Iterator(const Iterator<Other> &other): pos_(other.pos_), entries_(other.entries_) {}
+
+        reference operator*() const { return entries_[*pos_]; }
+        pointer operator->() const { return &entries_[*pos_]; }
+        Iterator &operator++() { ++pos_; return *this; }
+        Iterator operator++(int) { auto result = *this; ++pos_; return result; }
+        template<typename Other>
+        bool operator==(const Iterator<Other> &other) const { return pos_ == other.pos_; }
+        template<typename Other>
+        bool operator!=(const Iterator<Other> &other) const { return pos_ != other.pos_; }
+
+    private:
+        Iterator(const std::uint32_t *pos, Value *entries): pos_(pos), entries_(entries) {}
+
+        template<typename> friend class Iterator;
+        const std::uint32_t *pos_ = nullptr;
+        Value *entries_ = nullptr;
+    };
+    using iterator = Iterator<value_type>;
+    using const_iterator = Iterator<const value_type>;
+
+    SelectableCells() = default;
+
+    /* Clears and sizes the grid for a width x height battlefield */
+    void reset(int width, int height);
+    void clear();
+    [[nodiscard]] bool empty() const noexcept { return entries_.empty(); }
+    [[nodiscard]] size_type size() const noexcept { return entries_.size(); }
+
+    SelectableCell &operator[](key_type key);
+    SelectableCell &at(key_type key);
+    [[nodiscard]] const SelectableCell &at(key_type key) const;
+    /* O(1) lookups that never reorder, nullptr when the cell is absent */
+    [[nodiscard]] SelectableCell *lookup(key_type key) noexcept;
+    [[nodiscard]] const SelectableCell *lookup(key_type key) const noexcept;
+    [[nodiscard]] bool contains(key_type key) const noexcept { return lookup(key) != nullptr; }
+    [[nodiscard]] size_type count(key_type key) const noexcept { return contains(key) ? 1 : 0; }
+    iterator find(key_type key);
+    [[nodiscard]] const_iterator find(key_type key) const;
+
+    iterator begin() { sort(); return {order_.data(), entries_.data()}; }
+    iterator end() { return {order_.data() + order_.size(), entries_.data()}; }
+    [[nodiscard]] const_iterator begin() const { sort(); return {order_.data(), entries_.data()}; }
+    [[nodiscard]] const_iterator end() const { return {order_.data() + order_.size(), entries_.data()}; }
+
+private:
+    [[nodiscard]] int slotOf(key_type key) const noexcept;
+    void grow(key_type key);
+    void sort() const;
+    [[nodiscard]] std::uint32_t positionOf(int slot) const;
+
+private:
+    int width_ = 0, height_ = 0;
+    std::uint32_t generation_ = 1;
+    std::vector<std::uint32_t> stamps_;
+    std::vector<std::uint32_t> slots_;
+    std::vector<value_type> entries_;
+    /* Entry indices in insertion order until sort() puts them in key order */
+    mutable std::vector<std::uint32_t> order_;
+    mutable std::vector<std::uint32_t> positions_;
+    mutable bool sorted_ = true;
+    mutable bool positionsValid_ = false;
+};
+
+}
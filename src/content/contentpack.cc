@@ -0,0 +1,515 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "contentpack.hh"
+
+#include "atomic_file.hh"
+#include "grparchive.hh"
+#include "palette.hh"
+#include "util/conv.hh"
+#include "util/file.hh"
+#include "util/mappedfile.hh"
+#include <external/toml.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <new>
+#include <utility>
+
+namespace hojy::content {
+
+ContentPack gContentPack;
+
+namespace {
+
+constexpr char Magic[8] = {'H', 'O', 'J', 'Y', 'P', 'A', 'C', 'K'};
+
+constexpr std::array<const char *, 12> SourceNames = {
+    "TALK.IDX", "TALK.GRP", "KDEF.IDX", "KDEF.GRP", "strings.toml",
+    "MMAP.IDX", "MMAP.GRP", "EARTH.002", "SURFACE.002", "BUILDING.002",
+    "MMAP.COL", "ENDCOL.COL",
+};
+
+struct PackHeader {
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t sourceCount;
+    std::uint32_t sectionCount;
+    std::uint32_t reserved;
+    /* Covers everything after the header */
+    std::uint64_t checksum;
+};
+
+/* The stamp is compared first, the hash only when the modification time moved */
+struct PackSource {
+    char name[16];
+    std::uint64_t size;
+    std::int64_t mtime;
+    std::uint64_t hash;
+};
+
+struct PackSection {
+    std::uint32_t offset;
+    std::uint32_t size;
+};
+
+constexpr std::size_t PaletteSize = 256 * sizeof(std::uint32_t);
+
+/* FNV-1a over 64-bit words, folded back so that every byte reaches the low bits */
+std::uint64_t hashBytes(const char *data, std::size_t size) {
+    constexpr std::uint64_t Prime = 1099511628211ULL;
+    std::uint64_t hash = 14695981039346656037ULL;
+    std::size_t i = 0;
+    for (; i + sizeof(std::uint64_t) <= size; i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        hash = (hash ^ word) * Prime;
+        hash ^= hash >> 32U;
+    }
+    for (; i < size; ++i) {
+        hash = (hash ^ static_cast<std::uint8_t>(data[i])) * Prime;
+    }
+    return hash ^ size;
+}
+
+bool stampFile(const std::string &path, std::uint64_t &size, std::int64_t &mtime) {
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec) { return false; }
+    const auto time = std::filesystem::last_write_time(path, ec);
+    if (ec) { return false; }
+    mtime = static_cast<std::int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+bool hashFile(const std::string &path, std::uint64_t &size, std::uint64_t &hash) {
+    util::MappedFile mapped;
+    if (mapped.open(path)) {
+        size = mapped.size();
+        hash = hashBytes(reinterpret_cast<const char*>(mapped.data()), mapped.size());
+        return true;
+    }
+    /* MappedFile refuses empty files */
+    auto file = util::File::open(path);
+    if (!file || file.size() != 0) { return false; }
+    size = 0;
+    hash = hashBytes(nullptr, 0);
+    return true;
+}
+
+std::uint32_t readUint32(std::string_view data, std::size_t offset) {
+    std::uint32_t value = 0;
+    memcpy(&value, data.data() + offset, sizeof(value));
+    return value;
+}
+
+void appendUint32(std::string &out, std::uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void appendUtf32(std::string &out, std::wstring_view str) {
+    for (std::size_t i = 0; i < str.size(); ++i) {
+        auto ch = static_cast<std::uint32_t>(str[i]);
+        if constexpr (sizeof(wchar_t) == 2) {
+            if (ch >= 0xD800U && ch < 0xDC00U && i + 1 < str.size()) {
+                const auto low = static_cast<std::uint32_t>(str[i + 1]);
+                if (low >= 0xDC00U && low < 0xE000U) {
+                    ch = 0x10000U + ((ch - 0xD800U) << 10U) + (low - 0xDC00U);
+                    ++i;
+                }
+            }
+        }
+        appendUint32(out, ch);
+    }
+}
+
+/* uint32 count, uint32 offsets[count + 1] into the data that follows */
+std::string encodeTable(const std::vector<std::string> &entries) {
+    std::string out;
+    std::size_t total = 0;
+    for (const auto &entry: entries) { total += entry.size(); }
+    out.reserve((entries.size() + 2) * sizeof(std::uint32_t) + total);
+    appendUint32(out, static_cast<std::uint32_t>(entries.size()));
+    std::uint32_t offset = 0;
+    appendUint32(out, offset);
+    for (const auto &entry: entries) {
+        offset += static_cast<std::uint32_t>(entry.size());
+        appendUint32(out, offset);
+    }
+    for (const auto &entry: entries) { out += entry; }
+    return out;
+}
+
+bool validateTable(std::string_view table, std::size_t unit) {
+    if (table.size() < sizeof(std::uint32_t) * 2) { return false; }
+    const auto count = std::size_t(readUint32(table, 0));
+    if (count > table.size() / sizeof(std::uint32_t) - 2) { return false; }
+    const auto dataSize = table.size() - (count + 2) * sizeof(std::uint32_t);
+    std::uint32_t last = 0;
+    for (std::size_t i = 0; i <= count; ++i) {
+        const auto offset = readUint32(table, (i + 1) * sizeof(std::uint32_t));
+        if (offset < last || offset > dataSize || offset % unit != 0) { return false; }
+        last = offset;
+    }
+    return true;
+}
+
+bool readSource(const ContentPack::PathResolver &resolve, const char *name, std::string &content,
+                std::string &error) {
+    auto file = util::File::open(resolve(name));
+    if (!file) {
+        error = std::string("cannot open ") + name;
+        return false;
+    }
+    content.assign(static_cast<std::size_t>(file.size()), '\0');
+    if (!content.empty() && file.read(content.data(), content.size()) != content.size()) {
+        error = std::string("cannot read ") + name;
+        return false;
+    }
+    return true;
+}
+
+bool openArchive(const ContentPack::PathResolver &resolve, const std::string &name, GrpArchive &archive,
+                 std::string &error) {
+    if (archive.openFiles(resolve(name + ".IDX"), resolve(name + ".GRP"))) { return true; }
+    error = "cannot open " + name + ".IDX/" + name + ".GRP";
+    return false;
+}
+
+bool buildTalks(const ContentPack::PathResolver &resolve, std::string &big5, std::string &traditional,
+                std::string &simplified, std::string &error) {
+    GrpArchive archive;
+    if (!openArchive(resolve, "TALK", archive, error)) { return false; }
+    const auto count = archive.size();
+    std::vector<std::string> original(count), trad(count), simp(count);
+    for (std::size_t i = 0; i < count; ++i) {
+        auto t = std::string(archive[i]);
+        for (auto &c: t) {
+            if (c) { c = static_cast<char>(~static_cast<unsigned char>(c)); }
+        }
+        /* Conversion stops at the first terminator, like the runtime does */
+        const auto text = util::big5Conv.toUnicode(t.c_str());
+        appendUtf32(trad[i], text);
+        appendUtf32(simp[i], util::trad2SimpConv.convert(text));
+        original[i] = std::move(t);
+    }
+    big5 = encodeTable(original);
+    traditional = encodeTable(trad);
+    simplified = encodeTable(simp);
+    return true;
+}
+
+bool buildStrings(const ContentPack::PathResolver &resolve, std::string &traditional,
+                  std::string &simplified, std::string &error) {
+    std::string content;
+    if (!readSource(resolve, "strings.toml", content, error)) { return false; }
+    toml::table tbl;
+    try {
+        tbl = toml::parse(content);
+    } catch (const toml::parse_error &err) {
+        error = "cannot parse strings.toml: " + std::string(err.description());
+        return false;
+    }
+    auto arr = tbl["strings"].as_array();
+    if (!arr) {
+        error = "strings.toml has no strings array";
+        return false;
+    }
+    std::vector<std::string> trad, simp;
+    trad.reserve(arr->size());
+    simp.reserve(arr->size());
+    for (auto &n: *arr) {
+        const auto str = util::Utf8Conv::toUnicode(n.value_or<std::string>(""));
+        trad.emplace_back();
+        appendUtf32(trad.back(), str);
+        simp.emplace_back();
+        /* allow traditional chinese chars in default user name */
+        appendUtf32(simp.back(), simp.size() == 1 ? str : util::trad2SimpConv.convert(str));
+    }
+    traditional = encodeTable(trad);
+    simplified = encodeTable(simp);
+    return true;
+}
+
+bool buildEvents(const ContentPack::PathResolver &resolve, std::string &events, std::string &error) {
+    GrpArchive archive;
+    if (!openArchive(resolve, "KDEF", archive, error)) { return false; }
+    std::vector<std::string> programs(archive.size());
+    for (std::size_t i = 0; i < programs.size(); ++i) {
+        if (archive[i].size() % sizeof(std::int16_t) != 0) {
+            error = "KDEF entry " + std::to_string(i) + " has an odd size";
+            return false;
+        }
+        programs[i] = archive[i];
+    }
+    events = encodeTable(programs);
+    return true;
+}
+
+bool buildGlobalCells(const ContentPack::PathResolver &resolve, std::string &cells, std::string &error) {
+    GrpArchive textures;
+    if (!openArchive(resolve, "MMAP", textures, error)) { return false; }
+    std::vector<std::uint16_t> earth, surface, building;
+    if (!util::File::getFileContent(resolve("EARTH.002"), earth)
+        || !util::File::getFileContent(resolve("SURFACE.002"), surface)
+        || !util::File::getFileContent(resolve("BUILDING.002"), building)) {
+        error = "cannot read the global map layers";
+        return false;
+    }
+    std::vector<GlobalCell> classified;
+    if (!classifyGlobalCells(textures, earth, surface, building, classified)) {
+        error = "cannot classify the global map cells";
+        return false;
+    }
+    cells.assign(reinterpret_cast<const char*>(classified.data()), classified.size() * sizeof(GlobalCell));
+    return true;
+}
+
+bool buildPalettes(const ContentPack::PathResolver &resolve, std::string &palettes, std::string &error) {
+    palettes.clear();
+    for (const auto *name: {"MMAP.COL", "ENDCOL.COL"}) {
+        std::string raw;
+        std::array<std::uint32_t, 256> colors {};
+        if (!readSource(resolve, name, raw, error)) { return false; }
+        if (!decodePalette(raw, colors)) {
+            error = std::string("palette is too short: ") + name;
+            return false;
+        }
+        palettes.append(reinterpret_cast<const char*>(colors.data()), PaletteSize);
+    }
+    return true;
+}
+
+}
+
+bool ContentPack::build(const PathResolver &resolve, std::string &image, std::string &error) {
+    try {
+        std::array<PackSource, SourceNames.size()> sources {};
+        for (std::size_t i = 0; i < SourceNames.size(); ++i) {
+            auto &source = sources[i];
+            strncpy(source.name, SourceNames[i], sizeof(source.name) - 1);
+            const auto path = resolve(SourceNames[i]);
+            std::uint64_t hashedSize;
+            if (!stampFile(path, source.size, source.mtime)
+                || !hashFile(path, hashedSize, source.hash) || hashedSize != source.size) {
+                error = std::string("cannot read ") + SourceNames[i];
+                return false;
+            }
+        }
+
+        std::array<std::string, SectionCount> data;
+        if (!buildTalks(resolve, data[TalkBig5], data[TalkTraditional], data[TalkSimplified], error)
+            || !buildStrings(resolve, data[StringsTraditional], data[StringsSimplified], error)
+            || !buildEvents(resolve, data[Events], error)
+            || !buildGlobalCells(resolve, data[GlobalCells], error)
+            || !buildPalettes(resolve, data[Palettes], error)) {
+            return false;
+        }
+
+        PackHeader header {};
+        memcpy(header.magic, Magic, sizeof(Magic));
+        header.version = Version;
+        header.sourceCount = static_cast<std::uint32_t>(sources.size());
+        header.sectionCount = SectionCount;
+        std::array<PackSection, SectionCount> sections {};
+        std::string out(sizeof(header) + sizeof(sources) + sizeof(sections), '\0');
+        for (std::size_t i = 0; i < SectionCount; ++i) {
+            /* Sections start 8-aligned, tables can be read in place */
+            out.resize((out.size() + 7U) & ~std::size_t(7U), '\0');
+            if (out.size() + data[i].size() > std::numeric_limits<std::uint32_t>::max()) {
+                error = "content pack exceeds 4 GiB";
+                return false;
+            }
+            sections[i] = {static_cast<std::uint32_t>(out.size()), static_cast<std::uint32_t>(data[i].size())};
+            out += data[i];
+            std::string().swap(data[i]);
+        }
+        memcpy(out.data() + sizeof(header), sources.data(), sizeof(sources));
+        memcpy(out.data() + sizeof(header) + sizeof(sources), sections.data(), sizeof(sections));
+        header.checksum = hashBytes(out.data() + sizeof(header), out.size() - sizeof(header));
+        memcpy(out.data(), &header, sizeof(header));
+        image = std::move(out);
+        return true;
+    } catch (const std::bad_alloc &) {
+        error = "not enough memory to build the content pack";
+        return false;
+    }
+}
+
+bool ContentPack::open(const std::string &filename) {
+    close();
+    auto mapped = std::make_shared<util::MappedFile>();
+    if (!mapped->open(filename)) { return false; }
+    const auto *data = reinterpret_cast<const char*>(mapped->data());
+    if (!validate(data, mapped->size())) { return false; }
+    data_ = std::shared_ptr<const char>(std::move(mapped), data);
+    return true;
+}
+
+bool ContentPack::adopt(std::string image) {
+    close();
+    auto owned = std::make_shared<std::string>(std::move(image));
+    const auto *data = owned->data();
+    if (!validate(data, owned->size())) { return false; }
+    data_ = std::shared_ptr<const char>(std::move(owned), data);
+    return true;
+}
+
+bool ContentPack::load(const std::string &filename, const PathResolver &resolve, std::string &error) {
+    if (!open(filename)) {
+        error = "cannot open " + filename;
+        return false;
+    }
+    if (!upToDate(resolve)) {
+        close();
+        error = filename + " does not match its source files";
+        return false;
+    }
+    return true;
+}
+
+bool ContentPack::rebuild(const std::string &filename, const PathResolver &resolve, std::string &error) {
+    std::string image;
+    if (!build(resolve, image, error)) { return false; }
+    if (!AtomicFile::write(filename, image)) {
+        error = "cannot write " + filename;
+        return false;
+    }
+    return true;
+}
+
+void ContentPack::close() {
+    data_.reset();
+    size_ = 0;
+    sections_ = {};
+}
+
+bool ContentPack::upToDate(const PathResolver &resolve) const {
+    if (!loaded()) { return false; }
+    PackHeader header;
+    memcpy(&header, data_.get(), sizeof(header));
+    for (std::uint32_t i = 0; i < header.sourceCount; ++i) {
+        PackSource source;
+        memcpy(&source, data_.get() + sizeof(header) + i * sizeof(source), sizeof(source));
+        const std::string name(source.name, std::find(source.name, source.name + sizeof(source.name), '\0'));
+        const auto path = resolve(name);
+        std::uint64_t size;
+        std::int64_t mtime;
+        if (!stampFile(path, size, mtime) || size != source.size) { return false; }
+        if (mtime == source.mtime) { continue; }
+        /* Touched, e.g. copied again, but maybe with the same content */
+        std::uint64_t hash;
+        if (!hashFile(path, size, hash) || size != source.size || hash != source.hash) { return false; }
+    }
+    return true;
+}
+
+std::string_view ContentPack::section(Section section) const {
+    return section < SectionCount ? sections_[section] : std::string_view();
+}
+
+std::size_t ContentPack::count(Section section) const {
+    const auto table = this->section(section);
+    return table.empty() ? 0 : readUint32(table, 0);
+}
+
+std::string_view ContentPack::entry(Section section, std::size_t index) const {
+    const auto table = this->section(section);
+    if (table.empty()) { return {}; }
+    const auto count = std::size_t(readUint32(table, 0));
+    if (index >= count) { return {}; }
+    const auto start = readUint32(table, (index + 1) * sizeof(std::uint32_t));
+    const auto end = readUint32(table, (index + 2) * sizeof(std::uint32_t));
+    return table.substr((count + 2) * sizeof(std::uint32_t) + start, end - start);
+}
+
+std::wstring ContentPack::text(Section section, std::size_t index) const {
+    const auto raw = entry(section, index);
+    const auto length = raw.size() / sizeof(std::uint32_t);
+    std::wstring result;
+    if constexpr (sizeof(wchar_t) == sizeof(std::uint32_t)) {
+        result.resize(length);
+        if (length) { memcpy(result.data(), raw.data(), length * sizeof(std::uint32_t)); }
+    } else {
+        result.reserve(length);
+        for (std::size_t i = 0; i < length; ++i) {
+            const auto ch = readUint32(raw, i * sizeof(std::uint32_t));
+            if (ch >= 0x10000U) {
+                result += static_cast<wchar_t>(0xD800U + ((ch - 0x10000U) >> 10U));
+                result += static_cast<wchar_t>(0xDC00U + ((ch - 0x10000U) & 0x3FFU));
+            } else {
+                result += static_cast<wchar_t>(ch);
+            }
+        }
+    }
+    return result;
+}
+
+bool ContentPack::globalCells(std::vector<GlobalCell> &cells) const {
+    const auto raw = section(GlobalCells);
+    if (raw.empty()) { return false; }
+    cells.resize(raw.size() / sizeof(GlobalCell));
+    memcpy(cells.data(), raw.data(), raw.size());
+    return true;
+}
+
+bool ContentPack::palette(PaletteId id, std::array<std::uint32_t, 256> &colors) const {
+    const auto raw = section(Palettes);
+    if (raw.empty() || id >= PaletteCount) { return false; }
+    memcpy(colors.data(), raw.data() + id * PaletteSize, PaletteSize);
+    return true;
+}
+
+bool ContentPack::validate(const char *data, std::size_t size) {
+    PackHeader header;
+    if (size < sizeof(header)) { return false; }
+    memcpy(&header, data, sizeof(header));
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0 || header.version != Version
+        || header.sectionCount != SectionCount || header.sourceCount > 64) {
+        return false;
+    }
+    const auto tablesSize = header.sourceCount * sizeof(PackSource) + SectionCount * sizeof(PackSection);
+    if (size - sizeof(header) < tablesSize
+        || hashBytes(data + sizeof(header), size - sizeof(header)) != header.checksum) {
+        return false;
+    }
+    std::array<std::string_view, SectionCount> sections;
+    const auto *table = data + sizeof(header) + header.sourceCount * sizeof(PackSource);
+    for (std::size_t i = 0; i < SectionCount; ++i) {
+        PackSection entry;
+        memcpy(&entry, table + i * sizeof(entry), sizeof(entry));
+        if (entry.offset % 8U != 0 || entry.offset > size || entry.size > size - entry.offset) { return false; }
+        sections[i] = std::string_view(data + entry.offset, entry.size);
+    }
+    for (auto s: {TalkBig5, StringsTraditional, StringsSimplified, TalkTraditional, TalkSimplified, Events}) {
+        const auto unit = s == TalkBig5 ? 1 : (s == Events ? sizeof(std::int16_t) : sizeof(std::uint32_t));
+        if (!validateTable(sections[s], unit)) { return false; }
+    }
+    if (sections[GlobalCells].size() != GlobalMapWidth * GlobalMapHeight * sizeof(GlobalCell)
+        || sections[Palettes].size() != PaletteCount * PaletteSize) {
+        return false;
+    }
+    sections_ = sections;
+    size_ = size;
+    return true;
+}
+
+}
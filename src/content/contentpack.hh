@@ -0,0 +1,107 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "globalcells.hh"
+
+#include <array>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace hojy::content {
+
+/* Data the game otherwise converts on every start, prepared once and mapped
+ * in place: talk and UI text as UTF-32 in both scripts, the KDEF programs
+ * with their index, the classified global map cells and the palettes.
+ * The pack records the size, modification time and hash of each source file
+ * it was built from.  A source with another modification time is hashed to
+ * tell a touched file from a changed one.  A pack whose sources changed is
+ * not used until makedata or rebuild() writes it again.  Bump Version
+ * whenever the layout or a conversion (the Big5 or Traditional to
+ * Simplified tables) changes. */
+class ContentPack final {
+public:
+    enum : std::uint32_t {
+        Version = 3,
+    };
+    enum Section : std::uint32_t {
+        /* Talk lines with the XOR undone, still in Big5 */
+        TalkBig5 = 0,
+        TalkTraditional,
+        TalkSimplified,
+        StringsTraditional,
+        StringsSimplified,
+        /* KDEF programs as 16-bit words */
+        Events,
+        /* GlobalCell[GlobalMapWidth * GlobalMapHeight] */
+        GlobalCells,
+        /* MMAP and ENDCOL, 256 colors each */
+        Palettes,
+        SectionCount,
+    };
+    enum PaletteId {
+        NormalPalette = 0,
+        EndPalette,
+        PaletteCount,
+    };
+    /* Returns the path of a data file, e.g. through core::Config::dataFilePath */
+    using PathResolver = std::function<std::string(const std::string &name)>;
+    static constexpr const char *DefaultName = "CONTENT.PAK";
+
+    [[nodiscard]] static bool build(const PathResolver &resolve, std::string &image, std::string &error);
+
+    /* Maps a pack and checks its layout and checksum, not its sources */
+    bool open(const std::string &filename);
+    /* Takes over an image built in memory */
+    bool adopt(std::string image);
+    /* Opens the pack if it is up to date with its sources, it is never built here */
+    bool load(const std::string &filename, const PathResolver &resolve, std::string &error);
+    /* Builds the pack from its sources and writes it */
+    [[nodiscard]] static bool rebuild(const std::string &filename, const PathResolver &resolve, std::string &error);
+    void close();
+    [[nodiscard]] bool upToDate(const PathResolver &resolve) const;
+    [[nodiscard]] bool loaded() const { return data_ != nullptr; }
+
+    [[nodiscard]] std::string_view section(Section section) const;
+    /* Talk, strings and events are tables of entries */
+    [[nodiscard]] std::size_t count(Section section) const;
+    /* Raw bytes of an entry, empty for indices out of range */
+    [[nodiscard]] std::string_view entry(Section section, std::size_t index) const;
+    /* An entry of a UTF-32 table */
+    [[nodiscard]] std::wstring text(Section section, std::size_t index) const;
+    [[nodiscard]] bool globalCells(std::vector<GlobalCell> &cells) const;
+    [[nodiscard]] bool palette(PaletteId id, std::array<std::uint32_t, 256> &colors) const;
+
+private:
+    bool validate(const char *data, std::size_t size);
+
+private:
+    std::shared_ptr<const char> data_;
+    std::size_t size_ = 0;
+    std::array<std::string_view, SectionCount> sections_ {};
+};
+
+extern ContentPack gContentPack;
+
+}
@@ -19,17 +19,54 @@
 
 #include "event.hh"
 
+#include "contentpack.hh"
 #include "grpdata.hh"
 #include "core/config.hh"
 #include "util/conv.hh"
 #include <cstring>
+#include <list>
+#include <mutex>
 #include <new>
+#include <unordered_map>
 #include <utility>
 
 namespace hojy::content {
 
 Event gEvent;
 
+struct Event::TalkCache {
+    struct Entry {
+        size_t index;
+        std::wstring text;
+    };
+
+    /* Converted outside the lock, a line converted twice meanwhile is kept once */
+    void store(size_t index, std::wstring text) {
+        std::unique_lock<std::mutex> lk(mutex);
+        if (capacity == 0 || lookup.find(index) != lookup.end()) { return; }
+        try {
+            entries.push_front(Entry {index, std::move(text)});
+            lookup.emplace(index, entries.begin());
+        } catch (const std::bad_alloc &) {
+            if (!entries.empty() && entries.front().index == index) { entries.pop_front(); }
+            return;
+        }
+        trimLocked();
+    }
+
+    void trimLocked() {
+        while (entries.size() > capacity) {
+            lookup.erase(entries.back().index);
+            entries.pop_back();
+        }
+    }
+
+    size_t capacity = 0;
+    std::list<Entry> entries;
+    std::unordered_map<size_t, std::list<Entry>::iterator> lookup;
+    mutable std::mutex mutex;
+};
+
 namespace {
 
 bool parseEvents(const std::string &name,
@@ -49,38 +86,29 @@ bool parseEvents(const std::string &name,
     return true;
 }
 
-bool parseTalks(const std::string &name, std::vector<std::string> &origTalks,
-                std::vector<std::wstring> &talks) {
-    GrpData::DataSet dset;
-    if (!GrpData::loadData(name, dset)) { return false; }
-    auto sz = dset.size();
-    std::vector<std::string> parsedOrig(sz);
-    std::vector<std::wstring> parsedTalks(sz);
-    for (size_t i = 0; i < sz; ++i) {
-        auto t = dset[i];
-        for (auto &c: t) {
-            if (c) { c = static_cast<char>(~static_cast<unsigned char>(c)); }
-        }
-        parsedOrig[i] = t;
-        parsedTalks[i] = util::big5Conv.toUnicode(t.c_str());
+std::string invertTalk(std::string_view raw) {
+    std::string t(raw);
+    for (auto &c: t) {
+        if (c) { c = static_cast<char>(~static_cast<unsigned char>(c)); }
     }
-    if (core::config.simplifiedChinese()) {
-        for (auto &t: parsedTalks) {
-            t = util::trad2SimpConv.convert(t);
-        }
-    }
-    origTalks = std::move(parsedOrig);
-    talks = std::move(parsedTalks);
-    return true;
+    return t;
 }
 
 }
 
+Event::Event(): talkCache_(std::make_unique<TalkCache>()) {
+}
+
+Event::~Event() = default;
+Event::Event(Event &&other) noexcept = default;
+Event &Event::operator=(Event &&other) noexcept = default;
+
 bool Event::loadEvent(const std::string &name) {
     try {
         std::vector<std::vector<std::int16_t>> events;
         if (!parseEvents(name, events)) { return false; }
         events_ = std::move(events);
+        programs_.assign(events_.size(), nullptr);
         return true;
     } catch (const std::bad_alloc &) {
         return false;
@@ -88,30 +116,44 @@ bool Event::loadEvent(const std::string &name) {
 }
 
 bool Event::loadTalk(const std::string &name) {
+    GrpArchive talks;
+    if (!talks.open(name)) { return false; }
+    resetTalks(std::move(talks), nullptr, 0);
+    return true;
+}
+
+bool Event::load(const std::string &eventName, const std::string &talkName) {
     try {
-        std::vector<std::string> origTalks;
-        std::vector<std::wstring> talks;
-        if (!parseTalks(name, origTalks, talks)) { return false; }
-        origTalks_ = std::move(origTalks);
-        talks_ = std::move(talks);
+        std::vector<std::vector<std::int16_t>> events;
+        GrpArchive talks;
+        if (!parseEvents(eventName, events) || !talks.open(talkName)) {
+            return false;
+        }
+        events_ = std::move(events);
+        programs_.assign(events_.size(), nullptr);
+        resetTalks(std::move(talks), nullptr, 0);
         return true;
     } catch (const std::bad_alloc &) {
         return false;
     }
 }
 
-bool Event::load(const std::string &eventName, const std::string &talkName) {
+bool Event::load(const ContentPack &pack) {
+    if (!pack.loaded()) { return false; }
     try {
-        std::vector<std::vector<std::int16_t>> events;
-        std::vector<std::string> origTalks;
-        std::vector<std::wstring> talks;
-        if (!parseEvents(eventName, events)
-            || !parseTalks(talkName, origTalks, talks)) {
-            return false;
+        const auto eventCount = pack.count(ContentPack::Events);
+        std::vector<std::vector<std::int16_t>> events(eventCount);
+        for (size_t i = 0; i < eventCount; ++i) {
+            const auto raw = pack.entry(ContentPack::Events, i);
+            events[i].resize(raw.size() / sizeof(std::int16_t));
+            if (!raw.empty()) {
+                memcpy(events[i].data(), raw.data(), raw.size());
+            }
         }
         events_ = std::move(events);
-        origTalks_ = std::move(origTalks);
-        talks_ = std::move(talks);
+        programs_.assign(events_.size(), nullptr);
+        resetTalks(GrpArchive(), &pack, core::config.simplifiedChinese()
+            ? ContentPack::TalkSimplified : ContentPack::TalkTraditional);
         return true;
     } catch (const std::bad_alloc &) {
         return false;
@@ -126,20 +168,85 @@ const std::vector<std::int16_t> &Event::event(size_t index) const {
     return empty;
 }
 
-const std::string &Event::origTalk(size_t index) const {
-    if (index < origTalks_.size()) {
-        return origTalks_[index];
+std::shared_ptr<const LegacyProgram> Event::program(size_t index, const LegacyProgram::Decoder &decoder) const {
+    if (index >= events_.size()) {
+        static const auto empty = std::make_shared<const LegacyProgram>();
+        return empty;
     }
-    static std::string empty;
-    return empty;
+    auto &program = programs_[index];
+    if (!program) {
+        auto decoded = std::make_shared<LegacyProgram>(events_[index]);
+        decoded->decode(decoder);
+        program = std::move(decoded);
+    }
+    return program;
+}
+
+size_t Event::talkCount() const {
+    if (pack_) { return pack_->count(static_cast<ContentPack::Section>(packSection_)); }
+    return talks_.size();
+}
+
+std::string Event::origTalk(size_t index) const {
+    if (pack_) { return std::string(pack_->entry(ContentPack::TalkBig5, index)); }
+    return invertTalk(talks_.at(index));
+}
+
+std::wstring Event::talk(size_t index) const {
+    if (index >= talkCount()) { return {}; }
+    auto &cache = *talkCache_;
+    {
+        std::unique_lock<std::mutex> lk(cache.mutex);
+        auto it = cache.lookup.find(index);
+        if (it != cache.lookup.end()) {
+            cache.entries.splice(cache.entries.begin(), cache.entries, it->second);
+            return it->second->text;
+        }
+    }
+    auto text = convertTalk(index);
+    cache.store(index, text);
+    return text;
 }
 
-const std::wstring &Event::talk(size_t index) const {
-    if (index < talks_.size()) {
-        return talks_[index];
+void Event::prefetchTalk(size_t index) const {
+    if (index >= talkCount()) { return; }
+    auto &cache = *talkCache_;
+    {
+        std::unique_lock<std::mutex> lk(cache.mutex);
+        if (cache.capacity == 0 || cache.lookup.find(index) != cache.lookup.end()) { return; }
     }
-    static std::wstring empty;
-    return empty;
+    cache.store(index, convertTalk(index));
+}
+
+void Event::setTalkCacheCapacity(size_t count) {
+    std::unique_lock<std::mutex> lk(talkCache_->mutex);
+    talkCache_->capacity = count;
+    talkCache_->trimLocked();
+}
+
+size_t Event::talkCacheCount() const {
+    std::unique_lock<std::mutex> lk(talkCache_->mutex);
+    return talkCache_->entries.size();
+}
+
+void Event::resetTalks(GrpArchive talks, const ContentPack *pack, int packSection) {
+    talks_ = std::move(talks);
+    pack_ = pack;
+    packSection_ = packSection;
+    simplified_ = core::config.simplifiedChinese();
+    std::unique_lock<std::mutex> lk(talkCache_->mutex);
+    talkCache_->entries.clear();
+    talkCache_->lookup.clear();
+    talkCache_->capacity = static_cast<size_t>(core::config.talkCacheSize());
+}
+
+std::wstring Event::convertTalk(size_t index) const {
+    if (pack_) { return pack_->text(static_cast<ContentPack::Section>(packSection_), index); }
+    const auto big5 = invertTalk(talks_[index]);
+    /* Lines end at the first NUL, whatever padding follows is not text */
+    auto text = util::big5Conv.toUnicode(big5.c_str());
+    if (simplified_) { text = util::trad2SimpConv.convert(text); }
+    return text;
 }
 
 }
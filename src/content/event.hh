@@ -19,26 +19,63 @@
 
 #pragma once
 
+#include "grparchive.hh"
+#include "legacyprogram.hh"
+
+#include <memory>
 #include <vector>
 #include <string>
 #include <cstdint>
 
 namespace hojy::content {
 
+class ContentPack;
+
+/* Talk lines stay as they are stored, in TALK or in the content pack, and
+ * are converted for display the first time they are asked for.  The most
+ * recently used lines are kept converted, up to the configured count. */
 class Event {
 public:
+    Event();
+    ~Event();
+    Event(Event &&other) noexcept;
+    Event &operator=(Event &&other) noexcept;
+
     [[nodiscard]] bool loadEvent(const std::string &name);
     [[nodiscard]] bool loadTalk(const std::string &name);
     [[nodiscard]] bool load(const std::string &eventName, const std::string &talkName);
+    /* Talk lines are read from the pack on demand, it must outlive this object */
+    [[nodiscard]] bool load(const ContentPack &pack);
 
     [[nodiscard]] const std::vector<std::int16_t> &event(size_t index) const;
-    [[nodiscard]] const std::string &origTalk(size_t index) const;
-    [[nodiscard]] const std::wstring &talk(size_t index) const;
+    /* The event decoded on first use and kept until the next load, the
+     * decoder must be the same on every call.  Not thread safe. */
+    [[nodiscard]] std::shared_ptr<const LegacyProgram> program(size_t index, const LegacyProgram::Decoder &decoder) const;
+    [[nodiscard]] size_t talkCount() const;
+    [[nodiscard]] std::string origTalk(size_t index) const;
+    [[nodiscard]] std::wstring talk(size_t index) const;
+    /* Converts a line into the cache ahead of use, may be called from any thread */
+    void prefetchTalk(size_t index) const;
+
+    /* 0 keeps nothing, every talk() converts the line again */
+    void setTalkCacheCapacity(size_t count);
+    [[nodiscard]] size_t talkCacheCount() const;
+
+private:
+    struct TalkCache;
+
+    void resetTalks(GrpArchive talks, const ContentPack *pack, int packSection);
+    [[nodiscard]] std::wstring convertTalk(size_t index) const;
 
 private:
     std::vector<std::vector<std::int16_t>> events_;
-    std::vector<std::string> origTalks_;
-    std::vector<std::wstring> talks_;
+    mutable std::vector<std::shared_ptr<const LegacyProgram>> programs_;
+    /* TALK entries with their bytes inverted, unused when pack_ is set */
+    GrpArchive talks_;
+    const ContentPack *pack_ = nullptr;
+    int packSection_ = 0;
+    bool simplified_ = false;
+    std::unique_ptr<TalkCache> talkCache_;
 };
 
 extern Event gEvent;
@@ -0,0 +1,94 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "globalcells.hh"
+
+#include "grparchive.hh"
+#include <cstring>
+#include <utility>
+
+namespace hojy::content {
+
+namespace {
+
+std::uint16_t readUint16(std::string_view data, std::size_t index) {
+    std::uint16_t value = 0;
+    if (data.size() >= (index + 1) * sizeof(value)) {
+        memcpy(&value, data.data() + index * sizeof(value), sizeof(value));
+    }
+    return value;
+}
+
+}
+
+bool classifyGlobalCells(const GrpArchive &textures, const std::vector<std::uint16_t> &earth,
+                         const std::vector<std::uint16_t> &surface, const std::vector<std::uint16_t> &building,
+                         std::vector<GlobalCell> &cells) {
+    if (textures.empty()) { return false; }
+    const int cellHeight = readUint16(textures[0], 1);
+    const std::size_t size = GlobalMapWidth * GlobalMapHeight;
+    auto layer = [](const std::vector<std::uint16_t> &data, std::size_t pos) {
+        return pos < data.size() ? std::uint16_t(data[pos] >> 1) : std::uint16_t(0);
+    };
+    std::vector<GlobalCell> result(size);
+    std::size_t pos = 0;
+    for (int j = 0; j < GlobalMapHeight; ++j) {
+        for (int i = 0; i < GlobalMapWidth; ++i, ++pos) {
+            auto &ci = result[pos];
+            auto n = layer(earth, pos);
+            if (n) {
+                if (n == 419 || (n >= 306 && n <= 335)) {
+                    ci.type = 1;
+                } else if ((n >= 179 && n <= 181) || (n >= 253 && n <= 335) || (n >= 508 && n <= 511)) {
+                    ci.type = 1;
+                    ci.canWalk = 1;
+                } else {
+                    ci.canWalk = 1;
+                }
+            }
+            ci.earthId = std::int16_t(n);
+            ci.surfaceId = std::int16_t(layer(surface, pos));
+            auto n1 = layer(building, pos);
+            if (n1 == 0) { continue; }
+            ci.canWalk = 0;
+            if ((n1 >= 1008 && n1 <= 1164) || (n1 >= 1214 && n1 <= 1238)) {
+                ci.type = 2;
+            }
+            const auto tex = textures.at(n1);
+            if (tex.empty()) { continue; }
+            int deltaY = (readUint16(tex, 0) + 35) / 36 / 2;
+            if ((n1 >= 1176 && n1 <= 1182) || n1 == 1352) {
+                deltaY = readUint16(tex, 1) / 18 + 1;
+            }
+            if (deltaY) {
+                if (j < deltaY || i < deltaY) { continue; }
+                auto &ci2 = result[(j - deltaY) * GlobalMapWidth + (i - deltaY)];
+                ci2.buildingId = std::int16_t(n1);
+                ci2.buildingDeltaY = std::int16_t(deltaY * cellHeight);
+            } else {
+                ci.buildingId = std::int16_t(n1);
+                ci.buildingDeltaY = 0;
+            }
+        }
+    }
+    cells = std::move(result);
+    return true;
+}
+
+}
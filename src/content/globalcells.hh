@@ -0,0 +1,52 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace hojy::content {
+
+class GrpArchive;
+
+enum {
+    GlobalMapWidth = 480,
+    GlobalMapHeight = 480,
+};
+
+/* A classified global map cell, stored as is in the content pack */
+struct GlobalCell {
+    std::int16_t earthId = 0, surfaceId = 0, buildingId = 0;
+    /* Pixels the building drawn from this cell is shifted down */
+    std::int16_t buildingDeltaY = 0;
+    std::uint8_t canWalk = 0;
+    /* 0-land 1-water 2-wood */
+    std::uint8_t type = 0;
+    std::uint8_t reserved[2] = {};
+};
+static_assert(sizeof(GlobalCell) == 12, "GlobalCell is part of the content pack layout");
+
+/* Classifies the EARTH/SURFACE/BUILDING layers of the global map, building
+ * heights come from the MMAP texture headers */
+bool classifyGlobalCells(const GrpArchive &textures, const std::vector<std::uint16_t> &earth,
+                         const std::vector<std::uint16_t> &surface, const std::vector<std::uint16_t> &building,
+                         std::vector<GlobalCell> &cells);
+
+}
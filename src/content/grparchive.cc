@@ -0,0 +1,135 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "grparchive.hh"
+
+#include "core/config.hh"
+#include "content/binary_reader.hh"
+#include "util/file.hh"
+#include "util/mappedfile.hh"
+
+#include <limits>
+#include <new>
+#include <utility>
+
+namespace hojy::content {
+
+namespace {
+
+/* MappedFile refuses empty files, which are valid here: an index of zeroes
+ * over an empty group file is a set of empty entries */
+bool mapFile(const std::string &path, util::MappedFile &mapped) {
+    if (mapped.open(path)) { return true; }
+    auto file = util::File::open(path);
+    return file && file.size() == 0;
+}
+
+}
+
+bool GrpArchive::open(const std::string &idx, const std::string &grp, bool isSave) {
+    if (isSave) {
+        return openFiles(core::config.saveFilePath(idx), core::config.saveFilePath(grp));
+    }
+    return openFiles(core::config.dataFilePath(idx), core::config.dataFilePath(grp));
+}
+
+bool GrpArchive::open(const std::string &name, bool isSave) {
+    return open(name + ".IDX", name + ".GRP", isSave);
+}
+
+bool GrpArchive::openFiles(const std::string &idxPath, const std::string &grpPath) {
+    util::MappedFile indexFile;
+    auto groupFile = std::make_shared<util::MappedFile>();
+    if (!mapFile(idxPath, indexFile) || !mapFile(grpPath, *groupFile)) {
+        return false;
+    }
+    std::vector<std::uint32_t> offsets;
+    if (!parseIndex(indexFile.data(), indexFile.size(), groupFile->size(), offsets)) {
+        return false;
+    }
+    const auto *data = reinterpret_cast<const char*>(groupFile->data());
+    data_ = std::shared_ptr<const char>(std::move(groupFile), data);
+    offsets_ = std::move(offsets);
+    return true;
+}
+
+GrpArchive GrpArchive::fromEntries(const std::vector<std::string> &entries) {
+    GrpArchive archive;
+    auto data = std::make_shared<std::string>();
+    archive.offsets_.reserve(entries.size() + 1);
+    archive.offsets_.push_back(0);
+    for (const auto &entry: entries) {
+        data->append(entry);
+        archive.offsets_.push_back(static_cast<std::uint32_t>(data->size()));
+    }
+    const auto *ptr = data->data();
+    archive.data_ = std::shared_ptr<const char>(std::move(data), ptr);
+    return archive;
+}
+
+std::vector<std::string_view> GrpArchive::entries() const {
+    std::vector<std::string_view> result(size());
+    for (std::size_t i = 0; i < result.size(); ++i) {
+        result[i] = (*this)[i];
+    }
+    return result;
+}
+
+/* Offsets get one leading zero, entry i spans [offsets[i], offsets[i + 1]) */
+bool GrpArchive::parseIndex(const std::uint8_t *index, std::size_t indexSize, std::size_t groupSize,
+                            std::vector<std::uint32_t> &offsets) {
+    if (indexSize % sizeof(std::uint32_t) != 0
+        || groupSize > std::numeric_limits<std::uint32_t>::max()
+        || indexSize / sizeof(std::uint32_t) >= std::vector<std::uint32_t>().max_size()) {
+        return false;
+    }
+    const auto count = static_cast<std::size_t>(indexSize / sizeof(std::uint32_t));
+    try {
+        std::vector<std::uint32_t> parsed;
+        parsed.reserve(count + 1);
+        parsed.push_back(0);
+        BinaryReader indexReader(reinterpret_cast<const char*>(index), indexSize);
+        std::uint32_t offset = 0;
+        bool reachedEnd = false;
+        for (std::size_t i = 0; i < count; ++i) {
+            std::uint32_t endoffset = 0;
+            if (!indexReader.readPod(endoffset)) {
+                return false;
+            }
+            if (endoffset == 0) {
+                reachedEnd = true;
+                endoffset = static_cast<std::uint32_t>(groupSize);
+            } else if (reachedEnd) {
+                return false;
+            }
+            if (endoffset < offset || endoffset > groupSize) {
+                return false;
+            }
+            parsed.push_back(endoffset);
+            offset = endoffset;
+        }
+        if (offset != groupSize) { return false; }
+        offsets = std::move(parsed);
+        return true;
+    } catch (const std::bad_alloc &) {
+        return false;
+    }
+}
+
+}
@@ -0,0 +1,60 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+
+namespace hojy::content {
+
+/* An IDX/GRP pair mapped into memory.  Entries are views into the mapping,
+ * they stay valid as long as this archive or a copy of it is alive. */
+class GrpArchive final {
+public:
+    bool open(const std::string &idx, const std::string &grp, bool isSave = false);
+    bool open(const std::string &name, bool isSave = false);
+    /* Takes the paths as they are, without looking them up in the data paths */
+    bool openFiles(const std::string &idxPath, const std::string &grpPath);
+    /* Builds an archive over a copy of entries held in memory */
+    static GrpArchive fromEntries(const std::vector<std::string> &entries);
+
+    [[nodiscard]] std::size_t size() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+    [[nodiscard]] bool empty() const { return size() == 0; }
+    [[nodiscard]] std::string_view operator[](std::size_t index) const {
+        return {data_.get() + offsets_[index], offsets_[index + 1] - offsets_[index]};
+    }
+    /* Empty view for indices out of range */
+    [[nodiscard]] std::string_view at(std::size_t index) const {
+        return index < size() ? (*this)[index] : std::string_view();
+    }
+    [[nodiscard]] std::vector<std::string_view> entries() const;
+
+private:
+    static bool parseIndex(const std::uint8_t *index, std::size_t indexSize, std::size_t groupSize,
+                           std::vector<std::uint32_t> &offsets);
+
+    std::shared_ptr<const char> data_;
+    std::vector<std::uint32_t> offsets_;
+};
+
+}
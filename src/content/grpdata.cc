@@ -21,8 +21,7 @@
 
 #include "core/config.hh"
 #include "content/atomic_file.hh"
-#include "content/binary_reader.hh"
-#include "util/file.hh"
+#include "content/grparchive.hh"
 
 #include <cstdint>
 #include <limits>
@@ -32,80 +31,14 @@
 
 namespace hojy::content {
 
-namespace {
-
-bool readFile(const std::string &path, std::string &data) {
-    util::File file = util::File::open(path);
-    if (!file) {
-        return false;
-    }
-    const auto fileSize = file.size();
-    if (fileSize > std::numeric_limits<std::size_t>::max()
-        || fileSize > std::string().max_size()) {
-        return false;
-    }
-    try {
-        std::string loaded(static_cast<std::size_t>(fileSize), '\0');
-        if (!loaded.empty() && file.read(loaded.data(), loaded.size()) != loaded.size()) {
-            return false;
-        }
-        data = std::move(loaded);
-        return true;
-    } catch (const std::bad_alloc &) {
-        return false;
-    }
-}
-
-}
-
 bool GrpData::loadData(const std::string &idx, const std::string &grp, GrpData::DataSet &dset, bool isSave) {
-    std::string indexData;
-    std::string groupData;
-    if (isSave) {
-        if (!readFile(core::config.saveFilePath(idx), indexData)
-            || !readFile(core::config.saveFilePath(grp), groupData)) {
-            return false;
-        }
-    } else {
-        if (!readFile(core::config.dataFilePath(idx), indexData)
-            || !readFile(core::config.dataFilePath(grp), groupData)) {
-            return false;
-        }
-    }
-    const auto idxSize = indexData.size();
-    const auto fileSize = groupData.size();
-    if (idxSize % sizeof(std::uint32_t) != 0
-        || fileSize > std::numeric_limits<std::uint32_t>::max()
-        || idxSize / sizeof(std::uint32_t) > std::vector<std::string>().max_size()) {
-        return false;
-    }
-    const auto count = static_cast<size_t>(idxSize / sizeof(std::uint32_t));
+    GrpArchive archive;
+    if (!archive.open(idx, grp, isSave)) { return false; }
     try {
-        DataSet loaded(count);
-        content::BinaryReader indexReader(indexData);
-        std::uint32_t offset = 0;
-        bool reachedEnd = false;
-        for (size_t i = 0; i < count; ++i) {
-            std::uint32_t endoffset = 0;
-            if (!indexReader.readPod(endoffset)) {
-                return false;
-            }
-            if (endoffset == 0) {
-                reachedEnd = true;
-                endoffset = static_cast<std::uint32_t>(fileSize);
-            } else if (reachedEnd) {
-                return false;
-            }
-            if (endoffset < offset || endoffset > fileSize) {
-                return false;
-            }
-            const auto size = static_cast<size_t>(endoffset - offset);
-            if (size > 0) {
-                loaded[i].assign(groupData.data() + offset, size);
-            }
-            offset = endoffset;
+        DataSet loaded(archive.size());
+        for (size_t i = 0; i < loaded.size(); ++i) {
+            loaded[i] = archive[i];
         }
-        if (offset != fileSize) { return false; }
         dset = std::move(loaded);
         return true;
     } catch (const std::bad_alloc &) {
@@ -0,0 +1,71 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "legacyprogram.hh"
+
+#include <utility>
+
+namespace hojy::content {
+
+void LegacyProgram::decode(const Decoder &decoder, std::size_t entry) {
+    steps_.clear();
+    errors_.clear();
+    stepAt_.assign(words_.size(), NoStep);
+    std::vector<std::size_t> pending {entry, 0};
+    while (!pending.empty()) {
+        const auto offset = pending.back();
+        pending.pop_back();
+        if (offset >= words_.size() || stepAt_[offset] != NoStep) { continue; }
+
+        Step step;
+        auto &instruction = step.instruction;
+        std::string error;
+        if (!decoder(words_, offset, instruction, error)) {
+            step.error = static_cast<std::int32_t>(errors_.size());
+            errors_.emplace_back(std::move(error));
+        } else if (instruction.wordOffset != offset
+                   || instruction.nextWordOffset <= offset
+                   || instruction.nextWordOffset > words_.size()
+                   || (instruction.conditional
+                       && (instruction.trueAdvance > words_.size() - instruction.nextWordOffset
+                           || instruction.falseAdvance > words_.size() - instruction.nextWordOffset))) {
+            step.error = static_cast<std::int32_t>(errors_.size());
+            errors_.emplace_back("invalid legacy event instruction boundary");
+        } else if (instruction.conditional) {
+            step.trueTarget = instruction.nextWordOffset + instruction.trueAdvance;
+            step.falseTarget = instruction.nextWordOffset + instruction.falseAdvance;
+            pending.push_back(step.falseTarget);
+            pending.push_back(step.trueTarget);
+        } else {
+            step.trueTarget = step.falseTarget = instruction.nextWordOffset;
+            pending.push_back(instruction.nextWordOffset);
+        }
+        stepAt_[offset] = static_cast<std::uint32_t>(steps_.size());
+        steps_.emplace_back(std::move(step));
+    }
+    decoded_ = true;
+}
+
+bool LegacyProgram::patch(std::size_t offset, std::int16_t value) {
+    if (offset >= words_.size()) { return false; }
+    words_[offset] = value;
+    decoded_ = false;
+    return true;
+}
+
+}
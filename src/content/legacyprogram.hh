@@ -0,0 +1,128 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#pragma once
+
+#include <array>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+namespace hojy::content {
+
+/* Operands of one legacy event instruction, stored inline: the longest
+ * instruction (modify event) takes 13 words */
+class LegacyOperands final {
+public:
+    enum : std::size_t {
+        Capacity = 13,
+    };
+
+    LegacyOperands() = default;
+    LegacyOperands(std::initializer_list<std::int16_t> values) { (void)assign(values.begin(), values.end()); }
+
+    /* Fails and keeps nothing when there are more values than the capacity */
+    template<typename It>
+    bool assign(It first, It last) {
+        count_ = 0;
+        for (; first != last; ++first) {
+            if (!push_back(*first)) {
+                count_ = 0;
+                return false;
+            }
+        }
+        return true;
+    }
+    bool push_back(std::int16_t value) {
+        if (count_ >= Capacity) { return false; }
+        values_[count_++] = value;
+        return true;
+    }
+
+    [[nodiscard]] std::size_t size() const { return count_; }
+    [[nodiscard]] bool empty() const { return count_ == 0; }
+    [[nodiscard]] std::int16_t operator[](std::size_t index) const { return values_[index]; }
+    [[nodiscard]] std::int16_t front() const { return values_[0]; }
+    [[nodiscard]] const std::int16_t *begin() const { return values_.data(); }
+    [[nodiscard]] const std::int16_t *end() const { return values_.data() + count_; }
+
+private:
+    std::array<std::int16_t, Capacity> values_ {};
+    std::uint8_t count_ = 0;
+};
+
+struct LegacyInstruction {
+    std::int16_t opcode = 0;
+    LegacyOperands operands;
+    std::size_t wordOffset = 0;
+    std::size_t nextWordOffset = 0;
+    bool conditional = false;
+    std::size_t trueAdvance = 0;
+    std::size_t falseAdvance = 0;
+};
+
+/* A KDEF event program with its instructions decoded once.  Decoding starts
+ * at the entry and follows every instruction and branch from there, so each
+ * reachable word offset maps to a validated step.  An instruction that fails
+ * to decode becomes a faulted step, the program only stops if it runs into it. */
+class LegacyProgram final {
+public:
+    using Decoder = std::function<bool(const std::vector<std::int16_t> &program, std::size_t programCounter,
+                                       LegacyInstruction &instruction, std::string &error)>;
+    struct Step {
+        LegacyInstruction instruction;
+        /* Word offsets the branches continue at, never past the end */
+        std::size_t trueTarget = 0, falseTarget = 0;
+        /* Index into errors for a faulted step */
+        std::int32_t error = -1;
+    };
+
+    LegacyProgram() = default;
+    explicit LegacyProgram(std::vector<std::int16_t> words): words_(std::move(words)) {}
+
+    /* Decodes from word 0 and, when given, from a second entry */
+    void decode(const Decoder &decoder, std::size_t entry = 0);
+    /* Changes a word, the program has to be decoded again before it runs */
+    bool patch(std::size_t offset, std::int16_t value);
+
+    [[nodiscard]] bool decoded() const { return decoded_; }
+    [[nodiscard]] const std::vector<std::int16_t> &words() const { return words_; }
+    [[nodiscard]] std::size_t size() const { return words_.size(); }
+    [[nodiscard]] const std::vector<Step> &steps() const { return steps_; }
+    /* The step starting at a word offset, nullptr if none was decoded there */
+    [[nodiscard]] const Step *step(std::size_t offset) const {
+        return offset < stepAt_.size() && stepAt_[offset] != NoStep ? &steps_[stepAt_[offset]] : nullptr;
+    }
+    [[nodiscard]] const std::string &error(const Step &step) const { return errors_[step.error]; }
+
+private:
+    static constexpr std::uint32_t NoStep = std::numeric_limits<std::uint32_t>::max();
+
+    std::vector<std::int16_t> words_;
+    std::vector<Step> steps_;
+    std::vector<std::uint32_t> stepAt_;
+    std::vector<std::string> errors_;
+    bool decoded_ = false;
+};
+
+}
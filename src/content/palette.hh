@@ -0,0 +1,43 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <string_view>
+#include <cstdint>
+
+namespace hojy::content {
+
+/* 6-bit BGR triples of a .COL file to the colors the renderer takes */
+inline bool decodePalette(std::string_view raw, std::array<std::uint32_t, 256> &colors) {
+    if (raw.size() < 256 * 3) { return false; }
+    const auto *c = reinterpret_cast<const std::uint8_t*>(raw.data());
+    for (size_t i = 0; i < 256; ++i, c += 3) {
+        const auto red = std::uint32_t(c[2]) * 4U;
+        const auto green = std::uint32_t(c[1]) * 4U;
+        const auto blue = std::uint32_t(c[0]) * 4U;
+        // Preserve the original byte order after its explicit BGR swap.
+        colors[i] = 0xFF000000U | (blue << 16U) | (green << 8U) | red;
+    }
+    colors[0] = 0;
+    return true;
+}
+
+}
@@ -96,4 +96,9 @@ const WarfieldLayers *WarfieldData::layers(std::int16_t id) const {
     return &layers_[id];
 }
 
+bool isWarfieldCellBlocked(std::int16_t earthId, std::int16_t buildingId) noexcept {
+    return buildingId > 0 || earthId >= 179 && earthId <= 181 || earthId == 261 || earthId == 511
+        || earthId >= 662 && earthId <= 665 || earthId == 674;
+}
+
 }
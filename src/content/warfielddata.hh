@@ -54,4 +54,7 @@ private:
 
 extern WarfieldData gWarfieldData;
 
+/* Whether a war map cell stops movement, from its earth and building texture ids */
+[[nodiscard]] bool isWarfieldCellBlocked(std::int16_t earthId, std::int16_t buildingId) noexcept;
+
 }
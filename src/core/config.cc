@@ -69,6 +69,10 @@ bool Config::load(const std::string &filename) {
         musicPath_ = prePath_ + main["music_path"].value_or(std::move(musicPath_));
         soundPath_ = prePath_ + main["sound_path"].value_or(std::move(soundPath_));
         savePath_ = prePath_ + main["save_path"].value_or(std::move(savePath_));
+        replayPath_ = main["replay_path"].value_or(std::move(replayPath_));
+        if (!replayPath_.empty()) {
+            replayPath_ = prePath_ + replayPath_;
+        }
         auto fonts = main["fonts"];
         if (fonts.is_string()) {
             fonts_ = {fonts.value_or<std::string>("")};
@@ -82,6 +86,8 @@ bool Config::load(const std::string &filename) {
             fonts_[0] = prePath_ + fonts_[0];
         }
         shipLogicEnabled_ = main["ship_logic_enabled"].value_or<bool>(std::forward<bool>(shipLogicEnabled_));
+        startupTimings_ = main["startup_timings"].value_or<bool>(std::forward<bool>(startupTimings_));
+        contentPack_ = main["content_pack"].value_or<bool>(std::forward<bool>(contentPack_));
     }
     auto window = tbl["window"];
     if (window) {
@@ -89,6 +95,9 @@ bool Config::load(const std::string &filename) {
         windowHeight_ = window["height"].value_or<int>(std::forward<int>(windowHeight_));
         showFPS_ = window["show_fps"].value_or<bool>(std::forward<bool>(showFPS_));
         limitFPS_ = window["limit_fps"].value_or<int>(std::forward<int>(limitFPS_));
+        tileCacheSize_ = window["tile_cache_size"].value_or<int>(std::forward<int>(tileCacheSize_));
+        fightTextureCacheSize_ = window["fight_texture_cache_size"].value_or<int>(std::forward<int>(fightTextureCacheSize_));
+        renderThreads_ = window["render_threads"].value_or<int>(std::forward<int>(renderThreads_));
     }
     auto ui = tbl["ui"];
     if (ui) {
@@ -104,6 +113,7 @@ bool Config::load(const std::string &filename) {
         fadeSpeed_ = ui["fade_speed"].value_or<float>(std::forward<float>(fadeSpeed_));
         windowBorder_ = ui["window_border"].value_or<int>(std::forward<int>(windowBorder_));
         noNameInput_ = ui["no_name_input"].value_or<bool>(std::forward<bool>(noNameInput_));
+        talkCacheSize_ = ui["talk_cache_size"].value_or<int>(std::forward<int>(talkCacheSize_));
     }
     auto audio = tbl["audio"];
     if (audio) {
@@ -116,6 +126,11 @@ bool Config::load(const std::string &filename) {
         if (formatStr) {
             sampleFormat_ = formatStr == "I32" ? 1 : (formatStr == "F32" ? 2 : 0);
         }
+        soundCacheSize_ = audio["sound_cache_size"].value_or<int>(std::forward<int>(soundCacheSize_));
+        musicCachePath_ = audio["music_cache_path"].value_or(std::move(musicCachePath_));
+        if (!musicCachePath_.empty()) {
+            musicCachePath_ = prePath_ + musicCachePath_;
+        }
         musicVolume_ = audio["music_volume"].value_or<int>(std::forward<int>(musicVolume_));
         soundVolume_ = audio["sound_volume"].value_or<int>(std::forward<int>(soundVolume_));
     }
@@ -126,6 +141,8 @@ bool Config::load(const std::string &filename) {
     fixPath(musicPath_);
     fixPath(soundPath_);
     fixPath(savePath_);
+    fixPath(replayPath_);
+    fixPath(musicCachePath_);
     for (auto &path : dataPath_) {
         fixPath(path);
     }
@@ -162,6 +179,10 @@ bool Config::postLoad() {
         return false;
     }
     if (limitFPS_ == 0) { limitFPS_ = 60; }
+    tileCacheSize_ = std::max(tileCacheSize_, 0);
+    fightTextureCacheSize_ = std::max(fightTextureCacheSize_, 0);
+    renderThreads_ = std::max(renderThreads_, 0);
+    talkCacheSize_ = std::max(talkCacheSize_, 0);
     musicVolume_ = std::clamp(musicVolume_, 0, 8);
     soundVolume_ = std::clamp(soundVolume_, 0, 8);
 
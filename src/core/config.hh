@@ -42,8 +42,11 @@ public:
     [[nodiscard]] const std::string &musicPath() const { return musicPath_; }
     [[nodiscard]] const std::string &soundPath() const { return soundPath_; }
     [[nodiscard]] const std::string &savePath() const { return savePath_; }
+    [[nodiscard]] const std::string &replayPath() const { return replayPath_; }
 
     [[nodiscard]] bool shipLogicEnabled() const { return shipLogicEnabled_; }
+    [[nodiscard]] bool startupTimings() const { return startupTimings_; }
+    [[nodiscard]] bool contentPack() const { return contentPack_; }
 
     [[nodiscard]] int windowWidth() const { return windowWidth_; }
     [[nodiscard]] int windowHeight() const { return windowHeight_; }
@@ -59,14 +62,21 @@ public:
     [[nodiscard]] float fadeSpeed() const { return fadeSpeed_; }
     [[nodiscard]] int windowBorder() const { return windowBorder_; }
     [[nodiscard]] bool noNameInput() const { return noNameInput_; }
+    [[nodiscard]] int talkCacheSize() const { return talkCacheSize_; }
     [[nodiscard]] const std::wstring &defaultName() const { return defaultName_; }
 
     [[nodiscard]] bool showFPS() const { return showFPS_; }
     [[nodiscard]] int limitFPS() const { return limitFPS_; }
+    [[nodiscard]] int tileCacheSize() const { return tileCacheSize_; }
+    [[nodiscard]] int fightTextureCacheSize() const { return fightTextureCacheSize_; }
+    [[nodiscard]] int renderThreads() const { return renderThreads_; }
 
     [[nodiscard]] const std::string & oplEmulator() const { return oplEmulator_; }
+    void setOplEmulator(const std::string &emulator) { oplEmulator_ = emulator; }
     [[nodiscard]] int sampleRate() const { return sampleRate_; }
     [[nodiscard]] int sampleFormat() const { return sampleFormat_; }
+    [[nodiscard]] int soundCacheSize() const { return soundCacheSize_; }
+    [[nodiscard]] const std::string &musicCachePath() const { return musicCachePath_; }
 
     [[nodiscard]] int musicVolume() const { return musicVolume_; }
     void setMusicVolume(int volume) { musicVolume_ = volume; }
@@ -75,8 +85,10 @@ public:
 
 private:
     std::vector<std::string> dataPath_, fonts_;
-    std::string musicPath_, soundPath_, savePath_, prePath_;
+    std::string musicPath_, soundPath_, savePath_, replayPath_, prePath_;
     bool shipLogicEnabled_ = true;
+    bool startupTimings_ = false;
+    bool contentPack_ = false;
     int windowWidth_ = 640, windowHeight_ = 480;
     bool simplifiedChinese_ = false;
     bool showPotential_ = false;
@@ -87,12 +99,18 @@ private:
     float fadeSpeed_ = 1.f;
     int windowBorder_ = 8;
     bool noNameInput_ = false;
+    int talkCacheSize_ = 256;
     std::wstring defaultName_;
     bool showFPS_ = false;
     int limitFPS_ = 0;
+    int tileCacheSize_ = 32;
+    int fightTextureCacheSize_ = 26;
+    int renderThreads_ = 0;
     std::string oplEmulator_ = "dosbox";
+    std::string musicCachePath_;
     int sampleRate_ = 0;
     int sampleFormat_ = 0;
+    int soundCacheSize_ = 32;
     int musicVolume_ = 5;
     int soundVolume_ = 5;
 };
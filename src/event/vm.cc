@@ -12,12 +12,25 @@ void Vm::load(std::vector<Instruction> program) {
 }
 
 void Vm::loadLegacy(std::vector<std::int16_t> program) {
+    legacyPending_ = std::make_shared<LegacyProgram>(std::move(program));
+    legacyProgram_ = legacyPending_;
+    legacyProgramCounter_ = 0;
+    legacyInstructionNext_ = 0;
+    legacyTrueAdvance_ = 0;
+    legacyFalseAdvance_ = 0;
+    legacyActive_ = legacyProgram_->size() > 0;
+    legacyWaiting_ = false;
+    legacyConditionalWait_ = false;
+}
+
+void Vm::loadLegacy(std::shared_ptr<const LegacyProgram> program) {
+    legacyPending_.reset();
     legacyProgram_ = std::move(program);
     legacyProgramCounter_ = 0;
     legacyInstructionNext_ = 0;
     legacyTrueAdvance_ = 0;
     legacyFalseAdvance_ = 0;
-    legacyActive_ = !legacyProgram_.empty();
+    legacyActive_ = legacyProgram_ && legacyProgram_->size() > 0;
     legacyWaiting_ = false;
     legacyConditionalWait_ = false;
 }
@@ -25,7 +38,8 @@ void Vm::loadLegacy(std::vector<std::int16_t> program) {
 void Vm::reset() {
     programCounter_ = 0;
     memory_.clear();
-    legacyProgram_.clear();
+    legacyProgram_.reset();
+    legacyPending_.reset();
     clearLegacyExecutionState();
 }
 
@@ -41,19 +55,31 @@ void Vm::clearLegacyExecutionState() {
 }
 
 bool Vm::applyLegacyAdvance(std::size_t advance) {
-    if (legacyProgramCounter_ > legacyProgram_.size()
-        || advance > legacyProgram_.size() - legacyProgramCounter_) {
+    const auto size = legacyProgram_ ? legacyProgram_->size() : 0;
+    if (legacyProgramCounter_ > size
+        || advance > size - legacyProgramCounter_) {
         legacyActive_ = false;
         legacyWaiting_ = false;
         return false;
     }
     legacyProgramCounter_ += advance;
-    if (legacyProgramCounter_ == legacyProgram_.size()) {
+    if (legacyProgramCounter_ == size) {
         legacyActive_ = false;
     }
     return true;
 }
 
+void Vm::adoptPendingLegacy(const LegacyVmHost &host) {
+    if (legacyPending_) {
+        legacyPending_->decode(host.legacyDecoder(), legacyProgramCounter_);
+        legacyProgram_ = std::move(legacyPending_);
+    } else if (legacyProgram_ && !legacyProgram_->decoded()) {
+        auto program = std::make_shared<LegacyProgram>(legacyProgram_->words());
+        program->decode(host.legacyDecoder(), legacyProgramCounter_);
+        legacyProgram_ = std::move(program);
+    }
+}
+
 VmResult Vm::runLegacy(LegacyVmHost &host, std::size_t operationBudget) {
     if (!legacyActive_) {
         return {VmStatus::Completed, 0, {}};
@@ -67,33 +93,24 @@ VmResult Vm::runLegacy(LegacyVmHost &host, std::size_t operationBudget) {
 
     std::size_t executed = 0;
     while (legacyActive_ && executed < operationBudget) {
-        if (legacyProgramCounter_ >= legacyProgram_.size()) {
+        adoptPendingLegacy(host);
+        /* Held for the step, the host may reset or patch the program meanwhile */
+        const auto program = legacyProgram_;
+        if (legacyProgramCounter_ >= program->size()) {
             legacyActive_ = false;
             return {VmStatus::Completed, executed, {}};
         }
 
-        LegacyInstruction instruction;
-        std::string error;
-        if (!host.decodeLegacy(legacyProgram_, legacyProgramCounter_,
-                               instruction, error)) {
-            legacyActive_ = false;
-            legacyWaiting_ = false;
-            return {VmStatus::Faulted, executed, std::move(error)};
-        }
-        if (instruction.wordOffset != legacyProgramCounter_
-            || instruction.nextWordOffset <= legacyProgramCounter_
-            || instruction.nextWordOffset > legacyProgram_.size()
-            || (instruction.conditional
-                && (instruction.trueAdvance
-                        > legacyProgram_.size() - instruction.nextWordOffset
-                    || instruction.falseAdvance
-                        > legacyProgram_.size() - instruction.nextWordOffset))) {
+        const auto *step = program->step(legacyProgramCounter_);
+        if (!step || step->error >= 0) {
             legacyActive_ = false;
             legacyWaiting_ = false;
             return {VmStatus::Faulted, executed,
-                    "invalid legacy event instruction boundary"};
+                    step ? program->error(*step)
+                         : std::string("legacy event program counter out of range")};
         }
 
+        const auto &instruction = step->instruction;
         legacyInstructionNext_ = instruction.nextWordOffset;
         legacyProgramCounter_ = instruction.nextWordOffset;
         legacyDispatching_ = true;
@@ -109,7 +126,7 @@ VmResult Vm::runLegacy(LegacyVmHost &host, std::size_t operationBudget) {
         if (result.status == VmStatus::Completed) {
             legacyActive_ = false;
             legacyWaiting_ = false;
-            legacyProgramCounter_ = legacyProgram_.size();
+            legacyProgramCounter_ = program->size();
             return {VmStatus::Completed, executed, {}};
         }
 
@@ -118,11 +135,11 @@ VmResult Vm::runLegacy(LegacyVmHost &host, std::size_t operationBudget) {
                 legacyTrueAdvance_ = instruction.trueAdvance;
                 legacyFalseAdvance_ = instruction.falseAdvance;
                 legacyConditionalWait_ = true;
-            } else if (!applyLegacyAdvance(
-                           result.branch ? instruction.trueAdvance
-                                         : instruction.falseAdvance)) {
-                return {VmStatus::Faulted, executed,
-                        "legacy event branch target out of range"};
+            } else {
+                legacyProgramCounter_ = result.branch ? step->trueTarget : step->falseTarget;
+                if (legacyProgramCounter_ == program->size()) {
+                    legacyActive_ = false;
+                }
             }
         } else if (result.status == VmStatus::Waiting) {
             legacyConditionalWait_ = false;
@@ -152,14 +169,14 @@ bool Vm::resumeLegacy(bool branch) {
         legacyFalseAdvance_ = 0;
         return applyLegacyAdvance(advance);
     }
-    if (legacyProgramCounter_ == legacyProgram_.size()) {
+    if (legacyProgramCounter_ == legacyProgram_->size()) {
         legacyActive_ = false;
     }
     return true;
 }
 
 bool Vm::patchLegacyRelative(std::ptrdiff_t offset, std::int16_t value) {
-    if (!legacyDispatching_) {
+    if (!legacyDispatching_ || !legacyProgram_) {
         return false;
     }
     const auto base = static_cast<std::ptrdiff_t>(legacyInstructionNext_);
@@ -169,11 +186,14 @@ bool Vm::patchLegacyRelative(std::ptrdiff_t offset, std::int16_t value) {
     }
     const auto target = base + offset;
     if (target < 0
-        || static_cast<std::size_t>(target) >= legacyProgram_.size()) {
+        || static_cast<std::size_t>(target) >= legacyProgram_->size()) {
         return false;
     }
-    legacyProgram_[static_cast<std::size_t>(target)] = value;
-    return true;
+    /* The running program may be shared with the event cache, patches go to a copy */
+    if (!legacyPending_) {
+        legacyPending_ = std::make_shared<LegacyProgram>(legacyProgram_->words());
+    }
+    return legacyPending_->patch(static_cast<std::size_t>(target), value);
 }
 
 bool Vm::resolve(std::int16_t flags, std::int16_t operand, std::int16_t bit,
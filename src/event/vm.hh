@@ -1,10 +1,12 @@
 #pragma once
 
 #include "event_memory.hh"
+#include "content/legacyprogram.hh"
 
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -28,15 +30,8 @@ struct VmResult {
     std::string error;
 };
 
-struct LegacyInstruction {
-    std::int16_t opcode = 0;
-    std::vector<std::int16_t> operands;
-    std::size_t wordOffset = 0;
-    std::size_t nextWordOffset = 0;
-    bool conditional = false;
-    std::size_t trueAdvance = 0;
-    std::size_t falseAdvance = 0;
-};
+using LegacyInstruction = content::LegacyInstruction;
+using LegacyProgram = content::LegacyProgram;
 
 struct LegacyHostResult {
     VmStatus status = VmStatus::Running;
@@ -61,12 +56,22 @@ public:
     virtual LegacyHostResult executeLegacy(
             const LegacyInstruction &instruction,
             EventMemory &memory) = 0;
+
+    [[nodiscard]] LegacyProgram::Decoder legacyDecoder() const {
+        return [this](const std::vector<std::int16_t> &program, std::size_t programCounter,
+                      LegacyInstruction &instruction, std::string &error) {
+            return decodeLegacy(program, programCounter, instruction, error);
+        };
+    }
 };
 
 class Vm final {
 public:
     void load(std::vector<Instruction> program);
+    /* Decoded by the host on the first run */
     void loadLegacy(std::vector<std::int16_t> program);
+    /* Runs a program decoded ahead of time, it is shared until patched */
+    void loadLegacy(std::shared_ptr<const LegacyProgram> program);
     void reset();
 
     [[nodiscard]] VmResult run(VmHost &host, std::size_t operationBudget);
@@ -98,12 +103,15 @@ private:
     bool addressAdd(std::int16_t left, std::int16_t right,
                     std::int32_t &address, std::string &error) const;
     bool applyLegacyAdvance(std::size_t advance);
+    void adoptPendingLegacy(const LegacyVmHost &host);
     void clearLegacyExecutionState();
 
     EventMemory memory_;
     std::vector<Instruction> program_;
     std::size_t programCounter_ = 0;
-    std::vector<std::int16_t> legacyProgram_;
+    std::shared_ptr<const LegacyProgram> legacyProgram_;
+    /* A copy of our own, loaded or patched, decoded before the next step */
+    std::shared_ptr<LegacyProgram> legacyPending_;
     std::size_t legacyProgramCounter_ = 0;
     std::size_t legacyInstructionNext_ = 0;
     std::size_t legacyTrueAdvance_ = 0;
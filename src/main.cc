@@ -25,8 +25,7 @@
 
 #include "core/config.hh"
 #include "app/application.hh"
-#include "content/loader.hh"
-#include "world/strings.hh"
+#include "app/startup.hh"
 
 #include <cstdlib>
 #include <filesystem>
@@ -41,12 +40,15 @@ int main(int argc, char *argv[]) {
         core::config.load(optionsFile);
     }
     if (!core::config.postLoad()) { return EXIT_FAILURE; }
-    if (!::hojy::world::state::gStrings.load("strings.toml")) { return EXIT_FAILURE; }
-    core::config.fixOnTextLoaded();
-    if (!::hojy::content::loadData()) { return EXIT_FAILURE; }
+    if (!app::loadStartupData()) {
+        app::finishStartupData();
+        return EXIT_FAILURE;
+    }
     app::Application application(core::config.windowWidth(), core::config.windowHeight(),
                                  core::config.animationSpeed());
-    return application.run();
+    const auto result = application.run();
+    app::finishStartupData();
+    return result;
 }
 
 #ifdef _MSC_VER
@@ -19,6 +19,7 @@
 
 #include "colorpalette.hh"
 
+#include "content/palette.hh"
 #include "core/config.hh"
 #include "util/file.hh"
 
@@ -29,19 +30,12 @@ ColorPalette gNormalPalette, gEndPalette, gMaskPalette;
 bool ColorPalette::load(const std::string &name) {
     auto ifs = util::File::open(core::config.dataFilePath(name + ".COL"));
     if (!ifs) { return false; }
-    std::array<std::uint32_t, 256> loaded{};
-    for (size_t i = 0; i < 256; ++i) {
-        std::uint8_t c[3]{};
-        if (ifs.read(c, sizeof(c)) != sizeof(c)) {
-            return false;
-        }
-        const auto red = std::uint32_t(c[2]) * 4U;
-        const auto green = std::uint32_t(c[1]) * 4U;
-        const auto blue = std::uint32_t(c[0]) * 4U;
-        // Preserve the original byte order after its explicit BGR swap.
-        loaded[i] = 0xFF000000U | (blue << 16U) | (green << 8U) | red;
+    std::string raw(256 * 3, '\0');
+    if (ifs.read(raw.data(), raw.size()) != raw.size()) {
+        return false;
     }
-    loaded[0] = 0;
+    std::array<std::uint32_t, 256> loaded{};
+    if (!content::decodePalette(raw, loaded)) { return false; }
     palette_ = loaded;
     return true;
 }
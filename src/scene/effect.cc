@@ -20,7 +20,7 @@
 #include "effect.hh"
 
 #include "colorpalette.hh"
-#include "content/grpdata.hh"
+#include "content/grparchive.hh"
 #include "content/factors.hh"
 
 #include <cstddef>
@@ -33,37 +33,40 @@ Effect gEffect;
 
 bool Effect::load(const std::string &filename) {
     try {
-        ::hojy::content::GrpData::DataSet dset;
-        if (!::hojy::content::GrpData::loadData(filename, dset)) {
+        ::hojy::content::GrpArchive archive;
+        if (!archive.open(filename)) {
             return false;
         }
         auto effectSz = ::hojy::content::gFactors.effectFrames.size();
-        std::vector<std::vector<std::string>> loaded(effectSz);
+        std::vector<std::vector<std::string_view>> loaded(effectSz);
         size_t index = 0;
         for (size_t i = 0; i < effectSz; ++i) {
             auto &data = loaded[i];
             const auto frameCount = ::hojy::content::gFactors.effectFrames[i];
             if (frameCount < 0
-                || static_cast<std::size_t>(frameCount) > dset.size() - index) {
+                || static_cast<std::size_t>(frameCount) > archive.size() - index) {
                 return false;
             }
-            data.assign(dset.begin() + static_cast<std::ptrdiff_t>(index),
-                        dset.begin() + static_cast<std::ptrdiff_t>(index + frameCount));
+            data.resize(static_cast<std::size_t>(frameCount));
+            for (std::size_t j = 0; j < data.size(); ++j) {
+                data[j] = archive[index + j];
+            }
             index += static_cast<std::size_t>(frameCount);
         }
-        if (index != dset.size()) {
+        if (index != archive.size()) {
             return false;
         }
         effectTexData_ = std::move(loaded);
+        archive_ = std::move(archive);
         return true;
     } catch (const std::bad_alloc &) {
         return false;
     }
 }
 
-const std::vector<std::string> &Effect::operator[](std::int16_t index) const {
+const std::vector<std::string_view> &Effect::operator[](std::int16_t index) const {
     if (index < 0 || index >= effectTexData_.size()) {
-        static const std::vector<std::string> dummy;
+        static const std::vector<std::string_view> dummy;
         return dummy;
     }
     return effectTexData_[index];
@@ -19,7 +19,10 @@
 
 #pragma once
 
+#include "content/grparchive.hh"
+
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cstdint>
 
@@ -30,11 +33,16 @@ class Renderer;
 class Effect {
 public:
     [[nodiscard]] bool load(const std::string &filename);
-    const std::vector<std::string> &operator[](std::int16_t index) const;
-    void clear() { effectTexData_.clear(); }
+    const std::vector<std::string_view> &operator[](std::int16_t index) const;
+    void clear() {
+        effectTexData_.clear();
+        archive_ = {};
+    }
 
 private:
-    std::vector<std::vector<std::string>> effectTexData_;
+    /* Frames of each effect, viewing into archive_ */
+    std::vector<std::vector<std::string_view>> effectTexData_;
+    ::hojy::content::GrpArchive archive_;
 };
 
 extern Effect gEffect;
@@ -0,0 +1,81 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "fighttexturecache.hh"
+
+#include <fmt/format.h>
+#include <new>
+
+namespace hojy::scene {
+
+void FightTextureCache::setCapacity(std::size_t count) {
+    capacity_ = count;
+    trim();
+}
+
+void FightTextureCache::clear() {
+    entries_.clear();
+    index_.clear();
+    missing_.clear();
+}
+
+FightTextureCache::Frames FightTextureCache::get(std::int16_t id) {
+    if (id < 0 || missing_.count(id)) { return nullptr; }
+    auto it = index_.find(id);
+    if (it != index_.end()) {
+        entries_.splice(entries_.begin(), entries_, it->second);
+        return it->second->frames;
+    }
+    auto frames = std::make_shared<content::GrpArchive>();
+    if (!frames->open(fmt::format("FIGHT{:03}.IDX", id), fmt::format("FIGHT{:03}.GRP", id))) {
+        try {
+            missing_.insert(id);
+        } catch (const std::bad_alloc &) {
+        }
+        return nullptr;
+    }
+    if (capacity_ == 0) { return frames; }
+    try {
+        entries_.push_front(Entry {id, frames});
+        index_.emplace(id, entries_.begin());
+    } catch (const std::bad_alloc &) {
+        if (!entries_.empty() && entries_.front().id == id) { entries_.pop_front(); }
+        return frames;
+    }
+    trim();
+    return frames;
+}
+
+void FightTextureCache::preload(const std::vector<std::int16_t> &ids) {
+    /* Loading more than fits would drop sets loaded by this same call */
+    std::unordered_set<std::int16_t> loaded;
+    for (auto id: ids) {
+        if (loaded.size() >= capacity_) { break; }
+        if (get(id)) { loaded.insert(id); }
+    }
+}
+
+void FightTextureCache::trim() {
+    while (entries_.size() > capacity_) {
+        index_.erase(entries_.back().id);
+        entries_.pop_back();
+    }
+}
+
+}
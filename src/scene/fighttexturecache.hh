@@ -0,0 +1,70 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "content/grparchive.hh"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+#include <cstdint>
+
+namespace hojy::scene {
+
+/* Battle animation frames (FIGHTnnn) by character head id, opened on first
+ * use.  The least recently used sets are dropped once more than the capacity
+ * are held, so sets of frequent fighters survive from battle to battle.
+ * Ids without a usable archive are remembered until clear(). */
+class FightTextureCache final {
+public:
+    using Frames = std::shared_ptr<const content::GrpArchive>;
+
+    explicit FightTextureCache(std::size_t capacity = 0) noexcept: capacity_(capacity) {}
+
+    /* 0 keeps nothing, every get() opens the archive again */
+    void setCapacity(std::size_t count);
+    void clear();
+
+    /* The frames of one character, nullptr if the archive is missing or invalid */
+    [[nodiscard]] Frames get(std::int16_t id);
+    /* Stops once the capacity is reached, the rest are opened on first use */
+    void preload(const std::vector<std::int16_t> &ids);
+
+    [[nodiscard]] std::size_t capacity() const { return capacity_; }
+    [[nodiscard]] std::size_t count() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        std::int16_t id;
+        Frames frames;
+    };
+
+    void trim();
+
+private:
+    std::size_t capacity_;
+    std::list<Entry> entries_;
+    std::unordered_map<std::int16_t, std::list<Entry>::iterator> index_;
+    std::unordered_set<std::int16_t> missing_;
+};
+
+}
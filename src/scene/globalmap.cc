@@ -21,7 +21,8 @@
 
 #include "colorpalette.hh"
 #include "window.hh"
-#include "content/grpdata.hh"
+#include "content/contentpack.hh"
+#include "content/grparchive.hh"
 #include "world/savedata.hh"
 #include "util/file.hh"
 #include "util/random.hh"
@@ -30,10 +31,8 @@
 
 namespace hojy::scene {
 
-enum {
-    GlobalMapWidth = 480,
-    GlobalMapHeight = 480,
-};
+using content::GlobalMapWidth;
+using content::GlobalMapHeight;
 
 GlobalMap::GlobalMap(Renderer *renderer, int ix, int iy, int width, int height, std::pair<int, int> scale):
     MapWithEvent(renderer, ix, iy, width, height, scale),
@@ -45,11 +44,15 @@ GlobalMap::GlobalMap(Renderer *renderer, int ix, int iy, int width, int height,
     mapHeight_ = GlobalMapHeight;
     cloudTexMgr_.setRenderer(renderer_);
     cloudTexMgr_.setPalette(gNormalPalette);
-    ::hojy::content::GrpData::loadData("MMAP", texData_);
+    ::hojy::content::GrpArchive archive;
+    if (archive.open("MMAP")) {
+        texData_ = archive.entries();
+        texArchives_.emplace_back(std::move(archive));
+    }
     renderer_->enableLinear();
-    ::hojy::content::GrpData::DataSet dset;
-    if (::hojy::content::GrpData::loadData("CLOUD", dset)) {
-        cloudTexMgr_.loadFromRLE(dset);
+    ::hojy::content::GrpArchive clouds;
+    if (clouds.open("CLOUD")) {
+        cloudTexMgr_.loadFromRLE(clouds);
     }
     renderer_->enableLinear(false);
     {
@@ -59,64 +62,27 @@ GlobalMap::GlobalMap(Renderer *renderer, int ix, int iy, int width, int height,
         offsetX_ = arr[2];
         offsetY_ = arr[3];
     }
-    int cellDiffX = cellWidth_ / 2;
-    int cellDiffY = cellHeight_ / 2;
     auto size = mapWidth_ * mapHeight_;
-    std::vector<std::uint16_t> earth_, surface_;
-    util::File::getFileContent(core::config.dataFilePath("EARTH.002"), earth_);
-    util::File::getFileContent(core::config.dataFilePath("SURFACE.002"), surface_);
     util::File::getFileContent(core::config.dataFilePath("BUILDING.002"), building_);
     util::File::getFileContent(core::config.dataFilePath("BUILDX.002"), buildx_);
     util::File::getFileContent(core::config.dataFilePath("BUILDY.002"), buildy_);
-    earth_.resize(size);
-    surface_.resize(size);
     building_.resize(size);
     buildx_.resize(size);
     buildy_.resize(size);
+    /* The content pack holds the cells classified in advance */
+    if (!content::gContentPack.globalCells(cellInfo_)) {
+        std::vector<std::uint16_t> earth, surface;
+        util::File::getFileContent(core::config.dataFilePath("EARTH.002"), earth);
+        util::File::getFileContent(core::config.dataFilePath("SURFACE.002"), surface);
+        ::hojy::content::GrpArchive textures;
+        if (!texArchives_.empty()) { textures = texArchives_.front(); }
+        content::classifyGlobalCells(textures, earth, surface, building_, cellInfo_);
+    }
     cellInfo_.resize(size);
-
-    int pos = 0;
-    for (int j = 0; j < mapHeight_; ++j) {
-        for (int i = 0; i < mapWidth_; ++i, ++pos) {
-            auto &ci = cellInfo_[pos];
-            auto &n = earth_[pos];
-            n >>= 1;
-            if (n) {
-                if (n == 419 || n >= 306 && n <= 335) {
-                    ci.type = 1;
-                } else if (n >= 179 && n <= 181 || n >= 253 && n <= 335 || n >= 508 && n <= 511) {
-                    ci.type = 1;
-                    ci.canWalk = true;
-                } else if (n > 0) {
-                    ci.canWalk = true;
-                }
-            }
-            ci.earthId = n;
-            ci.surfaceId = surface_[pos] >> 1;
-            auto &n1 = building_[pos];
-            n1 >>= 1;
-            if (n1 > 0) {
-                ci.canWalk = false;
-                if (n1 >= 1008 && n1 <= 1164 || n1 >= 1214 && n1 <= 1238) {
-                    ci.type = 2;
-                }
-                if (n1 && n1 < texData_.size() && !texData_[n1].empty()) {
-                    const auto *arr = reinterpret_cast<const uint16_t *>(texData_[n1].data());
-                    auto deltaY = (arr[0] + 35) / 36 / 2;
-                    if (n1 >= 1176 && n1 <= 1182 || n1 == 1352) {
-                        deltaY = arr[1] / 18 + 1;
-                    }
-                    if (deltaY) {
-                        auto &ci2 = cellInfo_[(j - deltaY) * mapWidth_ + (i - deltaY)];
-                        ci2.buildingId = n1;
-                        ci2.buildingDeltaY = deltaY * cellHeight_;
-                    } else {
-                        ci.buildingId = n1;
-                        ci.buildingDeltaY = 0;
-                    }
-                }
-            }
-        }
+    ground_.setMap(&cellInfo_, &texData_, cellWidth_, cellHeight_);
+    ground_.resize(int(auxWidth_), int(auxHeight_));
+    for (auto &n: building_) {
+        n >>= 1;
     }
     resetTime();
     updateMainCharTexture();
@@ -226,6 +192,7 @@ void GlobalMap::render() {
     Map::render();
     if (drawDirty_) {
         drawDirty_ = false;
+        ground_.update(cameraX_, cameraY_);
         int cellDiffX = cellWidth_ / 2;
         int cellDiffY = cellHeight_ / 2;
         int camX = cameraX_, camY = cameraY_;
@@ -241,38 +208,14 @@ void GlobalMap::render() {
         ocx = camX - ocx; ocy = camY - ocy;
         int delta = -mapWidth_ + 1;
         int cx = ocx, cy = ocy, tx = otx, ty = oty;
-        const auto *colors = gNormalPalette.colors();
         auto *curTex = drawingTerrainTex_;
         int pitch;
         std::uint32_t *pixels = curTex->lock(pitch);
-        memset(pixels, 0, pitch * auxHeight_ * sizeof(std::uint32_t));
-        for (int j = hcount; j; --j) {
-            int x = cx, y = cy;
-            int dx = tx;
-            int offset = y * mapWidth_ + x;
-            for (int i = wcount; i; --i, dx += cellWidth_, offset += delta, ++x, --y) {
-                if (x < 0 || x >= GlobalMapWidth || y < 0 || y >= GlobalMapHeight) {
-                    Texture::renderRLE(texData_[0], colors, pixels, pitch, aheight, dx, ty);
-                    continue;
-                }
-                auto &ci = cellInfo_[offset];
-                Texture::renderRLE(texData_[ci.earthId], colors, pixels, pitch, aheight, dx, ty);
-                if (ci.surfaceId) {
-                    Texture::renderRLE(texData_[ci.surfaceId], colors, pixels, pitch, aheight, dx, ty);
-                }
-            }
-            if (j % 2) {
-                ++cx;
-                tx += cellDiffX;
-                ty += cellDiffY;
-            } else {
-                ++cy;
-                tx -= cellDiffX;
-                ty += cellDiffY;
-            }
+        for (int y = 0; y < aheight; ++y) {
+            memcpy(pixels + y * pitch, ground_.pixels() + y * auxWidth_, auxWidth_ * sizeof(std::uint32_t));
         }
-        cx = ocx; cy = ocy; tx = otx; ty = oty;
         int charX = currX_, charY = currY_;
+        rasterizer_.begin(tileCache_, pixels, pitch, aheight);
         for (int j = hcount; j; --j) {
             int x = cx, y = cy;
             int dx = tx;
@@ -283,13 +226,15 @@ void GlobalMap::render() {
                 }
                 auto &ci = cellInfo_[offset];
                 if (ci.buildingId) {
-                    Texture::renderRLE(texData_[ci.buildingId], colors, pixels, pitch, aheight, dx, ty + ci.buildingDeltaY);
+                    rasterizer_.draw(ci.buildingId, texData_[ci.buildingId], dx, ty + ci.buildingDeltaY);
                 }
                 if (x == charX && y == charY) {
+                    rasterizer_.flush();
                     curTex->unlock();
                     curTex = drawingTerrainTex2_;
                     pixels = curTex->lock(pitch);
                     memset(pixels, 0, pitch * auxHeight_ * sizeof(std::uint32_t));
+                    rasterizer_.begin(tileCache_, pixels, pitch, aheight);
                 }
             }
             if (j % 2) {
@@ -302,6 +247,7 @@ void GlobalMap::render() {
                 ty += cellDiffY;
             }
         }
+        rasterizer_.flush();
         curTex->unlock();
         int miniMapStartX = 2 * (mapHeight_ - 1) + 1 + 2 * (cameraX_ - cameraY_);
         int miniMapStartY = 1 + cameraX_ + cameraY_;
@@ -403,9 +349,23 @@ bool GlobalMap::tryMove(int x, int y, bool checkEvent) {
     cameraX_ = x;
     cameraY_ = y;
     drawDirty_ = true;
+    prefetchEntranceMusic(x, y);
     return true;
 }
 
+/* Opens the music of a sub map entrance next to the player before it is entered */
+void GlobalMap::prefetchEntranceMusic(int x, int y) const {
+    static const int offsets[4][2] = {{0, -1}, {1, 0}, {0, 1}, {-1, 0}};
+    for (const auto &offset: offsets) {
+        auto ite = subMapEntries_.find(std::make_pair(std::int16_t(x + offset[0]), std::int16_t(y + offset[1])));
+        if (ite == subMapEntries_.end()) { continue; }
+        auto *subMapInfo = ::hojy::world::state::gSaveData.subMapInfo[ite->second];
+        if (subMapInfo && subMapInfo->enterMusic >= 0) {
+            gWindow->prefetchMusic(subMapInfo->enterMusic);
+        }
+    }
+}
+
 void GlobalMap::updateMainCharTexture() {
     if (onShip_) {
         mainCharTex_ = getOrLoadTexture(3715 + int(direction_) * 4 + currMainCharFrame_);
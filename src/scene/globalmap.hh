@@ -21,18 +21,15 @@
 
 #include "mapwithevent.hh"
 
+#include "groundlayer.hh"
+#include "content/globalcells.hh"
+
 #include <map>
 
 namespace hojy::scene {
 
 class GlobalMap final: public MapWithEvent {
-    struct CellInfo {
-        std::int16_t earthId, surfaceId, buildingId;
-        int buildingDeltaY;
-        bool canWalk;
-        /* 0-land 1-water 2-wood */
-        std::uint8_t type;
-    };
+    using CellInfo = content::GlobalCell;
 public:
     GlobalMap(Renderer *renderer, int x, int y, int width, int height, std::pair<int, int> scale);
     ~GlobalMap() override;
@@ -49,11 +46,15 @@ protected:
     void resetTime() override;
     bool checkTime() override;
 
+private:
+    void prefetchEntranceMusic(int x, int y) const;
+
 private:
     bool onShip_ = false;
     Texture *drawingTerrainTex2_ = nullptr;
     std::vector<std::uint16_t> building_, buildx_, buildy_;
     std::vector<CellInfo> cellInfo_;
+    GroundLayer ground_ {tileCache_, rasterizer_};
     TextureMgr cloudTexMgr_;
     int cloudStartX_[3] = {}, cloudStartY_[3] = {};
     int cloudX_[3] = {}, cloudY_[3] = {};
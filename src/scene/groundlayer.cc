@@ -0,0 +1,172 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "groundlayer.hh"
+
+#include "tilecache.hh"
+#include "tilerasterizer.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+namespace hojy::scene {
+
+using content::GlobalMapWidth;
+using content::GlobalMapHeight;
+
+namespace {
+
+int floorDiv(int a, int b) {
+    return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+}
+
+void GroundLayer::setMap(const std::vector<content::GlobalCell> *cells, const std::vector<std::string_view> *textures,
+                         int cellWidth, int cellHeight) {
+    cells_ = cells;
+    textures_ = textures;
+    cellWidth_ = cellWidth;
+    cellHeight_ = cellHeight;
+    measured_ = false;
+    valid_ = false;
+}
+
+void GroundLayer::resize(int width, int height) {
+    width_ = std::max(width, 0);
+    height_ = std::max(height, 0);
+    pixels_.assign(std::size_t(width_) * height_, 0);
+    valid_ = false;
+}
+
+void GroundLayer::update(int cameraX, int cameraY) {
+    int w = width_, h = height_;
+    if (!cells_ || !textures_ || cellWidth_ < 2 || cellHeight_ < 2 || w == 0 || h == 0) { return; }
+    int cellDiffX = cellWidth_ / 2;
+    int cellDiffY = cellHeight_ / 2;
+    int dcx = cameraX - cameraX_, dcy = cameraY - cameraY_;
+    int sx = (dcy - dcx) * cellDiffX, sy = -(dcx + dcy) * cellDiffY;
+    cameraX_ = cameraX;
+    cameraY_ = cameraY;
+    if (!valid_ || std::abs(sx) >= w || std::abs(sy) >= h) {
+        valid_ = true;
+        render(0, 0, w, h);
+        return;
+    }
+    if (sx == 0 && sy == 0) { return; }
+    auto *pixels = pixels_.data();
+    int cols = w - std::abs(sx);
+    int dstX = std::max(sx, 0), srcX = std::max(-sx, 0);
+    if (sy > 0) {
+        for (int y = h - 1; y >= sy; --y) {
+            memmove(pixels + y * w + dstX, pixels + (y - sy) * w + srcX, cols * sizeof(std::uint32_t));
+        }
+    } else {
+        for (int y = 0; y < h + sy; ++y) {
+            memmove(pixels + y * w + dstX, pixels + (y - sy) * w + srcX, cols * sizeof(std::uint32_t));
+        }
+    }
+    int rowH = std::abs(sy);
+    int rowY = sy > 0 ? 0 : h - rowH;
+    if (rowH) {
+        render(0, rowY, w, rowH);
+    }
+    int colW = std::abs(sx);
+    if (colW) {
+        render(sx > 0 ? 0 : w - colW, sy > 0 ? rowH : 0, colW, h - rowH);
+    }
+}
+
+void GroundLayer::measureTiles() {
+    measured_ = true;
+    reachLeft_ = reachRight_ = reachUp_ = reachDown_ = 0;
+    std::vector<bool> seen(textures_->size(), false);
+    auto measure = [this, &seen](std::int16_t id) {
+        if (id < 0 || std::size_t(id) >= seen.size() || seen[id]) { return; }
+        seen[id] = true;
+        const auto *tile = cache_.get(id, (*textures_)[id]);
+        if (!tile) { return; }
+        reachLeft_ = std::max(reachLeft_, int(tile->originX));
+        reachRight_ = std::max(reachRight_, tile->extent - tile->originX);
+        reachUp_ = std::max(reachUp_, int(tile->originY));
+        reachDown_ = std::max(reachDown_, tile->height - tile->originY);
+    };
+    measure(0);
+    for (const auto &ci: *cells_) {
+        measure(ci.earthId);
+        if (ci.surfaceId) { measure(ci.surfaceId); }
+    }
+}
+
+void GroundLayer::render(int clipX, int clipY, int clipW, int clipH) {
+    if (!measured_) { measureTiles(); }
+    int cellDiffX = cellWidth_ / 2;
+    int cellDiffY = cellHeight_ / 2;
+    int nx = width_ / 2 + cellWidth_ * 2;
+    int ny = height_ / 2 + cellHeight_ * 2;
+    int cx = (nx / cellDiffX + ny / cellDiffY) / 2;
+    int cy = (ny / cellDiffY - nx / cellDiffX) / 2;
+    int wcount = nx * 2 / cellWidth_;
+    int hcount = (ny * 2 + 4 * cellHeight_) / cellDiffY;
+    int tx = width_ / 2 - (cx - cy) * cellDiffX;
+    int ty = height_ / 2 + cellDiffY - (cx + cy) * cellDiffY;
+    cx = cameraX_ - cx; cy = cameraY_ - cy;
+    int delta = -GlobalMapWidth + 1;
+    const auto &cells = *cells_;
+    const auto &textures = *textures_;
+    auto *pixels = pixels_.data();
+    for (int y = clipY; y < clipY + clipH; ++y) {
+        memset(pixels + y * width_ + clipX, 0, clipW * sizeof(std::uint32_t));
+    }
+    rasterizer_.begin(cache_, pixels, width_, clipX, clipY, clipW, clipH);
+    for (int j = hcount; j; --j) {
+        /* Only the cells whose tiles can reach into the clip rectangle */
+        if (ty + reachDown_ > clipY && ty - reachUp_ < clipY + clipH) {
+            int first = std::max(floorDiv(clipX - reachRight_ - tx, cellWidth_) + 1, 0);
+            int last = std::min(floorDiv(clipX + clipW + reachLeft_ - tx - 1, cellWidth_), wcount - 1);
+            int x = cx + first, y = cy - first;
+            int dx = tx + first * cellWidth_;
+            int offset = y * GlobalMapWidth + x;
+            for (int i = first; i <= last; ++i, dx += cellWidth_, offset += delta, ++x, --y) {
+                if (x < 0 || x >= GlobalMapWidth || y < 0 || y >= GlobalMapHeight) {
+                    rasterizer_.draw(0, textures[0], dx, ty);
+                    continue;
+                }
+                const auto &ci = cells[offset];
+                rasterizer_.draw(ci.earthId, textures[ci.earthId], dx, ty);
+                if (ci.surfaceId) {
+                    rasterizer_.draw(ci.surfaceId, textures[ci.surfaceId], dx, ty);
+                }
+            }
+        }
+        if (j % 2) {
+            ++cx;
+            tx += cellDiffX;
+            ty += cellDiffY;
+        } else {
+            ++cy;
+            tx -= cellDiffX;
+            ty += cellDiffY;
+        }
+    }
+    rasterizer_.flush();
+}
+
+}
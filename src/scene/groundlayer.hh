@@ -0,0 +1,72 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "content/globalcells.hh"
+
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace hojy::scene {
+
+class TileCache;
+class TileRasterizer;
+
+/* Earth and surface layers of the global map, kept in a pixel buffer that
+ * follows the camera: a step shifts what is still valid and only the strips
+ * uncovered along the two edges are drawn again. */
+class GroundLayer final {
+public:
+    GroundLayer(TileCache &cache, TileRasterizer &rasterizer) noexcept: cache_(cache), rasterizer_(rasterizer) {}
+
+    /* GlobalMapWidth x GlobalMapHeight cells and the MMAP tiles they refer to,
+     * both must outlive the layer */
+    void setMap(const std::vector<content::GlobalCell> *cells, const std::vector<std::string_view> *textures,
+                int cellWidth, int cellHeight);
+    void resize(int width, int height);
+    void invalidate() { valid_ = false; }
+    /* Brings the pixels to the view centered on cell (cameraX, cameraY) */
+    void update(int cameraX, int cameraY);
+
+    [[nodiscard]] const std::uint32_t *pixels() const { return pixels_.data(); }
+    [[nodiscard]] int width() const { return width_; }
+    [[nodiscard]] int height() const { return height_; }
+
+private:
+    void measureTiles();
+    void render(int clipX, int clipY, int clipW, int clipH);
+
+private:
+    TileCache &cache_;
+    TileRasterizer &rasterizer_;
+    const std::vector<content::GlobalCell> *cells_ = nullptr;
+    const std::vector<std::string_view> *textures_ = nullptr;
+    int cellWidth_ = 0, cellHeight_ = 0;
+    int width_ = 0, height_ = 0;
+    std::vector<std::uint32_t> pixels_;
+    int cameraX_ = 0, cameraY_ = 0;
+    bool valid_ = false;
+    /* How far any ground tile reaches from the point it is drawn at */
+    bool measured_ = false;
+    int reachLeft_ = 0, reachRight_ = 0, reachUp_ = 0, reachDown_ = 0;
+};
+
+}
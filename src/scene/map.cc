@@ -35,6 +35,8 @@ Map::Map(Renderer *renderer, int x, int y, int width, int height, std::pair<int,
     textureMgr_.clear();
     textureMgr_.setRenderer(renderer_);
     textureMgr_.setPalette(gNormalPalette);
+    tileCache_.setPalette(gNormalPalette);
+    tileCache_.setBudget(std::size_t(core::config.tileCacheSize()) * 1024U * 1024U);
     drawingTerrainTex_->enableBlendMode(true);
     miniPanelTex_->enableBlendMode(true);
 
@@ -52,10 +54,9 @@ Map::~Map() {
     delete drawingTerrainTex_;
 }
 
-const std::string &Map::texData(std::int16_t id) const {
+std::string_view Map::texData(std::int16_t id) const {
     if (id < 0 || id >= texData_.size()) {
-        static const std::string dummy;
-        return dummy;
+        return {};
     }
     return texData_[id];
 }
@@ -20,8 +20,13 @@
 #pragma once
 
 #include "node.hh"
+#include "content/grparchive.hh"
 #include "texture.hh"
+#include "tilecache.hh"
+#include "tilerasterizer.hh"
 
+#include <string_view>
+#include <vector>
 #include <cstdint>
 
 namespace hojy::scene {
@@ -43,7 +48,7 @@ public:
     ~Map() override;
 
     [[nodiscard]] std::int16_t subMapId() const { return subMapId_; }
-    [[nodiscard]] const std::string &texData(std::int16_t id) const;
+    [[nodiscard]] std::string_view texData(std::int16_t id) const;
     [[nodiscard]] const Texture *getOrLoadTexture(std::int16_t id);
 
     void resetFrame();
@@ -64,6 +69,8 @@ protected:
 
 protected:
     TextureMgr textureMgr_;
+    TileCache tileCache_;
+    TileRasterizer rasterizer_;
     std::int16_t subMapId_ = -1;
     int cameraX_ = 0, cameraY_ = 0;
 
@@ -78,7 +85,9 @@ protected:
     std::uint64_t eachFrameTime_ = 0;
     std::int32_t mapWidth_ = 0, mapHeight_ = 0, cellWidth_ = 0, cellHeight_ = 0;
     std::int32_t offsetX_ = 0, offsetY_ = 0;
-    std::vector<std::string> texData_;
+    /* Views into texArchives_, which keep the mappings alive */
+    std::vector<std::string_view> texData_;
+    std::vector<content::GrpArchive> texArchives_;
     Texture *drawingTerrainTex_ = nullptr;
     Texture *miniMapTex_ = nullptr;
     Texture *miniPanelTex_ = nullptr;
@@ -162,7 +162,7 @@ event::VmResult MapWithEvent::execute(const event::Instruction &instruction,
     case 8: {
         std::int16_t value = 0;
         if (!mov(v2, 1, value)) { return fault("event memory read out of range"); }
-        const auto &text = ::hojy::content::gEvent.origTalk(value);
+        const auto text = ::hojy::content::gEvent.origTalk(value);
         if (!memory.writeCString(v3, text)) {
             return fault("event talk string exceeds memory");
         }
@@ -39,10 +39,13 @@ bool decodeStandardInstruction(const std::vector<std::int16_t> &program,
 
     instruction.wordOffset = programCounter;
     instruction.opcode = program[programCounter];
-    instruction.operands.assign(
-        program.begin() + static_cast<std::ptrdiff_t>(programCounter + 1),
-        program.begin() + static_cast<std::ptrdiff_t>(programCounter + 1
-                                                       + argumentCount));
+    if (!instruction.operands.assign(
+            program.begin() + static_cast<std::ptrdiff_t>(programCounter + 1),
+            program.begin() + static_cast<std::ptrdiff_t>(programCounter + 1
+                                                           + argumentCount))) {
+        error = "too many legacy event operands";
+        return false;
+    }
     instruction.conditional = conditional;
     instruction.nextWordOffset = programCounter + 1 + payloadWords;
     if (!conditional) {
@@ -376,7 +379,7 @@ void MapWithEvent::continueEvents(bool result) {
 }
 
 void MapWithEvent::runEvent(std::int16_t evt) {
-    eventVm_.loadLegacy(::hojy::content::gEvent.event(evt));
+    eventVm_.loadLegacy(::hojy::content::gEvent.program(evt, legacyDecoder()));
     currEventPaused_ = eventVm_.legacyActive();
     pendingSubEventWaiting_ = false;
     if (!eventVm_.legacyDispatching()) {
@@ -27,6 +27,7 @@
 #include "world/action.hh"
 #include "world/savedata.hh"
 #include "world/strings.hh"
+#include "core/config.hh"
 #include "util/conv.hh"
 #include "util/random.hh"
 #include "util/math.hh"
@@ -35,13 +36,38 @@
 
 namespace hojy::scene {
 
-MapWithEvent::~MapWithEvent() = default;
-
-
-
-
-
+MapWithEvent::~MapWithEvent() {
+    /* The pool runs what is still queued before joining, those tasks see the new generation and return */
+    ++talkWarmGeneration_;
+    talkWarmer_.reset();
+}
 
+void MapWithEvent::warmTalks(const std::vector<std::int16_t> &eventIds) {
+    const auto generation = ++talkWarmGeneration_;
+    std::vector<std::size_t> talks;
+    for (auto id: eventIds) {
+        if (id <= 0) { continue; }
+        /* Decodes the programs of the map ahead of use as well */
+        const auto program = ::hojy::content::gEvent.program(id, legacyDecoder());
+        for (const auto &step: program->steps()) {
+            const auto &instruction = step.instruction;
+            if (step.error < 0 && instruction.opcode == 1
+                && !instruction.operands.empty() && instruction.operands[0] >= 0) {
+                talks.push_back(static_cast<std::size_t>(instruction.operands[0]));
+            }
+        }
+    }
+    /* More lines than the cache holds would only push each other out */
+    talks.resize(std::min(talks.size(), static_cast<std::size_t>(core::config.talkCacheSize())));
+    if (talks.empty()) { return; }
+    if (!talkWarmer_) { talkWarmer_ = std::make_unique<util::ThreadPool>(1); }
+    talkWarmer_->post([this, generation, talks = std::move(talks)]() {
+        for (auto index: talks) {
+            if (talkWarmGeneration_ != generation) { return; }
+            ::hojy::content::gEvent.prefetchTalk(index);
+        }
+    });
+}
 
 }
 
@@ -22,9 +22,12 @@
 #include "map.hh"
 #include "extendednode.hh"
 #include "event/vm.hh"
+#include "util/threadpool.hh"
 
+#include <atomic>
 #include <functional>
 #include <list>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -83,6 +86,9 @@ protected:
     virtual void setCellTexture(int x, int y, int layer, std::int16_t tex) {}
 
     void ensureExtendedNode();
+    /* Converts the talk lines used by these event programs on a background
+     * thread, dropping what is left from an earlier call */
+    void warmTalks(const std::vector<std::int16_t> &eventIds);
 
 private:
     static bool closePopup(MapWithEvent *map);
@@ -184,6 +190,10 @@ protected:
 
     ExtendedNode *extendedNode_ = nullptr;
     event::Vm eventVm_;
+
+private:
+    std::atomic<std::uint32_t> talkWarmGeneration_ {0};
+    std::unique_ptr<util::ThreadPool> talkWarmer_;
 };
 
 }
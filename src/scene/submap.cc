@@ -21,7 +21,7 @@
 
 #include "window.hh"
 #include "colorpalette.hh"
-#include "content/grpdata.hh"
+#include "content/grparchive.hh"
 #include "world/savedata.hh"
 #include <fmt/format.h>
 
@@ -41,23 +41,27 @@ bool SubMap::load(std::int16_t subMapId) {
     if (subMapLoaded_.find(subMapId) == subMapLoaded_.end()) {
         mapWidth_ = ::hojy::content::SubMapWidth;
         mapHeight_ = ::hojy::content::SubMapHeight;
-        if (::hojy::content::GrpData::loadData("SDX", "SMP", texData_)) {
+        ::hojy::content::GrpArchive archive;
+        if (archive.open("SDX", "SMP")) {
+            texData_ = archive.entries();
+            texArchives_.clear();
+            texArchives_.emplace_back(std::move(archive));
             for (std::int16_t i = 0; i < 1000; ++i) {
                 subMapLoaded_.insert(i);
             }
         } else {
-            ::hojy::content::GrpData::DataSet dset;
-            if (!::hojy::content::GrpData::loadData(fmt::format("SDX{:03}", subMapId), fmt::format("SMP{:03}", subMapId), dset)) {
+            if (!archive.open(fmt::format("SDX{:03}", subMapId), fmt::format("SMP{:03}", subMapId))) {
                 return false;
             }
-            if (dset.size() > texData_.size()) {
-                texData_.resize(dset.size());
+            if (archive.size() > texData_.size()) {
+                texData_.resize(archive.size());
             }
-            for (size_t i = 0; i < dset.size(); ++i) {
-                if (dset[i].empty()) { continue; }
+            for (size_t i = 0; i < archive.size(); ++i) {
+                if (archive[i].empty()) { continue; }
                 if (!texData_[i].empty()) { continue; }
-                texData_[i] = std::move(dset[i]);
+                texData_[i] = archive[i];
             }
+            texArchives_.emplace_back(std::move(archive));
             subMapLoaded_.insert(subMapId);
         }
     }
@@ -107,6 +111,13 @@ bool SubMap::load(std::int16_t subMapId) {
     }
     resetFrame();
 
+    std::vector<std::int16_t> eventIds;
+    eventIds.reserve(::hojy::content::SubMapEventCount * 3);
+    for (auto &ev: events) {
+        eventIds.insert(eventIds.end(), std::begin(ev.event), std::end(ev.event));
+    }
+    warmTalks(eventIds);
+
     subMapId_ = subMapId;
     return true;
 }
@@ -133,7 +144,6 @@ void SubMap::render() {
         int cx, cy, tx, ty;
         int delta = -mapWidth_ + 1;
 
-        const auto *colors = gNormalPalette.colors();
         auto *curTex = drawingTerrainTex_;
         int pitch;
         std::uint32_t *pixels = curTex->lock(pitch);
@@ -178,6 +188,7 @@ void SubMap::render() {
         ty = int(auxHeight_) / 2 + cellDiffY - (cx + cy) * cellDiffY;
         cx = camX - cx; cy = camY - cy;
         int texCount = texData_.size();
+        rasterizer_.begin(tileCache_, pixels, pitch, aheight);
         for (int j = hcount; j; --j) {
             int x = cx, y = cy;
             int dx = tx;
@@ -189,23 +200,25 @@ void SubMap::render() {
                 auto &ci = cellInfo_[offset];
                 auto h = ci.buildingDeltaY;
                 /* if (h > 0) {  NOTE: commented out, see notes above */
-                Texture::renderRLE(texData_[ci.earthId], colors, pixels, pitch, aheight, dx, ty);
+                rasterizer_.draw(ci.earthId, texData_[ci.earthId], dx, ty);
                 /* } */
                 if (ci.buildingId > 0 && ci.buildingId < texCount) {
-                    Texture::renderRLE(texData_[ci.buildingId], colors, pixels, pitch, aheight, dx, ty - h);
+                    rasterizer_.draw(ci.buildingId, texData_[ci.buildingId], dx, ty - h);
                 }
                 if (x == curX && y == curY) {
+                    rasterizer_.flush();
                     curTex->unlock();
                     curTex = drawingTerrainTex2_;
                     pixels = curTex->lock(pitch);
                     memset(pixels, 0, pitch * auxHeight_ * sizeof(std::uint32_t));
+                    rasterizer_.begin(tileCache_, pixels, pitch, aheight);
                     charHeight_ = h;
                 }
                 if (ci.eventId > 0 && ci.eventId < texCount) {
-                    Texture::renderRLE(texData_[ci.eventId], colors, pixels, pitch, aheight, dx, ty - h);
+                    rasterizer_.draw(ci.eventId, texData_[ci.eventId], dx, ty - h);
                 }
                 if (ci.decorationId > 0 && ci.decorationId < texCount) {
-                    Texture::renderRLE(texData_[ci.decorationId], colors, pixels, pitch, aheight, dx, ty - ci.decorationDeltaY);
+                    rasterizer_.draw(ci.decorationId, texData_[ci.decorationId], dx, ty - ci.decorationDeltaY);
                 }
             }
             if (j % 2) {
@@ -218,6 +231,7 @@ void SubMap::render() {
                 ty += cellDiffY;
             }
         }
+        rasterizer_.flush();
         curTex->unlock();
     }
 
@@ -22,7 +22,10 @@
 #include "renderer.hh"
 #include "colorpalette.hh"
 #include "rectpacker.hh"
+#include "texture_kernels.hh"
+#include "content/grparchive.hh"
 #include <SDL.h>
+#include <cstring>
 
 namespace hojy::scene {
 
@@ -116,9 +119,10 @@ void Texture::unlock() {
     SDL_UnlockTexture(static_cast<SDL_Texture*>(data_));
 }
 
-Texture *Texture::loadFromRLE(Renderer *renderer, const std::string &data, const ColorPalette &palette) {
-    if (data.empty()) { return nullptr; }
-    const auto *arr = reinterpret_cast<const uint16_t*>(data.data());
+Texture *Texture::loadFromRLE(Renderer *renderer, std::string_view data, const ColorPalette &palette) {
+    if (data.size() < 8) { return nullptr; }
+    std::uint16_t arr[4];
+    memcpy(arr, data.data(), sizeof(arr));
     auto w = arr[0], h = arr[1];
     auto *tex = Texture::create(renderer, w, h);
     if (!tex) { return nullptr; }
@@ -141,19 +145,19 @@ Texture *Texture::loadFromRAW(Renderer *renderer, const std::string &data, int w
     const auto *buf = reinterpret_cast<const uint8_t*>(data.data());
     auto *tex = Texture::create(renderer, width, height);
     if (!tex) { return nullptr; }
-    const auto *colors = palette.colors();
+    /* Index 0 is opaque black in raw images */
+    std::uint32_t colors[256];
+    memcpy(colors, palette.colors(), sizeof(colors));
+    colors[0] = 0xFF000000U;
+    const auto expand = detail::pixelKernels().expand;
     std::uint32_t *pixels;
     int pitch;
     SDL_LockTexture(static_cast<SDL_Texture*>(tex->data()), nullptr, reinterpret_cast<void**>(&pixels), &pitch);
     pitch /= sizeof(std::uint32_t);
     int h = height;
     while (h--) {
-        int w = width;
-        auto *ptr = pixels;
-        while (w--) {
-            auto c = *buf++;
-            *ptr++ = c ? colors[c] : 0xFF000000U;
-        }
+        expand(pixels, buf, colors, width);
+        buf += width;
         pixels += pitch;
     }
     SDL_UnlockTexture(static_cast<SDL_Texture*>(tex->data()));
@@ -164,226 +168,6 @@ Texture *Texture::loadFromRAW(Renderer *renderer, const std::string &data, int w
     return tex;
 }
 
-void Texture::renderRLE(const std::string &data, const std::uint32_t *colors, std::uint32_t *pixels, int pitch, int height, int ox, int oy, bool ignoreOrigin) {
-    size_t left = data.size();
-    if (left < 8) {
-        return;
-    }
-    const auto *obuf = reinterpret_cast<const std::uint8_t*>(data.data());
-    struct Header {
-        std::int16_t w, h, x, y;
-    };
-    const auto *hdr = reinterpret_cast<const Header*>(obuf);
-    obuf += 8;
-    left -= 8;
-    if (!ignoreOrigin) {
-        ox -= hdr->x;
-        oy -= hdr->y;
-    }
-    std::int32_t w = hdr->w, h = hdr->h;
-    if (ox + w <= 0 || oy + h <= 0) { return; }
-    while (left && h--) {
-        auto size = std::uint32_t(*obuf++);
-        if (--left < size) {
-            break;
-        }
-        const auto *buf = obuf;
-        left -= size;
-        obuf += size;
-        if (oy < 0) { ++oy; continue; }
-        if (oy >= height) { break; }
-        auto *ptr = pixels + ox + pitch * (oy++);
-        int x = ox;
-        while (size) {
-            auto cnt = *buf++;
-            --size;
-            if (!size) {
-                break;
-            }
-            ptr += cnt;
-            x += cnt;
-            cnt = *buf++;
-            --size;
-            if (size < cnt) {
-                break;
-            }
-            if (x < 0) {
-                if (x + cnt <= 0) {
-                    ptr += cnt;
-                    buf += cnt;
-                } else {
-                    ptr -= x;
-                    buf -= x;
-                    for (int z = x + cnt; z; --z) {
-                        *ptr++ = colors[*buf++];
-                    }
-                }
-            } else if (x + cnt > pitch) {
-                if (x >= pitch) {
-                    ptr += cnt;
-                    buf += cnt;
-                } else {
-                    for (int z = pitch - x; z; --z) {
-                        *ptr++ = colors[*buf++];
-                    }
-                    int offset = x + cnt - pitch;
-                    ptr += offset;
-                    buf += offset;
-                }
-            } else {
-                for (int z = cnt; z; --z) {
-                    *ptr++ = colors[*buf++];
-                }
-            }
-            x += cnt;
-            size -= cnt;
-        }
-    }
-}
-
-inline std::uint32_t blendAlpha(std::uint32_t p1, std::uint32_t p2) {
-    static const std::uint32_t AMASK = 0xFF000000;
-    static const std::uint32_t RBMASK = 0x00FF00FF;
-    static const std::uint32_t GMASK = 0x0000FF00;
-    std::uint32_t a = (p2 & AMASK) >> 24;
-    std::uint32_t na = 255 - a;
-    std::uint32_t rb = (na * (p1 & RBMASK)) + (a * (p2 & RBMASK));
-    rb = (rb + 0x10001 + ((rb >> 8) & 0xFF00FF)) >> 8;
-    std::uint32_t g = (na * (p1 & GMASK)) + (a * (p2 & GMASK));
-    g = ((g + 1) * 257) >> 16;
-    return (rb & RBMASK) | (g & GMASK) | 0xFF000000u;
-}
-
-void Texture::renderRLEBlending(const std::string &data, const std::uint32_t *colors, std::uint32_t *pixels, int pitch, int height, int ox, int oy, bool ignoreOrigin) {
-    size_t left = data.size();
-    if (left < 8) {
-        return;
-    }
-    const auto *obuf = reinterpret_cast<const std::uint8_t*>(data.data());
-    struct Header {
-        std::int16_t w, h, x, y;
-    };
-    const auto *hdr = reinterpret_cast<const Header*>(obuf);
-    obuf += 8;
-    left -= 8;
-    if (!ignoreOrigin) {
-        ox -= hdr->x;
-        oy -= hdr->y;
-    }
-    std::int32_t w = hdr->w, h = hdr->h;
-    if (ox + w <= 0 || oy + h <= 0) { return; }
-    while (left && h--) {
-        auto size = std::uint32_t(*obuf++);
-        if (--left < size) {
-            break;
-        }
-        const auto *buf = obuf;
-        left -= size;
-        obuf += size;
-        if (oy < 0) { ++oy; continue; }
-        if (oy >= height) { break; }
-        auto *ptr = pixels + ox + pitch * (oy++);
-        int x = ox;
-        while (size) {
-            auto cnt = *buf++;
-            --size;
-            if (!size) {
-                break;
-            }
-            ptr += cnt;
-            x += cnt;
-            cnt = *buf++;
-            --size;
-            if (size < cnt) {
-                break;
-            }
-            if (x < 0) {
-                if (x + cnt <= 0) {
-                    ptr += cnt;
-                    buf += cnt;
-                } else {
-                    ptr -= x;
-                    buf -= x;
-                    for (int z = x + cnt; z; --z) {
-                        *ptr = blendAlpha(*ptr, colors[*buf++]);
-                        ++ptr;
-                    }
-                }
-            } else if (x + cnt > pitch) {
-                if (x >= pitch) {
-                    ptr += cnt;
-                    buf += cnt;
-                } else {
-                    for (int z = pitch - x; z; --z) {
-                        *ptr = blendAlpha(*ptr, colors[*buf++]);
-                        ++ptr;
-                    }
-                    int offset = x + cnt - pitch;
-                    ptr += offset;
-                    buf += offset;
-                }
-            } else {
-                for (int z = cnt; z; --z) {
-                    *ptr = blendAlpha(*ptr, colors[*buf++]);
-                    ++ptr;
-                }
-            }
-            x += cnt;
-            size -= cnt;
-        }
-    }
-}
-
-std::uint32_t Texture::calcRLEAvgColor(const std::string &data, const std::uint32_t *colors) {
-    size_t left = data.size();
-    if (left < 8) {
-        return 0;
-    }
-    const auto *buf = reinterpret_cast<const std::uint8_t*>(data.data());
-    struct Header {
-        std::int16_t w, h, x, y;
-    };
-    const auto *hdr = reinterpret_cast<const Header*>(buf);
-    if (hdr->w == 0 && hdr->h == 0) {
-        return 0;
-    }
-    buf += 8;
-    left -= 8;
-    std::uint32_t r = 0, g = 0, b = 0, pixcount = 0;
-    std::int32_t y = 0, w = hdr->w, h = hdr->h;
-    while (left && y < h) {
-        auto size = std::uint32_t(*buf++);
-        if (--left < size) {
-            break;
-        }
-        left -= size;
-        while (size) {
-            auto cnt = *buf++;
-            --size;
-            if (!size) {
-                break;
-            }
-            cnt = *buf++;
-            --size;
-            if (size < cnt) {
-                break;
-            }
-            pixcount += cnt;
-            size -= cnt;
-            for (; cnt; --cnt) {
-                const auto *c = reinterpret_cast<const std::uint8_t*>(&colors[*buf++]);
-                r += c[2];
-                g += c[1];
-                b += c[0];
-            }
-        }
-    }
-    r /= pixcount;
-    g /= pixcount;
-    b /= pixcount;
-    return b | (g << 8) | (r << 16);
-}
-
 TextureSlice::TextureSlice(Texture *tex, std::int16_t x, std::int16_t y, std::int16_t w, std::int16_t h, std::int16_t ox, std::int16_t oy):
     x_(x), y_(y) {
     data_ = tex->data();
@@ -409,12 +193,16 @@ void TextureMgr::setPalette(const ColorPalette &col) {
     palette_ = &col;
 }
 
-Texture *TextureMgr::loadFromRLE(const std::string &data, std::int16_t index) {
+Texture *TextureMgr::loadFromRLE(std::string_view data, std::int16_t index) {
     auto ite = textures_.find(index);
     if (ite != textures_.end()) {
         return ite->second;
     }
-    const auto *arr = reinterpret_cast<const uint16_t*>(data.data());
+    if (data.size() < 8) {
+        return nullptr;
+    }
+    std::uint16_t arr[4];
+    memcpy(arr, data.data(), sizeof(arr));
     auto w = arr[0], h = arr[1];
     std::int16_t x, y;
     auto rpidx = rectPacker_->pack(w, h, x, y);
@@ -449,6 +237,13 @@ void TextureMgr::loadFromRLE(const std::vector<std::string> &data) {
     }
 }
 
+void TextureMgr::loadFromRLE(const content::GrpArchive &archive) {
+    int sz = int(archive.size());
+    for (int i = 0; i < sz; ++i) {
+        loadFromRLE(archive[i], i);
+    }
+}
+
 Texture *TextureMgr::loadFromRAW(const std::string &data, int width, int height, std::int16_t index) {
     if (textures_.find(index) != textures_.end()) {
         return nullptr;
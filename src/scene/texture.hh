@@ -22,8 +22,13 @@
 #include <unordered_map>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <cstdint>
 
+namespace hojy::content {
+class GrpArchive;
+}
+
 namespace hojy::scene {
 
 class Renderer;
@@ -57,11 +62,11 @@ public:
     std::uint32_t *lock(int &pitch, int x, int y, int w, int h);
     void unlock();
 
-    static Texture *loadFromRLE(Renderer *renderer, const std::string &data, const ColorPalette &palette);
+    static Texture *loadFromRLE(Renderer *renderer, std::string_view data, const ColorPalette &palette);
     static Texture *loadFromRAW(Renderer *renderer, const std::string &data, int width, int height, const ColorPalette &palette);
-    static void renderRLE(const std::string &data, const std::uint32_t *colors, std::uint32_t *pixels, int pitch, int height, int x, int y, bool ignoreOrigin = false);
-    static void renderRLEBlending(const std::string &data, const std::uint32_t *colors, std::uint32_t *pixels, int pitch, int height, int x, int y, bool ignoreOrigin = false);
-    static std::uint32_t calcRLEAvgColor(const std::string &data, const std::uint32_t *colors);
+    static void renderRLE(std::string_view data, const std::uint32_t *colors, std::uint32_t *pixels, int pitch, int height, int x, int y, bool ignoreOrigin = false);
+    static void renderRLEBlending(std::string_view data, const std::uint32_t *colors, std::uint32_t *pixels, int pitch, int height, int x, int y, bool ignoreOrigin = false);
+    static std::uint32_t calcRLEAvgColor(std::string_view data, const std::uint32_t *colors);
 
 protected:
     void *data_ = nullptr;
@@ -87,8 +92,9 @@ public:
     ~TextureMgr();
     inline void setRenderer(Renderer *renderer) { renderer_ = renderer; }
     void setPalette(const ColorPalette &col);
-    Texture *loadFromRLE(const std::string &data, std::int16_t index);
+    Texture *loadFromRLE(std::string_view data, std::int16_t index);
     void loadFromRLE(const std::vector<std::string> &data);
+    void loadFromRLE(const content::GrpArchive &archive);
     Texture *loadFromRAW(const std::string &data, int width, int height, std::int16_t index);
     void loadFromRAW(const std::vector<std::string> &data, int width, int height);
     const Texture *operator[](std::int32_t id) const;
@@ -0,0 +1,250 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "texture_kernels.hh"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define HOJY_KERNELS_X86
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define HOJY_TARGET_SSE2
+#define HOJY_TARGET_AVX2
+#else
+#define HOJY_TARGET_SSE2 __attribute__((target("sse2")))
+#define HOJY_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define HOJY_KERNELS_NEON
+#include <arm_neon.h>
+#endif
+
+namespace hojy::scene::detail {
+
+namespace {
+
+inline std::uint32_t blendAlpha(std::uint32_t p1, std::uint32_t p2) {
+    static const std::uint32_t AMASK = 0xFF000000;
+    static const std::uint32_t RBMASK = 0x00FF00FF;
+    static const std::uint32_t GMASK = 0x0000FF00;
+    std::uint32_t a = (p2 & AMASK) >> 24;
+    std::uint32_t na = 255 - a;
+    std::uint32_t rb = (na * (p1 & RBMASK)) + (a * (p2 & RBMASK));
+    rb = (rb + 0x10001 + ((rb >> 8) & 0xFF00FF)) >> 8;
+    std::uint32_t g = (na * (p1 & GMASK)) + (a * (p2 & GMASK));
+    g = ((g + 1) * 257) >> 16;
+    return (rb & RBMASK) | (g & GMASK) | 0xFF000000u;
+}
+
+void expandScalar(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count) {
+    for (; count; --count) {
+        *dst++ = colors[*src++];
+    }
+}
+
+void blendScalar(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count) {
+    for (; count; --count, ++dst) {
+        *dst = blendAlpha(*dst, colors[*src++]);
+    }
+}
+
+/* The vector blends work on 16-bit channel products v = na * dst + a * src,
+ * which never exceed 255 * 255. blendAlpha() rounds red and blue as
+ * (v + 1 + (v >> 8)) >> 8 and green as (257 * v + 1) >> 16, the vector code
+ * keeps both so the results stay bit-identical. */
+
+#ifdef HOJY_KERNELS_X86
+
+HOJY_TARGET_SSE2 inline __m128i blendChannelsSSE2(__m128i d, __m128i s) {
+    const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+    const __m128i v = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(255), alpha)),
+                                    _mm_mullo_epi16(s, alpha));
+    const __m128i rb = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(v, _mm_set1_epi16(1)), _mm_srli_epi16(v, 8)), 8);
+    const __m128i c257 = _mm_set1_epi16(257);
+    const __m128i g = _mm_sub_epi16(_mm_mulhi_epu16(v, c257),
+                                    _mm_cmpeq_epi16(_mm_mullo_epi16(v, c257), _mm_set1_epi16(-1)));
+    const __m128i gmask = _mm_set_epi16(0, 0, -1, 0, 0, 0, -1, 0);
+    return _mm_or_si128(_mm_and_si128(gmask, g), _mm_andnot_si128(gmask, rb));
+}
+
+HOJY_TARGET_SSE2 inline __m128i blendSSE2(__m128i d, __m128i s) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i lo = blendChannelsSSE2(_mm_unpacklo_epi8(d, zero), _mm_unpacklo_epi8(s, zero));
+    const __m128i hi = blendChannelsSSE2(_mm_unpackhi_epi8(d, zero), _mm_unpackhi_epi8(s, zero));
+    return _mm_or_si128(_mm_packus_epi16(lo, hi), _mm_set1_epi32(int(0xFF000000u)));
+}
+
+HOJY_TARGET_SSE2 void expandSSE2(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count) {
+    for (; count >= 4; count -= 4, src += 4, dst += 4) {
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst),
+                         _mm_set_epi32(int(colors[src[3]]), int(colors[src[2]]), int(colors[src[1]]), int(colors[src[0]])));
+    }
+    expandScalar(dst, src, colors, count);
+}
+
+HOJY_TARGET_SSE2 void blendSSE2(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count) {
+    for (; count >= 4; count -= 4, src += 4, dst += 4) {
+        const __m128i s = _mm_set_epi32(int(colors[src[3]]), int(colors[src[2]]), int(colors[src[1]]), int(colors[src[0]]));
+        const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), blendSSE2(d, s));
+    }
+    blendScalar(dst, src, colors, count);
+}
+
+/* vpgatherdd is slower than plain loads for the short runs tiles are made of */
+HOJY_TARGET_AVX2 inline __m256i loadColorsAVX2(const std::uint8_t *src, const std::uint32_t *colors) {
+    return _mm256_set_epi32(int(colors[src[7]]), int(colors[src[6]]), int(colors[src[5]]), int(colors[src[4]]),
+                            int(colors[src[3]]), int(colors[src[2]]), int(colors[src[1]]), int(colors[src[0]]));
+}
+
+HOJY_TARGET_AVX2 inline __m256i blendChannelsAVX2(__m256i d, __m256i s) {
+    const __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(s, 0xFF), 0xFF);
+    const __m256i v = _mm256_add_epi16(_mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(255), alpha)),
+                                       _mm256_mullo_epi16(s, alpha));
+    const __m256i rb = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(v, _mm256_set1_epi16(1)), _mm256_srli_epi16(v, 8)), 8);
+    const __m256i c257 = _mm256_set1_epi16(257);
+    const __m256i g = _mm256_sub_epi16(_mm256_mulhi_epu16(v, c257),
+                                       _mm256_cmpeq_epi16(_mm256_mullo_epi16(v, c257), _mm256_set1_epi16(-1)));
+    const __m256i gmask = _mm256_set_epi16(0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0, 0, 0, -1, 0);
+    return _mm256_or_si256(_mm256_and_si256(gmask, g), _mm256_andnot_si256(gmask, rb));
+}
+
+HOJY_TARGET_AVX2 void expandAVX2(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count) {
+    for (; count >= 8; count -= 8, src += 8, dst += 8) {
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), loadColorsAVX2(src, colors));
+    }
+    expandScalar(dst, src, colors, count);
+}
+
+HOJY_TARGET_AVX2 void blendAVX2(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count) {
+    const __m256i zero = _mm256_setzero_si256();
+    for (; count >= 8; count -= 8, src += 8, dst += 8) {
+        const __m256i s = loadColorsAVX2(src, colors);
+        const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst));
+        /* unpack and pack both work per 128-bit lane, so pixel order is kept */
+        const __m256i lo = blendChannelsAVX2(_mm256_unpacklo_epi8(d, zero), _mm256_unpacklo_epi8(s, zero));
+        const __m256i hi = blendChannelsAVX2(_mm256_unpackhi_epi8(d, zero), _mm256_unpackhi_epi8(s, zero));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst),
+                            _mm256_or_si256(_mm256_packus_epi16(lo, hi), _mm256_set1_epi32(int(0xFF000000u))));
+    }
+    blendSSE2(dst, src, colors, count);
+}
+
+bool cpuHasAVX2() {
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) { return false; }
+    __cpuid(info, 1);
+    /* OSXSAVE and AVX, then the OS must save the YMM state */
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) { return false; }
+    if ((_xgetbv(0) & 6) != 6) { return false; }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool cpuHasSSE2() {
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    return true;
+#elif defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[3] & (1 << 26)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse2");
+#endif
+}
+
+#endif
+
+#ifdef HOJY_KERNELS_NEON
+
+inline uint16x8_t blendChannelsNEON(uint8x8_t d, uint8x8_t s, uint8x8_t alpha) {
+    const uint16x8_t v = vmlal_u8(vmull_u8(d, vmvn_u8(alpha)), s, alpha);
+    const uint16x8_t rb = vshrq_n_u16(vaddq_u16(vaddq_u16(v, vdupq_n_u16(1)), vshrq_n_u16(v, 8)), 8);
+    const uint32x4_t one = vdupq_n_u32(1);
+    const uint16x8_t g = vcombine_u16(vshrn_n_u32(vmlal_n_u16(one, vget_low_u16(v), 257), 16),
+                                      vshrn_n_u32(vmlal_n_u16(one, vget_high_u16(v), 257), 16));
+    static const std::uint16_t gmask[8] = {0, 0xFFFF, 0, 0, 0, 0xFFFF, 0, 0};
+    return vbslq_u16(vld1q_u16(gmask), g, rb);
+}
+
+void expandNEON(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count) {
+    for (; count >= 4; count -= 4, src += 4, dst += 4) {
+        const std::uint32_t s[4] = {colors[src[0]], colors[src[1]], colors[src[2]], colors[src[3]]};
+        vst1q_u32(dst, vld1q_u32(s));
+    }
+    expandScalar(dst, src, colors, count);
+}
+
+void blendNEON(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count) {
+    for (; count >= 4; count -= 4, src += 4, dst += 4) {
+        const std::uint32_t sc[4] = {colors[src[0]], colors[src[1]], colors[src[2]], colors[src[3]]};
+        const uint32x4_t s32 = vld1q_u32(sc);
+        const uint8x16_t s = vreinterpretq_u8_u32(s32);
+        const uint8x16_t d = vreinterpretq_u8_u32(vld1q_u32(dst));
+        const uint8x16_t alpha = vreinterpretq_u8_u32(vmulq_n_u32(vshrq_n_u32(s32, 24), 0x01010101u));
+        const uint16x8_t lo = blendChannelsNEON(vget_low_u8(d), vget_low_u8(s), vget_low_u8(alpha));
+        const uint16x8_t hi = blendChannelsNEON(vget_high_u8(d), vget_high_u8(s), vget_high_u8(alpha));
+        const uint32x4_t result = vreinterpretq_u32_u8(vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+        vst1q_u32(dst, vorrq_u32(result, vdupq_n_u32(0xFF000000u)));
+    }
+    blendScalar(dst, src, colors, count);
+}
+
+#endif
+
+const PixelKernels scalarKernels {"scalar", expandScalar, blendScalar};
+#ifdef HOJY_KERNELS_X86
+const PixelKernels sse2Kernels {"sse2", expandSSE2, blendSSE2};
+const PixelKernels avx2Kernels {"avx2", expandAVX2, blendAVX2};
+#endif
+#ifdef HOJY_KERNELS_NEON
+const PixelKernels neonKernels {"neon", expandNEON, blendNEON};
+#endif
+
+}
+
+const PixelKernels &pixelKernels() {
+    static const PixelKernels &kernels = *availablePixelKernels().back();
+    return kernels;
+}
+
+std::vector<const PixelKernels*> availablePixelKernels() {
+    std::vector<const PixelKernels*> result {&scalarKernels};
+#ifdef HOJY_KERNELS_X86
+    if (cpuHasSSE2()) {
+        result.push_back(&sse2Kernels);
+        if (cpuHasAVX2()) {
+            result.push_back(&avx2Kernels);
+        }
+    }
+#endif
+#ifdef HOJY_KERNELS_NEON
+    result.push_back(&neonKernels);
+#endif
+    return result;
+}
+
+}
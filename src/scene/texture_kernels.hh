@@ -0,0 +1,40 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+namespace hojy::scene::detail {
+
+/* Palette expansion and alpha blending of 8-bit pixel runs, shared by the RLE
+ * renderers and the tile cache. The widest implementation the running CPU
+ * supports is picked on first use. */
+struct PixelKernels {
+    const char *name;
+    void (*expand)(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count);
+    void (*blend)(std::uint32_t *dst, const std::uint8_t *src, const std::uint32_t *colors, int count);
+};
+
+const PixelKernels &pixelKernels();
+/* Every implementation usable on this CPU, scalar first */
+std::vector<const PixelKernels*> availablePixelKernels();
+
+}
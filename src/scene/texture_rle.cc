@@ -0,0 +1,237 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "texture.hh"
+
+#include "texture_kernels.hh"
+
+#include <cstring>
+
+namespace hojy::scene {
+
+void Texture::renderRLE(std::string_view data, const std::uint32_t *colors, std::uint32_t *pixels, int pitch, int height, int ox, int oy, bool ignoreOrigin) {
+    size_t left = data.size();
+    if (left < 8) {
+        return;
+    }
+    const auto *obuf = reinterpret_cast<const std::uint8_t*>(data.data());
+    struct Header {
+        std::int16_t w, h, x, y;
+    };
+    Header hdr;
+    memcpy(&hdr, obuf, sizeof(hdr));
+    obuf += 8;
+    left -= 8;
+    if (!ignoreOrigin) {
+        ox -= hdr.x;
+        oy -= hdr.y;
+    }
+    std::int32_t w = hdr.w, h = hdr.h;
+    if (ox + w <= 0 || oy + h <= 0) { return; }
+    const auto expand = detail::pixelKernels().expand;
+    while (left && h--) {
+        auto size = std::uint32_t(*obuf++);
+        if (--left < size) {
+            break;
+        }
+        const auto *buf = obuf;
+        left -= size;
+        obuf += size;
+        if (oy < 0) { ++oy; continue; }
+        if (oy >= height) { break; }
+        auto *ptr = pixels + ox + pitch * (oy++);
+        int x = ox;
+        while (size) {
+            auto cnt = *buf++;
+            --size;
+            if (!size) {
+                break;
+            }
+            ptr += cnt;
+            x += cnt;
+            cnt = *buf++;
+            --size;
+            if (size < cnt) {
+                break;
+            }
+            if (x < 0) {
+                if (x + cnt <= 0) {
+                    ptr += cnt;
+                    buf += cnt;
+                } else {
+                    ptr -= x;
+                    buf -= x;
+                    expand(ptr, buf, colors, x + cnt);
+                    ptr += x + cnt;
+                    buf += x + cnt;
+                }
+            } else if (x + cnt > pitch) {
+                if (x >= pitch) {
+                    ptr += cnt;
+                    buf += cnt;
+                } else {
+                    expand(ptr, buf, colors, pitch - x);
+                    ptr += pitch - x;
+                    buf += pitch - x;
+                    int offset = x + cnt - pitch;
+                    ptr += offset;
+                    buf += offset;
+                }
+            } else {
+                expand(ptr, buf, colors, cnt);
+                ptr += cnt;
+                buf += cnt;
+            }
+            x += cnt;
+            size -= cnt;
+        }
+    }
+}
+
+void Texture::renderRLEBlending(std::string_view data, const std::uint32_t *colors, std::uint32_t *pixels, int pitch, int height, int ox, int oy, bool ignoreOrigin) {
+    size_t left = data.size();
+    if (left < 8) {
+        return;
+    }
+    const auto *obuf = reinterpret_cast<const std::uint8_t*>(data.data());
+    struct Header {
+        std::int16_t w, h, x, y;
+    };
+    Header hdr;
+    memcpy(&hdr, obuf, sizeof(hdr));
+    obuf += 8;
+    left -= 8;
+    if (!ignoreOrigin) {
+        ox -= hdr.x;
+        oy -= hdr.y;
+    }
+    std::int32_t w = hdr.w, h = hdr.h;
+    if (ox + w <= 0 || oy + h <= 0) { return; }
+    const auto blend = detail::pixelKernels().blend;
+    while (left && h--) {
+        auto size = std::uint32_t(*obuf++);
+        if (--left < size) {
+            break;
+        }
+        const auto *buf = obuf;
+        left -= size;
+        obuf += size;
+        if (oy < 0) { ++oy; continue; }
+        if (oy >= height) { break; }
+        auto *ptr = pixels + ox + pitch * (oy++);
+        int x = ox;
+        while (size) {
+            auto cnt = *buf++;
+            --size;
+            if (!size) {
+                break;
+            }
+            ptr += cnt;
+            x += cnt;
+            cnt = *buf++;
+            --size;
+            if (size < cnt) {
+                break;
+            }
+            if (x < 0) {
+                if (x + cnt <= 0) {
+                    ptr += cnt;
+                    buf += cnt;
+                } else {
+                    ptr -= x;
+                    buf -= x;
+                    blend(ptr, buf, colors, x + cnt);
+                    ptr += x + cnt;
+                    buf += x + cnt;
+                }
+            } else if (x + cnt > pitch) {
+                if (x >= pitch) {
+                    ptr += cnt;
+                    buf += cnt;
+                } else {
+                    blend(ptr, buf, colors, pitch - x);
+                    ptr += pitch - x;
+                    buf += pitch - x;
+                    int offset = x + cnt - pitch;
+                    ptr += offset;
+                    buf += offset;
+                }
+            } else {
+                blend(ptr, buf, colors, cnt);
+                ptr += cnt;
+                buf += cnt;
+            }
+            x += cnt;
+            size -= cnt;
+        }
+    }
+}
+
+std::uint32_t Texture::calcRLEAvgColor(std::string_view data, const std::uint32_t *colors) {
+    size_t left = data.size();
+    if (left < 8) {
+        return 0;
+    }
+    const auto *buf = reinterpret_cast<const std::uint8_t*>(data.data());
+    struct Header {
+        std::int16_t w, h, x, y;
+    };
+    Header hdr;
+    memcpy(&hdr, buf, sizeof(hdr));
+    if (hdr.w == 0 && hdr.h == 0) {
+        return 0;
+    }
+    buf += 8;
+    left -= 8;
+    std::uint32_t r = 0, g = 0, b = 0, pixcount = 0;
+    std::int32_t y = 0, h = hdr.h;
+    while (left && y < h) {
+        auto size = std::uint32_t(*buf++);
+        if (--left < size) {
+            break;
+        }
+        left -= size;
+        while (size) {
+            auto cnt = *buf++;
+            --size;
+            if (!size) {
+                break;
+            }
+            cnt = *buf++;
+            --size;
+            if (size < cnt) {
+                break;
+            }
+            pixcount += cnt;
+            size -= cnt;
+            for (; cnt; --cnt) {
+                const auto *c = reinterpret_cast<const std::uint8_t*>(&colors[*buf++]);
+                r += c[2];
+                g += c[1];
+                b += c[0];
+            }
+        }
+    }
+    r /= pixcount;
+    g /= pixcount;
+    b /= pixcount;
+    return b | (g << 8) | (r << 16);
+}
+
+}
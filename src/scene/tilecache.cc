@@ -0,0 +1,232 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tilecache.hh"
+
+#include "colorpalette.hh"
+#include "texture_kernels.hh"
+#include <algorithm>
+#include <cstring>
+
+namespace hojy::scene {
+
+namespace {
+
+void blitRows(const TileCache::Tile &tile, std::uint32_t *pixels, int pitch,
+              int left, int top, int right, int bottom, int ox, int oy) {
+    auto rows = int(tile.rowStart.size()) - 1;
+    const auto *src = tile.pixels.data();
+    for (int r = 0; r < rows; ++r) {
+        int y = oy + r;
+        if (y < top) { continue; }
+        if (y >= bottom) { break; }
+        auto *line = pixels + pitch * y;
+        auto end = tile.rowStart[r + 1];
+        for (auto i = tile.rowStart[r]; i < end; ++i) {
+            const auto &run = tile.runs[i];
+            int x = ox + run.x;
+            int cnt = int(run.count);
+            const auto *p = src + run.offset;
+            if (x < left) {
+                if (x + cnt <= left) { continue; }
+                p += left - x;
+                cnt -= left - x;
+                x = left;
+            }
+            if (x >= right) { break; }
+            if (x + cnt > right) {
+                cnt = right - x;
+            }
+            memcpy(line + x, p, cnt * sizeof(std::uint32_t));
+        }
+    }
+}
+
+}
+
+std::size_t TileCache::Tile::bytes() const {
+    return sizeof(Tile) + rowStart.capacity() * sizeof(std::uint32_t) + runs.capacity() * sizeof(Run)
+        + pixels.capacity() * sizeof(std::uint32_t);
+}
+
+TileCache::TileCache(std::size_t budget): budget_(budget) {
+}
+
+void TileCache::setPalette(const ColorPalette &col) {
+    if (palette_ != &col) {
+        clear();
+    }
+    palette_ = &col;
+}
+
+void TileCache::setBudget(std::size_t budget) {
+    budget_ = budget;
+    evict(0);
+}
+
+const TileCache::Tile *TileCache::get(std::int32_t id, std::string_view data) {
+    auto ite = tiles_.find(id);
+    if (ite != tiles_.end()) {
+        lru_.splice(lru_.begin(), lru_, ite->second.lru);
+        return &ite->second.tile;
+    }
+    Tile tile;
+    if (!palette_ || !decode(data, palette_->colors(), tile)) {
+        return nullptr;
+    }
+    auto bytes = tile.bytes();
+    if (!pins_) {
+        if (bytes > budget_) {
+            scratch_ = std::move(tile);
+            return &scratch_;
+        }
+        evict(bytes);
+    }
+    lru_.push_front(id);
+    auto &entry = tiles_[id];
+    entry.tile = std::move(tile);
+    entry.lru = lru_.begin();
+    usedBytes_ += bytes;
+    return &entry.tile;
+}
+
+void TileCache::render(std::int32_t id, std::string_view data, std::uint32_t *pixels, int pitch, int height, int x, int y) {
+    const auto *tile = get(id, data);
+    if (tile) {
+        blit(*tile, pixels, pitch, height, x, y);
+    }
+}
+
+void TileCache::render(std::int32_t id, std::string_view data, std::uint32_t *pixels, int pitch,
+                       int clipX, int clipY, int clipW, int clipH, int x, int y) {
+    const auto *tile = get(id, data);
+    if (tile) {
+        blit(*tile, pixels, pitch, clipX, clipY, clipW, clipH, x, y);
+    }
+}
+
+void TileCache::clear() {
+    tiles_.clear();
+    lru_.clear();
+    scratch_ = Tile();
+    usedBytes_ = 0;
+}
+
+void TileCache::unpin() {
+    if (pins_ && --pins_ == 0) {
+        evict(0);
+    }
+}
+
+void TileCache::evict(std::size_t needed) {
+    if (pins_) { return; }
+    while (!lru_.empty() && usedBytes_ + needed > budget_) {
+        auto ite = tiles_.find(lru_.back());
+        usedBytes_ -= ite->second.tile.bytes();
+        tiles_.erase(ite);
+        lru_.pop_back();
+    }
+}
+
+bool TileCache::decode(std::string_view data, const std::uint32_t *colors, Tile &tile) {
+    size_t left = data.size();
+    if (left < 8) {
+        return false;
+    }
+    const auto *obuf = reinterpret_cast<const std::uint8_t*>(data.data());
+    struct Header {
+        std::int16_t w, h, x, y;
+    };
+    Header hdr;
+    memcpy(&hdr, obuf, sizeof(hdr));
+    obuf += 8;
+    left -= 8;
+    tile.width = hdr.w;
+    tile.height = hdr.h;
+    tile.originX = hdr.x;
+    tile.originY = hdr.y;
+    tile.extent = 0;
+    tile.rowStart.clear();
+    tile.runs.clear();
+    tile.pixels.clear();
+    tile.rowStart.push_back(0);
+    std::int32_t h = hdr.h;
+    const auto expand = detail::pixelKernels().expand;
+    /* Row parsing mirrors Texture::renderRLE() so that truncated entries draw the same */
+    while (left && h--) {
+        auto size = std::uint32_t(*obuf++);
+        if (--left < size) {
+            break;
+        }
+        const auto *buf = obuf;
+        left -= size;
+        obuf += size;
+        std::int32_t x = 0;
+        while (size) {
+            auto cnt = *buf++;
+            --size;
+            if (!size) {
+                break;
+            }
+            x += cnt;
+            cnt = *buf++;
+            --size;
+            if (size < cnt) {
+                break;
+            }
+            if (cnt) {
+                auto offset = std::uint32_t(tile.pixels.size());
+                tile.runs.push_back(Run {x, offset, cnt});
+                tile.pixels.resize(offset + cnt);
+                expand(tile.pixels.data() + offset, buf, colors, cnt);
+                buf += cnt;
+            }
+            x += cnt;
+            size -= cnt;
+        }
+        tile.extent = std::max(tile.extent, x);
+        tile.rowStart.push_back(std::uint32_t(tile.runs.size()));
+    }
+    tile.rowStart.shrink_to_fit();
+    tile.runs.shrink_to_fit();
+    tile.pixels.shrink_to_fit();
+    return true;
+}
+
+void TileCache::blit(const Tile &tile, std::uint32_t *pixels, int pitch, int height, int ox, int oy, bool ignoreOrigin) {
+    if (!ignoreOrigin) {
+        ox -= tile.originX;
+        oy -= tile.originY;
+    }
+    if (ox + tile.width <= 0 || oy + tile.height <= 0) { return; }
+    blitRows(tile, pixels, pitch, 0, 0, pitch, height, ox, oy);
+}
+
+void TileCache::blit(const Tile &tile, std::uint32_t *pixels, int pitch,
+                     int clipX, int clipY, int clipW, int clipH, int ox, int oy) {
+    ox -= tile.originX;
+    oy -= tile.originY;
+    if (ox >= clipX + clipW || oy >= clipY + clipH
+        || ox + std::max<std::int32_t>(tile.width, tile.extent) <= clipX || oy + tile.height <= clipY) {
+        return;
+    }
+    blitRows(tile, pixels, pitch, clipX, clipY, clipX + clipW, clipY + clipH, ox, oy);
+}
+
+}
@@ -0,0 +1,105 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+
+namespace hojy::scene {
+
+class ColorPalette;
+
+/* Decoded map tiles, kept so that terrain redraws do not re-parse RLE bytes.
+ * Each tile stores its opaque runs as palette-resolved ARGB pixels (the
+ * palette entries are opaque, so they are already premultiplied) together
+ * with the run/skip layout needed to blit them back with clipping. */
+class TileCache final {
+public:
+    enum : std::size_t {
+        DefaultBudget = 32U * 1024U * 1024U,
+    };
+    struct Run {
+        std::int32_t x;
+        std::uint32_t offset;
+        std::uint32_t count;
+    };
+    struct Tile {
+        std::int16_t width = 0, height = 0, originX = 0, originY = 0;
+        /* rightmost decoded column + 1, runs may reach past `width` */
+        std::int32_t extent = 0;
+        /* rowStart[r]..rowStart[r + 1] are the runs of row r */
+        std::vector<std::uint32_t> rowStart;
+        std::vector<Run> runs;
+        std::vector<std::uint32_t> pixels;
+
+        [[nodiscard]] std::size_t bytes() const;
+    };
+
+public:
+    explicit TileCache(std::size_t budget = DefaultBudget);
+
+    void setPalette(const ColorPalette &col);
+    void setBudget(std::size_t budget);
+    [[nodiscard]] std::size_t budget() const { return budget_; }
+    [[nodiscard]] std::size_t usedBytes() const { return usedBytes_; }
+    [[nodiscard]] std::size_t size() const { return tiles_.size(); }
+
+    /* Returns the decoded tile for `id`, decoding `data` on a miss. Tiles
+     * that do not fit in the budget are decoded into a scratch slot that is
+     * only valid until the next call. */
+    const Tile *get(std::int32_t id, std::string_view data);
+    /* Same contract as Texture::renderRLE(), but served from the cache */
+    void render(std::int32_t id, std::string_view data, std::uint32_t *pixels, int pitch, int height, int x, int y);
+    /* Draws only the part of the tile inside the clip rectangle */
+    void render(std::int32_t id, std::string_view data, std::uint32_t *pixels, int pitch,
+                int clipX, int clipY, int clipW, int clipH, int x, int y);
+    void clear();
+    /* While pinned, tiles handed out by get() stay valid: eviction (and the
+     * scratch slot for oversized tiles) waits until the last unpin() */
+    void pin() { ++pins_; }
+    void unpin();
+
+    static bool decode(std::string_view data, const std::uint32_t *colors, Tile &tile);
+    static void blit(const Tile &tile, std::uint32_t *pixels, int pitch, int height, int x, int y, bool ignoreOrigin = false);
+    static void blit(const Tile &tile, std::uint32_t *pixels, int pitch,
+                     int clipX, int clipY, int clipW, int clipH, int x, int y);
+
+private:
+    void evict(std::size_t needed);
+
+private:
+    struct Entry {
+        Tile tile;
+        std::list<std::int32_t>::iterator lru;
+    };
+    std::unordered_map<std::int32_t, Entry> tiles_;
+    std::list<std::int32_t> lru_;
+    Tile scratch_;
+    std::size_t budget_;
+    std::size_t usedBytes_ = 0;
+    int pins_ = 0;
+    const ColorPalette *palette_ = nullptr;
+};
+
+}
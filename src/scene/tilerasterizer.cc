@@ -0,0 +1,127 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "tilerasterizer.hh"
+
+#include "texture.hh"
+#include "core/config.hh"
+#include "util/threadpool.hh"
+#include <algorithm>
+#include <cstring>
+
+namespace hojy::scene {
+
+TileRasterizer::TileRasterizer(util::ThreadPool *pool): pool_(pool) {
+}
+
+void TileRasterizer::begin(TileCache &cache, std::uint32_t *pixels, int pitch, int height) {
+    begin(cache, pixels, pitch, 0, 0, pitch, height);
+}
+
+void TileRasterizer::begin(TileCache &cache, std::uint32_t *pixels, int pitch, int clipX, int clipY, int clipW, int clipH) {
+    if (!pool_) {
+        pool_ = sharedPool();
+    }
+    cache_ = &cache;
+    cache_->pin();
+    pixels_ = pixels;
+    pitch_ = pitch;
+    clipX_ = clipX;
+    clipY_ = clipY;
+    clipW_ = clipW;
+    clipH_ = std::max(clipH, 0);
+    auto threads = pool_->threads();
+    bandCount_ = threads ? std::min<std::size_t>((threads + 1) * 2, std::max(1, clipH_ / MinBandHeight)) : 1;
+    bandHeight_ = std::max(1, int((clipH_ + bandCount_ - 1) / bandCount_));
+    if (bands_.size() < bandCount_) {
+        bands_.resize(bandCount_);
+    }
+}
+
+void TileRasterizer::draw(std::int32_t id, std::string_view data, int x, int y) {
+    const auto *tile = cache_->get(id, data);
+    if (!tile) { return; }
+    commands_.push_back(Command {tile, {}, nullptr, false, x, y});
+    int top = y - tile->originY;
+    bin(top, top + tile->height);
+}
+
+void TileRasterizer::drawRLE(std::string_view data, const std::uint32_t *colors, int x, int y, bool blending) {
+    if (data.size() < 8) { return; }
+    std::int16_t hdr[4];
+    memcpy(hdr, data.data(), sizeof(hdr));
+    commands_.push_back(Command {nullptr, data, colors, blending, x, y});
+    int top = y - hdr[3];
+    bin(top, top + hdr[1]);
+}
+
+void TileRasterizer::flush() {
+    if (!cache_) { return; }
+    if (bandCount_ == 1) {
+        renderBand(0);
+    } else {
+        pool_->parallelFor(bandCount_, [this](std::size_t band) { renderBand(band); });
+    }
+    commands_.clear();
+    for (std::size_t i = 0; i < bandCount_; ++i) {
+        bands_[i].clear();
+    }
+    cache_->unpin();
+    cache_ = nullptr;
+}
+
+util::ThreadPool *TileRasterizer::sharedPool() {
+    static util::ThreadPool pool(core::config.renderThreads() > 0
+                                     ? std::size_t(core::config.renderThreads() - 1)
+                                     : util::ThreadPool::defaultThreads(3));
+    return &pool;
+}
+
+void TileRasterizer::bin(int top, int bottom) {
+    top = std::max(top, clipY_) - clipY_;
+    bottom = std::min(bottom, clipY_ + clipH_) - clipY_;
+    if (top >= bottom) {
+        commands_.pop_back();
+        return;
+    }
+    auto index = std::uint32_t(commands_.size() - 1);
+    auto last = std::size_t((bottom - 1) / bandHeight_);
+    for (auto band = std::size_t(top / bandHeight_); band <= last; ++band) {
+        bands_[band].push_back(index);
+    }
+}
+
+void TileRasterizer::renderBand(std::size_t band) {
+    int top = clipY_ + int(band) * bandHeight_;
+    int height = std::min(bandHeight_, clipY_ + clipH_ - top);
+    if (height <= 0) { return; }
+    auto *pixels = pixels_ + top * pitch_;
+    for (auto index: bands_[band]) {
+        const auto &cmd = commands_[index];
+        if (cmd.tile) {
+            TileCache::blit(*cmd.tile, pixels_, pitch_, clipX_, top, clipW_, height, cmd.x, cmd.y);
+        } else if (cmd.blending) {
+            Texture::renderRLEBlending(cmd.data, cmd.colors, pixels, pitch_, height, cmd.x, cmd.y - top);
+        } else {
+            Texture::renderRLE(cmd.data, cmd.colors, pixels, pitch_, height, cmd.x, cmd.y - top);
+        }
+    }
+}
+
+}
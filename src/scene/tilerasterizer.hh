@@ -0,0 +1,79 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "tilecache.hh"
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+namespace hojy::util {
+class ThreadPool;
+}
+
+namespace hojy::scene {
+
+/* Records the draws of one terrain pass and replays them in horizontal bands
+ * on the render worker pool. Each band replays the draws overlapping it in
+ * submission order, clipped to its own rows, so the result is the same as
+ * drawing everything serially. */
+class TileRasterizer final {
+    enum {
+        MinBandHeight = 32,
+    };
+    struct Command {
+        const TileCache::Tile *tile;
+        std::string_view data;
+        const std::uint32_t *colors;
+        bool blending;
+        int x, y;
+    };
+
+public:
+    /* Uses the shared render pool when `pool` is null */
+    explicit TileRasterizer(util::ThreadPool *pool = nullptr);
+
+    void begin(TileCache &cache, std::uint32_t *pixels, int pitch, int height);
+    void begin(TileCache &cache, std::uint32_t *pixels, int pitch, int clipX, int clipY, int clipW, int clipH);
+    void draw(std::int32_t id, std::string_view data, int x, int y);
+    /* Draws raw RLE data with its own colors, the target must not be clipped horizontally */
+    void drawRLE(std::string_view data, const std::uint32_t *colors, int x, int y, bool blending = false);
+    void flush();
+
+    static util::ThreadPool *sharedPool();
+
+private:
+    void bin(int top, int bottom);
+    void renderBand(std::size_t band);
+
+private:
+    util::ThreadPool *pool_ = nullptr;
+    TileCache *cache_ = nullptr;
+    std::uint32_t *pixels_ = nullptr;
+    int pitch_ = 0, clipX_ = 0, clipY_ = 0, clipW_ = 0, clipH_ = 0;
+    int bandHeight_ = 0;
+    std::size_t bandCount_ = 0;
+    std::vector<Command> commands_;
+    std::vector<std::vector<std::uint32_t>> bands_;
+};
+
+}
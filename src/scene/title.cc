@@ -26,7 +26,7 @@
 #include "world/action.hh"
 #include "world/strings.hh"
 #include "content/factors.hh"
-#include "content/grpdata.hh"
+#include "content/grparchive.hh"
 #include "core/config.hh"
 #include "util/random.hh"
 #include "util/file.hh"
@@ -49,9 +49,9 @@ void Title::init() {
     big_ = Texture::loadFromRAW(renderer_, util::File::getFileContent(core::config.dataFilePath("TITLE.BIG")), 320, 200, gNormalPalette);
     renderer_->enableLinear(false);
 
-    std::vector<std::string> dset;
-    if (::hojy::content::GrpData::loadData("TITLE", dset)) {
-        titleTextureMgr_.loadFromRLE(dset);
+    ::hojy::content::GrpArchive archive;
+    if (archive.open("TITLE")) {
+        titleTextureMgr_.loadFromRLE(archive);
     }
     setDirty();
 }
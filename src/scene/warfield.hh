@@ -24,7 +24,9 @@
 #include "battle/engine.hh"
 #include "battle/game_random.hh"
 #include "battle/movement.hh"
+#include "fighttexturecache.hh"
 #include "map.hh"
+#include "sim/auto_battle_ai.hh"
 #include "world/bag.hh"
 #include "world/character.hh"
 #include <functional>
@@ -37,9 +39,6 @@
 namespace hojy::scene {
 
 class Warfield: public Map {
-    enum {
-        FightTextureListCount = 110,
-    };
     enum Stage {
         Idle,
         PlayerMenu,
@@ -75,6 +74,32 @@ class Warfield: public Map {
         std::uint8_t insideMovingArea = 0;
     };
     using SelectableCell = battle::SelectableCell;
+    /* The battle as seen by the shared auto control */
+    class AiField final: public sim::AutoBattleField {
+    public:
+        explicit AiField(Warfield &owner): owner_(owner) {}
+
+        [[nodiscard]] int fieldWidth() const override { return owner_.mapWidth_; }
+        [[nodiscard]] int fieldHeight() const override { return owner_.mapHeight_; }
+        [[nodiscard]] bool blocked(int x, int y) const override;
+        [[nodiscard]] bool occupied(int x, int y) const override;
+        battle::DistanceFieldCache &distances() override { return owner_.distanceFields(); }
+        battle::RandomSource &random() override;
+        [[nodiscard]] const ::hojy::world::state::Bag &bag() const override { return owner_.battleBag_; }
+        [[nodiscard]] int characterCount() const override { return static_cast<int>(owner_.chars_.size()); }
+        [[nodiscard]] sim::AutoCharacter character(int index) override;
+        [[nodiscard]] battle::AiStats aiStats(int index) const override;
+        void setActionCode(int index, std::int16_t actionCode) override;
+        [[nodiscard]] int currentActor() const override;
+        void moveAlong(std::vector<std::pair<int, int>> path) override;
+        void rest(int actor) override;
+        void endTurn(int actor) override;
+        void useItem(int actor, std::int16_t itemId) override;
+        void act(int actor, const sim::AutoAct &act) override;
+
+    private:
+        Warfield &owner_;
+    };
     struct PopupNumber {
         std::wstring str;
         int x, y;
@@ -99,20 +124,13 @@ protected:
 
     void nextAction();
     void autoAction();
-    void autoActionSkill(CharInfo *ch, int actorIndex,
-                         const battle::AiStats &actorAiStats,
-                         const battle::AiResourceState &resourceState,
-                         const std::vector<battle::AiAllyState> &allies,
-                         const battle::AiPowerSummary &allyPower,
-                         bool resumeAutoAttack, bool requestSupport,
-                         bool supportWithoutPosition,
-                         battle::AiResourceAction resourceAction,
-                         battle::RandomSource &resourceRandom);
     void recalcKnowledge();
+    void preloadSounds() const;
+    void preloadFightTextures();
     void playerMenu();
     void maskSelectableArea(int steps, int ranges, bool zoecheck = false);
     void unmaskArea();
-    void getSelectableArea(CharInfo *ch, std::map<std::pair<int, int>, SelectableCell> &selCells, int steps, int ranges, bool zoecheck = false);
+    void getSelectableArea(CharInfo *ch, battle::SelectableCells &selCells, int steps, int ranges, bool zoecheck = false);
     bool tryUseSkill(int index);
     void startActAction();
     void makeDamage(CharInfo *ch, int x, int y, int distance);
@@ -130,6 +148,7 @@ protected:
         const CharInfo *character) const noexcept;
     [[nodiscard]] battle::InventorySnapshot battleInventorySnapshot() const;
     bool recordBattleAction(const battle::BattleAction &action);
+    battle::DistanceFieldCache &distanceFields();
 
 private:
     std::int16_t warId_ = -1;
@@ -149,6 +168,8 @@ private:
     std::vector<CharInfo*> charQueue_;
     CharInfo *currentActor_ = nullptr;
     std::uint32_t round_ = 0;
+    battle::DistanceFieldCache distanceFields_;
+    std::uint32_t occupancyGeneration_ = 0;
     Stage stage_ = Idle;
     int lastMenuIndex_ = 0;
     std::uint16_t knowledge_[2] = {0, 0};
@@ -156,7 +177,7 @@ private:
     bool autoControl_ = false;
     bool won_ = false;
     bool skillLevelup_ = false;
-    std::map<std::pair<int, int>, SelectableCell> selCells_;
+    battle::SelectableCells selCells_;
     std::vector<std::pair<int, int>> movingPath_;
     /* -3poison -2depoison -1medic 0~skillId */
     std::int16_t actIndex_ = -1, actId_ = -1, actLevel_ = 0;
@@ -164,13 +185,14 @@ private:
     std::vector<battle::ActionTarget> actionTargets_;
     int effectId_ = -1, effectTexIdx_ = -1, fightTexIdx_ = -1, fightTexCount_ = 0, fightFrame_ = 0;
     int attackTimesLeft_ = 0;
-    const std::vector<std::string> *fightTex_ = nullptr;
+    FightTextureCache::Frames fightTex_;
     std::vector<PopupNumber> popupNumbers_;
-    std::function<void()> pendingAutoAction_;
-    bool resumeAutoAttack_ = false;
+    AiField aiField_{*this};
+    sim::AutoBattleAi ai_{aiField_};
     Node *statusPanel_ = nullptr;
     Texture *drawingTerrainTex2_ = nullptr;
-    std::vector<std::vector<std::string>> fightTexData_;
+    TileRasterizer overlayRasterizer_;
+    FightTextureCache fightTextures_;
 };
 
 }
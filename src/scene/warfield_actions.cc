@@ -264,8 +264,7 @@ void Warfield::startActAction() {
         if (cameraX_ != cursorX_ || cameraY_ != cursorY_) {
             ch->direction = calcDirection(cameraX_, cameraY_, cursorX_, cursorY_);
         }
-        fightTex_ = ch->info.headId >= 0 && ch->info.headId < fightTexData_.size()
-            ? &fightTexData_[ch->info.headId] : nullptr;
+        fightTex_ = fightTextures_.get(ch->info.headId);
         fightTexCount_ = ch->info.frame[0];
         fightTexIdx_ = fightTexCount_ * int(ch->direction);
         fightTexCount_ += fightTexIdx_;
@@ -283,8 +282,7 @@ void Warfield::startActAction() {
             && (cameraX_ != cursorX_ || cameraY_ != cursorY_)) {
             ch->direction = calcDirection(cameraX_, cameraY_, cursorX_, cursorY_);
         }
-        fightTex_ = ch->info.headId >= 0 && ch->info.headId < fightTexData_.size()
-                    ? &fightTexData_[ch->info.headId] : nullptr;
+        fightTex_ = fightTextures_.get(ch->info.headId);
         fightTexIdx_ = 0;
         for (std::int16_t i = 0; i < skillType; ++i) {
             fightTexIdx_ += 4 * ch->info.frame[i];
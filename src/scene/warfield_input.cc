@@ -7,8 +7,7 @@ void Warfield::handleKeyInput(Node::Key key) {
     if (stage_ != MoveSelecting && stage_ != AttackSelecting) {
         if (key == KeyCancel) {
             if (currentActor_ && currentActor_->side == 0) {
-                pendingAutoAction_ = nullptr;
-                resumeAutoAttack_ = false;
+                ai_.clear();
                 movingPath_.clear();
                 if (stage_ == Moving) { stage_ = Idle; }
             }
@@ -62,7 +61,7 @@ void Warfield::handleKeyInput(Node::Key key) {
                 auto *sc = &ite->second;
                 while (sc) {
                     movingPath_.emplace_back(std::make_pair(sc->x, sc->y));
-                    sc = sc->moveParent;
+                    sc = selCells_.lookup(sc->moveParent);
                 }
             } else {
                 stage_ = Idle;
@@ -1,7 +1,9 @@
 #include "warfield.hh"
 #include "warfield_load.hh"
+#include "battle/replay_file.hh"
+#include "core/config.hh"
 
-#include "content/grpdata.hh"
+#include "content/grparchive.hh"
 #include "content/warfielddata.hh"
 #include "world/action.hh"
 #include "world/savedata.hh"
@@ -9,6 +11,7 @@
 #include "window.hh"
 
 #include <fmt/xchar.h>
+#include <chrono>
 #include <memory>
 #include <new>
 #include <cstdint>
@@ -22,10 +25,7 @@ Warfield::Warfield(Renderer *renderer, int x, int y, int width, int height, std:
     battleRandom_(battleGameRandom_),
     drawingTerrainTex2_(Texture::create(renderer, auxWidth_, auxHeight_)) {
     drawingTerrainTex2_->enableBlendMode(true);
-    fightTexData_.resize(FightTextureListCount);
-    for (size_t i = 0; i < FightTextureListCount; ++i) {
-        ::hojy::content::GrpData::loadData(fmt::format("FIGHT{:03}.IDX", i), fmt::format("FIGHT{:03}.GRP", i), fightTexData_[i]);
-    }
+    fightTextures_.setCapacity(std::size_t(core::config.fightTextureCacheSize()));
 }
 
 Warfield::~Warfield() {
@@ -61,13 +61,13 @@ void Warfield::cleanup() {
     fadeNode_ = nullptr;
     fadePostAction_ = nullptr;
     runFadePostAction_ = false;
-    pendingAutoAction_ = nullptr;
-    resumeAutoAttack_ = false;
+    ai_.clear();
     currentActor_ = nullptr;
     for (auto &cell: cellInfo_) {
         cell.charInfo = nullptr;
         cell.insideMovingArea = 0;
     }
+    ++occupancyGeneration_;
     turnOrder_.clear();
     charQueue_.clear();
     chars_.clear();
@@ -199,8 +199,8 @@ bool Warfield::load(std::int16_t warId) {
                 fmt::format("WDX{:03}", warMapId),
                 fmt::format("WMP{:03}", warMapId),
                 [](const std::string &idx, const std::string &grp,
-                   ::hojy::content::GrpData::DataSet &textures) {
-                    return ::hojy::content::GrpData::loadData(idx, grp, textures);
+                   ::hojy::content::GrpArchive &textures) {
+                    return textures.open(idx, grp);
                 },
                 loadedTextures)) {
             return false;
@@ -212,10 +212,10 @@ bool Warfield::load(std::int16_t warId) {
     const int cellDiffX = loadedTextures.cellWidth / 2;
     const int cellDiffY = loadedTextures.cellHeight / 2;
     const auto size = mapWidth * mapHeight;
-    const auto &textureData = mapCached ? texData_ : loadedTextures.textures;
+    const auto textureCount = mapCached ? texData_.size() : loadedTextures.textures.size();
     if (!detail::validateWarfieldTextureIds(
             layers[0], layers[1], static_cast<std::size_t>(size),
-            textureData.size())) {
+            textureCount)) {
         return false;
     }
     std::vector<CellInfo> cellInfo(static_cast<size_t>(size));
@@ -230,7 +230,7 @@ bool Warfield::load(std::int16_t warId) {
             auto texId = layers[0][pos] >> 1;
             ci.earthId = texId;
             ci.buildingId = layers[1][pos] >> 1;
-            ci.blocked = ci.buildingId > 0 || texId >= 179 && texId <= 181 || texId == 261 || texId == 511 || texId >= 662 && texId <= 665 || texId == 674;
+            ci.blocked = ::hojy::content::isWarfieldCellBlocked(ci.earthId, ci.buildingId);
         }
         x -= cellDiffX; y += cellDiffY;
     }
@@ -256,10 +256,16 @@ bool Warfield::load(std::int16_t warId) {
     offsetY_ = loadedTextures.offsetY;
     if (!mapCached) {
         textureMgr_.clear();
-        texData_ = std::move(loadedTextures.textures);
+        tileCache_.clear();
+        texData_ = loadedTextures.textures.entries();
+        texArchives_.clear();
+        texArchives_.emplace_back(std::move(loadedTextures.textures));
         warMapLoaded_ = std::move(nextWarMapLoaded);
     }
     cellInfo_ = std::move(cellInfo);
+    distanceFields_.setTerrain(mapWidth_, mapHeight_, [this](int x, int y) {
+        return cellInfo_[y * mapWidth_ + x].blocked;
+    });
 
     subMapId_ = warMapId;
     resetFrame();
@@ -392,8 +398,15 @@ bool Warfield::putChars(const std::vector<std::int16_t> &chars) {
             chars_.clear();
             return false;
         }
-        if (!battleEngine_.begin({std::move(participants), std::move(enemy),
-                                  &battleRandom_, std::move(nextInventory)})) {
+        battle::BattleSetup setup{std::move(participants), std::move(enemy),
+                                  &battleRandom_, std::move(nextInventory)};
+        if (!core::config.replayPath().empty()) {
+            const auto stamp = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::system_clock::now().time_since_epoch()).count();
+            setup.replayFile = fmt::format("{}war{:03}-{}{}", core::config.replayPath(), warId_, stamp,
+                                           battle::ReplayFileExtension);
+        }
+        if (!battleEngine_.begin(std::move(setup))) {
             discardBattleSession();
             chars_.clear();
             return false;
@@ -414,11 +427,14 @@ bool Warfield::putChars(const std::vector<std::int16_t> &chars) {
         auto &cell = cellInfo_[static_cast<std::size_t>(ci.y) * static_cast<std::size_t>(mapWidth_) + ci.x];
         cell.charInfo = &ci;
     }
+    ++occupancyGeneration_;
     turnOrder_.reserve(chars_.size());
     for (auto &ci: chars_) {
         turnOrder_.emplace_back(&ci);
     }
     recalcKnowledge();
+    preloadSounds();
+    preloadFightTextures();
     frameUpdate();
     if (info->music >= 0) {
         gWindow->playMusic(info->music);
@@ -426,4 +442,28 @@ bool Warfield::putChars(const std::vector<std::int16_t> &chars) {
     return true;
 }
 
+void Warfield::preloadSounds() const {
+    std::vector<int> atkSounds = {0};
+    std::vector<int> effectSounds = {::hojy::content::PoisonEffectID, ::hojy::content::DepoisonEffectID,
+                                     ::hojy::content::MedicEffectID};
+    for (const auto &ci: chars_) {
+        for (auto skillId: ci.info.skillId) {
+            const auto *skillInfo = skillId > 0 ? ::hojy::world::state::gSaveData.skillInfo[skillId] : nullptr;
+            if (!skillInfo) { continue; }
+            atkSounds.push_back(skillInfo->soundId);
+            effectSounds.push_back(skillInfo->effectId);
+        }
+    }
+    gWindow->preloadSounds(atkSounds, effectSounds);
+}
+
+void Warfield::preloadFightTextures() {
+    std::vector<std::int16_t> ids;
+    ids.reserve(chars_.size());
+    for (const auto &ci: chars_) {
+        ids.push_back(ci.info.headId);
+    }
+    fightTextures_.preload(ids);
+}
+
 }
@@ -1,12 +1,13 @@
 #pragma once
 
-#include "content/grpdata.hh"
+#include "content/grparchive.hh"
 
 #include <array>
 #include <cstdint>
 #include <cstring>
 #include <set>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
@@ -24,7 +25,7 @@ inline bool validateUniqueWarfieldCharacterIds(
 }
 
 struct WarfieldTextureLoad {
-    ::hojy::content::GrpData::DataSet textures;
+    ::hojy::content::GrpArchive textures;
     bool shared = false;
     std::uint16_t cellWidth = 0;
     std::uint16_t cellHeight = 0;
@@ -32,11 +33,10 @@ struct WarfieldTextureLoad {
     std::uint16_t offsetY = 0;
 };
 
-inline const std::string &warfieldTextureAt(
-    const ::hojy::content::GrpData::DataSet &textures, int index) {
-    static const std::string empty;
+template<typename Textures>
+std::string_view warfieldTextureAt(const Textures &textures, int index) {
     if (index < 0 || static_cast<std::size_t>(index) >= textures.size()) {
-        return empty;
+        return {};
     }
     return textures[static_cast<std::size_t>(index)];
 }
@@ -56,9 +56,9 @@ inline bool validateWarfieldTextureIds(
     return true;
 }
 
-inline bool readWarfieldTextureHeader(
-    const ::hojy::content::GrpData::DataSet &textures,
-    WarfieldTextureLoad &result) {
+template<typename Textures>
+bool readWarfieldTextureHeader(const Textures &textures,
+                               WarfieldTextureLoad &result) {
     if (textures.empty() || textures[0].size() < sizeof(std::uint16_t) * 4) {
         return false;
     }
@@ -77,10 +77,10 @@ bool loadWarfieldTextures(const std::string &specificIndex,
                           const std::string &specificGroup,
                           Loader &&loader,
                           WarfieldTextureLoad &result) {
-    ::hojy::content::GrpData::DataSet textures;
+    ::hojy::content::GrpArchive textures;
     const bool shared = loader("WDX", "WMP", textures);
     if (!shared) {
-        textures.clear();
+        textures = {};
         if (!loader(specificIndex, specificGroup, textures)) {
             return false;
         }
@@ -8,16 +8,33 @@
 #include "world/savedata.hh"
 
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstring>
 
 namespace hojy::scene {
+
+namespace {
+
+/* Cell masks stay alive until the rasterizer flushes, so each color gets its own palette */
+std::array<std::uint32_t, 256> maskPalette(std::uint32_t color) {
+    std::array<std::uint32_t, 256> colors {};
+    colors[254] = color;
+    return colors;
+}
+
+const auto movingMaskColors = maskPalette(0xA0A0A0A0u);
+const auto charMaskColors = maskPalette(0x80A0A0A0u);
+const auto outsideMaskColors = maskPalette(0xD0A0A0A0u);
+
+}
+
 void Warfield::render() {
     Map::render();
 
     bool acting = stage_ == Acting;
     if (drawDirty_) {
-        std::vector<const std::string *> effectOverlay(cellInfo_.size(), nullptr);
+        std::vector<const std::string_view *> effectOverlay(cellInfo_.size(), nullptr);
         drawDirty_ = false;
         int cellDiffX = cellWidth_ / 2;
         int cellDiffY = cellHeight_ / 2;
@@ -134,6 +151,8 @@ void Warfield::render() {
         std::uint32_t *pixels2 = drawingTerrainTex2_->lock(pitch2);
         memset(pixels, 0, pitch * auxHeight_ * sizeof(std::uint32_t));
         memset(pixels2, 0, pitch * auxHeight_ * sizeof(std::uint32_t));
+        rasterizer_.begin(tileCache_, pixels, pitch, aheight);
+        overlayRasterizer_.begin(tileCache_, pixels2, pitch2, aheight);
         for (int j = hcount; j; --j) {
             int x = cx, y = cy;
             int dx = tx;
@@ -143,41 +162,35 @@ void Warfield::render() {
                     continue;
                 }
                 auto &ci = cellInfo_[offset];
-                Texture::renderRLE(detail::warfieldTextureAt(texData_, ci.earthId),
-                                   colors, pixels, pitch, aheight, dx, ty);
+                rasterizer_.draw(ci.earthId, detail::warfieldTextureAt(texData_, ci.earthId), dx, ty);
                 if (!movingOrActing) {
-                    static std::uint32_t maskColors[256] = {0};
+                    const std::uint32_t *maskColors = nullptr;
                     if (ci.insideMovingArea == 2) {
-                        maskColors[254] = 0xA0A0A0A0u;
-                        Texture::renderRLEBlending(detail::warfieldTextureAt(texData_, 0),
-                                                   maskColors, pixels, pitch, aheight, dx, ty);
+                        maskColors = movingMaskColors.data();
                     } else if (ci.charInfo) {
-                        maskColors[254] = 0x80A0A0A0u;
-                        Texture::renderRLEBlending(detail::warfieldTextureAt(texData_, 0),
-                                                   maskColors, pixels, pitch, aheight, dx, ty);
+                        maskColors = charMaskColors.data();
                     } else if (selecting && !ci.insideMovingArea) {
-                        maskColors[254] = 0xD0A0A0A0u;
-                        Texture::renderRLEBlending(detail::warfieldTextureAt(texData_, 0),
-                                                   maskColors, pixels, pitch, aheight, dx, ty);
+                        maskColors = outsideMaskColors.data();
+                    }
+                    if (maskColors) {
+                        rasterizer_.drawRLE(detail::warfieldTextureAt(texData_, 0), maskColors, dx, ty, true);
                     }
                 }
                 if (ci.buildingId > 0) {
-                    Texture::renderRLE(detail::warfieldTextureAt(texData_, ci.buildingId),
-                                       colors, pixels2, pitch2, aheight, dx, ty);
+                    overlayRasterizer_.draw(ci.buildingId, detail::warfieldTextureAt(texData_, ci.buildingId), dx, ty);
                 } else {
                     if (ci.charInfo) {
                         if (acting && ci.charInfo == ch && fightTex_ && fightTexIdx_ >= 0 && fightTexIdx_ < fightTex_->size()) {
-                            Texture::renderRLE((*fightTex_)[fightTexIdx_], colors, pixels2, pitch2, aheight, dx, ty);
+                            overlayRasterizer_.drawRLE((*fightTex_)[fightTexIdx_], colors, dx, ty);
                         } else {
                             const auto textureId = 2553 + 4 * ci.charInfo->texId
                                 + int(ci.charInfo->direction);
-                            Texture::renderRLE(detail::warfieldTextureAt(texData_, textureId),
-                                               colors, pixels2, pitch2, aheight, dx, ty);
+                            overlayRasterizer_.draw(textureId, detail::warfieldTextureAt(texData_, textureId), dx, ty);
                         }
                     }
                     const auto *effectData = effectOverlay[offset];
                     if (effectData) {
-                        Texture::renderRLE(*effectData, colors, pixels2, pitch2, aheight, dx, ty);
+                        overlayRasterizer_.drawRLE(*effectData, colors, dx, ty);
                     }
                 }
             }
@@ -191,6 +204,8 @@ void Warfield::render() {
                 ty += cellDiffY;
             }
         }
+        overlayRasterizer_.flush();
+        rasterizer_.flush();
         drawingTerrainTex2_->unlock();
         drawingTerrainTex_->unlock();
     }
@@ -2,6 +2,7 @@
 
 #include "battle/combat_rules.hh"
 #include "content/warfielddata.hh"
+#include "core/config.hh"
 #include "messagebox.hh"
 #include "window.hh"
 #include "world/action.hh"
@@ -19,7 +20,7 @@ void Warfield::endWar() {
     bool battleSessionFinished = false;
     if (battleEngine_.status() == battle::EngineStatus::Finished) {
         syncBattleParticipantsToWorking();
-        won_ = battleEngine_.snapshot().won;
+        won_ = battleEngine_.won();
         battleSessionFinished = true;
     } else if (battleEngine_.status() != battle::EngineStatus::Idle) {
         syncBattleParticipantsToWorking();
@@ -35,9 +36,8 @@ void Warfield::endWar() {
         return;
     }
     currentActor_ = nullptr;
-    pendingAutoAction_ = nullptr;
+    ai_.clear();
     movingPath_.clear();
-    resumeAutoAttack_ = false;
     clearActionState(false);
     removeAllChildren();
     fadeNode_ = nullptr;
@@ -221,6 +221,9 @@ void Warfield::endWar() {
         syncBattleParticipantsToWorking();
         if (battleEngine_.reconcile(battleInventorySnapshot())) {
             const auto result = battleEngine_.finish(true);
+            if (!core::config.replayPath().empty() && !result.replaySaved) {
+                fmt::print(stderr, "Unable to save the battle replay to {}\n", core::config.replayPath());
+            }
             if (result.committed) {
                 won_ = result.won;
                 syncBattleParticipantsFromWorking();
@@ -26,7 +26,7 @@ void Warfield::frameUpdate() {
             movingPath_.clear();
             if (currentActor_ && battle::shouldContinueAfterMovement(
                     currentActor_->side == 0 && !autoControl_,
-                    static_cast<bool>(pendingAutoAction_), resumeAutoAttack_)) {
+                    ai_.pending(), ai_.resuming())) {
                 stage_ = Idle;
             } else if (currentActor_) {
                 endTurn(currentActor_);
@@ -42,7 +42,7 @@ void Warfield::frameUpdate() {
             if (movingPath_.empty()) {
                 if (battle::shouldContinueAfterMovement(
                         currentActor_->side == 0 && !autoControl_,
-                        static_cast<bool>(pendingAutoAction_), resumeAutoAttack_)) {
+                        ai_.pending(), ai_.resuming())) {
                     stage_ = Idle;
                 } else {
                     endTurn(currentActor_);
@@ -76,6 +76,7 @@ void Warfield::frameUpdate() {
         --charInfo->steps;
         newci.charInfo = charInfo;
         ci.charInfo = nullptr;
+        ++occupancyGeneration_;
         charInfo->x = x;
         charInfo->y = y;
         cameraX_ = x;
@@ -98,7 +99,7 @@ void Warfield::frameUpdate() {
         if (movingPath_.empty()) {
             if (battle::shouldContinueAfterMovement(
                     currentActor_->side == 0 && !autoControl_,
-                    static_cast<bool>(pendingAutoAction_), resumeAutoAttack_)) {
+                    ai_.pending(), ai_.resuming())) {
                 stage_ = Idle;
             } else {
                 endTurn(currentActor_);
@@ -238,9 +239,7 @@ void Warfield::nextAction() {
         break;
     }
     currentActor_ = ch;
-    battle::prepareActorActionCode(
-        ch->actionCode,
-        static_cast<bool>(pendingAutoAction_) || resumeAutoAttack_);
+    battle::prepareActorActionCode(ch->actionCode, ai_.pending() || ai_.resuming());
     cameraX_ = ch->x;
     cameraY_ = ch->y;
     drawDirty_ = true;
@@ -288,9 +287,8 @@ void Warfield::endTurn(CharInfo *expectedActor) {
         charQueue_.erase(ite);
     }
     currentActor_ = nullptr;
-    pendingAutoAction_ = nullptr;
+    ai_.clear();
     movingPath_.clear();
-    resumeAutoAttack_ = false;
     clearActionState(false);
     for (auto &ci: chars_) {
         if (!battle::shouldClearDeadPosition(ci.info.hp, ci.x, ci.y)) {
@@ -298,7 +296,10 @@ void Warfield::endTurn(CharInfo *expectedActor) {
         }
         if (ci.x < mapWidth_ && ci.y < mapHeight_) {
             auto &cell = cellInfo_[ci.x + ci.y * mapWidth_];
-            if (cell.charInfo == &ci) { cell.charInfo = nullptr; }
+            if (cell.charInfo == &ci) {
+                cell.charInfo = nullptr;
+                ++occupancyGeneration_;
+            }
         }
         ci.x = ci.y = -1;
         drawDirty_ = true;
@@ -314,7 +315,7 @@ bool Warfield::checkWarEnd() {
         battleEngine_.reconcile(battleInventorySnapshot());
         syncBattleParticipantsFromWorking();
         if (battleEngine_.status() == battle::EngineStatus::Finished) {
-            won_ = battleEngine_.snapshot().won;
+            won_ = battleEngine_.won();
             endWar();
             return true;
         }
@@ -165,7 +165,7 @@ void Warfield::playerMenu() {
             }
             charQueue_.insert(charQueue_.begin(), ch);
             currentActor_ = nullptr;
-            pendingAutoAction_ = nullptr;
+            ai_.dropPending();
             stage_ = Idle;
             break;
         case 7: {
@@ -230,7 +230,7 @@ void Warfield::unmaskArea() {
     selCells_.clear();
 }
 
-void Warfield::getSelectableArea(CharInfo *ch, std::map<std::pair<int, int>, SelectableCell> &selCells, int steps, int ranges, bool zoecheck) {
+void Warfield::getSelectableArea(CharInfo *ch, battle::SelectableCells &selCells, int steps, int ranges, bool zoecheck) {
     battle::getSelectableArea(
         mapWidth_, mapHeight_, {ch->x, ch->y}, steps, ranges, selCells,
         [this](int x, int y) { return cellInfo_[y * mapWidth_ + x].blocked; },
@@ -35,7 +35,7 @@
 
 #include "audio/mixer.hh"
 #include "content/factors.hh"
-#include "content/grpdata.hh"
+#include "content/grparchive.hh"
 #include "content/event.hh"
 #include "world/strings.hh"
 #include "world/savedata.hh"
@@ -102,10 +102,7 @@ Window::Window(int w, int h) : width_(w), height_(h), currTime_(wallTimeMicros()
     renderer_ = new Renderer(win_, w, h);
     renderer_->enableLinear(false);
 
-    if (!gNormalPalette.load("MMAP") || !gEndPalette.load("ENDCOL")) {
-        ready_ = false;
-        return;
-    }
+    /* Palettes and effects were loaded by app::loadStartupData() */
     {
         std::array<std::uint32_t, 256> n{};
         n.fill(0xFFFFFFFFu);
@@ -115,16 +112,12 @@ Window::Window(int w, int h) : width_(w), height_(h), currTime_(wallTimeMicros()
 
     headTextureMgr_.setPalette(gNormalPalette);
     headTextureMgr_.setRenderer(renderer_);
-    ::hojy::content::GrpData::DataSet dset;
+    ::hojy::content::GrpArchive heads;
     renderer_->enableLinear(true);
-    if (::hojy::content::GrpData::loadData("HDGRP", dset)) {
-        headTextureMgr_.loadFromRLE(dset);
+    if (heads.open("HDGRP")) {
+        headTextureMgr_.loadFromRLE(heads);
     }
     renderer_->enableLinear(false);
-    if (!gEffect.load("EFT")) {
-        ready_ = false;
-        return;
-    }
 
     globalMap_ = new GlobalMap(renderer_, 0, 0, w, h, core::config.scale());
     subMap_ = new SubMap(renderer_, 0, 0, w, h, core::config.scale());
@@ -70,8 +70,12 @@ public:
     void applyDeferredCommands();
 
     void playMusic(int idx);
+    /* opens the music in the background, for a playMusic() that is likely to follow */
+    void prefetchMusic(int idx);
     void playAtkSound(int idx);
     void playEffectSound(int idx);
+    /* decodes the given sounds ahead of a scene that plays them in quick succession */
+    void preloadSounds(const std::vector<int> &atkSounds, const std::vector<int> &effectSounds);
 
     void title();
     void endscreen();
@@ -5,15 +5,35 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 namespace hojy::scene {
 
+namespace {
+
+std::string effectSoundFile(int idx) {
+    return core::config.soundFilePath(fmt::format("E{:02}.WAV", idx));
+}
+
+std::string musicFile(int idx) {
+    return core::config.musicFilePath(fmt::format("GAME{:02}.XMI", idx));
+}
+
+std::string atkSoundFile(int idx) {
+    return idx >= 24 ? effectSoundFile(idx - 24) : core::config.soundFilePath(fmt::format("ATK{:02}.WAV", idx));
+}
+
+}
+
 void Window::playMusic(int idx) {
     ++idx;
     if (playingMusic_ == idx) {
         return;
     }
     audio::gMixer.play(0,
-                       core::config.musicFilePath(fmt::format("GAME{:02}.XMI", idx)),
+                       musicFile(idx),
                        true,
                        16 * core::config.musicVolume(),
                        500,
@@ -21,22 +41,44 @@ void Window::playMusic(int idx) {
     playingMusic_ = idx;
 }
 
+void Window::prefetchMusic(int idx) {
+    ++idx;
+    if (playingMusic_ == idx) {
+        return;
+    }
+    audio::gMixer.prefetch(musicFile(idx));
+}
+
 void Window::playAtkSound(int idx) {
     if (idx >= 24) {
         playEffectSound(idx - 24);
         return;
     }
     audio::gMixer.play(1,
-                       core::config.soundFilePath(fmt::format("ATK{:02}.WAV", idx)),
+                       atkSoundFile(idx),
                        false,
                        16 * core::config.soundVolume());
 }
 
 void Window::playEffectSound(int idx) {
     audio::gMixer.play(2,
-                       core::config.soundFilePath(fmt::format("E{:02}.WAV", idx)),
+                       effectSoundFile(idx),
                        false,
                        16 * core::config.soundVolume());
 }
 
+void Window::preloadSounds(const std::vector<int> &atkSounds, const std::vector<int> &effectSounds) {
+    std::vector<std::string> files;
+    files.reserve(atkSounds.size() + effectSounds.size());
+    for (auto idx: atkSounds) {
+        files.emplace_back(atkSoundFile(idx));
+    }
+    for (auto idx: effectSounds) {
+        files.emplace_back(effectSoundFile(idx));
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    audio::gMixer.samples().preload(files);
+}
+
 }
@@ -0,0 +1,734 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "auto_battle_ai.hh"
+
+#include "battle/ai_strategy.hh"
+#include "battle/combat_rules.hh"
+#include "battle/turn_order.hh"
+#include "content/constants.hh"
+#include "world/action.hh"
+#include "world/savedata.hh"
+
+#include <algorithm>
+#include <limits>
+
+namespace hojy::sim {
+
+bool AutoBattleAi::run() {
+    if (pending_) {
+        battle::runPendingAction(pending_);
+        return true;
+    }
+    const auto actor = field_.currentActor();
+    if (actor < 0) { return false; }
+    const auto ch = field_.character(actor);
+    const auto &info = *ch.info;
+    const auto resumeAutoAttack = resume_;
+    resume_ = false;
+    const auto actorAiStats = field_.aiStats(actor);
+    const battle::AiResourceState resourceState{
+        info.hp, info.maxHp, info.hurt, info.poisoned,
+        info.stamina, info.mp, info.maxMp,
+        actorAiStats.medic, actorAiStats.depoison,
+    };
+    std::vector<battle::AiAllyState> allies;
+    const auto count = field_.characterCount();
+    allies.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const auto ally = field_.character(i);
+        const auto validPosition = onMap({ally.x, ally.y});
+        const auto allyAiStats = field_.aiStats(i);
+        allies.push_back(battle::AiAllyState{
+            ally.side, ally.id >= 0 && validPosition,
+            ally.info->hp > 0 && validPosition,
+            ally.info->hp, ally.info->maxHp, ally.info->hurt,
+            ally.info->poisoned, allyAiStats.medic, allyAiStats.depoison,
+            ally.actionCode, allyAiStats.attack,
+        });
+    }
+    const auto allyPower = battle::summarizeAllyPower(ch.side, allies);
+    std::int16_t resourceItemId = -1;
+    int resourceActId = 0;
+    std::optional<int> resourceTargetIndex;
+    std::optional<Position> resourceSupportPosition;
+    battle::SelectableCells resourceMovementCells;
+    auto &random = field_.random();
+    auto findResourceItem = [this, &ch, &resourceItemId](::hojy::world::state::PropType type, int delta) {
+        resourceItemId = ch.side == 1
+            ? ::hojy::world::state::tryUseNpcItem(ch.info, type, static_cast<std::int16_t>(delta))
+            : ::hojy::world::state::tryUseBagItem(
+                field_.bag(), ch.info, type, static_cast<std::int16_t>(delta));
+        return resourceItemId >= 0;
+    };
+    auto prepareSupport = [this, &ch, actor, actorAiStats, &allies, &random,
+                           &resourceActId, &resourceTargetIndex,
+                           &resourceSupportPosition, &resourceMovementCells]
+                          (battle::AiResourceAction action) {
+        std::optional<int> targetIndex;
+        int ability = 0;
+        if (action == battle::AiResourceAction::MedicSupport) {
+            ability = actorAiStats.medic;
+            resourceActId = -1;
+            targetIndex = battle::chooseMedicSupportTarget(actor, ability, allies, random);
+        } else {
+            ability = actorAiStats.depoison;
+            resourceActId = -2;
+            targetIndex = battle::chooseDepoisonSupportTarget(actor, ability, allies, random);
+        }
+        if (!targetIndex) { return battle::AiResourceAction::None; }
+
+        resourceTargetIndex = targetIndex;
+        const auto target = field_.character(*targetIndex);
+        movementArea(actor, resourceMovementCells);
+        const Position targetPosition{target.x, target.y};
+        const Position actorPosition{ch.x, ch.y};
+        const auto range = battle::calcTechniqueRange(ability);
+        const auto currentCanCast = battle::canCastFromPosition(
+            0, range, terrainDistance(actorPosition, targetPosition),
+            actorPosition, targetPosition);
+        const auto choice = battle::chooseCastMovementPosition(
+            resourceMovementCells, castRangeCells(targetPosition, actorPosition, range),
+            actorPosition, targetPosition, range,
+            battle::CastMovementMode::Approach, currentCanCast,
+            [this](Position from, Position target) { return terrainDistance(from, target); });
+        resourceSupportPosition = choice.position;
+        return action;
+    };
+    const auto resourceAction = resumeAutoAttack
+        ? battle::AiResourceAction::None
+        : battle::chooseAiResourceAction(
+            resourceState, random,
+            [&info, actor, actorAiStats, &allies, &findResourceItem, &resourceActId,
+             &resourceTargetIndex, &prepareSupport](battle::AiResourceAction action) {
+                switch (action) {
+                case battle::AiResourceAction::RecoverHp:
+                    if (battle::canSelfMedic(actorAiStats.medic, info.stamina, info.hurt)) {
+                        resourceActId = -1;
+                        return action;
+                    }
+                    if (findResourceItem(::hojy::world::state::PropType::Hp, info.maxHp - info.hp)) {
+                        return action;
+                    }
+                    resourceTargetIndex = battle::chooseMedicProvider(actor, info.hurt, allies);
+                    return resourceTargetIndex
+                        ? battle::AiResourceAction::RequestMedic
+                        : battle::AiResourceAction::None;
+                case battle::AiResourceAction::SelfDepoison:
+                    if (battle::canSelfDepoison(actorAiStats.depoison, info.stamina, info.poisoned)) {
+                        resourceActId = -2;
+                        return action;
+                    }
+                    if (findResourceItem(::hojy::world::state::PropType::Poisoned, info.poisoned)) {
+                        return action;
+                    }
+                    resourceTargetIndex = battle::chooseDepoisonProvider(actor, info.poisoned, allies);
+                    return resourceTargetIndex
+                        ? battle::AiResourceAction::RequestDepoison
+                        : battle::AiResourceAction::None;
+                case battle::AiResourceAction::RecoverMp:
+                    return findResourceItem(::hojy::world::state::PropType::Mp, info.maxMp - info.mp)
+                        ? action : battle::AiResourceAction::None;
+                case battle::AiResourceAction::MedicSupport:
+                case battle::AiResourceAction::DepoisonSupport:
+                    return prepareSupport(action);
+                default:
+                    return battle::AiResourceAction::None;
+                }
+            });
+    const auto supportWithoutPosition =
+        (resourceAction == battle::AiResourceAction::MedicSupport
+         || resourceAction == battle::AiResourceAction::DepoisonSupport)
+        && !resourceSupportPosition;
+    const auto requestSupport =
+        resourceAction == battle::AiResourceAction::RequestMedic
+        || resourceAction == battle::AiResourceAction::RequestDepoison;
+    if (!resumeAutoAttack) {
+        field_.setActionCode(actor, static_cast<std::int16_t>(
+            battle::originalActionCode(resourceAction, resourceItemId >= 0)));
+    }
+    if (requestSupport) {
+        if (resourceTargetIndex) {
+            const auto provider = field_.character(*resourceTargetIndex);
+            battle::SelectableCells movementCells;
+            movementArea(actor, movementCells);
+            const auto approachPosition = battle::chooseApproachPosition(
+                movementCells, {provider.x, provider.y},
+                [this](Position from, Position target) {
+                    return field_.distances().shortestDistance(from, target);
+                });
+            if (approachPosition && *approachPosition != Position{ch.x, ch.y}) {
+                resume_ = battle::shouldResumeAutoAttack(true);
+                moveTo(movementCells, *approachPosition);
+                return true;
+            }
+        }
+        /* No approach movement was scheduled.  The current actor continues
+         * immediately, and the continuation flag must not leak to the next
+         * queued actor. */
+        resume_ = battle::shouldResumeAutoAttack(false);
+    }
+    if (supportWithoutPosition
+        && battle::chooseUnreachableSupportFallback(
+               actorAiStats.attack, allyPower.total, allyPower.count)
+           == battle::AiSupportFallback::Rest) {
+        field_.rest(actor);
+        return true;
+    }
+    if (resourceAction != battle::AiResourceAction::None
+        && !supportWithoutPosition && !requestSupport) {
+        if (resourceAction == battle::AiResourceAction::Rest) {
+            pending_ = [this, actor]() { field_.rest(actor); };
+        } else if (resourceItemId >= 0) {
+            pending_ = [this, actor, resourceItemId]() {
+                if (field_.currentActor() != actor) { return; }
+                if (field_.character(actor).info->hp <= 0) {
+                    field_.endTurn(actor);
+                    return;
+                }
+                field_.useItem(actor, resourceItemId);
+            };
+        } else {
+            const auto targetIndex = resourceTargetIndex.value_or(actor);
+            const auto resourceRange = resourceAction == battle::AiResourceAction::MedicSupport
+                ? battle::calcTechniqueRange(actorAiStats.medic)
+                : battle::calcTechniqueRange(actorAiStats.depoison);
+            pending_ = [this, actor, targetIndex, resourceActId, resourceAction,
+                        resourceRange, allyPower, actorAiStats]() {
+                if (field_.currentActor() != actor) { return; }
+                const auto target = field_.character(targetIndex);
+                if (field_.character(actor).info->hp <= 0 || target.info->hp <= 0
+                    || !onMap({target.x, target.y})) {
+                    field_.endTurn(actor);
+                    return;
+                }
+                if ((resourceAction == battle::AiResourceAction::MedicSupport
+                     || resourceAction == battle::AiResourceAction::DepoisonSupport)
+                    && !canCastAt(actor, targetIndex, 0, resourceRange)) {
+                    fallBack(actor, actorAiStats, allyPower);
+                    return;
+                }
+                AutoAct act;
+                act.id = static_cast<std::int16_t>(resourceActId);
+                act.cursorX = target.x;
+                act.cursorY = target.y;
+                field_.act(actor, act);
+            };
+        }
+        if (resourceItemId >= 0) {
+            battle::SelectableCells movementCells;
+            movementArea(actor, movementCells);
+            const auto retreatPosition = battle::chooseRetreatPosition(
+                movementCells, ch.steps, enemyPositions(actor));
+            if (retreatPosition && *retreatPosition != Position{ch.x, ch.y}) {
+                moveTo(movementCells, *retreatPosition);
+                return true;
+            }
+        }
+        if (resourceSupportPosition && *resourceSupportPosition != Position{ch.x, ch.y}) {
+            moveTo(resourceMovementCells, *resourceSupportPosition);
+            return true;
+        }
+        battle::runPendingAction(pending_);
+        return true;
+    }
+    runSkill(actor, actorAiStats, resourceState, allyPower,
+             resumeAutoAttack, requestSupport, supportWithoutPosition, resourceAction);
+    return true;
+}
+
+void AutoBattleAi::runSkill(int actor, const battle::AiStats &actorAiStats,
+                            const battle::AiResourceState &resourceState,
+                            const battle::AiPowerSummary &allyPower,
+                            bool resumeAutoAttack, bool requestSupport,
+                            bool supportWithoutPosition,
+                            battle::AiResourceAction resourceAction) {
+    const auto ch = field_.character(actor);
+    const auto &info = *ch.info;
+    auto &random = field_.random();
+    const auto count = field_.characterCount();
+    std::vector<battle::AiStrategyCharacter> strategyCharacters;
+    strategyCharacters.reserve(count);
+    for (int i = 0; i < count; ++i) {
+        const auto candidate = field_.character(i);
+        const auto validPosition = onMap({candidate.x, candidate.y});
+        const auto candidateAiStats = field_.aiStats(i);
+        strategyCharacters.push_back(battle::AiStrategyCharacter{
+            candidate.side, candidate.id >= 0 && validPosition,
+            candidate.info->hp > 0 && validPosition,
+            candidate.x, candidate.y, candidate.info->hp, candidate.info->maxHp,
+            candidateAiStats.attack, candidateAiStats.medic,
+            candidate.info->poisoned, candidateAiStats.depoison,
+            candidateAiStats.antipoison, candidateAiStats.poison,
+        });
+    }
+    battle::AiStrategyActor strategyActor;
+    strategyActor.side = ch.side;
+    strategyActor.hp = info.hp;
+    strategyActor.attack = actorAiStats.attack;
+    strategyActor.stamina = info.stamina;
+    strategyActor.mp = info.mp;
+    strategyActor.medic = actorAiStats.medic;
+    strategyActor.poison = actorAiStats.poison;
+    strategyActor.depoison = actorAiStats.depoison;
+    strategyActor.throwing = actorAiStats.throwing;
+    strategyActor.integrity = actorAiStats.integrity;
+    strategyActor.potential = actorAiStats.potential;
+
+    std::vector<battle::AiSkillOption> strategySkills;
+    strategySkills.reserve(::hojy::content::LearnSkillCount);
+    for (int i = 0; i < ::hojy::content::LearnSkillCount; ++i) {
+        const auto skillId = info.skillId[i];
+        if (skillId <= 0) { continue; }
+        const auto *skill = ::hojy::world::state::gSaveData.skillInfo[skillId];
+        if (!skill) { continue; }
+        strategySkills.push_back(battle::AiSkillOption{i, skillId, skill->reqMp});
+    }
+
+    std::vector<battle::AiThrowingOption> throwingItems;
+    if (ch.side != 0) {
+        for (int i = 0; i < ::hojy::content::CarryItemCount; ++i) {
+            const auto itemId = info.item[i];
+            if (itemId < 0 || info.itemCount[i] <= 0) { continue; }
+            const auto *item = ::hojy::world::state::gSaveData.itemInfo[itemId];
+            if (!item) { continue; }
+            throwingItems.push_back(battle::AiThrowingOption{
+                i, itemId, item->addHp, item->addPoisoned, item->itemType,
+            });
+        }
+    } else {
+        int bagIndex = 0;
+        for (const auto &[itemId, itemCount]: field_.bag().orderedItems()) {
+            if (itemId < 0 || itemCount <= 0) { continue; }
+            const auto *item = ::hojy::world::state::gSaveData.itemInfo[itemId];
+            if (!item) { continue; }
+            throwingItems.push_back(battle::AiThrowingOption{
+                bagIndex++, itemId, item->addHp, item->addPoisoned, item->itemType,
+            });
+        }
+    }
+
+    const auto pathDistance = [this, &ch, &strategyCharacters](int targetIndex) {
+        if (targetIndex < 0
+            || targetIndex >= static_cast<int>(strategyCharacters.size())) {
+            return -1;
+        }
+        const auto &target = strategyCharacters[targetIndex];
+        if (!target.valid || !target.alive) { return -1; }
+        return terrainDistance({ch.x, ch.y}, {target.x, target.y});
+    };
+
+    struct CastPositionPlan {
+        battle::SelectableCells movementCells;
+        std::optional<Position> position;
+    };
+    auto chooseCastPosition = [this, actor, &ch, count](int targetIndex, int range, int attackAreaType,
+                                                        battle::CastMovementMode mode) {
+        CastPositionPlan plan;
+        movementArea(actor, plan.movementCells);
+        if (targetIndex < 0 || targetIndex >= count) {
+            return plan;
+        }
+        const auto target = field_.character(targetIndex);
+        const Position targetPosition{target.x, target.y};
+        const Position actorPosition{ch.x, ch.y};
+        plan.position = battle::chooseCastMovementPosition(
+            plan.movementCells, castRangeCells(targetPosition, actorPosition, range),
+            actorPosition, targetPosition, range, mode,
+            canCastAt(actor, targetIndex, attackAreaType, range),
+            [this](Position from, Position target) { return terrainDistance(from, target); }).position;
+        return plan;
+    };
+
+    const auto forceSkill = resumeAutoAttack || requestSupport || supportWithoutPosition;
+    bool preserveSupportFallback = false;
+    if (!forceSkill && resourceAction == battle::AiResourceAction::None
+        && battle::shouldRetreatForHealth(resourceState, random)) {
+        battle::SelectableCells movementCells;
+        movementArea(actor, movementCells);
+        const auto retreatPosition = battle::chooseRetreatPosition(
+            movementCells, ch.steps, enemyPositions(actor));
+        if (retreatPosition) {
+            runAt(actor, movementCells, *retreatPosition, [this, actor]() { field_.rest(actor); });
+        } else {
+            field_.rest(actor);
+        }
+        return;
+    }
+
+    auto followup = forceSkill
+        ? battle::AiFollowupDecision{battle::AiFollowupAction::Skill, -1, -1}
+        : battle::chooseAiFollowupAction(
+            actor, strategyActor, strategyCharacters,
+            throwingItems, strategySkills, random);
+
+    if (followup.action == battle::AiFollowupAction::Rest) {
+        field_.setActionCode(actor, 7);
+        field_.rest(actor);
+        return;
+    }
+
+    if (followup.action == battle::AiFollowupAction::MedicSupport
+        || followup.action == battle::AiFollowupAction::DepoisonSupport) {
+        const auto medic = followup.action == battle::AiFollowupAction::MedicSupport;
+        const auto range = battle::calcTechniqueRange(
+            medic ? actorAiStats.medic : actorAiStats.depoison);
+        field_.setActionCode(actor, medic ? 5 : 4);
+        auto plan = chooseCastPosition(followup.targetIndex, range, 0,
+                                       battle::CastMovementMode::Approach);
+        if (plan.position) {
+            const auto targetIndex = followup.targetIndex;
+            runAt(actor, plan.movementCells, *plan.position,
+                [this, actor, targetIndex, count, medic, range, allyPower, actorAiStats]() {
+                    if (targetIndex < 0 || targetIndex >= count
+                        || field_.character(targetIndex).info->hp <= 0
+                        || !canCastAt(actor, targetIndex, 0, range)) {
+                        /* Preserve action code 4/5 and let the next
+                         * invocation enter the ordinary skill path. */
+                        fallBack(actor, actorAiStats, allyPower);
+                        return;
+                    }
+                    const auto target = field_.character(targetIndex);
+                    AutoAct act;
+                    act.id = medic ? -1 : -2;
+                    act.cursorX = target.x;
+                    act.cursorY = target.y;
+                    field_.act(actor, act);
+                });
+            return;
+        }
+        if (battle::chooseUnreachableSupportFallback(
+                actorAiStats.attack, allyPower.total, allyPower.count)
+            == battle::AiSupportFallback::Rest) {
+            field_.rest(actor);
+            return;
+        }
+        preserveSupportFallback = true;
+        followup.action = battle::AiFollowupAction::Skill;
+    }
+
+    if (followup.action == battle::AiFollowupAction::Poison) {
+        const auto targetIndex = battle::choosePoisonTarget(
+            actor, strategyActor, strategyCharacters, random, pathDistance);
+        if (!targetIndex) {
+            /* Z.DAT:sub_3540E jumps directly to random-skill selection when
+             * no eligible poison target exists. */
+            followup.action = battle::AiFollowupAction::Skill;
+        } else {
+            const auto range = battle::calcTechniqueRange(actorAiStats.poison);
+            field_.setActionCode(actor, 3);
+            auto plan = chooseCastPosition(
+                *targetIndex, range, 0,
+                ch.steps > 0 ? battle::CastMovementMode::Reposition
+                             : battle::CastMovementMode::Approach);
+            if (plan.position) {
+                const auto selectedTargetIndex = *targetIndex;
+                runAt(actor, plan.movementCells, *plan.position,
+                    [this, actor, selectedTargetIndex, range, allyPower, actorAiStats]() {
+                        const auto target = field_.character(selectedTargetIndex);
+                        if (target.info->hp <= 0 || target.side == field_.character(actor).side
+                            || !canCastAt(actor, selectedTargetIndex, 0, range)) {
+                            /* sub_3540E uses the same team-power split when
+                             * repositioning still cannot reach the target. */
+                            fallBack(actor, actorAiStats, allyPower);
+                            return;
+                        }
+                        AutoAct act;
+                        act.id = -3;
+                        act.cursorX = target.x;
+                        act.cursorY = target.y;
+                        field_.act(actor, act);
+                    });
+                return;
+            }
+            if (battle::chooseUnreachableSupportFallback(
+                    actorAiStats.attack, allyPower.total, allyPower.count)
+                == battle::AiSupportFallback::Rest) {
+                field_.rest(actor);
+                return;
+            }
+            followup.action = battle::AiFollowupAction::Skill;
+        }
+    }
+
+    if (followup.action == battle::AiFollowupAction::Throw) {
+        const auto targetIndex = battle::chooseAiTarget(
+            actor, strategyActor, strategyCharacters, random, pathDistance);
+        const auto item = std::find_if(
+            throwingItems.begin(), throwingItems.end(),
+            [&followup](const battle::AiThrowingOption &candidate) {
+                return candidate.selectionIndex == followup.selectionIndex;
+            });
+        if (targetIndex && item != throwingItems.end()) {
+            const auto range = battle::calcTechniqueRange(actorAiStats.throwing);
+            field_.setActionCode(actor, 10);
+            auto plan = chooseCastPosition(*targetIndex, range, 0,
+                                           battle::CastMovementMode::Approach);
+            if (plan.position) {
+                const auto selectedTargetIndex = *targetIndex;
+                const auto itemId = item->itemId;
+                const auto itemSlot = static_cast<std::int16_t>(ch.side != 0 ? item->selectionIndex : -1);
+                runAt(actor, plan.movementCells, *plan.position,
+                    [this, actor, selectedTargetIndex, range, itemId, itemSlot]() {
+                        const auto target = field_.character(selectedTargetIndex);
+                        if (target.info->hp <= 0 || target.side == field_.character(actor).side
+                            || !canCastAt(actor, selectedTargetIndex, 0, range)) {
+                            /* sub_3582B falls through to random skills after
+                             * a failed post-move throw check. */
+                            resume_ = true;
+                            return;
+                        }
+                        AutoAct act;
+                        act.index = itemId;
+                        act.id = -4;
+                        act.itemSlot = itemSlot;
+                        act.cursorX = target.x;
+                        act.cursorY = target.y;
+                        field_.act(actor, act);
+                    });
+                return;
+            }
+        }
+        followup.action = battle::AiFollowupAction::Skill;
+    }
+
+    const auto skillSlot = battle::chooseOriginalSkillSlot(strategySkills, random);
+    if (!skillSlot || *skillSlot < 0 || *skillSlot >= ::hojy::content::LearnSkillCount) {
+        field_.rest(actor);
+        return;
+    }
+    const auto skillId = info.skillId[*skillSlot];
+    const auto *skill = skillId > 0 ? ::hojy::world::state::gSaveData.skillInfo[skillId] : nullptr;
+    if (!skill) {
+        field_.rest(actor);
+        return;
+    }
+    const auto storedSkillLevel = info.skillLevel[*skillSlot];
+    /*
+     * Z.DAT:sub_34C47 chooses the candidate position from the stored
+     * proficiency level.  MP-based level forcing happens later, when the
+     * selected action is executed (sub_37734).  Resolving it here changes
+     * target selection for low-MP actors because selRange[level] can differ.
+     */
+    const auto skillRange = skill->selRange[
+        battle::resolveAiSkillLevels(skill->reqMp, storedSkillLevel, info.mp).planning];
+
+    const auto selectedSkillSlot = static_cast<std::int16_t>(*skillSlot);
+    const auto castSkill = [this, actor, count, skill, skillId,
+                            selectedSkillSlot, storedSkillLevel](int targetIndex) {
+        if (targetIndex < 0 || targetIndex >= count) {
+            field_.rest(actor);
+            return;
+        }
+        const auto current = field_.character(actor);
+        const auto target = field_.character(targetIndex);
+        AutoAct act;
+        if (skill->attackAreaType == 1) {
+            const auto dx = target.x - current.x;
+            const auto dy = target.y - current.y;
+            if (dy < 0) act.direction = battle::AttackDirection::Up;
+            else if (dx > 0) act.direction = battle::AttackDirection::Right;
+            else if (dx < 0) act.direction = battle::AttackDirection::Left;
+            else act.direction = battle::AttackDirection::Down;
+            act.cursorX = current.x;
+            act.cursorY = current.y;
+        } else {
+            act.cursorX = target.x;
+            act.cursorY = target.y;
+        }
+        act.index = selectedSkillSlot;
+        act.id = skillId;
+        /* Resolve the actual cast level only after movement is complete. */
+        act.level = battle::resolveAiSkillLevels(
+            skill->reqMp, storedSkillLevel, current.info->mp).execution;
+        if (act.level < 0) {
+            field_.rest(actor);
+            return;
+        }
+        act.attackTimes = battle::attackCount(current.info->doubleAttack);
+        field_.act(actor, act);
+    };
+
+    auto targetIndex = battle::chooseAiTarget(
+        actor, strategyActor, strategyCharacters, random, pathDistance);
+    CastPositionPlan skillPlan;
+    if (targetIndex) {
+        skillPlan = chooseCastPosition(
+            *targetIndex, skillRange, skill->attackAreaType,
+            skill->attackAreaType == 1 || skill->attackAreaType == 2
+                ? battle::CastMovementMode::Aligned
+                : battle::CastMovementMode::Approach);
+    }
+    field_.setActionCode(actor, battle::actionCodeForSkill(
+        field_.character(actor).actionCode, forceSkill || preserveSupportFallback));
+    if (skillPlan.position) {
+        const auto selectedTargetIndex = *targetIndex;
+        runAt(actor, skillPlan.movementCells, *skillPlan.position,
+            [this, actor, selectedTargetIndex, skillRange, skill, castSkill]() {
+                if (canCastAt(actor, selectedTargetIndex, skill->attackAreaType, skillRange)) {
+                    castSkill(selectedTargetIndex);
+                    return;
+                }
+                const auto fallback = nearestTarget(actor);
+                if (fallback && canCastAt(actor, *fallback, skill->attackAreaType, skillRange)) {
+                    castSkill(*fallback);
+                } else {
+                    field_.rest(actor);
+                }
+            });
+        return;
+    }
+
+    const auto fallbackTarget = nearestTarget(actor);
+    if (fallbackTarget && canCastAt(actor, *fallbackTarget, skill->attackAreaType, skillRange)) {
+        castSkill(*fallbackTarget);
+        return;
+    }
+    field_.rest(actor);
+}
+
+bool AutoBattleAi::onMap(Position position) const {
+    return position.first >= 0 && position.first < field_.fieldWidth()
+        && position.second >= 0 && position.second < field_.fieldHeight();
+}
+
+int AutoBattleAi::terrainDistance(Position from, Position target) {
+    return field_.distances().terrainDistance(from, target);
+}
+
+bool AutoBattleAi::canCastAt(int actor, int target, int attackAreaType, int range) {
+    const auto ch = field_.character(actor);
+    if (target < 0 || target >= field_.characterCount() || !onMap({ch.x, ch.y})) {
+        return false;
+    }
+    const auto other = field_.character(target);
+    if (other.info->hp <= 0 || !onMap({other.x, other.y})) {
+        return false;
+    }
+    const Position actorPosition{ch.x, ch.y};
+    const Position targetPosition{other.x, other.y};
+    return battle::canCastFromPosition(
+        attackAreaType, range, terrainDistance(actorPosition, targetPosition),
+        actorPosition, targetPosition);
+}
+
+battle::SelectableCells AutoBattleAi::castRangeCells(Position target, Position actor, int range) {
+    battle::SelectableCells cells;
+    if (!onMap(target) || !onMap(actor)) {
+        return cells;
+    }
+    battle::getCastRangeArea(
+        field_.fieldWidth(), field_.fieldHeight(), target, std::max(0, range), cells,
+        [this](int x, int y) { return field_.blocked(x, y); },
+        [this, target, actor](int x, int y) {
+            const Position position{x, y};
+            return position != target && position != actor && field_.occupied(x, y);
+        });
+    return cells;
+}
+
+void AutoBattleAi::movementArea(int actor, battle::SelectableCells &cells) {
+    const auto ch = field_.character(actor);
+    battle::getSelectableArea(
+        field_.fieldWidth(), field_.fieldHeight(), {ch.x, ch.y}, ch.steps, 0, cells,
+        [this](int x, int y) { return field_.blocked(x, y); },
+        [this](int x, int y) { return field_.occupied(x, y); },
+        [](int, int) { return false; });
+}
+
+void AutoBattleAi::moveTo(const battle::SelectableCells &cells, Position position) {
+    std::vector<Position> path;
+    const auto *cell = cells.lookup(position);
+    while (cell) {
+        path.emplace_back(cell->x, cell->y);
+        cell = cells.lookup(cell->moveParent);
+    }
+    field_.moveAlong(std::move(path));
+}
+
+bool AutoBattleAi::runAt(int actor, const battle::SelectableCells &cells, Position position,
+                         std::function<void()> action) {
+    pending_ = [this, actor, action = std::move(action)]() {
+        if (field_.currentActor() != actor) { return; }
+        if (field_.character(actor).info->hp <= 0) {
+            field_.endTurn(actor);
+            return;
+        }
+        action();
+    };
+    const auto ch = field_.character(actor);
+    if (position != Position{ch.x, ch.y}) {
+        if (!cells.contains(position)) {
+            pending_ = nullptr;
+            field_.endTurn(actor);
+            return false;
+        }
+        moveTo(cells, position);
+        return true;
+    }
+    battle::runPendingAction(pending_);
+    return true;
+}
+
+std::vector<AutoBattleAi::Position> AutoBattleAi::enemyPositions(int actor) {
+    const auto side = field_.character(actor).side;
+    std::vector<Position> positions;
+    const auto count = field_.characterCount();
+    for (int i = 0; i < count; ++i) {
+        const auto candidate = field_.character(i);
+        if (candidate.id >= 0 && candidate.side != side && onMap({candidate.x, candidate.y})) {
+            positions.emplace_back(candidate.x, candidate.y);
+        }
+    }
+    return positions;
+}
+
+std::optional<int> AutoBattleAi::nearestTarget(int actor) {
+    const auto ch = field_.character(actor);
+    std::optional<int> selected;
+    auto selectedDistance = std::numeric_limits<int>::max();
+    const auto count = field_.characterCount();
+    for (int i = 0; i < count; ++i) {
+        const auto candidate = field_.character(i);
+        if (i == actor || candidate.id < 0 || candidate.side == ch.side
+            || candidate.info->hp <= 0 || !onMap({candidate.x, candidate.y})) {
+            continue;
+        }
+        const auto distance = terrainDistance({ch.x, ch.y}, {candidate.x, candidate.y});
+        if (distance < 0 || distance >= selectedDistance) { continue; }
+        selected = i;
+        selectedDistance = distance;
+    }
+    return selected;
+}
+
+void AutoBattleAi::fallBack(int actor, const battle::AiStats &actorAiStats,
+                            const battle::AiPowerSummary &allyPower) {
+    if (battle::chooseUnreachableSupportFallback(
+            actorAiStats.attack, allyPower.total, allyPower.count)
+        == battle::AiSupportFallback::Rest) {
+        field_.rest(actor);
+    } else {
+        /* Keeps action code 4/5 while the actor falls back to the
+         * ordinary random-skill path on the next frame */
+        resume_ = true;
+    }
+}
+
+}
@@ -0,0 +1,143 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "battle/ai.hh"
+#include "battle/ai_policy.hh"
+#include "battle/attack_area.hh"
+#include "battle/movement.hh"
+#include "world/bag.hh"
+#include "world/character.hh"
+
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace hojy::battle {
+class RandomSource;
+}
+
+namespace hojy::sim {
+
+/* A character as the auto control sees it */
+struct AutoCharacter {
+    std::uint8_t side = 0;
+    std::int16_t id = -1;
+    int x = -1, y = -1;
+    std::int16_t steps = 0;
+    std::int16_t actionCode = 0;
+    ::hojy::world::state::CharacterData *info = nullptr;
+};
+
+/* An action to start where the actor stands */
+struct AutoAct {
+    /* -4throw -3poison -2depoison -1medic 0~skillId */
+    std::int16_t index = -1, id = -1, level = 0;
+    std::int16_t itemSlot = -1;
+    int attackTimes = 1;
+    int cursorX = 0, cursorY = 0;
+    /* Set for directional skills, the actor turns before acting */
+    std::optional<battle::AttackDirection> direction;
+};
+
+/* What AutoBattleAi reads from and does to a battle field.  Characters are
+ * addressed by their index, which stays the same for the whole battle.  The
+ * actions only apply to the current actor and are ignored for anyone else. */
+class AutoBattleField {
+public:
+    virtual ~AutoBattleField() = default;
+
+    [[nodiscard]] virtual int fieldWidth() const = 0;
+    [[nodiscard]] virtual int fieldHeight() const = 0;
+    [[nodiscard]] virtual bool blocked(int x, int y) const = 0;
+    [[nodiscard]] virtual bool occupied(int x, int y) const = 0;
+    virtual battle::DistanceFieldCache &distances() = 0;
+    virtual battle::RandomSource &random() = 0;
+    /* Items of side 0, the other side carries its own */
+    [[nodiscard]] virtual const ::hojy::world::state::Bag &bag() const = 0;
+
+    [[nodiscard]] virtual int characterCount() const = 0;
+    [[nodiscard]] virtual AutoCharacter character(int index) = 0;
+    [[nodiscard]] virtual battle::AiStats aiStats(int index) const = 0;
+    virtual void setActionCode(int index, std::int16_t actionCode) = 0;
+    /* -1 between turns */
+    [[nodiscard]] virtual int currentActor() const = 0;
+
+    /* The path runs from the destination back to the actor's cell */
+    virtual void moveAlong(std::vector<std::pair<int, int>> path) = 0;
+    virtual void rest(int actor) = 0;
+    virtual void endTurn(int actor) = 0;
+    virtual void useItem(int actor, std::int16_t itemId) = 0;
+    virtual void act(int actor, const AutoAct &act) = 0;
+};
+
+/*
+ * The auto control of a battle: picks what the current actor does through
+ * battle::ai_policy and ai_strategy, moves it into place and starts the
+ * action.  Warfield runs it for enemies and auto-controlled allies, the
+ * batch simulator for everyone.  An action that waits for the actor to
+ * arrive is kept until run() is called again after the move.
+ */
+class AutoBattleAi final {
+public:
+    explicit AutoBattleAi(AutoBattleField &field): field_(field) {}
+
+    /* false when there is no current actor and nothing was pending */
+    bool run();
+    [[nodiscard]] bool pending() const noexcept { return static_cast<bool>(pending_); }
+    /* The actor goes on to its skills on the next run() */
+    [[nodiscard]] bool resuming() const noexcept { return resume_; }
+    void dropPending() noexcept { pending_ = nullptr; }
+    void clear() noexcept {
+        pending_ = nullptr;
+        resume_ = false;
+    }
+
+private:
+    using Position = std::pair<int, int>;
+
+    void runSkill(int actor, const battle::AiStats &actorAiStats,
+                  const battle::AiResourceState &resourceState,
+                  const battle::AiPowerSummary &allyPower,
+                  bool resumeAutoAttack, bool requestSupport,
+                  bool supportWithoutPosition,
+                  battle::AiResourceAction resourceAction);
+    [[nodiscard]] bool onMap(Position position) const;
+    int terrainDistance(Position from, Position target);
+    bool canCastAt(int actor, int target, int attackAreaType, int range);
+    battle::SelectableCells castRangeCells(Position target, Position actor, int range);
+    void movementArea(int actor, battle::SelectableCells &cells);
+    void moveTo(const battle::SelectableCells &cells, Position position);
+    bool runAt(int actor, const battle::SelectableCells &cells, Position position,
+               std::function<void()> action);
+    std::vector<Position> enemyPositions(int actor);
+    std::optional<int> nearestTarget(int actor);
+    /* Falls back to the skills, or rests when the allies are strong enough */
+    void fallBack(int actor, const battle::AiStats &actorAiStats, const battle::AiPowerSummary &allyPower);
+
+private:
+    AutoBattleField &field_;
+    std::function<void()> pending_;
+    bool resume_ = false;
+};
+
+}
@@ -0,0 +1,120 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "scenario.hh"
+
+#include "content/warfielddata.hh"
+#include "world/savedata.hh"
+
+#include <map>
+#include <set>
+#include <utility>
+
+namespace hojy::sim {
+
+std::vector<std::int16_t> defaultMembers(std::int16_t warId) {
+    std::vector<std::int16_t> members;
+    const auto *info = ::hojy::content::gWarfieldData.info(warId);
+    if (!info) { return members; }
+    const auto *source = info->forceMembers[0] >= 0
+        ? info->forceMembers : ::hojy::world::state::gSaveData.baseInfo->members;
+    for (size_t i = 0; i < ::hojy::content::TeamMemberCount; ++i) {
+        if (source[i] >= 0) { members.push_back(source[i]); }
+    }
+    return members;
+}
+
+bool buildScenario(std::int16_t warId, const std::vector<std::int16_t> &members, Scenario &scenario) {
+    const auto *info = ::hojy::content::gWarfieldData.info(warId);
+    if (!info) { return false; }
+    const auto *warfieldLayers = ::hojy::content::gWarfieldData.layers(info->warFieldId);
+    if (!warfieldLayers) { return false; }
+    const auto &layers = warfieldLayers->layers;
+
+    Scenario result;
+    result.warId = warId;
+    result.width = ::hojy::content::WarFieldWidth;
+    result.height = ::hojy::content::WarFieldHeight;
+    const auto size = result.width * result.height;
+    result.blocked.resize(size);
+    for (int pos = 0; pos < size; ++pos) {
+        result.blocked[pos] = ::hojy::content::isWarfieldCellBlocked(
+            std::int16_t(layers[0][pos] >> 1), std::int16_t(layers[1][pos] >> 1)) ? 1 : 0;
+    }
+
+    std::vector<bool> occupied(size, false);
+    std::set<std::int16_t> seen;
+    bool duplicated = false;
+    auto appendChar = [&](std::uint8_t side, std::int16_t id, std::int16_t x, std::int16_t y) {
+        if (id < 0) { return; }
+        if (!seen.insert(id).second) {
+            duplicated = true;
+            return;
+        }
+        const auto *charInfo = ::hojy::world::state::gSaveData.charInfo[id];
+        if (!charInfo) { return; }
+        if (x < 0 || x >= result.width || y < 0 || y >= result.height) { return; }
+        const auto index = y * result.width + x;
+        if (occupied[index]) { return; }
+        occupied[index] = true;
+        result.combatants.push_back(Combatant {side, id, x, y, *charInfo});
+    };
+
+    if (info->forceMembers[0] >= 0) {
+        for (size_t i = 0; i < ::hojy::content::TeamMemberCount; ++i) {
+            appendChar(0, info->forceMembers[i], info->memberX[i], info->memberY[i]);
+        }
+    } else {
+        std::map<std::int16_t, size_t> charMap;
+        std::set<size_t> indices;
+        for (size_t i = 0; i < ::hojy::content::TeamMemberCount; ++i) {
+            auto id = info->defaultMembers[i];
+            if (id >= 0) { charMap[id] = i; }
+            else { indices.insert(i); }
+        }
+        for (auto id: members) {
+            auto ite = charMap.find(id);
+            size_t index;
+            if (ite != charMap.end()) {
+                index = ite->second;
+            } else {
+                if (indices.empty()) { continue; }
+                index = *indices.begin();
+                indices.erase(indices.begin());
+            }
+            appendChar(0, id, info->memberX[index], info->memberY[index]);
+        }
+    }
+    for (size_t i = 0; i < ::hojy::content::WarFieldEnemyCount; ++i) {
+        appendChar(1, info->enemy[i], info->enemyX[i], info->enemyY[i]);
+    }
+    if (duplicated) { return false; }
+
+    bool hasPlayer = false, hasEnemy = false;
+    for (const auto &combatant: result.combatants) {
+        hasPlayer = hasPlayer || combatant.side == 0;
+        hasEnemy = hasEnemy || combatant.side != 0;
+    }
+    if (!hasPlayer || !hasEnemy) { return false; }
+    result.bag = ::hojy::world::state::gBag;
+    scenario = std::move(result);
+    return true;
+}
+
+}
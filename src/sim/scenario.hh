@@ -0,0 +1,57 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "world/bag.hh"
+#include "world/character.hh"
+
+#include <cstdint>
+#include <vector>
+
+namespace hojy::sim {
+
+struct Combatant {
+    std::uint8_t side; /* 0-self 1-enemy */
+    std::int16_t id;
+    std::int16_t x, y;
+    /* Save-data copy, before equipment bonuses and enemy refill */
+    ::hojy::world::state::CharacterData info;
+};
+
+/* Everything one battle needs, detached from the global save so that many
+ * battles can run from the same scenario concurrently. */
+struct Scenario {
+    std::int16_t warId = -1;
+    int width = 0, height = 0;
+    std::vector<std::uint8_t> blocked;
+    std::vector<Combatant> combatants;
+    ::hojy::world::state::Bag bag;
+};
+
+/* The forced line-up of the war, or else the whole current party; default
+ * members keep their fixed start cells when placed. */
+std::vector<std::int16_t> defaultMembers(std::int16_t warId);
+
+/* Places `members` and the war's enemies the way Warfield::putChars does,
+ * using gWarfieldData, gSaveData and gBag.  Returns false if the war does not
+ * exist or one of the sides ends up empty. */
+bool buildScenario(std::int16_t warId, const std::vector<std::int16_t> &members, Scenario &scenario);
+
+}
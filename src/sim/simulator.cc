@@ -0,0 +1,481 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "simulator.hh"
+
+#include "battle/combat_rules.hh"
+#include "battle/turn_order.hh"
+#include "content/constants.hh"
+#include "world/action.hh"
+#include "world/savedata.hh"
+
+#include <algorithm>
+#include <map>
+#include <tuple>
+
+namespace hojy::sim {
+
+namespace {
+
+/* Warfield has no such limit; it only keeps a batch run from spinning on an
+ * actor whose auto action never ends the turn. */
+constexpr int MaxActionsPerTurn = 32;
+
+}
+
+Simulator::Simulator(const Scenario &scenario, std::uint64_t seed, std::uint32_t maxRounds):
+    width_(scenario.width), height_(scenario.height), blocked_(scenario.blocked),
+    occupant_(static_cast<size_t>(scenario.width * scenario.height), -1),
+    bag_(scenario.bag), random_(seed), maxRounds_(maxRounds) {
+    blocked_.resize(occupant_.size(), 0);
+    chars_.reserve(scenario.combatants.size());
+    for (const auto &combatant: scenario.combatants) {
+        if (!onMap({combatant.x, combatant.y})
+            || occupant_[combatant.y * width_ + combatant.x] >= 0) {
+            continue;
+        }
+        occupant_[combatant.y * width_ + combatant.x] = static_cast<int>(chars_.size());
+        auto &ci = chars_.emplace_back();
+        ci.side = combatant.side;
+        ci.id = combatant.id;
+        ci.x = combatant.x;
+        ci.y = combatant.y;
+        ci.info = combatant.info;
+        ci.aiEntryStats = battle::snapshotAiStats(ci.info);
+        ::hojy::world::state::addUpPropFromEquipToChar(&ci.info);
+        ci.aiEquipmentBonusStats = battle::captureAiEquipmentBonuses(ci.aiEntryStats, ci.info);
+        if (ci.side == 1) {
+            ci.info.hp = ci.info.maxHp;
+            ci.info.mp = ci.info.maxMp;
+            ci.info.stamina = ::hojy::content::StaminaMax;
+        }
+    }
+    turnOrder_.reserve(chars_.size());
+    for (auto &ci: chars_) {
+        turnOrder_.emplace_back(&ci);
+    }
+    distanceFields_.setTerrain(width_, height_, [this](int x, int y) {
+        return blocked_[y * width_ + x] != 0;
+    });
+    recalcKnowledge();
+}
+
+Outcome Simulator::run() {
+    if (!checkWarEnd()) {
+        while (stage_ != Finished) {
+            switch (stage_) {
+            case Idle:
+                nextAction();
+                break;
+            case Moving:
+                moveStep();
+                break;
+            case Acting:
+                finishActing();
+                break;
+            default:
+                break;
+            }
+        }
+    }
+    for (const auto &ci: chars_) {
+        if (ci.info.hp > 0) { ++outcome_.survivors[ci.side]; }
+    }
+    return std::move(outcome_);
+}
+
+battle::AiStats Simulator::currentAiStats(const Fighter &fighter) const noexcept {
+    return battle::resolveAiRuntimeStats(
+        fighter.aiEntryStats, fighter.aiEquipmentBonusStats, fighter.info);
+}
+
+battle::DistanceFieldCache &Simulator::distanceFields() {
+    distanceFields_.setOccupancy(occupancyGeneration_, [this](int x, int y) {
+        return occupant_[y * width_ + x] >= 0;
+    });
+    return distanceFields_;
+}
+
+bool Simulator::AiField::blocked(int x, int y) const {
+    return owner_.blocked_[y * owner_.width_ + x] != 0;
+}
+
+bool Simulator::AiField::occupied(int x, int y) const {
+    return owner_.occupant_[y * owner_.width_ + x] >= 0;
+}
+
+AutoCharacter Simulator::AiField::character(int index) {
+    auto &fighter = owner_.chars_[index];
+    return AutoCharacter{
+        fighter.side, fighter.id, fighter.x, fighter.y,
+        fighter.steps, fighter.actionCode, &fighter.info,
+    };
+}
+
+battle::AiStats Simulator::AiField::aiStats(int index) const {
+    return owner_.currentAiStats(owner_.chars_[index]);
+}
+
+void Simulator::AiField::setActionCode(int index, std::int16_t actionCode) {
+    owner_.chars_[index].actionCode = actionCode;
+}
+
+int Simulator::AiField::currentActor() const {
+    return owner_.currentActor_ ? static_cast<int>(owner_.currentActor_ - owner_.chars_.data()) : -1;
+}
+
+void Simulator::AiField::moveAlong(std::vector<std::pair<int, int>> path) {
+    owner_.movingPath_ = std::move(path);
+    owner_.stage_ = Moving;
+}
+
+void Simulator::AiField::rest(int actor) {
+    owner_.doRest(&owner_.chars_[actor]);
+}
+
+void Simulator::AiField::endTurn(int actor) {
+    owner_.endTurn(&owner_.chars_[actor]);
+}
+
+void Simulator::AiField::useItem(int actor, std::int16_t itemId) {
+    auto *ch = &owner_.chars_[actor];
+    if (owner_.currentActor_ != ch) { return; }
+    std::map<::hojy::world::state::PropType, std::int16_t> changes;
+    const auto usedItem = ch->side == 1
+        ? ::hojy::world::state::useNpcItem(&ch->info, itemId, changes)
+        : ::hojy::world::state::useItem(owner_.bag_, &ch->info, itemId, changes);
+    if (!usedItem) {
+        owner_.doRest(ch);
+        return;
+    }
+    owner_.endTurn(ch);
+}
+
+void Simulator::AiField::act(int actor, const AutoAct &act) {
+    auto *ch = &owner_.chars_[actor];
+    if (owner_.currentActor_ != ch) { return; }
+    if (act.direction) { ch->direction = *act.direction; }
+    owner_.actIndex_ = act.index;
+    owner_.actId_ = act.id;
+    owner_.actLevel_ = act.level;
+    owner_.actItemSlot_ = act.itemSlot;
+    owner_.attackTimesLeft_ = act.attackTimes;
+    owner_.cursorX_ = act.cursorX;
+    owner_.cursorY_ = act.cursorY;
+    owner_.startActAction();
+}
+
+void Simulator::recalcKnowledge() {
+    knowledge_[0] = knowledge_[1] = 0;
+    for (auto &ci: chars_) {
+        if (ci.info.hp > 0 && ci.info.knowledge > ::hojy::content::KnowledgeBarrier) {
+            knowledge_[ci.side] += ci.info.knowledge;
+        }
+    }
+}
+
+void Simulator::clearActionState() {
+    actIndex_ = -1;
+    actId_ = -1;
+    actLevel_ = 0;
+    actItemSlot_ = -1;
+    attackTimesLeft_ = 0;
+}
+
+void Simulator::nextAction() {
+    currentActor_ = nullptr;
+    Fighter *ch = nullptr;
+    for (;;) {
+        if (charQueue_.empty()) {
+            if (outcome_.rounds > 0) {
+                for (auto &ci: chars_) {
+                    ::hojy::world::state::actRoundEndDrain(&ci.info, ci.x < 0 || ci.y < 0);
+                }
+                if (checkWarEnd()) { return; }
+            }
+            if (outcome_.rounds >= maxRounds_) {
+                stage_ = Finished;
+                return;
+            }
+            ++outcome_.rounds;
+            charQueue_ = battle::buildRoundQueue(
+                turnOrder_,
+                [](const Fighter *actor) { return actor->info.speed; },
+                [](const Fighter *actor) { return actor->info.hp > 0; });
+            for (auto *actor: charQueue_) {
+                actor->steps = battle::calculateMovementSteps(
+                    actor->info.speed, actor->info.hurt);
+                actor->initialSteps = actor->steps;
+            }
+            if (charQueue_.empty()) {
+                checkWarEnd();
+                return;
+            }
+        }
+        ch = charQueue_.back();
+        if (ch->info.hp <= 0) {
+            charQueue_.pop_back();
+            actionsThisTurn_ = 0;
+            continue;
+        }
+        break;
+    }
+    currentActor_ = ch;
+    if (++actionsThisTurn_ > MaxActionsPerTurn) {
+        endTurn(ch);
+        return;
+    }
+    battle::prepareActorActionCode(ch->actionCode, ai_.pending() || ai_.resuming());
+    if (!ai_.run()) {
+        stage_ = Idle;
+    }
+}
+
+void Simulator::moveStep() {
+    auto *ch = currentActor_;
+    const auto continueOrEnd = [this, ch]() {
+        if (battle::shouldContinueAfterMovement(
+                false, ai_.pending(), ai_.resuming())) {
+            stage_ = Idle;
+        } else {
+            endTurn(ch);
+        }
+    };
+    if (movingPath_.empty() || !ch) {
+        movingPath_.clear();
+        if (ch) {
+            continueOrEnd();
+        } else {
+            stage_ = Idle;
+        }
+        return;
+    }
+    int x, y;
+    std::tie(x, y) = movingPath_.back();
+    if (x == ch->x && y == ch->y) {
+        movingPath_.pop_back();
+        if (movingPath_.empty()) {
+            continueOrEnd();
+            return;
+        }
+        std::tie(x, y) = movingPath_.back();
+    }
+    movingPath_.pop_back();
+    auto &from = occupant_[ch->y * width_ + ch->x];
+    auto &to = occupant_[y * width_ + x];
+    if (from != static_cast<int>(ch - chars_.data()) || to >= 0) {
+        movingPath_.clear();
+        endTurn(ch);
+        return;
+    }
+    --ch->steps;
+    to = from;
+    from = -1;
+    ++occupancyGeneration_;
+    ch->x = x;
+    ch->y = y;
+    if (movingPath_.empty()) {
+        continueOrEnd();
+    }
+}
+
+void Simulator::finishActing() {
+    auto *actor = currentActor_;
+    if (!actor) {
+        stage_ = Idle;
+        clearActionState();
+        return;
+    }
+    if (--attackTimesLeft_ > 0) {
+        const auto *skill = ::hojy::world::state::gSaveData.skillInfo[actId_];
+        if (!skill) {
+            clearActionState();
+            endTurn(actor);
+            return;
+        }
+        actLevel_ = battle::calcRepeatedSkillLevel(skill->reqMp, actLevel_, actor->info.mp);
+        if (actLevel_ >= 0) {
+            startActAction();
+        } else {
+            actIndex_ = actId_ = -1;
+            actItemSlot_ = -1;
+        }
+    } else {
+        actIndex_ = actId_ = -1;
+        actItemSlot_ = -1;
+    }
+    if (actIndex_ < 0) {
+        clearActionState();
+        endTurn(actor);
+    }
+}
+
+void Simulator::startActAction() {
+    auto *ch = currentActor_;
+    if (!ch) { stage_ = Idle; return; }
+    if (actId_ < 0) {
+        const auto targetIndex = onMap({cursorX_, cursorY_}) ? occupant_[cursorY_ * width_ + cursorX_] : -1;
+        if (targetIndex < 0) {
+            endTurn(ch);
+            return;
+        }
+        auto *target = &chars_[targetIndex];
+        const bool targetAlive = target->info.hp > 0;
+        const bool targetIsEnemy = target->side != ch->side;
+        const auto *itemInfo = actId_ == -4 && actIndex_ >= 0
+            && static_cast<std::size_t>(actIndex_) < ::hojy::world::state::gSaveData.itemInfo.size()
+            ? ::hojy::world::state::gSaveData.itemInfo[actIndex_]
+            : nullptr;
+        const bool validTarget = actId_ == -3
+            ? targetAlive && targetIsEnemy
+            : actId_ == -2 || actId_ == -1
+                ? targetAlive && !targetIsEnemy
+                : actId_ == -4 && itemInfo && targetAlive && targetIsEnemy;
+        if (!validTarget) {
+            endTurn(ch);
+            return;
+        }
+        switch (actId_) {
+        case -3:
+            ::hojy::world::state::actPoison(&ch->info, &target->info, 0);
+            break;
+        case -2:
+            ::hojy::world::state::actDepoison(&ch->info, &target->info, 0, random_);
+            break;
+        case -1:
+            ::hojy::world::state::actMedic(&ch->info, &target->info, 2, random_);
+            break;
+        default: {
+            bool dead = false;
+            ::hojy::world::state::actThrow(&ch->info, &target->info, actIndex_, 0, dead, random_);
+            if (ch->side == 0) { bag_.remove(actIndex_, 1); }
+            else {
+                ::hojy::world::state::consumeNpcItemAt(&ch->info, actItemSlot_, actIndex_);
+            }
+            if (dead) {
+                recalcKnowledge();
+            }
+            break;
+        }
+        }
+        if (actId_ >= -3 && actId_ <= -1) {
+            battle::finishUtilityAction(ch->info, ch->exp);
+        }
+        stage_ = Acting;
+        return;
+    }
+    const auto *skillInfo = ::hojy::world::state::gSaveData.skillInfo[actId_];
+    if (!skillInfo) {
+        clearActionState();
+        endTurn(ch);
+        return;
+    }
+    stage_ = Acting;
+    const auto attackCells = battle::enumerateAttackCells(
+        width_, height_, ch->x, ch->y, cursorX_, cursorY_,
+        skillInfo->attackAreaType, skillInfo->selRange[actLevel_],
+        skillInfo->area[actLevel_], ch->direction);
+    for (const auto &cell: attackCells) {
+        makeDamage(ch, cell.x, cell.y, cell.distance);
+    }
+    bool levelup = false;
+    ::hojy::world::state::postDamage(
+        &ch->info, actIndex_, actLevel_,
+        attackTimesLeft_ == 1 ? 3 : 0, levelup, random_);
+    if (levelup) {
+        actLevel_ = std::clamp<std::int16_t>(ch->info.skillLevel[actIndex_] / 100, 0, 9);
+    }
+}
+
+void Simulator::makeDamage(Fighter *ch, int x, int y, int distance) {
+    const auto index = occupant_[y * width_ + x];
+    if (index < 0 || chars_[index].side == ch->side) { return; }
+    auto &enemyInfo = chars_[index].info;
+    std::int16_t dmg, ps, exp;
+    bool dead = false;
+    bool wasDead = enemyInfo.hp <= 0;
+    if (::hojy::world::state::actDamage(
+            &ch->info, &enemyInfo, knowledge_[ch->side], knowledge_[ch->side ^ 1],
+            distance, actIndex_, actLevel_, dmg, ps, exp, dead, random_)) {
+        ch->exp += exp;
+        if (!wasDead && dead) {
+            recalcKnowledge();
+        }
+        outcome_.damage[ch->side] += dmg;
+        outcome_.hits[ch->side].push_back(dmg);
+    }
+}
+
+void Simulator::doRest(Fighter *expectedActor) {
+    auto *ch = currentActor_;
+    if (!ch || (expectedActor && expectedActor != ch)) { return; }
+    if (ch->info.hp <= 0) {
+        endTurn(ch);
+        return;
+    }
+    ::hojy::world::state::actRest(
+        &ch->info, battle::hasMoved(ch->initialSteps, ch->steps), random_);
+    endTurn(ch);
+}
+
+void Simulator::endTurn(Fighter *expectedActor) {
+    auto *ch = currentActor_;
+    if (!ch || (expectedActor && expectedActor != ch)) { return; }
+    const auto ite = std::find(charQueue_.begin(), charQueue_.end(), ch);
+    if (ite != charQueue_.end()) {
+        charQueue_.erase(ite);
+    }
+    ++outcome_.turns;
+    actionsThisTurn_ = 0;
+    currentActor_ = nullptr;
+    ai_.clear();
+    movingPath_.clear();
+    clearActionState();
+    for (auto &ci: chars_) {
+        if (!battle::shouldClearDeadPosition(ci.info.hp, ci.x, ci.y)) {
+            continue;
+        }
+        if (onMap({ci.x, ci.y})) {
+            auto &cell = occupant_[ci.y * width_ + ci.x];
+            if (cell == static_cast<int>(&ci - chars_.data())) {
+                cell = -1;
+                ++occupancyGeneration_;
+            }
+        }
+        ci.x = ci.y = -1;
+    }
+    if (checkWarEnd()) { return; }
+    stage_ = Idle;
+}
+
+bool Simulator::checkWarEnd() {
+    int aliveCount[2] = {0, 0};
+    for (const auto &ci: chars_) {
+        if (ci.info.hp > 0) { ++aliveCount[ci.side]; }
+    }
+    if (aliveCount[0] > 0 && aliveCount[1] > 0) {
+        return false;
+    }
+    outcome_.won = aliveCount[1] == 0;
+    outcome_.finished = true;
+    stage_ = Finished;
+    return true;
+}
+
+}
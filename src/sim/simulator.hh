@@ -0,0 +1,157 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "scenario.hh"
+#include "auto_battle_ai.hh"
+
+#include "battle/ai.hh"
+#include "battle/attack_area.hh"
+#include "battle/movement.hh"
+#include "battle/random.hh"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace hojy::sim {
+
+struct Outcome {
+    bool won = false;
+    /* false when the round limit ran out before either side was wiped out */
+    bool finished = false;
+    std::uint32_t rounds = 0;
+    std::uint32_t turns = 0;
+    std::uint32_t survivors[2] = {0, 0};
+    /* skill damage dealt by each side, and the damage of every single hit */
+    std::int64_t damage[2] = {0, 0};
+    std::vector<std::int16_t> hits[2];
+};
+
+/*
+ * Plays one battle with both sides under AI control, without rendering,
+ * animation or engine recording.  The turn flow follows Warfield's auto
+ * control path and calls the same battle:: decisions and world act*
+ * functions, but movement and attack animations complete immediately.  All
+ * randomness is drawn from a private SeededRandom, so a scenario and a seed
+ * always give the same outcome and battles can run on any thread.
+ */
+class Simulator final {
+public:
+    static constexpr std::uint32_t DefaultMaxRounds = 500;
+
+    Simulator(const Scenario &scenario, std::uint64_t seed, std::uint32_t maxRounds = DefaultMaxRounds);
+
+    Outcome run();
+
+private:
+    enum Stage {
+        Idle,
+        Moving,
+        Acting,
+        Finished,
+    };
+    struct Fighter {
+        std::uint8_t side;
+        std::int16_t id;
+        int x, y;
+        ::hojy::world::state::CharacterData info;
+        std::uint16_t exp = 0;
+        std::int16_t steps = 0, initialSteps = 0;
+        battle::AttackDirection direction = battle::AttackDirection::Up;
+        battle::AiStats aiEntryStats;
+        battle::AiStats aiEquipmentBonusStats;
+        std::int16_t actionCode = 0;
+    };
+    using Position = std::pair<int, int>;
+
+    /* The battle as seen by the shared auto control */
+    class AiField final: public AutoBattleField {
+    public:
+        explicit AiField(Simulator &owner): owner_(owner) {}
+
+        [[nodiscard]] int fieldWidth() const override { return owner_.width_; }
+        [[nodiscard]] int fieldHeight() const override { return owner_.height_; }
+        [[nodiscard]] bool blocked(int x, int y) const override;
+        [[nodiscard]] bool occupied(int x, int y) const override;
+        battle::DistanceFieldCache &distances() override { return owner_.distanceFields(); }
+        battle::RandomSource &random() override { return owner_.random_; }
+        [[nodiscard]] const ::hojy::world::state::Bag &bag() const override { return owner_.bag_; }
+        [[nodiscard]] int characterCount() const override { return static_cast<int>(owner_.chars_.size()); }
+        [[nodiscard]] AutoCharacter character(int index) override;
+        [[nodiscard]] battle::AiStats aiStats(int index) const override;
+        void setActionCode(int index, std::int16_t actionCode) override;
+        [[nodiscard]] int currentActor() const override;
+        void moveAlong(std::vector<std::pair<int, int>> path) override;
+        void rest(int actor) override;
+        void endTurn(int actor) override;
+        void useItem(int actor, std::int16_t itemId) override;
+        void act(int actor, const AutoAct &act) override;
+
+    private:
+        Simulator &owner_;
+    };
+
+    void nextAction();
+    void moveStep();
+    void finishActing();
+    void startActAction();
+    void makeDamage(Fighter *ch, int x, int y, int distance);
+    void doRest(Fighter *expectedActor = nullptr);
+    void endTurn(Fighter *expectedActor = nullptr);
+    bool checkWarEnd();
+    void recalcKnowledge();
+    void clearActionState();
+
+    [[nodiscard]] bool onMap(Position position) const noexcept {
+        return position.first >= 0 && position.first < width_
+            && position.second >= 0 && position.second < height_;
+    }
+    [[nodiscard]] battle::AiStats currentAiStats(const Fighter &fighter) const noexcept;
+    battle::DistanceFieldCache &distanceFields();
+
+private:
+    int width_, height_;
+    std::vector<std::uint8_t> blocked_;
+    std::vector<int> occupant_;
+    std::vector<Fighter> chars_;
+    ::hojy::world::state::Bag bag_;
+    battle::SeededRandom random_;
+    std::uint32_t maxRounds_;
+    std::vector<Fighter *> turnOrder_;
+    std::vector<Fighter *> charQueue_;
+    Fighter *currentActor_ = nullptr;
+    battle::DistanceFieldCache distanceFields_;
+    std::uint32_t occupancyGeneration_ = 0;
+    Stage stage_ = Idle;
+    std::uint16_t knowledge_[2] = {0, 0};
+    int cursorX_ = 0, cursorY_ = 0;
+    std::vector<Position> movingPath_;
+    /* -4throw -3poison -2depoison -1medic 0~skillId */
+    std::int16_t actIndex_ = -1, actId_ = -1, actLevel_ = 0;
+    std::int16_t actItemSlot_ = -1;
+    int attackTimesLeft_ = 0;
+    int actionsThisTurn_ = 0;
+    Outcome outcome_;
+    AiField aiField_{*this};
+    AutoBattleAi ai_{aiField_};
+};
+
+}
@@ -0,0 +1,248 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Headless batch runner for war balance and regression checks.  Every battle
+ * is played by the Warfield AI on both sides from a fixed seed, so the same
+ * arguments always print the same numbers.
+ */
+
+#include "core/config.hh"
+#include "content/loader.hh"
+#include "content/warfielddata.hh"
+#include "sim/simulator.hh"
+#include "util/threadpool.hh"
+#include "world/bag.hh"
+#include "world/savedata.hh"
+#include "world/strings.hh"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace hojy;
+
+namespace {
+
+struct Options {
+    std::string config = "config.toml";
+    std::vector<std::int16_t> wars;
+    bool allWars = false;
+    std::size_t battles = 1000;
+    std::uint64_t seed = 1;
+    std::size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    std::vector<std::int16_t> members;
+    int save = 0;
+    std::uint32_t maxRounds = sim::Simulator::DefaultMaxRounds;
+};
+
+void usage(const char *name) {
+    std::fprintf(stderr,
+                 "Usage: %s (--war <id>[,<id>...] | --all) [options]\n"
+                 "  --battles <n>        battles per war (default 1000)\n"
+                 "  --seed <n>           base seed (default 1)\n"
+                 "  --threads <n>        worker threads including this one (default: all cores)\n"
+                 "  --members <id,...>   party sent into non-forced wars (default: current party)\n"
+                 "  --save <n>           save slot to load, 0 for a new game (default 0)\n"
+                 "  --max-rounds <n>     rounds before a battle counts as timed out (default %u)\n"
+                 "  --config <file>      config file (default config.toml)\n",
+                 name, sim::Simulator::DefaultMaxRounds);
+}
+
+bool parseNumber(const char *text, std::uint64_t &value) {
+    char *end = nullptr;
+    value = std::strtoull(text, &end, 0);
+    return end != text && *end == 0;
+}
+
+bool parseIdList(const char *text, std::vector<std::int16_t> &ids) {
+    std::string list = text;
+    std::size_t pos = 0;
+    while (pos <= list.size()) {
+        auto comma = list.find(',', pos);
+        if (comma == std::string::npos) { comma = list.size(); }
+        std::uint64_t value;
+        if (!parseNumber(list.substr(pos, comma - pos).c_str(), value) || value > 32767) {
+            return false;
+        }
+        ids.push_back(static_cast<std::int16_t>(value));
+        pos = comma + 1;
+    }
+    return !ids.empty();
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--all") == 0) {
+            options.allWars = true;
+            continue;
+        }
+        if (i + 1 >= argc) { return false; }
+        const char *value = argv[++i];
+        std::uint64_t number = 0;
+        if (std::strcmp(arg, "--war") == 0) {
+            if (!parseIdList(value, options.wars)) { return false; }
+        } else if (std::strcmp(arg, "--members") == 0) {
+            if (!parseIdList(value, options.members)) { return false; }
+        } else if (std::strcmp(arg, "--config") == 0) {
+            options.config = value;
+        } else if (!parseNumber(value, number)) {
+            return false;
+        } else if (std::strcmp(arg, "--battles") == 0) {
+            options.battles = static_cast<std::size_t>(number);
+        } else if (std::strcmp(arg, "--seed") == 0) {
+            options.seed = number;
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            options.threads = std::max<std::size_t>(1, static_cast<std::size_t>(number));
+        } else if (std::strcmp(arg, "--save") == 0) {
+            options.save = static_cast<int>(number);
+        } else if (std::strcmp(arg, "--max-rounds") == 0) {
+            options.maxRounds = static_cast<std::uint32_t>(std::max<std::uint64_t>(1, number));
+        } else {
+            return false;
+        }
+    }
+    return options.allWars || !options.wars.empty();
+}
+
+/* Independent seed per battle, so results do not depend on the thread count */
+std::uint64_t battleSeed(std::uint64_t seed, std::int16_t warId, std::uint64_t index) {
+    auto z = seed ^ (static_cast<std::uint64_t>(static_cast<std::uint16_t>(warId)) << 48) ^ index;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr std::array<int, 9> HistogramBounds = {1, 10, 25, 50, 100, 200, 400, 800, 1600};
+
+void printDamage(const char *label, const std::vector<sim::Outcome> &outcomes, int side) {
+    std::vector<std::int16_t> hits;
+    std::int64_t total = 0;
+    for (const auto &outcome: outcomes) {
+        hits.insert(hits.end(), outcome.hits[side].begin(), outcome.hits[side].end());
+        total += outcome.damage[side];
+    }
+    std::fprintf(stdout, "  %s damage: %.1f per battle, %zu hits", label,
+                 outcomes.empty() ? 0.0 : double(total) / double(outcomes.size()), hits.size());
+    if (hits.empty()) {
+        std::fprintf(stdout, "\n");
+        return;
+    }
+    std::sort(hits.begin(), hits.end());
+    const auto at = [&hits](double quantile) {
+        return int(hits[std::min(hits.size() - 1, std::size_t(quantile * double(hits.size())))]);
+    };
+    std::fprintf(stdout, ", per hit p10 %d p50 %d p90 %d max %d\n", at(0.1), at(0.5), at(0.9), int(hits.back()));
+    std::array<std::size_t, HistogramBounds.size() + 1> buckets {};
+    for (auto hit: hits) {
+        const auto bucket = std::upper_bound(HistogramBounds.begin(), HistogramBounds.end(), int(hit))
+            - HistogramBounds.begin();
+        ++buckets[bucket];
+    }
+    std::fprintf(stdout, "   ");
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        if (i == 0) {
+            std::fprintf(stdout, " <%d:%zu", HistogramBounds[0], buckets[i]);
+        } else if (i == HistogramBounds.size()) {
+            std::fprintf(stdout, " %d+:%zu", HistogramBounds[i - 1], buckets[i]);
+        } else {
+            std::fprintf(stdout, " %d-%d:%zu", HistogramBounds[i - 1], HistogramBounds[i] - 1, buckets[i]);
+        }
+    }
+    std::fprintf(stdout, "\n");
+}
+
+void report(std::int16_t warId, const std::vector<sim::Outcome> &outcomes, double seconds) {
+    std::size_t won = 0, timedOut = 0;
+    std::uint64_t rounds = 0, turns = 0;
+    std::uint32_t minRounds = std::numeric_limits<std::uint32_t>::max(), maxRounds = 0;
+    for (const auto &outcome: outcomes) {
+        won += outcome.won ? 1 : 0;
+        timedOut += outcome.finished ? 0 : 1;
+        rounds += outcome.rounds;
+        turns += outcome.turns;
+        minRounds = std::min(minRounds, outcome.rounds);
+        maxRounds = std::max(maxRounds, outcome.rounds);
+    }
+    const auto count = double(std::max<std::size_t>(1, outcomes.size()));
+    std::fprintf(stdout,
+                 "war %d: %zu battles, won %.1f%%, timed out %.1f%%, rounds %.2f (%u-%u), turns %.2f,"
+                 " %.2f us/battle\n",
+                 int(warId), outcomes.size(), 100.0 * double(won) / count, 100.0 * double(timedOut) / count,
+                 double(rounds) / count, outcomes.empty() ? 0U : minRounds, maxRounds,
+                 double(turns) / count, seconds * 1e6 / count);
+    printDamage("party", outcomes, 0);
+    printDamage("enemy", outcomes, 1);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    if (!core::config.load(options.config) || !core::config.postLoad()) { return EXIT_FAILURE; }
+    if (!::hojy::world::state::gStrings.load("strings.toml")) { return EXIT_FAILURE; }
+    core::config.fixOnTextLoaded();
+    if (!::hojy::content::loadData()) {
+        std::fprintf(stderr, "Unable to load game data\n");
+        return EXIT_FAILURE;
+    }
+    if (!::hojy::world::state::gSaveData.load(options.save)) {
+        std::fprintf(stderr, "Unable to load save %d\n", options.save);
+        return EXIT_FAILURE;
+    }
+    ::hojy::world::state::gBag.syncFromSave();
+    if (options.allWars) {
+        options.wars.clear();
+        for (std::size_t i = 0; i < ::hojy::content::gWarfieldData.size(); ++i) {
+            options.wars.push_back(static_cast<std::int16_t>(i));
+        }
+    }
+
+    util::ThreadPool pool(options.threads - 1);
+    for (auto warId: options.wars) {
+        sim::Scenario scenario;
+        const auto members = options.members.empty() ? sim::defaultMembers(warId) : options.members;
+        if (!sim::buildScenario(warId, members, scenario)) {
+            std::fprintf(stdout, "war %d: skipped, no valid line-up\n", int(warId));
+            continue;
+        }
+        std::vector<sim::Outcome> outcomes(options.battles);
+        const auto start = std::chrono::steady_clock::now();
+        pool.parallelFor(outcomes.size(), [&](std::size_t index) {
+            sim::Simulator simulator(scenario, battleSeed(options.seed, warId, index), options.maxRounds);
+            outcomes[index] = simulator.run();
+        });
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        report(warId, outcomes, elapsed.count());
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/* Build-time generator for util/conv.cc: turns the Big5 and Traditional to
+ * Simplified Chinese source tables into constant arrays, so that nothing is
+ * sorted or allocated when the game starts.
+ * Usage: hojy_convtables <output.inl> */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+
+struct Pair {
+    std::uint32_t from;
+    std::uint32_t to;
+};
+
+const Pair Big5Source[] =
+#include "util/big5table.inl"
+
+const std::vector<std::pair<std::uint32_t, std::uint32_t>> CharSource = {
+#include "util/tschars.inl"
+};
+
+const std::vector<std::pair<std::vector<std::uint32_t>, std::vector<std::uint32_t>>> WordSource = {
+#include "util/tswords.inl"
+};
+
+class Writer {
+public:
+    explicit Writer(FILE *file): file_(file) {}
+
+    template<typename T>
+    void array(const char *type, const char *name, const std::vector<T> &values) {
+        std::fprintf(file_, "constexpr %s %s[%zu] = {", type, name, values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            std::fprintf(file_, "%s0x%llx,", i % 16 == 0 ? "\n    " : " ",
+                         static_cast<unsigned long long>(values[i]));
+        }
+        std::fprintf(file_, "\n};\n\n");
+    }
+
+    void pairs(const char *name, const std::vector<Pair> &values) {
+        std::fprintf(file_, "constexpr Conv::Pair %s[%zu] = {", name, values.size());
+        for (std::size_t i = 0; i < values.size(); ++i) {
+            std::fprintf(file_, "%s{0x%x, 0x%x},", i % 8 == 0 ? "\n    " : " ", values[i].from, values[i].to);
+        }
+        std::fprintf(file_, "\n};\n\n");
+    }
+
+private:
+    FILE *file_;
+};
+
+bool pairLess(const Pair &a, const Pair &b) {
+    return a.from == b.from ? a.to < b.to : a.from < b.from;
+}
+
+/* Big5 to Unicode as rows of 256 trail bytes, one row per lead byte in use */
+void writeBig5(Writer &writer) {
+    std::vector<std::uint8_t> rowOf(256, 0);
+    std::vector<std::uint16_t> rows;
+    std::vector<Pair> reverse;
+    for (const auto &p: Big5Source) {
+        const auto lead = p.from >> 8U, trail = p.from & 0xFFU;
+        if (rowOf[lead] == 0) {
+            rows.resize(rows.size() + 256, 0);
+            rowOf[lead] = static_cast<std::uint8_t>(rows.size() / 256);
+        }
+        rows[(rowOf[lead] - 1U) * 256U + trail] = static_cast<std::uint16_t>(p.to);
+        reverse.push_back({p.to, p.from});
+    }
+    std::sort(reverse.begin(), reverse.end(), pairLess);
+    writer.array("std::uint8_t", "Big5Rows", rowOf);
+    writer.array("std::uint16_t", "Big5ToUnicode", rows);
+    writer.pairs("UnicodeToBig5", reverse);
+}
+
+/* Phrases as a double-array trie over a compact alphabet: child of state s by
+ * code c is t = base[s] + c when check[t] == s, the root is state 1 */
+void writeTrie(Writer &writer) {
+    struct Node {
+        std::map<std::uint32_t, int> children;
+        int word = -1;
+    };
+    std::vector<Node> nodes(1);
+    std::vector<std::uint32_t> alphabet;
+    for (std::size_t i = 0; i < WordSource.size(); ++i) {
+        int node = 0;
+        for (auto ch: WordSource[i].first) {
+            alphabet.push_back(ch);
+            auto ite = nodes[node].children.find(ch);
+            if (ite == nodes[node].children.end()) {
+                nodes.emplace_back();
+                ite = nodes[node].children.emplace(ch, int(nodes.size() - 1)).first;
+            }
+            node = ite->second;
+        }
+        nodes[node].word = int(i);
+    }
+    std::sort(alphabet.begin(), alphabet.end());
+    alphabet.erase(std::unique(alphabet.begin(), alphabet.end()), alphabet.end());
+    auto codeOf = [&alphabet](std::uint32_t ch) {
+        return std::uint32_t(std::lower_bound(alphabet.begin(), alphabet.end(), ch) - alphabet.begin()) + 1U;
+    };
+
+    std::vector<std::uint32_t> base(2, 0), check(2, 0), word(2, 0);
+    std::vector<std::uint32_t> wordOffsets(1, 0), wordChars;
+    auto grow = [&](std::size_t size) {
+        if (size <= check.size()) { return; }
+        base.resize(size, 0);
+        check.resize(size, 0);
+        word.resize(size, 0);
+    };
+    std::queue<std::pair<int, std::uint32_t>> pending;
+    pending.emplace(0, 1U);
+    check[1] = 1;
+    std::uint32_t firstFree = 2;
+    while (!pending.empty()) {
+        const auto [node, state] = pending.front();
+        pending.pop();
+        /* A phrase with nothing to replace it with is not a match */
+        if (nodes[node].word >= 0 && !WordSource[nodes[node].word].second.empty()) {
+            const auto &to = WordSource[nodes[node].word].second;
+            wordChars.insert(wordChars.end(), to.begin(), to.end());
+            wordOffsets.push_back(std::uint32_t(wordChars.size()));
+            word[state] = std::uint32_t(wordOffsets.size() - 1);
+        }
+        if (nodes[node].children.empty()) { continue; }
+        std::vector<std::uint32_t> codes;
+        for (const auto &child: nodes[node].children) { codes.push_back(codeOf(child.first)); }
+        std::uint32_t b = firstFree > codes.front() ? firstFree - codes.front() : 1U;
+        for (;; ++b) {
+            grow(b + codes.back() + 1);
+            if (std::all_of(codes.begin(), codes.end(), [&](std::uint32_t c) { return check[b + c] == 0; })) {
+                break;
+            }
+        }
+        base[state] = b;
+        auto child = nodes[node].children.begin();
+        for (auto c: codes) {
+            check[b + c] = state;
+            pending.emplace(child->second, b + c);
+            ++child;
+        }
+        while (firstFree < check.size() && check[firstFree] != 0) { ++firstFree; }
+    }
+    writer.array("std::uint32_t", "TrieAlphabet", alphabet);
+    writer.array("std::uint32_t", "TrieBase", base);
+    writer.array("std::uint32_t", "TrieCheck", check);
+    writer.array("std::uint32_t", "TrieWord", word);
+    writer.array("std::uint32_t", "TrieWordOffsets", wordOffsets);
+    writer.array("std::uint32_t", "TrieWordChars", wordChars);
+}
+
+void writeChars(Writer &writer) {
+    std::vector<Pair> chars;
+    for (const auto &p: CharSource) { chars.push_back({p.first, p.second}); }
+    /* The first mapping of a character wins */
+    std::stable_sort(chars.begin(), chars.end(), [](const Pair &a, const Pair &b) { return a.from < b.from; });
+    chars.erase(std::unique(chars.begin(), chars.end(), [](const Pair &a, const Pair &b) {
+        return a.from == b.from;
+    }), chars.end());
+    writer.pairs("TradToSimp", chars);
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    if (argc != 2) {
+        std::fprintf(stderr, "Usage: %s <output.inl>\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    FILE *file = std::fopen(argv[1], "w");
+    if (!file) {
+        std::fprintf(stderr, "Cannot write %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    std::fprintf(file, "/* Generated by hojy_convtables from big5table.inl, tschars.inl and tswords.inl */\n\n");
+    Writer writer(file);
+    writeBig5(writer);
+    writeChars(writer);
+    writeTrie(writer);
+    if (std::fclose(file) != 0) {
+        std::fprintf(stderr, "Cannot write %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
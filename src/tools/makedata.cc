@@ -18,6 +18,7 @@
  */
 
 #include "content/atomic_file.hh"
+#include "content/contentpack.hh"
 #include "makedata_assets.hh"
 
 #include <array>
@@ -439,15 +440,18 @@ std::string quoteToml(const std::string &value) {
     return result;
 }
 
-bool makeConfig(const std::string &configTemplate, const std::string &fontPath,
+bool makeConfig(const std::string &configTemplate, const std::string &fontPath, bool contentPack,
                 std::string &config, std::string &error) {
-    const std::map<std::string, std::string> replacements = {
+    std::map<std::string, std::string> replacements = {
         {"data_path", "data_path = [\"data\"]"},
         {"music_path", "music_path = \"data\""},
         {"sound_path", "sound_path = \"data\""},
         {"save_path", "save_path = \"data\""},
         {"fonts", "fonts = " + quoteToml(fontPath)},
     };
+    if (contentPack) {
+        replacements.emplace("content_pack", "content_pack = true");
+    }
     std::map<std::string, bool> replaced;
     for (const auto &entry : replacements) {
         replaced.emplace(entry.first, false);
@@ -618,15 +622,28 @@ bool installStagedOutput(const fs::path &stage, const fs::path &target,
     return true;
 }
 
+bool writeContentPack(const fs::path &dataDirectory, std::string &error) {
+    const auto resolve = [&dataDirectory](const std::string &name) {
+        return (dataDirectory / name).string();
+    };
+    if (!hojy::content::ContentPack::rebuild((dataDirectory / hojy::content::ContentPack::DefaultName).string(),
+                                             resolve, error)) {
+        error = "cannot build the content pack: " + error;
+        return false;
+    }
+    return true;
+}
+
 int run(int argc, char *argv[]) {
-    if (argc != 4) {
-        std::fprintf(stderr, "Usage: %s <original-game-path> <target-path> <font-file>\n", argv[0]);
+    const bool contentPack = argc == 5 && std::string(argv[1]) == "--pack";
+    if (argc != 4 && !contentPack) {
+        std::fprintf(stderr, "Usage: %s [--pack] <original-game-path> <target-path> <font-file>\n", argv[0]);
         return EXIT_FAILURE;
     }
 
-    const fs::path source = argv[1];
-    const fs::path target = argv[2];
-    const fs::path font = argv[3];
+    const fs::path source = argv[argc - 3];
+    const fs::path target = argv[argc - 2];
+    const fs::path font = argv[argc - 1];
     std::error_code ec;
     if (!fs::is_directory(source, ec)) {
         std::fprintf(stderr, "Source path is not a directory: %s\n", source.string().c_str());
@@ -670,7 +687,7 @@ int run(int argc, char *argv[]) {
     std::string generatedConfig;
     const auto relativeFont = (fs::path("data") / "font" / font.filename()).generic_string();
     if (!makeConfig(std::string(hojy::tools::assets::ConfigToml),
-                    relativeFont, generatedConfig, error)) {
+                    relativeFont, contentPack, generatedConfig, error)) {
         std::fprintf(stderr, "%s\n", error.c_str());
         return EXIT_FAILURE;
     }
@@ -713,6 +730,11 @@ int run(int argc, char *argv[]) {
         removeTree(stage);
         return EXIT_FAILURE;
     }
+    if (contentPack && !writeContentPack(dataDirectory, error)) {
+        std::fprintf(stderr, "%s\n", error.c_str());
+        removeTree(stage);
+        return EXIT_FAILURE;
+    }
     if (!hojy::content::AtomicFile::write(stage / "config.toml", generatedConfig)) {
         std::fprintf(stderr, "Cannot write config.toml to target directory.\n");
         removeTree(stage);
@@ -0,0 +1,196 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Checks a set of battle replays (.hjr files written when replay_path is set
+ * in config.toml) against the current battle rules.  Files are verified in
+ * parallel; failures are listed in path order with the first action and
+ * random call that no longer match.
+ */
+
+#include "battle/replay_file.hh"
+#include "util/threadpool.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <variant>
+#include <vector>
+
+using namespace hojy;
+
+namespace {
+
+struct Options {
+    std::vector<std::string> paths;
+    std::size_t threads = std::max(1U, std::thread::hardware_concurrency());
+    bool quiet = false;
+};
+
+struct Verdict {
+    bool loaded = false;
+    battle::ReplayResult result;
+    std::string actionText;
+    std::string randomText;
+};
+
+void usage(const char *name) {
+    std::fprintf(stderr,
+                 "Usage: %s [options] <file|directory>...\n"
+                 "  --threads <n>    worker threads including this one (default: all cores)\n"
+                 "  --quiet          only print failures and the summary\n"
+                 "Directories are searched recursively for *%s files.\n",
+                 name, battle::ReplayFileExtension);
+}
+
+bool parseOptions(int argc, char *argv[], Options &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+        } else if (std::strcmp(arg, "--threads") == 0) {
+            if (i + 1 >= argc) { return false; }
+            char *end = nullptr;
+            const auto value = std::strtoull(argv[++i], &end, 0);
+            if (*end != 0) { return false; }
+            options.threads = std::max<std::size_t>(1, static_cast<std::size_t>(value));
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            return false;
+        } else {
+            options.paths.emplace_back(arg);
+        }
+    }
+    return !options.paths.empty();
+}
+
+bool collectFiles(const std::vector<std::string> &paths, std::vector<std::string> &files) {
+    namespace fs = std::filesystem;
+    for (const auto &path: paths) {
+        std::error_code ec;
+        if (fs::is_directory(path, ec)) {
+            for (fs::recursive_directory_iterator it(path, ec), end; !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file(ec) && it->path().extension() == battle::ReplayFileExtension) {
+                    files.push_back(it->path().string());
+                }
+            }
+        } else if (fs::is_regular_file(path, ec)) {
+            files.push_back(path);
+        }
+        if (ec) {
+            std::fprintf(stderr, "%s: %s\n", path.c_str(), ec.message().c_str());
+            return false;
+        }
+    }
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return true;
+}
+
+const char *actionName(const battle::ActionPayload &payload) {
+    static constexpr const char *names[] = {
+        "move", "skill", "technique", "throw", "item", "rest", "round end", "no-op",
+    };
+    static_assert(std::size(names) == std::variant_size_v<battle::ActionPayload>);
+    return names[payload.index()];
+}
+
+/* Describes the failing action and random call while the replay is still at hand */
+void describe(const battle::BattleReplay &replay, Verdict &verdict) {
+    const auto &result = verdict.result;
+    if (result.failedAction < replay.actions.size()) {
+        const auto record = replay.actions.at(result.failedAction);
+        verdict.actionText = "action " + std::to_string(result.failedAction) + " (" + actionName(record.action.payload)
+            + " by participant " + std::to_string(record.action.actor) + ")";
+    }
+    if (result.failedRandomCall < replay.randomCalls.size()) {
+        const auto &call = replay.randomCalls[result.failedRandomCall];
+        verdict.randomText = "random call " + std::to_string(result.failedRandomCall) + " (range "
+            + std::to_string(call.minimum) + ".." + std::to_string(call.maximum) + ", raw "
+            + std::to_string(call.rawValue) + ", result " + std::to_string(call.result) + ")";
+    }
+}
+
+}
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    std::vector<std::string> files;
+    if (!collectFiles(options.paths, files)) { return EXIT_FAILURE; }
+
+    std::vector<Verdict> verdicts(files.size());
+    const auto start = std::chrono::steady_clock::now();
+    util::ThreadPool pool(options.threads - 1);
+    pool.parallelFor(files.size(), [&](std::size_t index) {
+        auto &verdict = verdicts[index];
+        /* A worker must not throw, one bad file would end the whole run */
+        try {
+            battle::BattleReplay replay;
+            verdict.loaded = battle::loadReplay(files[index], replay, &verdict.result.error);
+            if (!verdict.loaded) { return; }
+            verdict.result = battle::BattleEngine::replay(replay);
+            if (!verdict.result.valid) {
+                describe(replay, verdict);
+            }
+        } catch (const std::exception &error) {
+            verdict.loaded = false;
+            verdict.result.valid = false;
+            verdict.result.error = error.what();
+        }
+    });
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::size_t failed = 0;
+    std::size_t actions = 0;
+    for (std::size_t index = 0; index < files.size(); ++index) {
+        const auto &verdict = verdicts[index];
+        const auto &result = verdict.result;
+        if (verdict.loaded && result.valid) {
+            actions += result.actions;
+            if (!options.quiet) {
+                std::fprintf(stdout, "ok    %s: %zu actions, %s\n", files[index].c_str(), result.actions,
+                             result.won ? "won" : "lost");
+            }
+            continue;
+        }
+        ++failed;
+        std::fprintf(stdout, "FAIL  %s: %s\n", files[index].c_str(), result.error.c_str());
+        if (!verdict.actionText.empty()) {
+            std::fprintf(stdout, "      first diverging %s\n", verdict.actionText.c_str());
+        }
+        if (!verdict.randomText.empty()) {
+            std::fprintf(stdout, "      first diverging %s\n", verdict.randomText.c_str());
+        }
+    }
+    std::fprintf(stdout, "%zu replays, %zu passed, %zu failed, %zu actions verified in %.3f s on %zu threads\n",
+                 files.size(), files.size() - failed, failed, actions, elapsed.count(), pool.threads() + 1);
+    return failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
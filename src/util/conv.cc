@@ -20,25 +20,34 @@
 #include "conv.hh"
 
 #include <algorithm>
+#include <iterator>
 
 namespace hojy::util {
 
-Big5Conv big5Conv;
-Trad2SimpConv trad2SimpConv;
+const Big5Conv big5Conv {};
+const Trad2SimpConv trad2SimpConv {};
 
-struct PairCompare {
-    bool operator()(const Conv::Pair &a1, const Conv::Pair &a2) {
-        return a1.from == a2.from ? a1.to < a2.to : a1.from < a2.from;
-    }
-    bool operator()(std::uint32_t a1, const Conv::Pair &a2) {
-        return a1 == a2.from ? 0 < a2.to : a1 < a2.from;
-    }
-    bool operator()(const Conv::Pair &a1, std::uint32_t a2) {
-        return a1.from == a2 ? a1.to < 0 : a1.from < a2;
-    }
-};
+namespace {
+
+#include "convtables.inl"
+
+template<std::size_t N>
+const Conv::Pair *findPair(const Conv::Pair (&table)[N], std::uint32_t from) {
+    const auto *ite = std::lower_bound(table, table + N, from, [](const Conv::Pair &p, std::uint32_t value) {
+        return p.from < value;
+    });
+    return ite < table + N && ite->from == from ? ite : nullptr;
+}
 
-std::wstring Conv::toUnicode(std::string_view str) {
+std::uint32_t trieCode(std::uint32_t ch) {
+    const auto *end = TrieAlphabet + std::size(TrieAlphabet);
+    const auto *ite = std::lower_bound(TrieAlphabet, end, ch);
+    return ite < end && *ite == ch ? std::uint32_t(ite - TrieAlphabet) + 1U : 0U;
+}
+
+}
+
+std::wstring Big5Conv::toUnicode(std::string_view str) const {
     size_t len = str.length();
     const char *cstr = str.data();
     const char *cstrEnd = cstr + len;
@@ -55,19 +64,19 @@ std::wstring Conv::toUnicode(std::string_view str) {
         if (cstr + 1 >= cstrEnd) {
             break;
         }
-        std::uint32_t charcode = (std::uint16_t(c) << 8) | std::uint8_t(*(cstr + 1));
-        auto ite = std::lower_bound(table_, table_ + size_, charcode, PairCompare());
-        if (ite >= table_ + size_ || ite->from != charcode) {
+        const auto row = Big5Rows[c];
+        const auto ch = row ? Big5ToUnicode[(row - 1U) * 256U + std::uint8_t(*(cstr + 1))] : 0U;
+        if (ch == 0) {
             result.append(L"  ");
         } else {
-            result += wchar_t(ite->to);
+            result += wchar_t(ch);
         }
         cstr += 2;
     }
     return result;
 }
 
-std::string Conv::fromUnicode(std::wstring_view wstr) {
+std::string Big5Conv::fromUnicode(std::wstring_view wstr) const {
     size_t len = wstr.length();
     const wchar_t *cstr = wstr.data();
     const wchar_t *cstrEnd = cstr + len;
@@ -80,36 +89,18 @@ std::string Conv::fromUnicode(std::wstring_view wstr) {
             ++cstr;
             continue;
         }
-        auto ite = std::lower_bound(tableRev_, tableRev_ + size_, c, PairCompare());
-        if (ite >= tableRev_ + size_ || ite->from != c) {
+        const auto *p = findPair(UnicodeToBig5, c);
+        if (!p) {
             result.append("  ");
         } else {
-            result += char(ite->to >> 8);
-            result += char(ite->to & 0xFF);
+            result += char(p->to >> 8);
+            result += char(p->to & 0xFF);
         }
         ++cstr;
     }
     return result;
 }
 
-void Conv::postInit() {
-    tableRev_ = new Pair[size_];
-    for (size_t i = 0; i < size_; ++i) {
-        auto &p = table_[i];
-        tableRev_[i] = { p.to, p.from };
-    }
-    std::sort(table_, table_ + size_, PairCompare());
-    std::sort(tableRev_, tableRev_ + size_, PairCompare());
-}
-
-Big5Conv::Big5Conv() noexcept {
-    static Pair table[] =
-#include "big5table.inl"
-    table_ = table;
-    size_ = sizeof(table) / sizeof(Pair);
-    postInit();
-}
-
 std::wstring Utf8Conv::toUnicode(std::string_view str) {
     size_t sz = str.size();
     const auto *n = reinterpret_cast<const std::uint8_t*>(str.data());
@@ -204,50 +195,31 @@ std::string Utf8Conv::fromUnicode(std::wstring_view wstr) {
     return res;
 }
 
-Trad2SimpConv::Trad2SimpConv() noexcept {
-    charTable_ = {
-#include "tschars.inl"
-    };
-    std::vector<std::pair<std::vector<std::uint32_t>, std::vector<std::uint32_t>>> wordTable = {
-#include "tswords.inl"
-    };
-    for (auto &p: wordTable) {
-        auto *node = &root_;
-        for (auto c: p.first) {
-            node = &node->nodes[c];
-        }
-        node->word = std::move(p.second);
-    }
-}
-
-std::wstring Trad2SimpConv::convert(const std::wstring &str) {
+std::wstring Trad2SimpConv::convert(const std::wstring &str) const {
     std::wstring res;
     size_t sz = str.size();
     res.reserve(sz);
     for (size_t i = 0; i < sz;) {
-        {
-            auto *node = &root_;
-            size_t j = i;
-            bool notfound = false;
-            while (j < sz) {
-                auto c = str[j++];
-                auto ite = node->nodes.find(c);
-                if (ite == node->nodes.end()) {
-                    notfound = true;
-                    break;
-                }
-                node = &ite->second;
-            }
-            if (!notfound && !node->word.empty()) {
-                res.insert(res.end(), node->word.begin(), node->word.end());
-                i = j;
-                continue;
+        std::uint32_t state = 1;
+        size_t j = i;
+        while (j < sz) {
+            const auto code = trieCode(std::uint32_t(str[j]));
+            const auto next = TrieBase[state] + code;
+            if (code == 0 || next >= std::size(TrieCheck) || TrieCheck[next] != state) { break; }
+            state = next;
+            ++j;
+        }
+        if (j == sz && TrieWord[state]) {
+            const auto word = TrieWord[state];
+            for (auto k = TrieWordOffsets[word - 1]; k < TrieWordOffsets[word]; ++k) {
+                res += wchar_t(TrieWordChars[k]);
             }
+            break;
         }
         auto c = str[i];
-        auto ite = charTable_.find(c);
-        if (ite == charTable_.end()) res += c;
-        else res += wchar_t(ite->second);
+        const auto *p = findPair(TradToSimp, std::uint32_t(c));
+        if (!p) res += c;
+        else res += wchar_t(p->to);
         ++i;
     }
     return res;
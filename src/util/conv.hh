@@ -19,37 +19,26 @@
 
 #pragma once
 
-#include <vector>
-#include <map>
-#include <unordered_map>
 #include <string>
 #include <string_view>
-#include <utility>
 #include <cstdint>
 
 namespace hojy::util {
 
+/* Lookups go to constant tables generated at build time by hojy_convtables,
+ * so the converters need no initialization */
 class Conv {
 public:
     struct Pair {
         std::uint32_t from;
         std::uint32_t to;
     };
-    std::wstring toUnicode(std::string_view str);
-    std::string fromUnicode(std::wstring_view wstr);
-    virtual ~Conv() { delete[] tableRev_; }
-
-protected:
-    void postInit();
-
-protected:
-    Pair *table_ = nullptr, *tableRev_ = nullptr;
-    size_t size_ = 0;
 };
 
 class Big5Conv final: public Conv {
 public:
-    Big5Conv() noexcept;
+    [[nodiscard]] std::wstring toUnicode(std::string_view str) const;
+    [[nodiscard]] std::string fromUnicode(std::wstring_view wstr) const;
 };
 
 class Utf8Conv {
@@ -59,20 +48,13 @@ public:
 };
 
 class Trad2SimpConv final {
-    struct CNode {
-        std::vector<std::uint32_t> word;
-        std::map<std::uint32_t, CNode> nodes;
-    };
 public:
-    Trad2SimpConv() noexcept;
-    std::wstring convert(const std::wstring &str);
-
-private:
-    std::unordered_map<std::uint32_t, std::uint32_t> charTable_;
-    CNode root_;
+    /* Character by character, except that a phrase running to the end of the
+     * string is replaced as a whole */
+    [[nodiscard]] std::wstring convert(const std::wstring &str) const;
 };
 
-extern Big5Conv big5Conv;
-extern Trad2SimpConv trad2SimpConv;
+extern const Big5Conv big5Conv;
+extern const Trad2SimpConv trad2SimpConv;
 
 }
@@ -0,0 +1,55 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+namespace hojy::util {
+
+/* Read-only memory mapping of a whole file */
+class MappedFile final {
+public:
+    MappedFile() = default;
+    explicit MappedFile(const std::string &filename) { open(filename); }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    ~MappedFile();
+    MappedFile &operator=(const MappedFile&) = delete;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    bool open(const std::string &filename);
+    void close();
+
+    [[nodiscard]] const std::uint8_t *data() const { return data_; }
+    [[nodiscard]] std::size_t size() const { return size_; }
+    explicit operator bool() const { return data_ != nullptr; }
+
+private:
+    const std::uint8_t *data_ = nullptr;
+    std::size_t size_ = 0;
+#if defined(_WIN32)
+    void *file_ = nullptr;
+    void *mapping_ = nullptr;
+#endif
+};
+
+}
@@ -0,0 +1,119 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace hojy::util {
+
+/* Byte ring for exactly one producer and one consumer thread.  Data is reached
+ * through at most two spans (before and after the wrap point), so both sides
+ * can read or write in place; only reset() and clear() need both sides idle. */
+class RingBuffer final {
+public:
+    struct Span {
+        std::uint8_t *data;
+        std::size_t size;
+    };
+    using Spans = std::array<Span, 2>;
+
+    RingBuffer() = default;
+    explicit RingBuffer(std::size_t capacity) { reset(capacity); }
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer &operator=(const RingBuffer&) = delete;
+
+    /* Capacity is rounded up to a power of two */
+    inline void reset(std::size_t capacity) {
+        std::size_t size = 1;
+        while (size < capacity) { size <<= 1; }
+        buffer_ = capacity ? std::make_unique<std::uint8_t[]>(size) : nullptr;
+        capacity_ = capacity ? size : 0;
+        clear();
+    }
+    inline void clear() {
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+    }
+    [[nodiscard]] inline std::size_t capacity() const { return capacity_; }
+    [[nodiscard]] inline std::size_t readable() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed);
+    }
+    [[nodiscard]] inline std::size_t writable() const {
+        return capacity_ - (tail_.load(std::memory_order_relaxed) - head_.load(std::memory_order_acquire));
+    }
+
+    /* Consumer side */
+    [[nodiscard]] inline Spans readSpans(std::size_t limit) const {
+        return spans(head_.load(std::memory_order_relaxed), std::min(readable(), limit));
+    }
+    inline void commitRead(std::size_t size) {
+        head_.store(head_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+    inline std::size_t read(void *data, std::size_t size) {
+        auto *out = static_cast<std::uint8_t*>(data);
+        std::size_t total = 0;
+        for (const auto &span: readSpans(size)) {
+            std::copy_n(span.data, span.size, out + total);
+            total += span.size;
+        }
+        commitRead(total);
+        return total;
+    }
+
+    /* Producer side */
+    [[nodiscard]] inline Spans writeSpans(std::size_t limit) const {
+        return spans(tail_.load(std::memory_order_relaxed), std::min(writable(), limit));
+    }
+    inline void commitWrite(std::size_t size) {
+        tail_.store(tail_.load(std::memory_order_relaxed) + size, std::memory_order_release);
+    }
+    inline std::size_t write(const void *data, std::size_t size) {
+        const auto *in = static_cast<const std::uint8_t*>(data);
+        std::size_t total = 0;
+        for (const auto &span: writeSpans(size)) {
+            std::copy_n(in + total, span.size, span.data);
+            total += span.size;
+        }
+        commitWrite(total);
+        return total;
+    }
+
+private:
+    [[nodiscard]] inline Spans spans(std::size_t position, std::size_t size) const {
+        if (size == 0) { return {Span {nullptr, 0}, Span {nullptr, 0}}; }
+        const auto offset = position & (capacity_ - 1);
+        const auto first = std::min(size, capacity_ - offset);
+        return {Span {buffer_.get() + offset, first}, Span {buffer_.get(), size - first}};
+    }
+
+private:
+    std::unique_ptr<std::uint8_t[]> buffer_;
+    std::size_t capacity_ = 0;
+    /* Free-running positions, each written by one side only */
+    alignas(64) std::atomic<std::size_t> head_ {0};
+    alignas(64) std::atomic<std::size_t> tail_ {0};
+};
+
+}
@@ -0,0 +1,107 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "taskgraph.hh"
+
+#include "threadpool.hh"
+
+#include <stdexcept>
+#include <utility>
+
+namespace hojy::util {
+
+namespace {
+
+double millisecondsSince(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+}
+
+TaskGraph::Id TaskGraph::add(std::string name, std::function<bool()> func, const std::vector<Id> &dependencies) {
+    const auto id = tasks_.size();
+    for (auto dep: dependencies) {
+        if (dep >= id) {
+            throw std::invalid_argument("TaskGraph: dependency on a job not added yet");
+        }
+    }
+    tasks_.push_back(Task {std::move(name), std::move(func), {}, dependencies.size(), 0});
+    for (auto dep: dependencies) {
+        tasks_[dep].dependents.push_back(id);
+    }
+    return id;
+}
+
+bool TaskGraph::run(ThreadPool &pool) {
+    std::vector<Id> ready;
+    {
+        std::unique_lock<std::mutex> lk(mutex_);
+        timings_.clear();
+        timings_.reserve(tasks_.size());
+        failed_ = false;
+        startTime_ = std::chrono::steady_clock::now();
+        for (Id id = 0; id < tasks_.size(); ++id) {
+            tasks_[id].waiting = tasks_[id].dependencies;
+            if (tasks_[id].waiting == 0) { ready.push_back(id); }
+        }
+    }
+    launch(pool, ready);
+    std::unique_lock<std::mutex> lk(mutex_);
+    cond_.wait(lk, [this]() { return running_ == 0; });
+    elapsed_ = millisecondsSince(startTime_);
+    return !failed_ && timings_.size() == tasks_.size();
+}
+
+void TaskGraph::launch(ThreadPool &pool, const std::vector<Id> &ids) {
+    {
+        std::unique_lock<std::mutex> lk(mutex_);
+        running_ += ids.size();
+    }
+    /* Posting outside the lock: a pool without threads runs the job right here */
+    for (auto id: ids) {
+        pool.post([this, &pool, id]() { execute(pool, id); });
+    }
+}
+
+void TaskGraph::execute(ThreadPool &pool, Id id) {
+    auto &task = tasks_[id];
+    Timing timing {task.name, millisecondsSince(startTime_)};
+    try {
+        timing.ok = task.func();
+    } catch (const std::exception &) {
+        timing.ok = false;
+    }
+    timing.duration = millisecondsSince(startTime_) - timing.start;
+    std::vector<Id> ready;
+    {
+        std::unique_lock<std::mutex> lk(mutex_);
+        timings_.push_back(std::move(timing));
+        if (!timings_.back().ok) { failed_ = true; }
+        if (!failed_) {
+            for (auto next: task.dependents) {
+                if (--tasks_[next].waiting == 0) { ready.push_back(next); }
+            }
+        }
+    }
+    launch(pool, ready);
+    std::unique_lock<std::mutex> lk(mutex_);
+    if (--running_ == 0) { cond_.notify_all(); }
+}
+
+}
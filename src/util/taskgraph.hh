@@ -0,0 +1,78 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+
+namespace hojy::util {
+
+class ThreadPool;
+
+/* Jobs with dependencies run on a thread pool: a job is queued as soon as
+ * every job it depends on has finished.  Once a job fails no further job is
+ * started, run() returns after the ones already running are done. */
+class TaskGraph final {
+public:
+    using Id = std::size_t;
+    struct Timing {
+        std::string name;
+        /* Milliseconds, start is counted from the beginning of run() */
+        double start = 0., duration = 0.;
+        bool ok = false;
+    };
+
+    /* Dependencies must be jobs added earlier, which rules out cycles */
+    Id add(std::string name, std::function<bool()> func, const std::vector<Id> &dependencies = {});
+    [[nodiscard]] bool run(ThreadPool &pool);
+
+    /* Jobs that ran, in the order they finished */
+    [[nodiscard]] const std::vector<Timing> &timings() const { return timings_; }
+    [[nodiscard]] double elapsed() const { return elapsed_; }
+
+private:
+    struct Task {
+        std::string name;
+        std::function<bool()> func;
+        std::vector<Id> dependents;
+        std::size_t dependencies = 0;
+        std::size_t waiting = 0;
+    };
+
+    void launch(ThreadPool &pool, const std::vector<Id> &ids);
+    void execute(ThreadPool &pool, Id id);
+
+private:
+    std::vector<Task> tasks_;
+    std::vector<Timing> timings_;
+    double elapsed_ = 0.;
+    std::chrono::steady_clock::time_point startTime_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    std::size_t running_ = 0;
+    bool failed_ = false;
+};
+
+}
@@ -0,0 +1,113 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "threadpool.hh"
+
+#include <algorithm>
+#include <atomic>
+
+namespace hojy::util {
+
+ThreadPool::ThreadPool(std::size_t threads) {
+    workers_.reserve(threads);
+    for (std::size_t i = 0; i < threads; ++i) {
+        workers_.emplace_back([this]() { workerLoop(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::unique_lock<std::mutex> lk(mutex_);
+        stopping_ = true;
+    }
+    cond_.notify_all();
+    for (auto &worker: workers_) {
+        worker.join();
+    }
+}
+
+void ThreadPool::post(std::function<void()> task) {
+    if (workers_.empty()) {
+        task();
+        return;
+    }
+    {
+        std::unique_lock<std::mutex> lk(mutex_);
+        tasks_.emplace_back(std::move(task));
+    }
+    cond_.notify_one();
+}
+
+void ThreadPool::parallelFor(std::size_t count, const std::function<void(std::size_t)> &func) {
+    if (workers_.empty() || count < 2) {
+        for (std::size_t i = 0; i < count; ++i) {
+            func(i);
+        }
+        return;
+    }
+    struct State {
+        std::atomic<std::size_t> next {0};
+        std::atomic<std::size_t> done {0};
+        std::mutex mutex;
+        std::condition_variable cond;
+    };
+    auto state = std::make_shared<State>();
+    /* Helpers that start after all indices are taken never touch `func`,
+     * so it is safe to return while they are still queued */
+    auto work = [state, &func, count]() {
+        std::size_t finished = 0;
+        for (auto i = state->next++; i < count; i = state->next++) {
+            func(i);
+            ++finished;
+        }
+        if (finished && state->done.fetch_add(finished) + finished == count) {
+            std::unique_lock<std::mutex> lk(state->mutex);
+            state->cond.notify_all();
+        }
+    };
+    auto helpers = std::min(workers_.size(), count - 1);
+    for (std::size_t i = 0; i < helpers; ++i) {
+        post(work);
+    }
+    work();
+    std::unique_lock<std::mutex> lk(state->mutex);
+    state->cond.wait(lk, [&state, count]() { return state->done.load() == count; });
+}
+
+std::size_t ThreadPool::defaultThreads(std::size_t limit) {
+    std::size_t hw = std::thread::hardware_concurrency();
+    if (hw < 2) { return 0; }
+    return std::min(hw - 1, limit);
+}
+
+void ThreadPool::workerLoop() {
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lk(mutex_);
+            cond_.wait(lk, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) { return; }
+            task = std::move(tasks_.front());
+            tasks_.pop_front();
+        }
+        task();
+    }
+}
+
+}
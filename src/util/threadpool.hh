@@ -0,0 +1,72 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <cstddef>
+
+namespace hojy::util {
+
+class ThreadPool final {
+public:
+    /* A pool with 0 threads runs every task on the calling thread */
+    explicit ThreadPool(std::size_t threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool &operator=(const ThreadPool&) = delete;
+
+    [[nodiscard]] std::size_t threads() const { return workers_.size(); }
+
+    void post(std::function<void()> task);
+    template<typename F>
+    auto submit(F &&func) -> std::future<std::invoke_result_t<F>> {
+        using Result = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<F>(func));
+        auto result = task->get_future();
+        post([task]() { (*task)(); });
+        return result;
+    }
+    /* Calls func(0) .. func(count - 1) on the pool and the calling thread,
+     * returns when all calls are finished */
+    void parallelFor(std::size_t count, const std::function<void(std::size_t)> &func);
+
+    /* Worker count to use when the configuration asks for automatic sizing */
+    static std::size_t defaultThreads(std::size_t limit);
+
+private:
+    void workerLoop();
+
+private:
+    std::vector<std::thread> workers_;
+    std::deque<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cond_;
+    bool stopping_ = false;
+};
+
+}
@@ -20,6 +20,7 @@
 #include "strings.hh"
 
 #include "savedata.hh"
+#include "content/contentpack.hh"
 #include "content/warfielddata.hh"
 #include "core/config.hh"
 #include "util/conv.hh"
@@ -66,6 +67,19 @@ bool Strings::load(const std::string &filename) {
     return true;
 }
 
+bool Strings::load(const content::ContentPack &pack) {
+    const auto section = core::config.simplifiedChinese()
+        ? content::ContentPack::StringsSimplified : content::ContentPack::StringsTraditional;
+    const auto count = pack.count(section);
+    if (count < RequiredTextCount) { return false; }
+    std::vector<std::wstring> strings(count);
+    for (size_t i = 0; i < count; ++i) {
+        strings[i] = pack.text(section, i);
+    }
+    strings_[Text] = std::move(strings);
+    return true;
+}
+
 void Strings::saveDataLoaded() {
     auto sz = gSaveData.charInfo.size();
     strings_[CharName].resize(sz);
@@ -23,6 +23,10 @@
 #include <vector>
 #include <cstdint>
 
+namespace hojy::content {
+class ContentPack;
+}
+
 namespace hojy::world::state {
 
 class Strings {
@@ -41,6 +45,7 @@ public:
     };
 
     [[nodiscard]] bool load(const std::string &filename);
+    [[nodiscard]] bool load(const content::ContentPack &pack);
     void saveDataLoaded();
     const std::wstring &operator()(Type type, std::int16_t index) {
         static const std::wstring empty;
@@ -25,14 +25,18 @@ class AudioCallbackPurityTests(unittest.TestCase):
         body = function_body("src/audio/mixer.cc", "void Mixer::callback")
         for forbidden in ("SDL_GetTicks", "new ", "delete ", ".reset(", ".resize(",
                           "filenameNext", "dynamic_cast", ".load(", ".start()",
-                          "readData"):
+                          "readData", "scoped_lock", "mutex"):
             self.assertNotIn(forbidden, body)
 
     def test_lifecycle_work_is_on_main_thread_service(self) -> None:
         body = function_body("src/audio/mixer.cc", "void Mixer::service()")
         self.assertIn("SDL_GetTicks", body)
         self.assertIn("prepareChannelLocked", body)
-        self.assertIn("fillChannelLocked", body)
+        self.assertNotIn("fillChannelLocked", body)
+        self.assertNotIn("readData", body)
+
+        render_body = function_body("src/audio/mixer.cc", "void Mixer::renderLoop()")
+        self.assertIn("fillChannelLocked", render_body)
 
         play_body = function_body(
             "src/audio/mixer.cc",
@@ -60,7 +60,7 @@ class WarfieldBattleBoundaryTests(unittest.TestCase):
         for path in (
             "src/scene/warfield_actions.cc",
             "src/scene/warfield_ai.cc",
-            "src/scene/warfield_ai_skill.cc",
+            "src/sim/auto_battle_ai.cc",
             "src/scene/warfield_results.cc",
         ):
             text = (ROOT / path).read_text(encoding="utf-8")
@@ -22,6 +22,7 @@
 namespace hojy::audio {
 
 Mixer::~Mixer() = default;
+Mixer::Voice::~Voice() = default;
 
 Mixer::DataType Mixer::convertDataType(std::uint16_t type) {
     switch (type) {
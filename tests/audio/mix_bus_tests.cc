@@ -0,0 +1,93 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+ */
+
+#include "audio/mixbus.hh"
+#include "test_support.hh"
+
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+namespace {
+
+using hojy::audio::Mixer;
+
+template<typename T, std::size_t N>
+const std::uint8_t *bytes(const std::array<T, N> &samples) {
+    return reinterpret_cast<const std::uint8_t *>(samples.data());
+}
+
+void channelsSumBeforeTheOnlyClip() {
+    std::array<float, 4> bus {};
+    const std::array<std::int16_t, 4> loud {24576, -24576, 24576, -24576};
+    const std::array<std::int16_t, 4> quiet {-16384, 16384, 0, 0};
+    hojy::audio::mixToBus(bus.data(), bytes(loud), Mixer::I16, 2, 1.f);
+    hojy::audio::mixToBus(bus.data(), bytes(loud), Mixer::I16, 2, 1.f);
+    hojy::audio::mixToBus(bus.data(), bytes(quiet), Mixer::I16, 2, 1.f);
+    /* 0.75 + 0.75 - 0.5: over full scale in between, not in the sum */
+    HOJY_CHECK_EQ(bus[0], 1.f);
+    HOJY_CHECK_EQ(bus[2], 1.5f);
+
+    std::array<std::int16_t, 4> output {};
+    hojy::audio::busToOutput(reinterpret_cast<std::uint8_t *>(output.data()), bus.data(), Mixer::I16, 2);
+    HOJY_CHECK_EQ(output[0], 32767);
+    HOJY_CHECK_EQ(output[1], -32767);
+    HOJY_CHECK_EQ(output[2], 32767);
+
+    std::array<std::int32_t, 4> output32 {};
+    hojy::audio::busToOutput(reinterpret_cast<std::uint8_t *>(output32.data()), bus.data(), Mixer::I32, 2);
+    HOJY_CHECK_EQ(output32[2], 2147483647);
+    HOJY_CHECK_EQ(output32[3], -2147483647);
+
+    std::array<float, 4> outputF {};
+    hojy::audio::busToOutput(reinterpret_cast<std::uint8_t *>(outputF.data()), bus.data(), Mixer::F32, 2);
+    HOJY_CHECK_EQ(outputF[0], 1.f);
+    HOJY_CHECK_EQ(outputF[3], -1.f);
+}
+
+void gainScalesEveryFormat() {
+    std::array<float, 2> bus {};
+    const std::array<float, 2> f32 {0.5f, -0.5f};
+    hojy::audio::mixToBus(bus.data(), bytes(f32), Mixer::F32, 1, 0.5f);
+    HOJY_CHECK_EQ(bus[0], 0.25f);
+    HOJY_CHECK_EQ(bus[1], -0.25f);
+
+    const std::array<std::int32_t, 2> i32 {1073741824, 0};
+    hojy::audio::mixToBus(bus.data(), bytes(i32), Mixer::I32, 1, 0.5f);
+    HOJY_CHECK_EQ(bus[0], 0.5f);
+}
+
+void rampsMoveTheGainEveryFrame() {
+    std::array<float, 8> bus {};
+    const std::array<float, 8> ones {1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f};
+    const auto gain = hojy::audio::mixToBusRamp(bus.data(), bytes(ones), Mixer::F32, 4, 0.f, 0.25f);
+    HOJY_CHECK_EQ(gain, 1.f);
+    HOJY_CHECK_EQ(bus[0], 0.f);
+    HOJY_CHECK_EQ(bus[1], 0.f);
+    HOJY_CHECK_EQ(bus[2], 0.25f);
+    HOJY_CHECK_EQ(bus[5], 0.5f);
+    HOJY_CHECK_EQ(bus[7], 0.75f);
+
+    std::array<float, 2> down {};
+    const std::array<std::int16_t, 2> half {16384, 16384};
+    hojy::audio::mixToBusRamp(down.data(), bytes(half), Mixer::I16, 1, 1.f, -1.f);
+    HOJY_CHECK_EQ(down[0], 0.5f);
+}
+
+}
+
+int main() {
+    try {
+        channelsSumBeforeTheOnlyClip();
+        gainScalesEveryFormat();
+        rampsMoveTheGainEveryFrame();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
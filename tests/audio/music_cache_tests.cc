@@ -0,0 +1,192 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+ */
+
+#include "audio/channelcached.hh"
+#include "audio/musiccache.hh"
+#include "audio/resampler.hh"
+#include "test_support.hh"
+
+#include <SDL.h>
+
+#include <array>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace hojy::audio {
+
+Mixer::~Mixer() = default;
+Mixer::Voice::~Voice() = default;
+
+/* No device here: play 8 kHz 16-bit stereo, the rate of the fixtures */
+bool Mixer::init(int channels) {
+    (void)channels;
+    sampleRate_ = 8000;
+    format_ = AUDIO_S16;
+    return true;
+}
+
+Mixer::DataType Mixer::convertDataType(std::uint16_t type) {
+    switch (type) {
+    case AUDIO_F32:return F32;
+    case AUDIO_S32:return I32;
+    case AUDIO_S16:return I16;
+    default:return InvalidType;
+    }
+}
+
+size_t Mixer::dataTypeToSize(Mixer::DataType type) {
+    switch (type) {
+    case F32:
+    case I32:return 4;
+    case F64:return 8;
+    case I16:return 2;
+    default:return 1;
+    }
+}
+
+Resampler::Resampler(std::uint32_t channels, double sampleRateIn, double sampleRateOut,
+                     Mixer::DataType typeIn, Mixer::DataType typeOut) {
+    (void)channels;
+    (void)sampleRateIn;
+    (void)sampleRateOut;
+    (void)typeIn;
+    (void)typeOut;
+}
+
+Resampler::~Resampler() = default;
+
+void Resampler::setInputCallback(InputCallback callback) {
+    inputCB_ = std::move(callback);
+}
+
+size_t Resampler::read(void *data, size_t size) {
+    (void)data;
+    (void)size;
+    return 0;
+}
+
+}
+
+namespace {
+
+/* The track every fixture claims to be rendered from */
+constexpr std::uint64_t SourceSize = 1234;
+constexpr std::int64_t SourceTime = 5678;
+
+/* Frame n holds n in the left and -n in the right channel */
+void writeCache(const std::filesystem::path &filename, std::uint32_t sampleRate, std::uint64_t frames,
+                std::uint64_t loopStart, std::uint64_t loopEnd) {
+    hojy::audio::MusicCacheHeader header {};
+    std::memcpy(header.magic, hojy::audio::MusicCacheMagic, sizeof(header.magic));
+    header.version = hojy::audio::MusicCacheVersion;
+    header.sampleRate = sampleRate;
+    header.frames = frames;
+    header.loopStart = loopStart;
+    header.loopEnd = loopEnd;
+    header.sourceSize = SourceSize;
+    header.sourceTime = SourceTime;
+    std::vector<std::int16_t> samples;
+    for (std::uint64_t i = 0; i < frames; ++i) {
+        samples.push_back(static_cast<std::int16_t>(i));
+        samples.push_back(static_cast<std::int16_t>(-static_cast<std::int16_t>(i)));
+    }
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char *>(samples.data()),
+               static_cast<std::streamsize>(samples.size() * sizeof(std::int16_t)));
+    if (!file) { throw std::runtime_error("failed to write cache fixture"); }
+}
+
+class Fixtures {
+public:
+    Fixtures(): directory_(std::filesystem::temp_directory_path() / "hojy-music-cache-tests") {
+        std::error_code ec;
+        std::filesystem::remove_all(directory_, ec);
+        std::filesystem::create_directories(directory_);
+        writeCache(directory_ / "loop.pcm", 8000, 10, 4, 8);
+        writeCache(directory_ / "rate.pcm", 44100, 10, 0, 10);
+        writeCache(directory_ / "short.pcm", 8000, 10, 0, 10);
+        std::filesystem::resize_file(directory_ / "short.pcm", sizeof(hojy::audio::MusicCacheHeader) + 8);
+    }
+    ~Fixtures() {
+        std::error_code ec;
+        std::filesystem::remove_all(directory_, ec);
+    }
+
+    [[nodiscard]] std::string path(const char *name) const { return (directory_ / name).string(); }
+
+private:
+    std::filesystem::path directory_;
+};
+
+void streamsTheMappedFrames() {
+    Fixtures fixtures;
+    hojy::audio::Mixer mixer;
+    HOJY_CHECK_EQ(mixer.init(1), true);
+
+    hojy::audio::ChannelCached channel(&mixer, fixtures.path("loop.pcm"), SourceSize, SourceTime);
+    HOJY_CHECK_EQ(channel.ok(), true);
+    channel.start();
+    std::array<std::int16_t, 32> output {};
+    HOJY_CHECK_EQ(channel.readData(output.data(), 12), 12U);
+    HOJY_CHECK_EQ(output[4], 2);
+    HOJY_CHECK_EQ(output[5], -2);
+    /* without repeat the whole track plays, past the loop end */
+    HOJY_CHECK_EQ(channel.readData(output.data(), sizeof(output)), 28U);
+    HOJY_CHECK_EQ(output[12], 9);
+    HOJY_CHECK_EQ(channel.readData(output.data(), sizeof(output)), 0U);
+}
+
+void repeatJumpsBackToTheLoopStart() {
+    Fixtures fixtures;
+    hojy::audio::Mixer mixer;
+    HOJY_CHECK_EQ(mixer.init(1), true);
+
+    hojy::audio::ChannelCached channel(&mixer, fixtures.path("loop.pcm"), SourceSize, SourceTime);
+    channel.setRepeat(true);
+    channel.start();
+    std::array<std::int16_t, 32> output {};
+    HOJY_CHECK_EQ(channel.readData(output.data(), sizeof(output)), 32U);
+    HOJY_CHECK_EQ(output[14], 7);
+    HOJY_CHECK_EQ(channel.readData(output.data(), sizeof(output)), 16U);
+    HOJY_CHECK_EQ(output[0], 4);
+    HOJY_CHECK_EQ(output[6], 7);
+
+    channel.reset();
+    HOJY_CHECK_EQ(channel.readData(output.data(), 4), 4U);
+    HOJY_CHECK_EQ(output[0], 0);
+}
+
+void rejectsStaleOrBrokenFiles() {
+    Fixtures fixtures;
+    hojy::audio::Mixer mixer;
+    HOJY_CHECK_EQ(mixer.init(1), true);
+
+    HOJY_CHECK_EQ(hojy::audio::ChannelCached(&mixer, fixtures.path("rate.pcm"), SourceSize, SourceTime).ok(), false);
+    HOJY_CHECK_EQ(hojy::audio::ChannelCached(&mixer, fixtures.path("short.pcm"), SourceSize, SourceTime).ok(), false);
+    HOJY_CHECK_EQ(hojy::audio::ChannelCached(&mixer, fixtures.path("missing.pcm"), SourceSize, SourceTime).ok(), false);
+    /* The track was changed after it was rendered */
+    HOJY_CHECK_EQ(hojy::audio::ChannelCached(&mixer, fixtures.path("loop.pcm"), SourceSize + 1, SourceTime).ok(), false);
+    HOJY_CHECK_EQ(hojy::audio::ChannelCached(&mixer, fixtures.path("loop.pcm"), SourceSize, SourceTime + 1).ok(), false);
+}
+
+}
+
+int main() {
+    try {
+        streamsTheMappedFrames();
+        repeatJumpsBackToTheLoopStart();
+        rejectsStaleOrBrokenFiles();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
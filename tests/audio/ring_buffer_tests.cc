@@ -0,0 +1,101 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+ */
+
+#include "util/ringbuffer.hh"
+#include "test_support.hh"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+namespace {
+
+void spansSplitAtTheWrapPoint() {
+    hojy::util::RingBuffer ring(6);
+    HOJY_CHECK_EQ(ring.capacity(), 8U);
+    HOJY_CHECK_EQ(ring.writable(), 8U);
+
+    const std::array<std::uint8_t, 6> first {1, 2, 3, 4, 5, 6};
+    HOJY_CHECK_EQ(ring.write(first.data(), first.size()), 6U);
+    std::array<std::uint8_t, 4> out {};
+    HOJY_CHECK_EQ(ring.read(out.data(), out.size()), 4U);
+    HOJY_CHECK_EQ(out[3], 4);
+
+    /* two bytes left at the end, four more wrap to the front */
+    auto spans = ring.writeSpans(100);
+    HOJY_CHECK_EQ(spans[0].size, 2U);
+    HOJY_CHECK_EQ(spans[1].size, 4U);
+    const std::array<std::uint8_t, 7> second {7, 8, 9, 10, 11, 12, 13};
+    HOJY_CHECK_EQ(ring.write(second.data(), second.size()), 6U);
+    HOJY_CHECK_EQ(ring.writable(), 0U);
+
+    auto readable = ring.readSpans(5);
+    HOJY_CHECK_EQ(readable[0].size, 4U);
+    HOJY_CHECK_EQ(readable[0].data[0], 5);
+    HOJY_CHECK_EQ(readable[1].size, 1U);
+    HOJY_CHECK_EQ(readable[1].data[0], 9);
+    ring.commitRead(5);
+    HOJY_CHECK_EQ(ring.readable(), 3U);
+
+    ring.clear();
+    HOJY_CHECK_EQ(ring.readable(), 0U);
+    HOJY_CHECK_EQ(ring.writable(), 8U);
+
+    hojy::util::RingBuffer empty;
+    HOJY_CHECK_EQ(empty.writeSpans(16)[0].size, 0U);
+    HOJY_CHECK_EQ(empty.read(out.data(), out.size()), 0U);
+}
+
+void producerAndConsumerThreadsKeepTheOrder() {
+    constexpr std::uint32_t Count = 200000;
+    hojy::util::RingBuffer ring(256);
+    std::thread producer([&ring]() {
+        std::uint32_t next = 0;
+        while (next < Count) {
+            std::size_t written = 0;
+            for (const auto &span: ring.writeSpans(std::min<std::uint32_t>(61, Count - next))) {
+                for (std::size_t i = 0; i < span.size; ++i) {
+                    span.data[i] = static_cast<std::uint8_t>((next + written + i) * 7);
+                }
+                written += span.size;
+            }
+            ring.commitWrite(written);
+            next += static_cast<std::uint32_t>(written);
+            if (written == 0) { std::this_thread::yield(); }
+        }
+    });
+    std::uint32_t received = 0;
+    bool ordered = true;
+    std::array<std::uint8_t, 37> out {};
+    while (received < Count) {
+        const auto size = ring.read(out.data(), out.size());
+        for (std::size_t i = 0; i < size; ++i) {
+            ordered = ordered && out[i] == static_cast<std::uint8_t>((received + i) * 7);
+        }
+        received += static_cast<std::uint32_t>(size);
+        if (size == 0) { std::this_thread::yield(); }
+    }
+    producer.join();
+    HOJY_CHECK_EQ(ordered, true);
+    HOJY_CHECK_EQ(received, Count);
+    HOJY_CHECK_EQ(ring.readable(), 0U);
+}
+
+}
+
+int main() {
+    try {
+        spansSplitAtTheWrapPoint();
+        producerAndConsumerThreadsKeepTheOrder();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
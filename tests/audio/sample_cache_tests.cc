@@ -0,0 +1,234 @@
+/*
+ * Heroes of Jin Yong.
+ * A reimplementation of the DOS game `The legend of Jin Yong Heroes`.
+ * Copyright (C) 2021, Soar Qin<soarchin@gmail.com>
+ */
+
+#include "audio/channelsample.hh"
+#include "audio/samplecache.hh"
+#include "audio/resampler.hh"
+#include "test_support.hh"
+
+#include <SDL.h>
+
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace hojy::audio {
+
+Mixer::~Mixer() = default;
+Mixer::Voice::~Voice() = default;
+
+/* No device here: play 8 kHz 16-bit stereo, the rate of the fixtures */
+bool Mixer::init(int channels) {
+    (void)channels;
+    sampleRate_ = 8000;
+    format_ = AUDIO_S16;
+    return true;
+}
+
+Mixer::DataType Mixer::convertDataType(std::uint16_t type) {
+    switch (type) {
+    case AUDIO_F32:return F32;
+    case AUDIO_S32:return I32;
+    case AUDIO_S16:return I16;
+    default:return InvalidType;
+    }
+}
+
+std::uint16_t Mixer::convertType(Mixer::DataType type) {
+    switch (type) {
+    case I16:return AUDIO_S16;
+    case I32:return AUDIO_S32;
+    default:return AUDIO_F32;
+    }
+}
+
+size_t Mixer::dataTypeToSize(Mixer::DataType type) {
+    switch (type) {
+    case F32:
+    case I32:return 4;
+    case F64:return 8;
+    case I16:return 2;
+    default:return 1;
+    }
+}
+
+Resampler::Resampler(std::uint32_t channels, double sampleRateIn, double sampleRateOut,
+                     Mixer::DataType typeIn, Mixer::DataType typeOut) {
+    (void)channels;
+    (void)sampleRateIn;
+    (void)sampleRateOut;
+    (void)typeIn;
+    (void)typeOut;
+}
+
+Resampler::~Resampler() = default;
+
+void Resampler::setInputCallback(InputCallback callback) {
+    inputCB_ = std::move(callback);
+}
+
+size_t Resampler::read(void *data, size_t size) {
+    (void)data;
+    (void)size;
+    return 0;
+}
+
+}
+
+namespace {
+
+void append16(std::vector<std::uint8_t> &data, std::uint16_t value) {
+    data.push_back(static_cast<std::uint8_t>(value));
+    data.push_back(static_cast<std::uint8_t>(value >> 8));
+}
+
+void append32(std::vector<std::uint8_t> &data, std::uint32_t value) {
+    append16(data, static_cast<std::uint16_t>(value));
+    append16(data, static_cast<std::uint16_t>(value >> 16));
+}
+
+void appendTag(std::vector<std::uint8_t> &data, const char *tag) {
+    data.insert(data.end(), tag, tag + 4);
+}
+
+void writeMonoU8Wav(const std::filesystem::path &filename, const std::vector<std::uint8_t> &samples) {
+    std::vector<std::uint8_t> data;
+    appendTag(data, "RIFF");
+    append32(data, 36 + samples.size());
+    appendTag(data, "WAVE");
+    appendTag(data, "fmt ");
+    append32(data, 16);
+    append16(data, 1);
+    append16(data, 1);
+    append32(data, 8000);
+    append32(data, 8000);
+    append16(data, 1);
+    append16(data, 8);
+    appendTag(data, "data");
+    append32(data, samples.size());
+    data.insert(data.end(), samples.begin(), samples.end());
+
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(data.data()), static_cast<std::streamsize>(data.size()));
+    if (!file) { throw std::runtime_error("failed to write wav fixture"); }
+}
+
+class Fixtures {
+public:
+    Fixtures(): directory_(std::filesystem::temp_directory_path() / "hojy-sample-cache-tests") {
+        std::error_code ec;
+        std::filesystem::remove_all(directory_, ec);
+        std::filesystem::create_directories(directory_);
+        writeMonoU8Wav(directory_ / "short.wav", {0, 255});
+        writeMonoU8Wav(directory_ / "other.wav", {128, 64});
+        writeMonoU8Wav(directory_ / "long.wav", std::vector<std::uint8_t>(64, 200));
+    }
+    ~Fixtures() {
+        std::error_code ec;
+        std::filesystem::remove_all(directory_, ec);
+    }
+
+    [[nodiscard]] std::string path(const char *name) const { return (directory_ / name).string(); }
+    void remove(const char *name) const { std::filesystem::remove(directory_ / name); }
+
+private:
+    std::filesystem::path directory_;
+};
+
+void decodesOnceToTheOutputFormat() {
+    Fixtures fixtures;
+    hojy::audio::Mixer mixer;
+    HOJY_CHECK_EQ(mixer.init(1), true);
+    hojy::audio::SampleCache cache(&mixer);
+    cache.setCapacity(1024);
+
+    const auto sample = cache.get(fixtures.path("short.wav"));
+    HOJY_CHECK_EQ(static_cast<bool>(sample), true);
+    /* two mono 8-bit frames become two stereo 16-bit frames */
+    HOJY_CHECK_EQ(sample->size(), 8U);
+    HOJY_CHECK_EQ(cache.size(), 8U);
+    HOJY_CHECK_EQ(cache.count(), 1U);
+
+    fixtures.remove("short.wav");
+    const auto again = cache.get(fixtures.path("short.wav"));
+    HOJY_CHECK_EQ(again.get(), sample.get());
+    HOJY_CHECK_EQ(static_cast<bool>(cache.get(fixtures.path("missing.wav"))), false);
+    HOJY_CHECK_EQ(cache.count(), 1U);
+}
+
+void dropsLeastRecentlyUsedSamplesOverCapacity() {
+    Fixtures fixtures;
+    hojy::audio::Mixer mixer;
+    HOJY_CHECK_EQ(mixer.init(1), true);
+    hojy::audio::SampleCache cache(&mixer);
+    cache.setCapacity(16);
+
+    cache.preload({fixtures.path("short.wav"), fixtures.path("other.wav")});
+    HOJY_CHECK_EQ(cache.count(), 2U);
+    HOJY_CHECK_EQ(cache.size(), 16U);
+
+    const auto first = cache.get(fixtures.path("short.wav"));
+    cache.setCapacity(8);
+    HOJY_CHECK_EQ(cache.count(), 1U);
+    HOJY_CHECK_EQ(cache.get(fixtures.path("short.wav")).get(), first.get());
+
+    /* larger than the whole cache: played, but not kept */
+    const auto large = cache.get(fixtures.path("long.wav"));
+    HOJY_CHECK_EQ(large->size(), 256U);
+    HOJY_CHECK_EQ(cache.count(), 1U);
+    HOJY_CHECK_EQ(cache.size(), 8U);
+
+    /* an evicted sample stays valid for channels still playing it */
+    cache.clear();
+    HOJY_CHECK_EQ(cache.size(), 0U);
+    HOJY_CHECK_EQ(first->size(), 8U);
+}
+
+void sampleChannelReadsTheSharedBuffer() {
+    Fixtures fixtures;
+    hojy::audio::Mixer mixer;
+    HOJY_CHECK_EQ(mixer.init(1), true);
+    hojy::audio::SampleCache cache(&mixer);
+    cache.setCapacity(1024);
+    const auto sample = cache.get(fixtures.path("short.wav"));
+
+    hojy::audio::ChannelSample channel(&mixer, sample);
+    HOJY_CHECK_EQ(channel.ok(), true);
+    channel.start();
+    std::array<std::uint8_t, 16> output;
+    output.fill(0xCD);
+    HOJY_CHECK_EQ(channel.readData(output.data(), output.size()), 8U);
+    HOJY_CHECK_EQ(std::equal(sample->begin(), sample->end(), output.begin()), true);
+    HOJY_CHECK_EQ(output[8], 0xCD);
+    HOJY_CHECK_EQ(channel.readData(output.data(), output.size()), 0U);
+
+    channel.reset();
+    channel.setRepeat(true);
+    HOJY_CHECK_EQ(channel.readData(output.data(), 6), 6U);
+    HOJY_CHECK_EQ(channel.readData(output.data(), 6), 2U);
+    HOJY_CHECK_EQ(channel.readData(output.data(), 6), 6U);
+    HOJY_CHECK_EQ(output[0], (*sample)[0]);
+
+    hojy::audio::ChannelSample empty(&mixer, nullptr);
+    HOJY_CHECK_EQ(empty.ok(), false);
+}
+
+}
+
+int main() {
+    try {
+        decodesOnceToTheOutputFormat();
+        dropsLeastRecentlyUsedSamplesOverCapacity();
+        sampleChannelReadsTheSharedBuffer();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -582,9 +582,9 @@ void testOriginalSkillSlotSkipsEmptySparseSlots() {
 
 void testRetreatPositionRequiresExactStepsAndStrictScore() {
     SelectableCells cells;
-    cells[{0, 0}] = SelectableCell{0, 0, 2, 0, nullptr, nullptr};
-    cells[{1, 1}] = SelectableCell{1, 1, 2, 0, nullptr, nullptr};
-    cells[{2, 2}] = SelectableCell{2, 2, 1, 0, nullptr, nullptr};
+    cells[{0, 0}] = SelectableCell{0, 0, 2, 0, SelectableCell::NoParent, SelectableCell::NoParent};
+    cells[{1, 1}] = SelectableCell{1, 1, 2, 0, SelectableCell::NoParent, SelectableCell::NoParent};
+    cells[{2, 2}] = SelectableCell{2, 2, 1, 0, SelectableCell::NoParent, SelectableCell::NoParent};
     const auto position = hojy::battle::chooseRetreatPosition(
         cells, 2, {{0, 3}, {3, 0}});
     HOJY_CHECK_EQ(position.has_value(), true);
@@ -3,8 +3,11 @@
 #include "battle/random.hh"
 #include "test_support.hh"
 
+#include <cstring>
 #include <iostream>
+#include <memory>
 #include <type_traits>
+#include <vector>
 
 namespace {
 
@@ -17,6 +20,7 @@ using hojy::battle::EngineStatus;
 using hojy::battle::InventorySource;
 using hojy::battle::ItemAction;
 using hojy::battle::MoveAction;
+using hojy::battle::ParticipantId;
 using hojy::battle::RecordingRandom;
 using hojy::battle::SequenceRandom;
 using hojy::battle::SkillAction;
@@ -229,7 +233,15 @@ void testBattleReplayIsDeterministicAndRejectsCorruptRandomLog() {
     HOJY_CHECK_EQ(rejected.randomCalls.empty(), true);
 
     auto corruptMiddle = result.replay;
-    ++corruptMiddle.actions[0].participants[0].exp;
+    hojy::battle::ActionLog tampered;
+    tampered.reset(result.replay.initialParticipants,
+                   result.replay.initialInventory);
+    for (std::size_t index = 0; index < result.replay.actions.size(); ++index) {
+        auto record = result.replay.actions[index];
+        if (index == 0) { ++record.participants[0].exp; }
+        tampered.append(std::move(record));
+    }
+    corruptMiddle.actions = std::move(tampered);
     const auto rejectedMiddle = BattleEngine::replay(corruptMiddle);
     HOJY_CHECK_EQ(rejectedMiddle.valid, false);
 }
@@ -512,6 +524,86 @@ void testBattleReplayTracksSettlementRandomCallsWithoutActions() {
     HOJY_CHECK_EQ(BattleEngine::replay(corruptBoundary).valid, false);
 }
 
+hojy::battle::BattleResult runLongBattle(std::size_t keyframeInterval,
+                                         std::size_t &storageBytes) {
+    std::vector<hojy::world::state::CharacterData> characters(12);
+    for (auto &character: characters) {
+        character.hp = 1000;
+    }
+    std::vector<std::unique_ptr<BattleParticipant>> participants;
+    hojy::battle::BattleSetup setup;
+    for (std::size_t index = 0; index < characters.size(); ++index) {
+        participants.push_back(std::make_unique<BattleParticipant>(characters[index]));
+        setup.participants.push_back(participants.back().get());
+        setup.enemy.push_back(index >= 6);
+    }
+    setup.inventory = {{42, 100}};
+    setup.keyframeInterval = keyframeInterval;
+    BattleEngine engine;
+    HOJY_CHECK_EQ(engine.begin(std::move(setup)), true);
+    hojy::battle::InventorySnapshot inventory{{42, 100}};
+    for (int step = 0; step < 300; ++step) {
+        const auto actor = ParticipantId(step % 6);
+        ++participants[actor]->state().exp;
+        if (step % 10 == 9) {
+            --inventory[0].second;
+            HOJY_CHECK_EQ(engine.record(BattleAction{
+                actor, ItemAction{42, InventorySource::PartyBag, -1},
+            }, inventory), true);
+            continue;
+        }
+        const auto target = ParticipantId(6 + step % 6);
+        participants[target]->state().hp -= 3;
+        HOJY_CHECK_EQ(engine.record(BattleAction{
+            actor, SkillAction{0, 7, 1, {ActionTarget{target, 1}}},
+        }, inventory), true);
+    }
+    for (std::size_t index = 6; index < participants.size(); ++index) {
+        participants[index]->state().hp = 0;
+    }
+    HOJY_CHECK_EQ(engine.reconcile(), true);
+    storageBytes = engine.snapshot().actionLog.storageBytes();
+    return engine.finish(true);
+}
+
+void testBattleActionLogStoresDeltasAndRebuildsRecords() {
+    std::size_t fullBytes = 0;
+    std::size_t deltaBytes = 0;
+    std::size_t sparseBytes = 0;
+    const auto full = runLongBattle(1, fullBytes);
+    const auto delta = runLongBattle(
+        hojy::battle::ActionLog::DefaultKeyframeInterval, deltaBytes);
+    const auto sparse = runLongBattle(7, sparseBytes);
+    HOJY_CHECK_EQ(full.replay.actions.size(), 300U);
+    HOJY_CHECK_EQ(delta.replay.actions.size(), 300U);
+    HOJY_CHECK_EQ(BattleEngine::replay(full.replay).valid, true);
+    HOJY_CHECK_EQ(BattleEngine::replay(delta.replay).valid, true);
+    HOJY_CHECK_EQ(BattleEngine::replay(sparse.replay).valid, true);
+    HOJY_CHECK_EQ(delta.replay.finalIntegrity, full.replay.finalIntegrity);
+
+    std::size_t index = 0;
+    HOJY_CHECK_EQ(delta.replay.actions.forEach([&](const hojy::battle::ActionRecord &record) {
+        const auto expected = full.replay.actions[index];
+        const auto random = delta.replay.actions.at(index);
+        const auto other = sparse.replay.actions[index];
+        HOJY_CHECK_EQ(record.integrity, expected.integrity);
+        HOJY_CHECK_EQ(random.integrity, expected.integrity);
+        HOJY_CHECK_EQ(other.integrity, expected.integrity);
+        HOJY_CHECK_EQ(record.action == expected.action, true);
+        HOJY_CHECK_EQ(record.inventory, expected.inventory);
+        HOJY_CHECK_EQ(std::memcmp(record.participants.data(), expected.participants.data(),
+                                  expected.participants.size() * sizeof(expected.participants[0])), 0);
+        HOJY_CHECK_EQ(std::memcmp(random.participants.data(), expected.participants.data(),
+                                  expected.participants.size() * sizeof(expected.participants[0])), 0);
+        ++index;
+        return true;
+    }), true);
+    HOJY_CHECK_EQ(index, 300U);
+
+    HOJY_CHECK_EQ(fullBytes / 300 > 12 * sizeof(hojy::world::state::CharacterData), true);
+    HOJY_CHECK_EQ(deltaBytes / 300 < 160, true);
+}
+
 }
 
 int main() {
@@ -540,6 +632,7 @@ int main() {
         testBattleReplayBindsInitialStateAndCommitDisposition();
         testBattleReplayRejectsRandomModuloAliases();
         testBattleReplayTracksSettlementRandomCallsWithoutActions();
+        testBattleActionLogStoresDeltasAndRebuildsRecords();
     } catch (const std::exception &error) {
         std::cerr << error.what() << '\n';
         return 1;
@@ -1,8 +1,12 @@
 #include "battle/movement.hh"
 #include "test_support.hh"
 
+#include <cstdint>
+#include <functional>
 #include <iostream>
 #include <set>
+#include <stdexcept>
+#include <vector>
 
 namespace {
 
@@ -57,7 +61,7 @@ void testSelectableAreaUsesOriginalDirectionPriority() {
         [](int, int) { return false; },
         [](int, int) { return false; });
 
-    const auto *parent = cells.at({2, 0}).moveParent;
+    const auto *parent = cells.lookup(cells.at({2, 0}).moveParent);
     HOJY_CHECK_EQ(parent != nullptr, true);
     const auto parentPosition = std::make_pair(parent->x, parent->y);
     const auto expectedPosition = std::make_pair(1, 0);
@@ -72,7 +76,7 @@ void testSelectableAreaUsesOriginalRangeDirectionPriority() {
         [](int, int) { return false; },
         [](int, int) { return false; });
 
-    const auto *parent = cells.at({0, 0}).rangeParent;
+    const auto *parent = cells.lookup(cells.at({0, 0}).rangeParent);
     HOJY_CHECK_EQ(parent != nullptr, true);
     const auto parentPosition = std::make_pair(parent->x, parent->y);
     const auto expectedPosition = std::make_pair(0, 1);
@@ -342,6 +346,171 @@ void testTerrainPathDistanceIgnoresCharacterOccupancy() {
     HOJY_CHECK_EQ(terrainOnly, 4);
 }
 
+void testDistanceFieldCacheMatchesPathSearches() {
+    constexpr int width = 9, height = 7;
+    std::uint32_t seed = 7;
+    const auto next = [&seed]() {
+        seed = seed * 1103515245U + 12345U;
+        return (seed >> 16) % 100;
+    };
+    for (int round = 0; round < 8; ++round) {
+        std::set<Cell> blocked, occupied;
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                const auto roll = next();
+                if (roll < 20) {
+                    blocked.insert({x, y});
+                } else if (roll < 35) {
+                    occupied.insert({x, y});
+                }
+            }
+        }
+        const auto isBlocked = [&](int x, int y) { return blocked.count({x, y}) != 0; };
+        hojy::battle::DistanceFieldCache cache;
+        cache.setTerrain(width, height, isBlocked);
+        cache.setOccupancy(1, [&](int x, int y) { return occupied.count({x, y}) != 0; });
+        for (int ty = 0; ty < height; ++ty) {
+            for (int tx = 0; tx < width; ++tx) {
+                const Cell target{tx, ty};
+                for (int fy = 0; fy < height; ++fy) {
+                    for (int fx = 0; fx < width; ++fx) {
+                        const Cell from{fx, fy};
+                        HOJY_CHECK_EQ(cache.terrainDistance(from, target),
+                                      hojy::battle::terrainPathDistance(width, height, from, target, isBlocked));
+                        HOJY_CHECK_EQ(cache.shortestDistance(from, target),
+                                      hojy::battle::shortestPathDistance(
+                                          width, height, from, target, isBlocked,
+                                          [&](int x, int y) {
+                                              return Cell{x, y} != target && occupied.count({x, y}) != 0;
+                                          }));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void testDistanceFieldCacheReusesFieldsUntilOccupancyChanges() {
+    hojy::battle::DistanceFieldCache cache;
+    cache.setTerrain(5, 3, [](int x, int y) { return x == 2 && y == 0; });
+    std::set<Cell> occupied{{2, 1}};
+    const auto isOccupied = [&](int x, int y) { return occupied.count({x, y}) != 0; };
+    cache.setOccupancy(1, isOccupied);
+    HOJY_CHECK_EQ(cache.shortestDistance({0, 1}, {4, 1}), 6);
+    HOJY_CHECK_EQ(cache.shortestDistance({1, 1}, {4, 1}), 5);
+    HOJY_CHECK_EQ(cache.terrainDistance({0, 1}, {4, 1}), 4);
+    HOJY_CHECK_EQ(cache.terrainDistance({0, 0}, {4, 1}), 5);
+    HOJY_CHECK_EQ(cache.fieldsBuilt(), 2U);
+
+    occupied.clear();
+    cache.setOccupancy(1, isOccupied);
+    HOJY_CHECK_EQ(cache.shortestDistance({0, 1}, {4, 1}), 6);
+    cache.setOccupancy(2, isOccupied);
+    HOJY_CHECK_EQ(cache.shortestDistance({0, 1}, {4, 1}), 4);
+    HOJY_CHECK_EQ(cache.terrainDistance({0, 1}, {4, 1}), 4);
+    HOJY_CHECK_EQ(cache.fieldsBuilt(), 3U);
+}
+
+void testCellGridSearchesMatchPredicateSearches() {
+    const std::set<Cell> blocked{{1, 0}, {1, 1}, {3, 2}};
+    const std::set<Cell> occupied{{2, 1}, {0, 2}};
+    const std::set<Cell> sameSide{{0, 2}};
+    hojy::battle::CellGrid grid;
+    grid.reset(5, 4);
+    for (const auto &[x, y]: blocked) { grid.set(x, y, hojy::battle::CellGrid::Blocked); }
+    for (const auto &[x, y]: occupied) { grid.set(x, y, hojy::battle::CellGrid::Occupied); }
+    for (const auto &[x, y]: sameSide) { grid.set(x, y, hojy::battle::CellGrid::SameSide); }
+    const std::function<bool(int, int)> isBlocked = [&](int x, int y) { return blocked.count({x, y}) != 0; };
+    const std::function<bool(int, int)> isOccupied = [&](int x, int y) { return occupied.count({x, y}) != 0; };
+    const std::function<bool(int, int)> isSameSide = [&](int x, int y) { return sameSide.count({x, y}) != 0; };
+
+    hojy::battle::SelectableCells expected, actual;
+    hojy::battle::getSelectableArea(5, 4, {0, 0}, 4, 2, expected, isBlocked, isOccupied, isSameSide);
+    hojy::battle::getSelectableArea(grid, {0, 0}, 4, 2, actual);
+    HOJY_CHECK_EQ(actual.size(), expected.size());
+    for (const auto &[position, cell]: expected) {
+        HOJY_CHECK_EQ(actual.at(position).moves, cell.moves);
+        HOJY_CHECK_EQ(actual.at(position).ranges, cell.ranges);
+    }
+    hojy::battle::getCastRangeArea(5, 4, {4, 3}, 3, expected, isBlocked, isOccupied);
+    hojy::battle::getCastRangeArea(grid, {4, 3}, 3, actual);
+    HOJY_CHECK_EQ(actual.size(), expected.size());
+    for (int y = 0; y < 4; ++y) {
+        for (int x = 0; x < 5; ++x) {
+            HOJY_CHECK_EQ(hojy::battle::terrainPathDistance(grid, {0, 0}, {x, y}),
+                          hojy::battle::terrainPathDistance(5, 4, {0, 0}, {x, y}, isBlocked));
+            HOJY_CHECK_EQ(hojy::battle::shortestPathDistance(grid, {0, 0}, {x, y}),
+                          hojy::battle::shortestPathDistance(5, 4, {0, 0}, {x, y}, isBlocked, isOccupied));
+        }
+    }
+}
+
+void testSelectableCellsIterateInKeyOrder() {
+    hojy::battle::SelectableCells cells;
+    cells.reset(4, 4);
+    cells[{2, 1}].moves = 1;
+    cells[{0, 3}].moves = 2;
+    auto *kept = &cells[{1, 0}];
+    kept->moves = 3;
+    cells[{0, 1}].moves = 4;
+    HOJY_CHECK_EQ(cells.size(), 4U);
+    HOJY_CHECK_EQ(cells.lookup({1, 0}), kept);
+
+    std::vector<Cell> order;
+    for (const auto &[position, cell]: cells) {
+        order.push_back(position);
+    }
+    const std::vector<Cell> expected{{0, 1}, {0, 3}, {1, 0}, {2, 1}};
+    HOJY_CHECK_EQ(order == expected, true);
+
+    const auto found = cells.find({1, 0});
+    HOJY_CHECK_EQ(found != cells.end(), true);
+    HOJY_CHECK_EQ(found->second.moves, 3);
+    HOJY_CHECK_EQ((++cells.find({1, 0}))->first == Cell(2, 1), true);
+    HOJY_CHECK_EQ(cells.find({3, 3}) == cells.end(), true);
+    HOJY_CHECK_EQ(cells.count({0, 3}), 1U);
+    HOJY_CHECK_EQ(cells.lookup({3, 0}) == nullptr, true);
+
+    cells.clear();
+    HOJY_CHECK_EQ(cells.empty(), true);
+    HOJY_CHECK_EQ(cells.count({0, 3}), 0U);
+    HOJY_CHECK_EQ(cells.begin() == cells.end(), true);
+
+    /* cells outside the reset grid still work, like the map they replace */
+    cells[{6, 2}].moves = 5;
+    cells[{1, 1}].moves = 6;
+    HOJY_CHECK_EQ(cells.at({6, 2}).moves, 5);
+    HOJY_CHECK_EQ(cells.begin()->first == Cell(1, 1), true);
+    bool thrown = false;
+    try {
+        (void)cells.at({5, 5});
+    } catch (const std::out_of_range &) {
+        thrown = true;
+    }
+    HOJY_CHECK_EQ(thrown, true);
+}
+
+void testSelectableCellParentsSurviveGrowth() {
+    /* No reset(): every cell below lies outside the grid and grows it */
+    hojy::battle::SelectableCells cells;
+    Cell previous = hojy::battle::SelectableCell::NoParent;
+    for (int i = 0; i < 40; ++i) {
+        const Cell position{i, i / 2};
+        auto &cell = cells[position];
+        cell.x = position.first;
+        cell.y = position.second;
+        cell.moveParent = previous;
+        previous = position;
+    }
+    std::vector<Cell> path;
+    for (const auto *cell = cells.lookup(previous); cell; cell = cells.lookup(cell->moveParent)) {
+        path.emplace_back(cell->x, cell->y);
+    }
+    HOJY_CHECK_EQ(path.size(), 40U);
+    HOJY_CHECK_EQ(path.front() == Cell(39, 19), true);
+    HOJY_CHECK_EQ(path.back() == Cell(0, 0), true);
+}
+
 void testMovementAndDeathPredicates() {
     HOJY_CHECK_EQ(hojy::battle::hasMoved(4, 4), false);
     HOJY_CHECK_EQ(hojy::battle::hasMoved(4, 3), true);
@@ -396,6 +565,11 @@ int main() {
         testPoisonRepositionKeepsOriginAtMaximumRange();
         testShortestPathDistanceHonorsBlockedCellsAndTargetOccupancy();
         testTerrainPathDistanceIgnoresCharacterOccupancy();
+        testDistanceFieldCacheMatchesPathSearches();
+        testDistanceFieldCacheReusesFieldsUntilOccupancyChanges();
+        testCellGridSearchesMatchPredicateSearches();
+        testSelectableCellsIterateInKeyOrder();
+        testSelectableCellParentsSurviveGrowth();
         testMovementAndDeathPredicates();
         testMovementContinuationKeepsRequestingActorAlive();
         testPlayerMovementReturnsToTheSameTurn();
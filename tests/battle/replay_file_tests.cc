@@ -0,0 +1,301 @@
+#include "battle/engine.hh"
+#include "battle/random.hh"
+#include "battle/replay_file.hh"
+#include "test_support.hh"
+
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using hojy::battle::ActionTarget;
+using hojy::battle::BattleAction;
+using hojy::battle::BattleEngine;
+using hojy::battle::BattleParticipant;
+using hojy::battle::BattleReplay;
+using hojy::battle::InventorySource;
+using hojy::battle::ItemAction;
+using hojy::battle::ParticipantId;
+using hojy::battle::RecordingRandom;
+using hojy::battle::ReplayResult;
+using hojy::battle::SequenceRandom;
+using hojy::battle::SkillAction;
+
+class ScopedTempDirectory {
+public:
+    ScopedTempDirectory() {
+        const auto suffix = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        path_ = std::filesystem::temp_directory_path() / ("hojy-replay-" + std::to_string(suffix));
+        std::filesystem::create_directories(path_);
+    }
+
+    ~ScopedTempDirectory() {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    [[nodiscard]] const std::filesystem::path &path() const { return path_; }
+
+private:
+    std::filesystem::path path_;
+};
+
+/* Six against six; every step draws one random number and either hits an
+ * enemy or uses an item, then the enemies fall at the end. */
+hojy::battle::BattleResult runBattle(const std::string &replayFile) {
+    std::vector<hojy::world::state::CharacterData> characters(12);
+    for (auto &character: characters) {
+        character.hp = 1000;
+    }
+    std::vector<std::unique_ptr<BattleParticipant>> participants;
+    std::vector<int> values(120);
+    for (std::size_t index = 0; index < values.size(); ++index) {
+        values[index] = int(index * 7 % 100);
+    }
+    SequenceRandom sequence(std::move(values));
+    RecordingRandom random(sequence);
+    hojy::battle::BattleSetup setup;
+    for (std::size_t index = 0; index < characters.size(); ++index) {
+        participants.push_back(std::make_unique<BattleParticipant>(characters[index]));
+        setup.participants.push_back(participants.back().get());
+        setup.enemy.push_back(index >= 6);
+    }
+    setup.random = &random;
+    setup.inventory = {{42, 100}};
+    setup.replayFile = replayFile;
+    BattleEngine engine;
+    HOJY_CHECK_EQ(engine.begin(std::move(setup)), true);
+    hojy::battle::InventorySnapshot inventory{{42, 100}};
+    for (int step = 0; step < 100; ++step) {
+        const auto actor = ParticipantId(step % 6);
+        participants[actor]->state().exp += std::uint16_t(random.next(100));
+        if (step % 10 == 9) {
+            --inventory[0].second;
+            HOJY_CHECK_EQ(engine.record(BattleAction{
+                actor, ItemAction{42, InventorySource::PartyBag, -1},
+            }, inventory), true);
+            continue;
+        }
+        const auto target = ParticipantId(6 + step % 6);
+        participants[target]->state().hp -= 3;
+        HOJY_CHECK_EQ(engine.record(BattleAction{
+            actor, SkillAction{0, 7, 1, {ActionTarget{target, 1}}},
+        }, inventory), true);
+    }
+    for (std::size_t index = 6; index < participants.size(); ++index) {
+        participants[index]->state().hp = 0;
+    }
+    HOJY_CHECK_EQ(random.next(1, 3) >= 1, true);
+    HOJY_CHECK_EQ(engine.reconcile(), true);
+    return engine.finish(true);
+}
+
+std::string encode(const BattleReplay &replay) {
+    std::ostringstream stream;
+    HOJY_CHECK_EQ(hojy::battle::writeReplay(stream, replay), true);
+    return stream.str();
+}
+
+void testFinishSavesAReplayThatVerifiesAfterLoading() {
+    ScopedTempDirectory directory;
+    const auto path = (directory.path() / "war001.hjr").string();
+    const auto result = runBattle(path);
+    HOJY_CHECK_EQ(result.committed, true);
+    HOJY_CHECK_EQ(result.replaySaved, true);
+    HOJY_CHECK_EQ(std::filesystem::exists(path + ".tmp"), false);
+
+    BattleReplay loaded;
+    std::string error;
+    HOJY_CHECK_EQ(hojy::battle::loadReplay(path, loaded, &error), true);
+    HOJY_CHECK_EQ(error.empty(), true);
+    HOJY_CHECK_EQ(loaded.actions.size(), 100U);
+    HOJY_CHECK_EQ(loaded.randomCalls.size(), 101U);
+    HOJY_CHECK_EQ(loaded.settlementRandomBegin, 100U);
+    HOJY_CHECK_EQ(loaded.finalIntegrity, result.replay.finalIntegrity);
+    HOJY_CHECK_EQ(loaded.initialInventory, result.replay.initialInventory);
+    HOJY_CHECK_EQ(loaded.finalInventory, result.replay.finalInventory);
+    std::size_t index = 0;
+    HOJY_CHECK_EQ(loaded.actions.forEach([&](const hojy::battle::ActionRecord &record) {
+        const auto expected = result.replay.actions[index++];
+        HOJY_CHECK_EQ(record.action == expected.action, true);
+        HOJY_CHECK_EQ(record.integrity, expected.integrity);
+        HOJY_CHECK_EQ(record.randomBegin, expected.randomBegin);
+        HOJY_CHECK_EQ(record.randomEnd, expected.randomEnd);
+        HOJY_CHECK_EQ(record.inventory, expected.inventory);
+        HOJY_CHECK_EQ(std::memcmp(record.participants.data(), expected.participants.data(),
+                                  expected.participants.size() * sizeof(expected.participants[0])), 0);
+        return true;
+    }), true);
+
+    const auto verified = BattleEngine::replay(loaded);
+    HOJY_CHECK_EQ(verified.valid, true);
+    HOJY_CHECK_EQ(verified.won, true);
+    HOJY_CHECK_EQ(verified.failedAction, ReplayResult::NoIndex);
+    HOJY_CHECK_EQ(verified.failedRandomCall, ReplayResult::NoIndex);
+
+    /* one full copy of the participants per action would be 100 * 12 characters */
+    const auto bytes = std::filesystem::file_size(path);
+    HOJY_CHECK_EQ(bytes < 100 * 12 * sizeof(hojy::world::state::CharacterData) / 20, true);
+    HOJY_CHECK_EQ(encode(loaded), encode(result.replay));
+}
+
+void testFinishCreatesTheReplayDirectory() {
+    ScopedTempDirectory directory;
+    const auto path = (directory.path() / "replays" / "war002.hjr").string();
+    HOJY_CHECK_EQ(runBattle(path).replaySaved, true);
+    HOJY_CHECK_EQ(std::filesystem::exists(path), true);
+
+    /* a file standing where the directory should be */
+    const auto blocked = directory.path() / "blocked";
+    std::ofstream(blocked.string()) << "x";
+    HOJY_CHECK_EQ(runBattle((blocked / "war003.hjr").string()).replaySaved, false);
+}
+
+void testDamagedFilesAreRejectedBeforeVerification() {
+    const auto result = runBattle({});
+    HOJY_CHECK_EQ(result.replaySaved, false);
+    const auto data = encode(result.replay);
+    BattleReplay replay;
+    std::string error;
+
+    auto flipped = data;
+    flipped[flipped.size() / 2] ^= 0x10;
+    std::istringstream flippedStream(flipped);
+    HOJY_CHECK_EQ(hojy::battle::readReplay(flippedStream, replay, &error), false);
+    HOJY_CHECK_EQ(error, std::string("replay checksum mismatch"));
+
+    std::istringstream truncated(data.substr(0, data.size() - 9));
+    HOJY_CHECK_EQ(hojy::battle::readReplay(truncated, replay, &error), false);
+
+    auto other = data;
+    other[0] = 'X';
+    std::istringstream otherStream(other);
+    HOJY_CHECK_EQ(hojy::battle::readReplay(otherStream, replay, &error), false);
+    HOJY_CHECK_EQ(error, std::string("not a replay file"));
+
+    HOJY_CHECK_EQ(hojy::battle::loadReplay("/nonexistent/war.hjr", replay, &error), false);
+    HOJY_CHECK_EQ(replay.actions.empty(), true);
+}
+
+/* Replaces the only occurrence of from and recomputes the trailing checksum */
+std::string patch(const std::string &data, const std::string &from, const std::string &to) {
+    const auto pos = data.find(from);
+    HOJY_CHECK_EQ(pos != std::string::npos && data.find(from, pos + 1) == std::string::npos, true);
+    auto body = data.substr(0, data.size() - sizeof(std::uint64_t));
+    body.replace(pos, from.size(), to);
+    std::uint64_t hash = 1469598103934665603ULL;
+    for (auto c: body) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ULL;
+    }
+    for (int shift = 0; shift < 64; shift += 8) {
+        body.push_back(static_cast<char>(hash >> shift));
+    }
+    return body;
+}
+
+void testDamagedRandomWindowsAreRejected() {
+    const auto result = runBattle({});
+    /* One action whose random window sits at the 32-bit limit */
+    auto record = result.replay.actions.at(0);
+    record.randomBegin = record.randomEnd = std::numeric_limits<std::uint32_t>::max();
+    auto edge = result.replay;
+    edge.actions = hojy::battle::ActionLog();
+    edge.actions.reset(edge.initialParticipants, edge.initialInventory);
+    edge.actions.append(record);
+    const auto data = encode(edge);
+    BattleReplay replay;
+    std::string error;
+    std::istringstream edgeStream(data);
+    HOJY_CHECK_EQ(hojy::battle::readReplay(edgeStream, replay, &error), true);
+    HOJY_CHECK_EQ(replay.actions.at(0).randomEnd, std::size_t(std::numeric_limits<std::uint32_t>::max()));
+
+    /* zigzag varints of the begin and end deltas */
+    const std::string window("\xfe\xff\xff\xff\x1f\x00", 6);
+    const std::string damaged[] = {
+        /* begins past the limit */
+        std::string("\x80\x80\x80\x80\x20\x00", 6),
+        /* ends past the limit */
+        std::string("\xfe\xff\xff\xff\x1f\x02", 6),
+        /* ends before it begins */
+        std::string("\xfe\xff\xff\xff\x1f\x01", 6),
+        /* deltas that overflow when added */
+        std::string("\xfe\xff\xff\xff\xff\xff\xff\xff\xff\x01\xfe\xff\xff\xff\xff\xff\xff\xff\xff\x01", 20),
+    };
+    for (const auto &bytes: damaged) {
+        std::istringstream stream(patch(data, window, bytes));
+        error.clear();
+        HOJY_CHECK_EQ(hojy::battle::readReplay(stream, replay, &error), false);
+        HOJY_CHECK_EQ(error, std::string("malformed replay action"));
+    }
+
+    ScopedTempDirectory directory;
+    const auto filename = (directory.path() / "war001.hjr").string();
+    {
+        std::ofstream file(filename, std::ios::binary);
+        const auto bytes = patch(data, window, damaged[0]);
+        file.write(bytes.data(), std::streamsize(bytes.size()));
+    }
+    error.clear();
+    HOJY_CHECK_EQ(hojy::battle::loadReplay(filename, replay, &error), false);
+    HOJY_CHECK_EQ(error, std::string("malformed replay action"));
+}
+
+void testVerifierReportsTheFirstDivergingActionAndRandomCall() {
+    const auto result = runBattle({});
+
+    auto random = result.replay;
+    ++random.randomCalls[37].result;
+    const auto randomFailure = BattleEngine::replay(random);
+    HOJY_CHECK_EQ(randomFailure.valid, false);
+    HOJY_CHECK_EQ(randomFailure.failedRandomCall, 37U);
+    HOJY_CHECK_EQ(randomFailure.failedAction, 37U);
+
+    auto settlement = result.replay;
+    ++settlement.randomCalls[100].rawValue;
+    const auto settlementFailure = BattleEngine::replay(settlement);
+    HOJY_CHECK_EQ(settlementFailure.valid, false);
+    HOJY_CHECK_EQ(settlementFailure.failedRandomCall, 100U);
+    HOJY_CHECK_EQ(settlementFailure.failedAction, ReplayResult::NoIndex);
+
+    auto state = result.replay;
+    hojy::battle::ActionLog tampered;
+    tampered.reset(result.replay.initialParticipants, result.replay.initialInventory);
+    for (std::size_t index = 0; index < result.replay.actions.size(); ++index) {
+        auto record = result.replay.actions[index];
+        if (index >= 52) { ++record.participants[3].exp; }
+        tampered.append(std::move(record));
+    }
+    state.actions = std::move(tampered);
+    std::istringstream stream(encode(state));
+    BattleReplay loaded;
+    HOJY_CHECK_EQ(hojy::battle::readReplay(stream, loaded), true);
+    const auto stateFailure = BattleEngine::replay(loaded);
+    HOJY_CHECK_EQ(stateFailure.valid, false);
+    HOJY_CHECK_EQ(stateFailure.failedAction, 52U);
+    HOJY_CHECK_EQ(stateFailure.failedRandomCall, 52U);
+}
+
+}
+
+int main() {
+    try {
+        testFinishSavesAReplayThatVerifiesAfterLoading();
+        testFinishCreatesTheReplayDirectory();
+        testDamagedFilesAreRejectedBeforeVerification();
+        testDamagedRandomWindowsAreRejected();
+        testVerifierReportsTheFirstDivergingActionAndRandomCall();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,212 @@
+#include "content/contentpack.hh"
+#include "test_support.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+class ScopedTempDirectory {
+public:
+    ScopedTempDirectory(): oldPath_(std::filesystem::current_path()) {
+        const auto suffix = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        path_ = std::filesystem::temp_directory_path() / ("hojy-pack-" + std::to_string(suffix));
+        std::filesystem::create_directories(path_);
+        std::filesystem::current_path(path_);
+    }
+
+    ~ScopedTempDirectory() {
+        std::error_code ec;
+        std::filesystem::current_path(oldPath_, ec);
+        std::filesystem::remove_all(path_, ec);
+    }
+
+private:
+    std::filesystem::path oldPath_;
+    std::filesystem::path path_;
+};
+
+using hojy::content::ContentPack;
+
+void writeBytes(const std::string &filename, const std::string &data) {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) { throw std::runtime_error("failed to write " + filename); }
+}
+
+template<typename T>
+std::string bytesOf(const std::vector<T> &values) {
+    return std::string(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(T));
+}
+
+void writeGrp(const std::string &name, const std::vector<std::string> &entries) {
+    std::vector<std::uint32_t> offsets;
+    std::string group;
+    for (const auto &entry: entries) {
+        group += entry;
+        offsets.push_back(static_cast<std::uint32_t>(group.size()));
+    }
+    writeBytes(name + ".IDX", bytesOf(offsets));
+    writeBytes(name + ".GRP", group);
+}
+
+std::string talk(std::string big5) {
+    for (auto &c: big5) { c = static_cast<char>(~static_cast<unsigned char>(c)); }
+    return big5;
+}
+
+/* A minimal set of sources: two talks, two programs, a building on the global map */
+void writeSources() {
+    /* 國 in Big5 */
+    writeGrp("TALK", {talk("\xb0\xea"), talk("AB")});
+    writeGrp("KDEF", {bytesOf(std::vector<std::int16_t>{1, 2, -1}), ""});
+    writeBytes("strings.toml", "strings = [\"\xe5\x9c\x8b\", \"\xe5\x9c\x8b\"]\n");
+    /* Cells 36x18, building 2 is 72 pixels wide so it is drawn one cell up */
+    writeGrp("MMAP", {bytesOf(std::vector<std::uint16_t>{36, 18, 0, 0}), "",
+                      bytesOf(std::vector<std::uint16_t>{72, 40, 0, 0})});
+    std::vector<std::uint16_t> earth(hojy::content::GlobalMapWidth * hojy::content::GlobalMapHeight);
+    std::vector<std::uint16_t> surface(earth.size()), building(earth.size());
+    earth[5] = 419 * 2;
+    earth[6] = 180 * 2;
+    earth[7] = 10 * 2;
+    building[3 * hojy::content::GlobalMapWidth + 3] = 2 * 2;
+    writeBytes("EARTH.002", bytesOf(earth));
+    writeBytes("SURFACE.002", bytesOf(surface));
+    writeBytes("BUILDING.002", bytesOf(building));
+    std::string colors(256 * 3, '\0');
+    colors[3] = 1;
+    colors[4] = 2;
+    colors[5] = 3;
+    writeBytes("MMAP.COL", colors);
+    writeBytes("ENDCOL.COL", std::string(256 * 3, '\x3f'));
+}
+
+std::string resolve(const std::string &name) {
+    return name;
+}
+
+void packHoldsConvertedContent() {
+    ScopedTempDirectory tempDirectory;
+    writeSources();
+    std::string image, error;
+    HOJY_CHECK_EQ(ContentPack::build(resolve, image, error), true);
+    ContentPack pack;
+    HOJY_CHECK_EQ(pack.adopt(image), true);
+    HOJY_CHECK_EQ(pack.upToDate(resolve), true);
+
+    HOJY_CHECK_EQ(pack.count(ContentPack::TalkBig5), 2U);
+    HOJY_CHECK_EQ(pack.entry(ContentPack::TalkBig5, 0), std::string_view("\xb0\xea"));
+    HOJY_CHECK_EQ(pack.text(ContentPack::TalkTraditional, 0), std::wstring(L"國"));
+    HOJY_CHECK_EQ(pack.text(ContentPack::TalkSimplified, 0), std::wstring(L"国"));
+    HOJY_CHECK_EQ(pack.text(ContentPack::TalkTraditional, 1), std::wstring(L"AB"));
+    HOJY_CHECK_EQ(pack.text(ContentPack::TalkTraditional, 2).empty(), true);
+
+    /* The default name keeps its traditional characters */
+    HOJY_CHECK_EQ(pack.text(ContentPack::StringsSimplified, 0), std::wstring(L"國"));
+    HOJY_CHECK_EQ(pack.text(ContentPack::StringsSimplified, 1), std::wstring(L"国"));
+
+    HOJY_CHECK_EQ(pack.count(ContentPack::Events), 2U);
+    HOJY_CHECK_EQ(pack.entry(ContentPack::Events, 0), std::string_view(bytesOf(std::vector<std::int16_t>{1, 2, -1})));
+    HOJY_CHECK_EQ(pack.entry(ContentPack::Events, 1).empty(), true);
+
+    std::vector<hojy::content::GlobalCell> cells;
+    HOJY_CHECK_EQ(pack.globalCells(cells), true);
+    HOJY_CHECK_EQ(cells.size(), std::size_t(hojy::content::GlobalMapWidth * hojy::content::GlobalMapHeight));
+    HOJY_CHECK_EQ(int(cells[5].type), 1);
+    HOJY_CHECK_EQ(int(cells[5].canWalk), 0);
+    HOJY_CHECK_EQ(int(cells[6].type), 1);
+    HOJY_CHECK_EQ(int(cells[6].canWalk), 1);
+    HOJY_CHECK_EQ(int(cells[7].canWalk), 1);
+    const auto &shifted = cells[2 * hojy::content::GlobalMapWidth + 2];
+    HOJY_CHECK_EQ(shifted.buildingId, std::int16_t(2));
+    HOJY_CHECK_EQ(shifted.buildingDeltaY, std::int16_t(18));
+
+    std::array<std::uint32_t, 256> colors {};
+    HOJY_CHECK_EQ(pack.palette(ContentPack::NormalPalette, colors), true);
+    HOJY_CHECK_EQ(colors[0], 0U);
+    HOJY_CHECK_EQ(colors[1], 0xFF04080CU);
+    HOJY_CHECK_EQ(pack.palette(ContentPack::EndPalette, colors), true);
+    HOJY_CHECK_EQ(colors[1], 0xFFFCFCFCU);
+}
+
+void stalePackIsNotLoaded() {
+    ScopedTempDirectory tempDirectory;
+    writeSources();
+    std::string error;
+    ContentPack pack;
+    HOJY_CHECK_EQ(pack.load(ContentPack::DefaultName, resolve, error), false);
+    HOJY_CHECK_EQ(std::filesystem::exists(ContentPack::DefaultName), false);
+    HOJY_CHECK_EQ(ContentPack::rebuild(ContentPack::DefaultName, resolve, error), true);
+    HOJY_CHECK_EQ(pack.load(ContentPack::DefaultName, resolve, error), true);
+
+    /* Written again with the same content, the hash keeps the pack in use */
+    writeGrp("TALK", {talk("\xb0\xea"), talk("AB")});
+    std::filesystem::last_write_time("TALK.GRP",
+                                     std::filesystem::last_write_time("TALK.GRP") + std::chrono::hours(1));
+    HOJY_CHECK_EQ(pack.upToDate(resolve), true);
+    HOJY_CHECK_EQ(pack.load(ContentPack::DefaultName, resolve, error), true);
+
+    /* A source of another size */
+    writeGrp("TALK", {talk("CD")});
+    HOJY_CHECK_EQ(pack.upToDate(resolve), false);
+    error.clear();
+    HOJY_CHECK_EQ(pack.load(ContentPack::DefaultName, resolve, error), false);
+    HOJY_CHECK_EQ(pack.loaded(), false);
+    HOJY_CHECK_EQ(error.empty(), false);
+    HOJY_CHECK_EQ(ContentPack::rebuild(ContentPack::DefaultName, resolve, error), true);
+    HOJY_CHECK_EQ(pack.load(ContentPack::DefaultName, resolve, error), true);
+    HOJY_CHECK_EQ(pack.count(ContentPack::TalkTraditional), 1U);
+    HOJY_CHECK_EQ(pack.text(ContentPack::TalkTraditional, 0), std::wstring(L"CD"));
+
+    /* Same size, written later */
+    writeGrp("TALK", {talk("EF")});
+    std::filesystem::last_write_time("TALK.GRP",
+                                     std::filesystem::last_write_time("TALK.GRP") + std::chrono::hours(1));
+    HOJY_CHECK_EQ(pack.upToDate(resolve), false);
+
+    ContentPack reopened;
+    HOJY_CHECK_EQ(reopened.open(ContentPack::DefaultName), true);
+    HOJY_CHECK_EQ(reopened.upToDate(resolve), false);
+    HOJY_CHECK_EQ(ContentPack::rebuild(ContentPack::DefaultName, resolve, error), true);
+    HOJY_CHECK_EQ(reopened.open(ContentPack::DefaultName), true);
+    HOJY_CHECK_EQ(reopened.upToDate(resolve), true);
+    HOJY_CHECK_EQ(reopened.text(ContentPack::TalkTraditional, 0), std::wstring(L"EF"));
+}
+
+void damagedPackIsRejected() {
+    ScopedTempDirectory tempDirectory;
+    writeSources();
+    std::string image, error;
+    HOJY_CHECK_EQ(ContentPack::build(resolve, image, error), true);
+    ContentPack pack;
+    auto damaged = image;
+    damaged[damaged.size() / 2] ^= 1;
+    HOJY_CHECK_EQ(pack.adopt(damaged), false);
+    HOJY_CHECK_EQ(pack.loaded(), false);
+    HOJY_CHECK_EQ(pack.adopt(image.substr(0, 16)), false);
+
+    std::filesystem::remove("KDEF.GRP");
+    HOJY_CHECK_EQ(ContentPack::build(resolve, image, error), false);
+    HOJY_CHECK_EQ(error.empty(), false);
+}
+
+}
+
+int main() {
+    try {
+        packHoldsConvertedContent();
+        stalePackIsNotLoaded();
+        damagedPackIsRejected();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,152 @@
+#include "content/event.hh"
+#include "test_support.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+class ScopedTempDirectory {
+public:
+    ScopedTempDirectory(): oldPath_(std::filesystem::current_path()) {
+        const auto suffix = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        path_ = std::filesystem::temp_directory_path() / ("hojy-talk-" + std::to_string(suffix));
+        std::filesystem::create_directories(path_);
+        std::filesystem::current_path(path_);
+    }
+
+    ~ScopedTempDirectory() {
+        std::error_code ec;
+        std::filesystem::current_path(oldPath_, ec);
+        std::filesystem::remove_all(path_, ec);
+    }
+
+private:
+    std::filesystem::path oldPath_;
+    std::filesystem::path path_;
+};
+
+void writeBytes(const std::string &filename, const std::string &data) {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) { throw std::runtime_error("failed to write " + filename); }
+}
+
+std::string invert(std::string big5) {
+    for (auto &c: big5) {
+        if (c) { c = static_cast<char>(~static_cast<unsigned char>(c)); }
+    }
+    return big5;
+}
+
+void writeTalks(const std::vector<std::string> &talks) {
+    std::vector<std::uint32_t> offsets;
+    std::string group;
+    for (const auto &talk: talks) {
+        group += invert(talk);
+        offsets.push_back(static_cast<std::uint32_t>(group.size()));
+    }
+    writeBytes("TALK.IDX", std::string(reinterpret_cast<const char *>(offsets.data()),
+                                       offsets.size() * sizeof(std::uint32_t)));
+    writeBytes("TALK.GRP", group);
+}
+
+void talksAreConvertedOnDemand() {
+    /* 國 in Big5, and a line padded with NULs */
+    writeTalks({"\xb0\xea", std::string("AB\0\0", 4), "CD"});
+    hojy::content::Event event;
+    HOJY_CHECK_EQ(event.loadTalk("TALK"), true);
+    HOJY_CHECK_EQ(event.talkCount(), 3U);
+    HOJY_CHECK_EQ(event.talkCacheCount(), 0U);
+
+    HOJY_CHECK_EQ(event.talk(0), std::wstring(L"國"));
+    HOJY_CHECK_EQ(event.talk(1), std::wstring(L"AB"));
+    HOJY_CHECK_EQ(event.talkCacheCount(), 2U);
+    HOJY_CHECK_EQ(event.talk(0), std::wstring(L"國"));
+    HOJY_CHECK_EQ(event.talkCacheCount(), 2U);
+
+    HOJY_CHECK_EQ(event.origTalk(0), std::string("\xb0\xea"));
+    HOJY_CHECK_EQ(event.origTalk(1), std::string("AB\0\0", 4));
+    HOJY_CHECK_EQ(event.origTalk(3), std::string());
+    HOJY_CHECK_EQ(event.talk(3), std::wstring());
+    HOJY_CHECK_EQ(event.talkCacheCount(), 2U);
+}
+
+void cacheDropsLeastRecentlyUsed() {
+    writeTalks({"A", "B", "C"});
+    hojy::content::Event event;
+    HOJY_CHECK_EQ(event.loadTalk("TALK"), true);
+    event.setTalkCacheCapacity(2);
+    (void)event.talk(0);
+    (void)event.talk(1);
+    (void)event.talk(0);
+    (void)event.talk(2);
+    HOJY_CHECK_EQ(event.talkCacheCount(), 2U);
+    /* Line 1 was dropped, asking for it again still converts it */
+    HOJY_CHECK_EQ(event.talk(1), std::wstring(L"B"));
+    HOJY_CHECK_EQ(event.talk(2), std::wstring(L"C"));
+
+    event.setTalkCacheCapacity(0);
+    HOJY_CHECK_EQ(event.talkCacheCount(), 0U);
+    HOJY_CHECK_EQ(event.talk(0), std::wstring(L"A"));
+    event.prefetchTalk(1);
+    HOJY_CHECK_EQ(event.talkCacheCount(), 0U);
+}
+
+void prefetchRunsAlongsideReads() {
+    std::vector<std::string> talks;
+    for (int i = 0; i < 200; ++i) {
+        talks.push_back("line " + std::to_string(i));
+    }
+    writeTalks(talks);
+    hojy::content::Event event;
+    HOJY_CHECK_EQ(event.loadTalk("TALK"), true);
+    event.setTalkCacheCapacity(64);
+    std::thread warmer([&event]() {
+        for (std::size_t i = 0; i < 200; ++i) {
+            event.prefetchTalk(i);
+        }
+    });
+    bool matched = true;
+    for (std::size_t round = 0; round < 4; ++round) {
+        for (std::size_t i = 0; i < 200; ++i) {
+            matched = matched && event.talk(i) == L"line " + std::to_wstring(i);
+        }
+    }
+    warmer.join();
+    HOJY_CHECK_EQ(matched, true);
+    HOJY_CHECK_EQ(event.talkCacheCount(), 64U);
+}
+
+void failedLoadKeepsTalks() {
+    writeTalks({"A"});
+    hojy::content::Event event;
+    HOJY_CHECK_EQ(event.loadTalk("TALK"), true);
+    HOJY_CHECK_EQ(event.talk(0), std::wstring(L"A"));
+    std::filesystem::remove("TALK.IDX");
+    HOJY_CHECK_EQ(event.loadTalk("TALK"), false);
+    HOJY_CHECK_EQ(event.talk(0), std::wstring(L"A"));
+    HOJY_CHECK_EQ(event.origTalk(0), std::string("A"));
+}
+
+}
+
+int main() {
+    try {
+        ScopedTempDirectory directory;
+        talksAreConvertedOnDemand();
+        cacheDropsLeastRecentlyUsed();
+        prefetchRunsAlongsideReads();
+        failedLoadKeepsTalks();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
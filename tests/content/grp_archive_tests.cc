@@ -0,0 +1,119 @@
+#include "content/grparchive.hh"
+#include "test_support.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+class ScopedTempDirectory {
+public:
+    ScopedTempDirectory(): oldPath_(std::filesystem::current_path()) {
+        const auto suffix = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        path_ = std::filesystem::temp_directory_path() / ("hojy-grp-" + std::to_string(suffix));
+        std::filesystem::create_directories(path_);
+        std::filesystem::current_path(path_);
+    }
+
+    ~ScopedTempDirectory() {
+        std::error_code ec;
+        std::filesystem::current_path(oldPath_, ec);
+        std::filesystem::remove_all(path_, ec);
+    }
+
+private:
+    std::filesystem::path oldPath_;
+    std::filesystem::path path_;
+};
+
+void writeBytes(const std::string &filename, const std::string &data) {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) { throw std::runtime_error("failed to write " + filename); }
+}
+
+void writeOffsets(const std::string &filename, const std::vector<std::uint32_t> &offsets) {
+    std::ofstream file(filename, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(offsets.data()),
+               static_cast<std::streamsize>(offsets.size() * sizeof(std::uint32_t)));
+    if (!file) { throw std::runtime_error("failed to write " + filename); }
+}
+
+void archiveViewsEntriesInPlace() {
+    ScopedTempDirectory tempDirectory;
+    writeOffsets("GOOD.IDX", {2, 2, 5});
+    writeBytes("GOOD.GRP", "abcde");
+    hojy::content::GrpArchive archive;
+    HOJY_CHECK_EQ(archive.open("GOOD"), true);
+    HOJY_CHECK_EQ(archive.size(), 3U);
+    HOJY_CHECK_EQ(archive[0], std::string_view("ab"));
+    HOJY_CHECK_EQ(archive[1].empty(), true);
+    HOJY_CHECK_EQ(archive[2], std::string_view("cde"));
+    HOJY_CHECK_EQ(archive[2].data(), archive[0].data() + 2);
+    HOJY_CHECK_EQ(archive.at(3).empty(), true);
+
+    /* Copies share the mapping, views outlive the archive they came from */
+    const auto views = archive.entries();
+    auto copy = archive;
+    archive = {};
+    HOJY_CHECK_EQ(archive.empty(), true);
+    HOJY_CHECK_EQ(copy.size(), 3U);
+    HOJY_CHECK_EQ(views[2], std::string_view("cde"));
+}
+
+void archiveAcceptsEmptyGroupFile() {
+    ScopedTempDirectory tempDirectory;
+    writeOffsets("EMPTY.IDX", {0, 0});
+    writeBytes("EMPTY.GRP", "");
+    hojy::content::GrpArchive archive;
+    HOJY_CHECK_EQ(archive.open("EMPTY"), true);
+    HOJY_CHECK_EQ(archive.size(), 2U);
+    HOJY_CHECK_EQ(archive[0].empty(), true);
+    HOJY_CHECK_EQ(archive[1].empty(), true);
+}
+
+void failedOpenKeepsPreviousEntries() {
+    ScopedTempDirectory tempDirectory;
+    writeOffsets("GOOD.IDX", {3});
+    writeBytes("GOOD.GRP", "abc");
+    writeOffsets("PAST_END.IDX", {4});
+    writeBytes("PAST_END.GRP", "abc");
+    writeOffsets("ZERO_MIDDLE.IDX", {0, 3});
+    writeBytes("ZERO_MIDDLE.GRP", "abc");
+    hojy::content::GrpArchive archive;
+    HOJY_CHECK_EQ(archive.open("GOOD"), true);
+    HOJY_CHECK_EQ(archive.open("PAST_END"), false);
+    HOJY_CHECK_EQ(archive.open("ZERO_MIDDLE"), false);
+    HOJY_CHECK_EQ(archive.open("MISSING"), false);
+    HOJY_CHECK_EQ(archive.size(), 1U);
+    HOJY_CHECK_EQ(archive[0], std::string_view("abc"));
+}
+
+void archiveFromEntriesMatchesInput() {
+    const auto archive = hojy::content::GrpArchive::fromEntries({"x", "", "yz"});
+    HOJY_CHECK_EQ(archive.size(), 3U);
+    HOJY_CHECK_EQ(archive[0], std::string_view("x"));
+    HOJY_CHECK_EQ(archive[1].empty(), true);
+    HOJY_CHECK_EQ(archive[2], std::string_view("yz"));
+}
+
+}
+
+int main() {
+    try {
+        archiveViewsEntriesInPlace();
+        archiveAcceptsEmptyGroupFile();
+        failedOpenKeepsPreviousEntries();
+        archiveFromEntriesMatchesInput();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include "test_support.hh"
 
 #include <iostream>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -33,6 +34,7 @@ public:
             error = "legacy event program counter out of range";
             return false;
         }
+        ++decodes;
         instruction = {};
         instruction.wordOffset = programCounter;
         instruction.opcode = program[programCounter];
@@ -69,6 +71,7 @@ public:
 
     std::vector<std::int16_t> calls;
     std::vector<std::int16_t> values;
+    mutable std::size_t decodes = 0;
 
 private:
     hojy::event::Vm *vm_ = nullptr;
@@ -213,6 +216,55 @@ void testLegacyVmFaultsBeforeExecutingTruncatedInstruction() {
     HOJY_CHECK_EQ(vm.legacyActive(), false);
 }
 
+void testLegacyVmRunsSharedProgramWithoutDecoding() {
+    LegacyHost host;
+    auto program = std::make_shared<hojy::event::LegacyProgram>(
+        std::vector<std::int16_t>{2, 20, 1, 7, 0, 2, 3, 30, 5, 50});
+    program->decode(host.legacyDecoder());
+    HOJY_CHECK_EQ(host.decodes, 4U);
+    HOJY_CHECK_EQ(program->steps().size(), 4U);
+
+    for (int run = 0; run < 3; ++run) {
+        hojy::event::Vm vm;
+        vm.loadLegacy(std::shared_ptr<const hojy::event::LegacyProgram>(program));
+        HOJY_CHECK_EQ(vm.runLegacy(host, 8).status,
+                      hojy::event::VmStatus::Waiting);
+        HOJY_CHECK_EQ(vm.resumeLegacy(false), true);
+        HOJY_CHECK_EQ(vm.runLegacy(host, 8).status,
+                      hojy::event::VmStatus::Completed);
+    }
+    HOJY_CHECK_EQ(host.decodes, 4U);
+    HOJY_CHECK_EQ(host.calls,
+                  (std::vector<std::int16_t>{2, 1, 5, 2, 1, 5, 2, 1, 5}));
+}
+
+void testLegacyVmPatchesCopyOfSharedProgram() {
+    hojy::event::Vm vm;
+    LegacyHost host(&vm);
+    auto program = std::make_shared<hojy::event::LegacyProgram>(
+        std::vector<std::int16_t>{6, 1, 7, 2, 8, 3});
+    program->decode(host.legacyDecoder());
+    vm.loadLegacy(std::shared_ptr<const hojy::event::LegacyProgram>(program));
+
+    HOJY_CHECK_EQ(vm.runLegacy(host, 8).status,
+                  hojy::event::VmStatus::Completed);
+    HOJY_CHECK_EQ(host.values,
+                  (std::vector<std::int16_t>{1, 99, 3}));
+    HOJY_CHECK_EQ(program->words()[3], 2);
+    HOJY_CHECK_EQ(program->step(2)->instruction.operands[0], 2);
+}
+
+void testLegacyVmFaultsOnlyWhenReachingUndecodableInstruction() {
+    hojy::event::Vm vm;
+    LegacyHost host;
+    vm.loadLegacy({2, 20, 1, 7, 2});
+
+    const auto result = vm.runLegacy(host, 8);
+    HOJY_CHECK_EQ(result.status, hojy::event::VmStatus::Faulted);
+    HOJY_CHECK_EQ(result.error, std::string("truncated legacy event instruction"));
+    HOJY_CHECK_EQ(host.calls, (std::vector<std::int16_t>{2}));
+}
+
 }
 
 int main() {
@@ -226,6 +278,9 @@ int main() {
         testLegacyVmSequentialWaitIgnoresResumeResult();
         testLegacyVmRespectsBudgetAndPatchesRelativeToNextInstruction();
         testLegacyVmFaultsBeforeExecutingTruncatedInstruction();
+        testLegacyVmRunsSharedProgramWithoutDecoding();
+        testLegacyVmPatchesCopyOfSharedProgram();
+        testLegacyVmFaultsOnlyWhenReachingUndecodableInstruction();
     } catch (const std::exception &error) {
         std::cerr << error.what() << '\n';
         return 1;
@@ -0,0 +1,129 @@
+#include "scene/fighttexturecache.hh"
+#include "test_support.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+namespace {
+
+class ScopedTempDirectory {
+public:
+    ScopedTempDirectory(): oldPath_(std::filesystem::current_path()) {
+        const auto suffix = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        path_ = std::filesystem::temp_directory_path() / ("hojy-fight-" + std::to_string(suffix));
+        std::filesystem::create_directories(path_);
+        std::filesystem::current_path(path_);
+    }
+
+    ~ScopedTempDirectory() {
+        std::error_code ec;
+        std::filesystem::current_path(oldPath_, ec);
+        std::filesystem::remove_all(path_, ec);
+    }
+
+private:
+    std::filesystem::path oldPath_;
+    std::filesystem::path path_;
+};
+
+/* One frame per archive, holding the character id */
+void writeFightArchive(int id) {
+    char name[16];
+    std::snprintf(name, sizeof(name), "FIGHT%03d", id);
+    const auto frame = std::to_string(id);
+    const auto end = static_cast<std::uint32_t>(frame.size());
+    std::ofstream idx(std::string(name) + ".IDX", std::ios::binary);
+    idx.write(reinterpret_cast<const char *>(&end), sizeof(end));
+    std::ofstream grp(std::string(name) + ".GRP", std::ios::binary);
+    grp.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+    if (!idx || !grp) { throw std::runtime_error("failed to write fight archive"); }
+}
+
+void cacheOpensOnFirstUseAndDropsLeastRecent() {
+    ScopedTempDirectory tempDirectory;
+    for (int id = 0; id < 3; ++id) { writeFightArchive(id); }
+    hojy::scene::FightTextureCache cache(2);
+    const auto first = cache.get(0);
+    HOJY_CHECK_EQ(first != nullptr, true);
+    HOJY_CHECK_EQ((*first)[0], std::string_view("0"));
+    HOJY_CHECK_EQ(cache.get(0) == first, true);
+    HOJY_CHECK_EQ(cache.count(), 1U);
+
+    (void)cache.get(1);
+    (void)cache.get(0);
+    (void)cache.get(2);
+    HOJY_CHECK_EQ(cache.count(), 2U);
+    /* 1 was the least recently used, 0 is still the same set */
+    HOJY_CHECK_EQ(cache.get(0) == first, true);
+    HOJY_CHECK_EQ(cache.count(), 2U);
+
+    /* A dropped set stays usable while someone holds it */
+    cache.clear();
+    HOJY_CHECK_EQ(cache.count(), 0U);
+    HOJY_CHECK_EQ((*first)[0], std::string_view("0"));
+}
+
+void missingArchivesAreRemembered() {
+    ScopedTempDirectory tempDirectory;
+    writeFightArchive(4);
+    hojy::scene::FightTextureCache cache(4);
+    HOJY_CHECK_EQ(cache.get(-1) == nullptr, true);
+    HOJY_CHECK_EQ(cache.get(5) == nullptr, true);
+    cache.preload({4, 5, -1});
+    HOJY_CHECK_EQ(cache.count(), 1U);
+
+    /* Not looked for again until the cache is cleared */
+    writeFightArchive(5);
+    HOJY_CHECK_EQ(cache.get(5) == nullptr, true);
+    cache.clear();
+    HOJY_CHECK_EQ(cache.get(5) != nullptr, true);
+}
+
+void preloadStopsAtCapacity() {
+    ScopedTempDirectory tempDirectory;
+    for (int id = 0; id < 4; ++id) { writeFightArchive(id); }
+    hojy::scene::FightTextureCache cache(2);
+    /* Missing and repeated ids do not take a place */
+    cache.preload({7, 0, 0, 1, 2, 3});
+    HOJY_CHECK_EQ(cache.count(), 2U);
+    for (int id = 0; id < 4; ++id) {
+        std::filesystem::remove("FIGHT00" + std::to_string(id) + ".IDX");
+    }
+    HOJY_CHECK_EQ(cache.get(0) != nullptr, true);
+    HOJY_CHECK_EQ(cache.get(1) != nullptr, true);
+    HOJY_CHECK_EQ(cache.get(2) == nullptr, true);
+}
+
+void zeroCapacityKeepsNothing() {
+    ScopedTempDirectory tempDirectory;
+    writeFightArchive(1);
+    hojy::scene::FightTextureCache cache;
+    HOJY_CHECK_EQ(cache.get(1) != nullptr, true);
+    HOJY_CHECK_EQ(cache.count(), 0U);
+    cache.setCapacity(1);
+    cache.preload({1});
+    HOJY_CHECK_EQ(cache.count(), 1U);
+    cache.setCapacity(0);
+    HOJY_CHECK_EQ(cache.count(), 0U);
+}
+
+}
+
+int main() {
+    try {
+        cacheOpensOnFirstUseAndDropsLeastRecent();
+        missingArchivesAreRemembered();
+        preloadStopsAtCapacity();
+        zeroCapacityKeepsNothing();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,179 @@
+#include "scene/colorpalette.hh"
+#include "scene/groundlayer.hh"
+#include "scene/tilecache.hh"
+#include "scene/tilerasterizer.hh"
+#include "util/threadpool.hh"
+#include "test_support.hh"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+using hojy::content::GlobalCell;
+using hojy::content::GlobalMapWidth;
+using hojy::content::GlobalMapHeight;
+
+constexpr int CellWidth = 36;
+constexpr int CellHeight = 18;
+constexpr int Width = 200;
+constexpr int Height = 150;
+
+struct Random {
+    std::uint32_t state;
+    int next(int range) {
+        state = state * 1664525U + 1013904223U;
+        return int((state >> 8) % std::uint32_t(range));
+    }
+};
+
+std::string makeTile(Random &random, int w, int h, int ox, int oy) {
+    std::string data;
+    for (auto v: {w, h, ox, oy}) {
+        data.push_back(char(v & 0xFF));
+        data.push_back(char((v >> 8) & 0xFF));
+    }
+    for (int y = 0; y < h; ++y) {
+        std::string row;
+        int x = 0;
+        while (x < w) {
+            int skip = random.next(3);
+            int count = std::min(1 + random.next(12), w - x - skip);
+            if (count <= 0) { break; }
+            row.push_back(char(skip));
+            row.push_back(char(count));
+            for (int i = 0; i < count; ++i) {
+                row.push_back(char(1 + random.next(253)));
+            }
+            x += skip + count;
+        }
+        data.push_back(char(row.size()));
+        data += row;
+    }
+    return data;
+}
+
+hojy::scene::ColorPalette makePalette() {
+    std::array<std::uint32_t, 256> colors{};
+    for (std::uint32_t i = 0; i < colors.size(); ++i) {
+        colors[i] = 0xFF000000U | (i * 0x010203U);
+    }
+    hojy::scene::ColorPalette palette;
+    palette.create(colors);
+    return palette;
+}
+
+/* Every cell of the view drawn without culling, the way the whole ground used to be drawn */
+std::vector<std::uint32_t> drawAllCells(hojy::scene::TileCache &cache, const std::vector<GlobalCell> &cells,
+                                        const std::vector<std::string_view> &textures, int cameraX, int cameraY) {
+    std::vector<std::uint32_t> pixels(Width * Height, 0);
+    int cellDiffX = CellWidth / 2, cellDiffY = CellHeight / 2;
+    int nx = Width / 2 + CellWidth * 2, ny = Height / 2 + CellHeight * 2;
+    int cx = (nx / cellDiffX + ny / cellDiffY) / 2;
+    int cy = (ny / cellDiffY - nx / cellDiffX) / 2;
+    int wcount = nx * 2 / CellWidth;
+    int hcount = (ny * 2 + 4 * CellHeight) / cellDiffY;
+    int tx = Width / 2 - (cx - cy) * cellDiffX;
+    int ty = Height / 2 + cellDiffY - (cx + cy) * cellDiffY;
+    cx = cameraX - cx; cy = cameraY - cy;
+    for (int j = hcount; j; --j) {
+        for (int i = 0; i < wcount; ++i) {
+            int x = cx + i, y = cy - i, dx = tx + i * CellWidth;
+            if (x < 0 || x >= GlobalMapWidth || y < 0 || y >= GlobalMapHeight) {
+                cache.render(0, textures[0], pixels.data(), Width, Height, dx, ty);
+                continue;
+            }
+            const auto &ci = cells[y * GlobalMapWidth + x];
+            cache.render(ci.earthId, textures[ci.earthId], pixels.data(), Width, Height, dx, ty);
+            if (ci.surfaceId) {
+                cache.render(ci.surfaceId, textures[ci.surfaceId], pixels.data(), Width, Height, dx, ty);
+            }
+        }
+        if (j % 2) {
+            ++cx;
+            tx += cellDiffX;
+        } else {
+            ++cy;
+            tx -= cellDiffX;
+        }
+        ty += cellDiffY;
+    }
+    return pixels;
+}
+
+std::vector<std::uint32_t> pixelsOf(const hojy::scene::GroundLayer &layer) {
+    return std::vector<std::uint32_t>(layer.pixels(), layer.pixels() + layer.width() * layer.height());
+}
+
+void scrolledGroundMatchesFullRender() {
+    Random random {2021};
+    std::vector<std::string> tiles;
+    tiles.push_back(makeTile(random, CellWidth, CellHeight, CellWidth / 2, CellHeight / 2));
+    /* Earth tiles of about a cell, surface tiles that reach well above it */
+    for (int i = 1; i < 24; ++i) {
+        tiles.push_back(makeTile(random, CellWidth + random.next(8), CellHeight + random.next(6),
+                                 CellWidth / 2 + random.next(4), CellHeight / 2 + random.next(4)));
+    }
+    for (int i = 24; i < 32; ++i) {
+        tiles.push_back(makeTile(random, 20 + random.next(40), 30 + random.next(50),
+                                 random.next(30), 25 + random.next(30)));
+    }
+    std::vector<std::string_view> textures(tiles.begin(), tiles.end());
+    std::vector<GlobalCell> cells(GlobalMapWidth * GlobalMapHeight);
+    for (auto &ci: cells) {
+        ci.earthId = std::int16_t(1 + random.next(23));
+        ci.surfaceId = std::int16_t(random.next(4) == 0 ? 24 + random.next(8) : 0);
+    }
+
+    auto palette = makePalette();
+    hojy::util::ThreadPool pool(2);
+    hojy::scene::TileCache cache, freshCache, referenceCache;
+    cache.setPalette(palette);
+    freshCache.setPalette(palette);
+    referenceCache.setPalette(palette);
+    hojy::scene::TileRasterizer rasterizer(&pool), freshRasterizer(&pool);
+    hojy::scene::GroundLayer layer(cache, rasterizer);
+    layer.setMap(&cells, &textures, CellWidth, CellHeight);
+    layer.resize(Width, Height);
+
+    /* Starts by the map corner so that cells outside the map scroll in too */
+    int cameraX = 2, cameraY = 3;
+    int mismatches = 0;
+    for (int step = 0; step < 120; ++step) {
+        if (step % 25 == 24) {
+            cameraX = std::max(cameraX + random.next(21) - 10, 0);
+            cameraY = std::max(cameraY + random.next(21) - 10, 0);
+        } else {
+            cameraX = std::max(cameraX + random.next(3) - 1, 0);
+            cameraY = std::max(cameraY + random.next(3) - 1, 0);
+        }
+        layer.update(cameraX, cameraY);
+
+        hojy::scene::GroundLayer fresh(freshCache, freshRasterizer);
+        fresh.setMap(&cells, &textures, CellWidth, CellHeight);
+        fresh.resize(Width, Height);
+        fresh.update(cameraX, cameraY);
+        const auto expected = drawAllCells(referenceCache, cells, textures, cameraX, cameraY);
+        if (pixelsOf(fresh) != expected || pixelsOf(layer) != expected) { ++mismatches; }
+    }
+    HOJY_CHECK_EQ(mismatches, 0);
+
+    const auto pixels = pixelsOf(layer);
+    HOJY_CHECK_EQ(std::count(pixels.begin(), pixels.end(), 0U) < std::ptrdiff_t(pixels.size() / 2), true);
+}
+
+}
+
+int main() {
+    try {
+        scrolledGroundMatchesFullRender();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include "scene/texture_kernels.hh"
+#include "test_support.hh"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+namespace {
+
+struct Random {
+    std::uint32_t state;
+    std::uint32_t next() {
+        state = state * 1664525U + 1013904223U;
+        return state;
+    }
+};
+
+std::array<std::uint32_t, 256> makeColors(Random &random) {
+    std::array<std::uint32_t, 256> colors{};
+    for (auto &color: colors) {
+        color = random.next();
+    }
+    /* make sure the fully transparent and fully opaque edges are covered */
+    colors[0] = 0x00FFFFFFU;
+    colors[1] = 0xFF000000U;
+    colors[2] = 0xFFFFFFFFU;
+    colors[3] = 0x01FF00FFU;
+    colors[4] = 0xFE00FF00U;
+    return colors;
+}
+
+void kernelsMatchScalarResults() {
+    const auto kernels = hojy::scene::detail::availablePixelKernels();
+    HOJY_CHECK_EQ(kernels.empty(), false);
+    const auto &scalar = *kernels.front();
+    HOJY_CHECK_EQ(&hojy::scene::detail::pixelKernels(), kernels.back());
+    Random random {2024};
+    for (int round = 0; round < 64; ++round) {
+        const auto colors = makeColors(random);
+        for (int count = 0; count <= 37; ++count) {
+            std::vector<std::uint8_t> src(count);
+            for (auto &index: src) {
+                index = std::uint8_t(random.next() >> 24);
+            }
+            std::vector<std::uint32_t> background(count);
+            for (auto &pixel: background) {
+                pixel = random.next();
+            }
+            std::vector<std::uint32_t> expectedExpand(count, 0), expectedBlend = background;
+            scalar.expand(expectedExpand.data(), src.data(), colors.data(), count);
+            scalar.blend(expectedBlend.data(), src.data(), colors.data(), count);
+            for (const auto *kernel: kernels) {
+                std::vector<std::uint32_t> expanded(count, 0), blended = background;
+                kernel->expand(expanded.data(), src.data(), colors.data(), count);
+                kernel->blend(blended.data(), src.data(), colors.data(), count);
+                HOJY_CHECK_EQ(expanded == expectedExpand, true);
+                HOJY_CHECK_EQ(blended == expectedBlend, true);
+            }
+        }
+    }
+}
+
+void scalarBlendKeepsReferenceRounding() {
+    const auto &scalar = *hojy::scene::detail::availablePixelKernels().front();
+    std::array<std::uint32_t, 256> colors{};
+    colors[1] = 0x80FF0000U;
+    colors[2] = 0x00123456U;
+    colors[3] = 0xFF123456U;
+    const std::uint8_t src[3] = {1, 2, 3};
+    std::uint32_t pixels[3] = {0xFF0000FFU, 0x00ABCDEFU, 0x00000000U};
+    scalar.blend(pixels, src, colors.data(), 3);
+    HOJY_CHECK_EQ(pixels[0], 0xFF80007FU);
+    HOJY_CHECK_EQ(pixels[1], 0xFFABCCEFU);
+    HOJY_CHECK_EQ(pixels[2], 0xFF123356U);
+}
+
+}
+
+int main() {
+    try {
+        kernelsMatchScalarResults();
+        scalarBlendKeepsReferenceRounding();
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,133 @@
+#include "scene/colorpalette.hh"
+#include "scene/tilecache.hh"
+#include "test_support.hh"
+
+#include <array>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string makeTile(std::int16_t w, std::int16_t h, std::int16_t ox, std::int16_t oy,
+                     const std::vector<std::vector<std::uint8_t>> &rows) {
+    std::string data;
+    for (auto v: {w, h, ox, oy}) {
+        data.push_back(char(v & 0xFF));
+        data.push_back(char((v >> 8) & 0xFF));
+    }
+    for (const auto &row: rows) {
+        data.push_back(char(row.size()));
+        data.append(row.begin(), row.end());
+    }
+    return data;
+}
+
+hojy::scene::ColorPalette makePalette() {
+    std::array<std::uint32_t, 256> colors{};
+    for (std::uint32_t i = 0; i < colors.size(); ++i) {
+        colors[i] = 0xFF000000U | (i * 0x010101U);
+    }
+    hojy::scene::ColorPalette palette;
+    palette.create(colors);
+    return palette;
+}
+
+void tileBlitsRunsWithOriginAndClipping() {
+    auto palette = makePalette();
+    /* row 0: skip 1, draw 2; row 1: draw 1, skip 1, draw 1 */
+    const auto data = makeTile(3, 2, 1, 0, {{1, 2, 10, 11}, {0, 1, 20, 1, 1, 21}});
+    hojy::scene::TileCache cache;
+    cache.setPalette(palette);
+    std::vector<std::uint32_t> pixels(4 * 3, 0);
+    cache.render(7, data, pixels.data(), 4, 3, 1, 1);
+    HOJY_CHECK_EQ(pixels[4 + 1], 0xFF0A0A0AU);
+    HOJY_CHECK_EQ(pixels[4 + 2], 0xFF0B0B0BU);
+    HOJY_CHECK_EQ(pixels[8 + 0], 0xFF141414U);
+    HOJY_CHECK_EQ(pixels[8 + 1], 0U);
+    HOJY_CHECK_EQ(pixels[8 + 2], 0xFF151515U);
+    HOJY_CHECK_EQ(cache.size(), 1U);
+
+    std::vector<std::uint32_t> clipped(2 * 2, 0);
+    cache.render(7, data, clipped.data(), 2, 2, 2, 0);
+    HOJY_CHECK_EQ(clipped[0], 0U);
+    HOJY_CHECK_EQ(clipped[1], 0U);
+    HOJY_CHECK_EQ(clipped[2], 0U);
+    HOJY_CHECK_EQ(clipped[3], 0xFF141414U);
+
+    clipped.assign(2 * 2, 0);
+    cache.render(7, data, clipped.data(), 2, 2, 0, 0);
+    HOJY_CHECK_EQ(clipped[0], 0xFF0A0A0AU);
+    HOJY_CHECK_EQ(clipped[1], 0xFF0B0B0BU);
+    HOJY_CHECK_EQ(clipped[2], 0U);
+    HOJY_CHECK_EQ(clipped[3], 0xFF151515U);
+    HOJY_CHECK_EQ(cache.size(), 1U);
+}
+
+void clipRectangleLimitsPatchedArea() {
+    auto palette = makePalette();
+    const auto data = makeTile(3, 2, 0, 0, {{0, 3, 1, 2, 3}, {0, 3, 4, 5, 6}});
+    hojy::scene::TileCache cache;
+    cache.setPalette(palette);
+    std::vector<std::uint32_t> pixels(4 * 2, 0);
+    cache.render(1, data, pixels.data(), 4, 1, 1, 2, 1, 0, 0);
+    HOJY_CHECK_EQ(pixels[0], 0U);
+    HOJY_CHECK_EQ(pixels[1], 0U);
+    HOJY_CHECK_EQ(pixels[4 + 0], 0U);
+    HOJY_CHECK_EQ(pixels[4 + 1], 0xFF050505U);
+    HOJY_CHECK_EQ(pixels[4 + 2], 0xFF060606U);
+    HOJY_CHECK_EQ(pixels[4 + 3], 0U);
+
+    pixels.assign(4 * 2, 0);
+    cache.render(1, data, pixels.data(), 4, 3, 0, 1, 2, 0, 0);
+    for (auto pixel: pixels) {
+        HOJY_CHECK_EQ(pixel, 0U);
+    }
+}
+
+void truncatedRowsStopDecoding() {
+    auto palette = makePalette();
+    auto data = makeTile(2, 2, 0, 0, {{0, 2, 1, 2}, {0, 2, 3, 4}});
+    data.resize(data.size() - 2);
+    hojy::scene::TileCache::Tile tile;
+    HOJY_CHECK_EQ(hojy::scene::TileCache::decode(data, palette.colors(), tile), true);
+    HOJY_CHECK_EQ(tile.rowStart.size(), 2U);
+    HOJY_CHECK_EQ(tile.pixels.size(), 2U);
+    HOJY_CHECK_EQ(hojy::scene::TileCache::decode("short", palette.colors(), tile), false);
+}
+
+void leastRecentlyUsedTilesAreEvicted() {
+    auto palette = makePalette();
+    const auto data = makeTile(2, 1, 0, 0, {{0, 2, 1, 2}});
+    hojy::scene::TileCache::Tile tile;
+    hojy::scene::TileCache::decode(data, palette.colors(), tile);
+    hojy::scene::TileCache cache(tile.bytes() * 2);
+    cache.setPalette(palette);
+    HOJY_CHECK_EQ(cache.get(1, data) != nullptr, true);
+    HOJY_CHECK_EQ(cache.get(2, data) != nullptr, true);
+    HOJY_CHECK_EQ(cache.get(1, data) != nullptr, true);
+    HOJY_CHECK_EQ(cache.get(3, data) != nullptr, true);
+    HOJY_CHECK_EQ(cache.size(), 2U);
+    HOJY_CHECK_EQ(cache.usedBytes() <= cache.budget(), true);
+
+    cache.setBudget(0);
+    HOJY_CHECK_EQ(cache.size(), 0U);
+    HOJY_CHECK_EQ(cache.get(4, data) != nullptr, true);
+    HOJY_CHECK_EQ(cache.size(), 0U);
+}
+
+}
+
+int main() {
+    try {
+        tileBlitsRunsWithOriginAndClipping();
+        clipRectangleLimitsPatchedArea();
+        truncatedRowsStopDecoding();
+        leastRecentlyUsedTilesAreEvicted();
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
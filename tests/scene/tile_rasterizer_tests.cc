@@ -0,0 +1,223 @@
+#include "scene/colorpalette.hh"
+#include "scene/texture.hh"
+#include "scene/tilecache.hh"
+#include "scene/tilerasterizer.hh"
+#include "util/threadpool.hh"
+#include "test_support.hh"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr int Width = 96;
+constexpr int Height = 240;
+
+struct Random {
+    std::uint32_t state;
+    std::uint32_t next(std::uint32_t range) {
+        state = state * 1664525U + 1013904223U;
+        return (state >> 8) % range;
+    }
+};
+
+std::string makeRandomTile(Random &random) {
+    auto w = std::int16_t(4 + random.next(40));
+    auto h = std::int16_t(4 + random.next(60));
+    auto ox = std::int16_t(random.next(w));
+    auto oy = std::int16_t(random.next(h));
+    std::string data;
+    for (auto v: {w, h, ox, oy}) {
+        data.push_back(char(v & 0xFF));
+        data.push_back(char((v >> 8) & 0xFF));
+    }
+    for (int y = 0; y < h; ++y) {
+        std::string row;
+        int x = 0;
+        while (x < w) {
+            int skip = int(random.next(4));
+            int count = std::min(int(random.next(8)), w - x - skip);
+            if (count <= 0) { break; }
+            row.push_back(char(skip));
+            row.push_back(char(count));
+            for (int i = 0; i < count; ++i) {
+                row.push_back(char(1 + random.next(253)));
+            }
+            x += skip + count;
+        }
+        data.push_back(char(row.size()));
+        data += row;
+    }
+    return data;
+}
+
+hojy::scene::ColorPalette makePalette() {
+    std::array<std::uint32_t, 256> colors{};
+    for (std::uint32_t i = 0; i < colors.size(); ++i) {
+        colors[i] = 0xFF000000U | (i * 0x010203U);
+    }
+    hojy::scene::ColorPalette palette;
+    palette.create(colors);
+    return palette;
+}
+
+struct Draw {
+    int index;
+    int x, y;
+    bool raw, blending;
+};
+
+std::vector<Draw> makeDraws(Random &random, int tileCount, int count) {
+    std::vector<Draw> draws;
+    for (int i = 0; i < count; ++i) {
+        auto raw = random.next(5) == 0;
+        draws.push_back(Draw {int(random.next(tileCount)), int(random.next(Width + 40)) - 20,
+                              int(random.next(Height + 80)) - 20, raw, raw && random.next(2) == 0});
+    }
+    return draws;
+}
+
+void bandedDrawsMatchSerialRendering() {
+    auto palette = makePalette();
+    std::array<std::uint32_t, 256> maskColors{};
+    for (std::uint32_t i = 0; i < maskColors.size(); ++i) {
+        maskColors[i] = 0x80204060U + i;
+    }
+    Random random {12345};
+    std::vector<std::string> tiles;
+    for (int i = 0; i < 64; ++i) {
+        tiles.push_back(makeRandomTile(random));
+    }
+    const auto draws = makeDraws(random, int(tiles.size()), 600);
+
+    std::vector<std::uint32_t> expected(Width * Height, 0);
+    hojy::scene::TileCache serialCache;
+    serialCache.setPalette(palette);
+    for (const auto &draw: draws) {
+        const auto &data = tiles[draw.index];
+        if (!draw.raw) {
+            serialCache.render(draw.index, data, expected.data(), Width, Height, draw.x, draw.y);
+        } else if (draw.blending) {
+            hojy::scene::Texture::renderRLEBlending(data, maskColors.data(), expected.data(), Width, Height, draw.x, draw.y);
+        } else {
+            hojy::scene::Texture::renderRLE(data, palette.colors(), expected.data(), Width, Height, draw.x, draw.y);
+        }
+    }
+
+    for (std::size_t threads: {0U, 1U, 3U}) {
+        hojy::util::ThreadPool pool(threads);
+        hojy::scene::TileCache cache;
+        cache.setPalette(palette);
+        hojy::scene::TileRasterizer rasterizer(&pool);
+        std::vector<std::uint32_t> pixels(Width * Height, 0);
+        /* second pass replays from a warm cache */
+        for (int pass = 0; pass < 2; ++pass) {
+            pixels.assign(pixels.size(), 0);
+            rasterizer.begin(cache, pixels.data(), Width, Height);
+            for (const auto &draw: draws) {
+                const auto &data = tiles[draw.index];
+                if (!draw.raw) {
+                    rasterizer.draw(draw.index, data, draw.x, draw.y);
+                } else {
+                    rasterizer.drawRLE(data, draw.blending ? maskColors.data() : palette.colors(),
+                                       draw.x, draw.y, draw.blending);
+                }
+            }
+            rasterizer.flush();
+            HOJY_CHECK_EQ(pixels == expected, true);
+        }
+    }
+}
+
+void clippedPassOnlyTouchesClipRectangle() {
+    auto palette = makePalette();
+    Random random {777};
+    std::vector<std::string> tiles;
+    for (int i = 0; i < 16; ++i) {
+        tiles.push_back(makeRandomTile(random));
+    }
+    const auto draws = makeDraws(random, int(tiles.size()), 200);
+    const int clipX = 10, clipY = 37, clipW = 50, clipH = 150;
+
+    std::vector<std::uint32_t> expected(Width * Height, 0);
+    hojy::scene::TileCache serialCache;
+    serialCache.setPalette(palette);
+    for (const auto &draw: draws) {
+        serialCache.render(draw.index, tiles[draw.index], expected.data(), Width,
+                           clipX, clipY, clipW, clipH, draw.x, draw.y);
+    }
+
+    hojy::util::ThreadPool pool(2);
+    hojy::scene::TileCache cache;
+    cache.setPalette(palette);
+    hojy::scene::TileRasterizer rasterizer(&pool);
+    std::vector<std::uint32_t> pixels(Width * Height, 0);
+    rasterizer.begin(cache, pixels.data(), Width, clipX, clipY, clipW, clipH);
+    for (const auto &draw: draws) {
+        rasterizer.draw(draw.index, tiles[draw.index], draw.x, draw.y);
+    }
+    rasterizer.flush();
+    HOJY_CHECK_EQ(pixels == expected, true);
+}
+
+void pinnedCacheKeepsTilesUntilFlush() {
+    auto palette = makePalette();
+    Random random {99};
+    std::vector<std::string> tiles;
+    for (int i = 0; i < 32; ++i) {
+        tiles.push_back(makeRandomTile(random));
+    }
+    hojy::scene::TileCache::Tile tile;
+    hojy::scene::TileCache::decode(tiles[0], palette.colors(), tile);
+    hojy::scene::TileCache cache(tile.bytes());
+    cache.setPalette(palette);
+
+    std::vector<std::uint32_t> expected(Width * Height, 0);
+    hojy::scene::TileCache serialCache;
+    serialCache.setPalette(palette);
+    hojy::util::ThreadPool pool(2);
+    hojy::scene::TileRasterizer rasterizer(&pool);
+    std::vector<std::uint32_t> pixels(Width * Height, 0);
+    rasterizer.begin(cache, pixels.data(), Width, Height);
+    for (int i = 0; i < int(tiles.size()); ++i) {
+        int x = i * 3, y = i * 7;
+        serialCache.render(i, tiles[i], expected.data(), Width, Height, x, y);
+        rasterizer.draw(i, tiles[i], x, y);
+    }
+    HOJY_CHECK_EQ(cache.size(), tiles.size());
+    rasterizer.flush();
+    HOJY_CHECK_EQ(pixels == expected, true);
+    HOJY_CHECK_EQ(cache.usedBytes() <= cache.budget(), true);
+}
+
+void threadPoolRunsEveryIndexOnce() {
+    for (std::size_t threads: {0U, 1U, 4U}) {
+        hojy::util::ThreadPool pool(threads);
+        std::vector<std::atomic<int>> hits(1000);
+        pool.parallelFor(hits.size(), [&hits](std::size_t index) { ++hits[index]; });
+        for (auto &hit: hits) {
+            HOJY_CHECK_EQ(hit.load(), 1);
+        }
+        auto result = pool.submit([]() { return 42; });
+        HOJY_CHECK_EQ(result.get(), 42);
+    }
+}
+
+}
+
+int main() {
+    try {
+        bandedDrawsMatchSerialRendering();
+        clippedPassOnlyTouchesClipRectangle();
+        pinnedCacheKeepsTilesUntilFlush();
+        threadPoolRunsEveryIndexOnce();
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -10,27 +10,26 @@
 
 namespace {
 
-hojy::content::GrpData::DataSet makeTextures(
+hojy::content::GrpArchive makeTextures(
     std::uint16_t cellWidth, std::uint16_t cellHeight,
     std::uint16_t offsetX, std::uint16_t offsetY) {
     std::uint16_t values[] = {cellWidth, cellHeight, offsetX, offsetY};
-    hojy::content::GrpData::DataSet textures(1);
-    textures[0].resize(sizeof(values));
-    std::memcpy(textures[0].data(), values, sizeof(values));
-    return textures;
+    std::string header(sizeof(values), '\0');
+    std::memcpy(header.data(), values, sizeof(values));
+    return hojy::content::GrpArchive::fromEntries({header});
 }
 
 void testInvalidTextureHeaderLeavesPreviousResultUntouched() {
     hojy::scene::detail::WarfieldTextureLoad result;
-    result.textures = {"keep"};
+    result.textures = hojy::content::GrpArchive::fromEntries({"keep"});
     result.cellWidth = 48;
     result.cellHeight = 24;
 
     const auto loaded = hojy::scene::detail::loadWarfieldTextures(
         "WDX007", "WMP007",
         [](const std::string &, const std::string &,
-           hojy::content::GrpData::DataSet &textures) {
-            textures = {std::string(7, '\0')};
+           hojy::content::GrpArchive &textures) {
+            textures = hojy::content::GrpArchive::fromEntries({std::string(7, '\0')});
             return true;
         },
         result);
@@ -49,7 +48,7 @@ void testSpecificTextureFallbackCommitsOnlyValidatedData() {
     const auto loaded = hojy::scene::detail::loadWarfieldTextures(
         "WDX007", "WMP007",
         [&calls](const std::string &idx, const std::string &grp,
-                 hojy::content::GrpData::DataSet &textures) {
+                 hojy::content::GrpArchive &textures) {
             calls.emplace_back(idx, grp);
             if (idx == "WDX") { return false; }
             textures = makeTextures(48, 24, 12, 6);
@@ -70,14 +69,14 @@ void testSpecificTextureFallbackCommitsOnlyValidatedData() {
 
 void testZeroCellDimensionsAreRejectedWithoutMutation() {
     hojy::scene::detail::WarfieldTextureLoad result;
-    result.textures = {"keep"};
+    result.textures = hojy::content::GrpArchive::fromEntries({"keep"});
     result.cellWidth = 48;
     result.cellHeight = 24;
 
     const auto loaded = hojy::scene::detail::loadWarfieldTextures(
         "WDX007", "WMP007",
         [](const std::string &, const std::string &,
-           hojy::content::GrpData::DataSet &textures) {
+           hojy::content::GrpArchive &textures) {
             textures = makeTextures(0, 0, 0, 0);
             return true;
         },
@@ -100,7 +99,7 @@ void testSpecificTextureCacheOnlyMarksCurrentMap() {
 }
 
 void testTextureLookupRejectsInvalidIndices() {
-    const hojy::content::GrpData::DataSet textures = {"earth", "building"};
+    const auto textures = hojy::content::GrpArchive::fromEntries({"earth", "building"});
     HOJY_CHECK_EQ(hojy::scene::detail::warfieldTextureAt(textures, 0),
                   std::string("earth"));
     HOJY_CHECK_EQ(hojy::scene::detail::warfieldTextureAt(textures, -1),
@@ -0,0 +1,170 @@
+#include "battle/random.hh"
+#include "content/factors.hh"
+#include "sim/simulator.hh"
+#include "util/threadpool.hh"
+#include "world/bag.hh"
+#include "world/savedata.hh"
+#include "world/strings.hh"
+#include "test_support.hh"
+
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace hojy::content {
+Factors gFactors{};
+}
+
+namespace hojy::world::state {
+SaveData gSaveData{};
+Bag gBag{};
+Strings gStrings{};
+
+bool Bag::remove(std::int16_t, std::int16_t) {
+    return false;
+}
+}
+
+namespace {
+
+constexpr int Width = 16;
+constexpr int Height = 16;
+
+template<typename T, typename Container>
+void loadRecords(Container &container, const T *records, std::size_t count) {
+    const auto *bytes = reinterpret_cast<const char *>(records);
+    HOJY_CHECK_EQ(container.deserialize(
+        std::string(bytes, bytes + sizeof(T) * count)), true);
+}
+
+void prepareData() {
+    hojy::world::state::ItemData items[1]{};
+    items[0].skillId = -1;
+    loadRecords(hojy::world::state::gSaveData.itemInfo, items, 1);
+
+    hojy::world::state::SkillData skills[2]{};
+    skills[1].id = 1;
+    skills[1].reqMp = 1;
+    for (int level = 0; level < 10; ++level) {
+        skills[1].damage[level] = std::int16_t(100 + level * 50);
+        skills[1].selRange[level] = 1;
+    }
+    loadRecords(hojy::world::state::gSaveData.skillInfo, skills, 2);
+}
+
+hojy::sim::Combatant makeCombatant(std::uint8_t side, std::int16_t id, std::int16_t x, std::int16_t y,
+                                   std::int16_t attack, std::int16_t hp) {
+    hojy::world::state::CharacterData info{};
+    info.id = id;
+    info.equip[0] = info.equip[1] = -1;
+    for (auto &item: info.item) { item = -1; }
+    info.hp = info.maxHp = hp;
+    info.mp = info.maxMp = 100;
+    info.stamina = 100;
+    info.attack = attack;
+    info.defence = 20;
+    info.speed = 40;
+    info.level = 5;
+    info.skillId[0] = 1;
+    info.skillLevel[0] = 500;
+    return hojy::sim::Combatant {side, id, x, y, info};
+}
+
+hojy::sim::Scenario makeScenario() {
+    hojy::sim::Scenario scenario;
+    scenario.width = Width;
+    scenario.height = Height;
+    scenario.blocked.assign(Width * Height, 0);
+    scenario.combatants.push_back(makeCombatant(0, 0, 3, 7, 120, 300));
+    scenario.combatants.push_back(makeCombatant(0, 1, 3, 9, 120, 300));
+    scenario.combatants.push_back(makeCombatant(1, 2, 12, 8, 20, 60));
+    return scenario;
+}
+
+void checkSameOutcome(const hojy::sim::Outcome &left, const hojy::sim::Outcome &right) {
+    HOJY_CHECK_EQ(left.won, right.won);
+    HOJY_CHECK_EQ(left.finished, right.finished);
+    HOJY_CHECK_EQ(left.rounds, right.rounds);
+    HOJY_CHECK_EQ(left.turns, right.turns);
+    for (int side = 0; side < 2; ++side) {
+        HOJY_CHECK_EQ(left.survivors[side], right.survivors[side]);
+        HOJY_CHECK_EQ(left.damage[side], right.damage[side]);
+        HOJY_CHECK_EQ(left.hits[side] == right.hits[side], true);
+    }
+}
+
+void strongPartyWinsAndCountsDamage() {
+    const auto scenario = makeScenario();
+    hojy::sim::Simulator simulator(scenario, 7);
+    const auto outcome = simulator.run();
+    HOJY_CHECK_EQ(outcome.finished, true);
+    HOJY_CHECK_EQ(outcome.won, true);
+    HOJY_CHECK_EQ(outcome.survivors[1], 0U);
+    HOJY_CHECK_EQ(outcome.rounds > 0, true);
+    HOJY_CHECK_EQ(outcome.turns >= outcome.rounds, true);
+    HOJY_CHECK_EQ(outcome.hits[0].empty(), false);
+    std::int64_t total = 0;
+    for (auto hit: outcome.hits[0]) { total += hit; }
+    HOJY_CHECK_EQ(total, outcome.damage[0]);
+}
+
+void seededBattlesRepeatOnAnyThread() {
+    const auto scenario = makeScenario();
+    constexpr std::size_t Count = 64;
+    std::vector<hojy::sim::Outcome> serial;
+    for (std::size_t i = 0; i < Count; ++i) {
+        serial.push_back(hojy::sim::Simulator(scenario, 1000 + i).run());
+    }
+    hojy::util::ThreadPool pool(3);
+    std::vector<hojy::sim::Outcome> parallel(Count);
+    pool.parallelFor(Count, [&](std::size_t index) {
+        parallel[index] = hojy::sim::Simulator(scenario, 1000 + index).run();
+    });
+    for (std::size_t i = 0; i < Count; ++i) {
+        checkSameOutcome(serial[i], parallel[i]);
+    }
+}
+
+void walledOffSidesTimeOut() {
+    auto scenario = makeScenario();
+    for (int y = 0; y < Height; ++y) {
+        scenario.blocked[y * Width + 8] = 1;
+    }
+    hojy::sim::Simulator simulator(scenario, 3, 20);
+    const auto outcome = simulator.run();
+    HOJY_CHECK_EQ(outcome.finished, false);
+    HOJY_CHECK_EQ(outcome.won, false);
+    HOJY_CHECK_EQ(outcome.rounds, 20U);
+    HOJY_CHECK_EQ(outcome.survivors[0], 2U);
+    HOJY_CHECK_EQ(outcome.survivors[1], 1U);
+}
+
+void seededRandomFollowsOriginalBounds() {
+    hojy::battle::SeededRandom left(42), right(42);
+    HOJY_CHECK_EQ(left.next(1), 0);
+    HOJY_CHECK_EQ(left.next(30001), 0);
+    for (int i = 0; i < 100; ++i) {
+        const auto value = left.next(100);
+        HOJY_CHECK_EQ(value >= 0 && value < 100, true);
+        HOJY_CHECK_EQ(right.next(100), value);
+        const auto ranged = left.next(-5, 5);
+        HOJY_CHECK_EQ(ranged >= -5 && ranged <= 5, true);
+        HOJY_CHECK_EQ(right.next(-5, 5), ranged);
+    }
+}
+
+}
+
+int main() {
+    try {
+        prepareData();
+        seededRandomFollowsOriginalBounds();
+        strongPartyWinsAndCountsDamage();
+        seededBattlesRepeatOnAnyThread();
+        walledOffSidesTimeOut();
+    } catch (const std::exception &exception) {
+        std::cerr << exception.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
@@ -97,6 +97,38 @@ class MakeDataTests(unittest.TestCase):
             self.assertEqual(rerun.returncode, 0, rerun.stderr)
             self.assertEqual((target / "keep.txt").read_text(encoding="utf-8"), "keep")
 
+    def test_generates_content_pack_on_request(self) -> None:
+        with tempfile.TemporaryDirectory(prefix="hojy-makedata-pack-") as temporary:
+            root = Path(temporary)
+            source = root / "original"
+            target = root / "target"
+            font = root / "font.otf"
+            source.mkdir()
+
+            for name in REQUIRED_DATA_FILES:
+                (source / name).write_bytes(name.encode("ascii"))
+            write_grp(source, "TALK.IDX", "TALK.GRP", [bytes(~ch & 0xff for ch in b"AB")])
+            write_grp(source, "KDEF.IDX", "KDEF.GRP", [struct.pack("<hh", 1, -1)])
+            write_grp(source, "MMAP.IDX", "MMAP.GRP", [struct.pack("<HHHH", 36, 18, 0, 0)])
+            cells = bytes(480 * 480 * 2)
+            for name in ("EARTH.002", "SURFACE.002", "BUILDING.002"):
+                (source / name).write_bytes(cells)
+            (source / "MMAP.COL").write_bytes(bytes(768))
+            (source / "ENDCOL.COL").write_bytes(bytes(768))
+            write_grp(source, "SDX000", "SMP000", [b"A"])
+            write_grp(source, "WDX000", "WMP000", [b"C"])
+            font.write_bytes(b"font")
+
+            result = subprocess.run(
+                [str(MAKEDATA), "--pack", str(source), str(target), str(font)],
+                capture_output=True,
+                text=True,
+                check=False,
+            )
+            self.assertEqual(result.returncode, 0, result.stderr)
+            self.assertEqual((target / "data" / "CONTENT.PAK").read_bytes()[:8], b"HOJYPACK")
+            self.assertIn("content_pack = true", (target / "config.toml").read_text(encoding="utf-8"))
+
     def test_rejects_corrupt_map_before_creating_target(self) -> None:
         with tempfile.TemporaryDirectory(prefix="hojy-makedata-bad-") as temporary:
             root = Path(temporary)
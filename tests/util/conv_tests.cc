@@ -0,0 +1,254 @@
+#include "util/conv.hh"
+#include "test_support.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace {
+
+using hojy::util::big5Conv;
+using hojy::util::trad2SimpConv;
+
+void big5DecodesThroughRows() {
+    HOJY_CHECK_EQ(big5Conv.toUnicode("A\xa4\xa4\xb0\xea"), std::wstring(L"A中國"));
+    /* The terminator ends the text, unmapped pairs become two spaces */
+    HOJY_CHECK_EQ(big5Conv.toUnicode(std::string("\xa4\xa4\0\xa4\xa4", 5)), std::wstring(L"中"));
+    HOJY_CHECK_EQ(big5Conv.toUnicode("\x81\x40"), std::wstring(L"  "));
+    HOJY_CHECK_EQ(big5Conv.toUnicode("\xa4"), std::wstring());
+}
+
+void big5EncodesFromUnicode() {
+    HOJY_CHECK_EQ(big5Conv.fromUnicode(L"A中國"), std::string("A\xa4\xa4\xb0\xea"));
+    HOJY_CHECK_EQ(big5Conv.fromUnicode(L"\x20ac"), std::string("  "));
+}
+
+void simplifiedMatchesPhrasesAtTheEnd() {
+    HOJY_CHECK_EQ(trad2SimpConv.convert(L"國"), std::wstring(L"国"));
+    HOJY_CHECK_EQ(trad2SimpConv.convert(L"乾淨"), std::wstring(L"干净"));
+    /* A phrase that maps to itself keeps its characters */
+    HOJY_CHECK_EQ(trad2SimpConv.convert(L"乾坤"), std::wstring(L"乾坤"));
+    HOJY_CHECK_EQ(trad2SimpConv.convert(L"說一目瞭然"), std::wstring(L"说一目了然"));
+    /* Phrases followed by more text go character by character */
+    HOJY_CHECK_EQ(trad2SimpConv.convert(L"一目瞭然的話"), std::wstring(L"一目瞭然的话"));
+    HOJY_CHECK_EQ(trad2SimpConv.convert(L"abc"), std::wstring(L"abc"));
+}
+
+/* The map-based converters the generated tables replaced, built from the same
+ * sources, so that the output can be compared byte for byte */
+class ReferenceConv {
+    struct Node {
+        std::vector<std::uint32_t> word;
+        std::map<std::uint32_t, Node> nodes;
+    };
+
+public:
+    ReferenceConv() {
+        const hojy::util::Conv::Pair big5[] =
+#include "util/big5table.inl"
+        big5_.assign(std::begin(big5), std::end(big5));
+        auto pairLess = [](const auto &a, const auto &b) {
+            return a.from == b.from ? a.to < b.to : a.from < b.from;
+        };
+        for (const auto &p: big5_) {
+            big5Rev_.push_back({p.to, p.from});
+        }
+        std::sort(big5_.begin(), big5_.end(), pairLess);
+        std::sort(big5Rev_.begin(), big5Rev_.end(), pairLess);
+        chars_ = {
+#include "util/tschars.inl"
+        };
+        words_ = {
+#include "util/tswords.inl"
+        };
+        for (auto &p: words_) {
+            auto *node = &root_;
+            for (auto c: p.first) {
+                node = &node->nodes[c];
+            }
+            node->word = p.second;
+        }
+    }
+
+    std::wstring toUnicode(const std::string &str) const {
+        std::wstring result;
+        for (std::size_t i = 0; i < str.size();) {
+            auto c = std::uint8_t(str[i]);
+            if (c == 0) { break; }
+            if (c < 0x80) {
+                result += wchar_t(c);
+                ++i;
+                continue;
+            }
+            if (i + 1 >= str.size()) { break; }
+            const auto *p = find(big5_, (std::uint32_t(c) << 8) | std::uint8_t(str[i + 1]));
+            if (!p) {
+                result.append(L"  ");
+            } else {
+                result += wchar_t(p->to);
+            }
+            i += 2;
+        }
+        return result;
+    }
+
+    std::string fromUnicode(const std::wstring &wstr) const {
+        std::string result;
+        for (auto ch: wstr) {
+            if (std::uint32_t(ch) < 0x80) {
+                result += char(ch);
+                continue;
+            }
+            const auto *p = find(big5Rev_, std::uint32_t(ch));
+            if (!p) {
+                result.append("  ");
+            } else {
+                result += char(p->to >> 8);
+                result += char(p->to & 0xFF);
+            }
+        }
+        return result;
+    }
+
+    std::wstring convert(const std::wstring &str) const {
+        std::wstring res;
+        std::size_t sz = str.size();
+        for (std::size_t i = 0; i < sz;) {
+            {
+                const auto *node = &root_;
+                std::size_t j = i;
+                bool notfound = false;
+                while (j < sz) {
+                    auto ite = node->nodes.find(str[j++]);
+                    if (ite == node->nodes.end()) {
+                        notfound = true;
+                        break;
+                    }
+                    node = &ite->second;
+                }
+                if (!notfound && !node->word.empty()) {
+                    res.insert(res.end(), node->word.begin(), node->word.end());
+                    i = j;
+                    continue;
+                }
+            }
+            auto ite = chars_.find(str[i]);
+            if (ite == chars_.end()) res += str[i];
+            else res += wchar_t(ite->second);
+            ++i;
+        }
+        return res;
+    }
+
+    std::vector<hojy::util::Conv::Pair> big5_, big5Rev_;
+    std::unordered_map<std::uint32_t, std::uint32_t> chars_;
+    std::vector<std::pair<std::vector<std::uint32_t>, std::vector<std::uint32_t>>> words_;
+
+private:
+    static const hojy::util::Conv::Pair *find(const std::vector<hojy::util::Conv::Pair> &table, std::uint32_t from) {
+        auto ite = std::lower_bound(table.begin(), table.end(), from, [](const auto &p, std::uint32_t v) {
+            return p.from < v;
+        });
+        return ite == table.end() || ite->from != from ? nullptr : &*ite;
+    }
+
+    Node root_;
+};
+
+bool sameAsReference(const ReferenceConv &reference, const std::string &big5) {
+    const auto text = big5Conv.toUnicode(big5);
+    return text == reference.toUnicode(big5) && trad2SimpConv.convert(text) == reference.convert(text);
+}
+
+void generatedTablesMatchReference(const ReferenceConv &reference) {
+    std::size_t mismatches = 0;
+    for (const auto &p: reference.big5_) {
+        const std::string code {char(p.from >> 8), char(p.from & 0xFF)};
+        const std::wstring ch(1, wchar_t(p.to));
+        if (!sameAsReference(reference, code) || big5Conv.fromUnicode(ch) != reference.fromUnicode(ch)) {
+            ++mismatches;
+        }
+    }
+    auto check = [&](const std::wstring &text) {
+        if (trad2SimpConv.convert(text) != reference.convert(text)) { ++mismatches; }
+    };
+    for (const auto &p: reference.chars_) {
+        check(std::wstring(1, wchar_t(p.first)));
+    }
+    std::wstring previous;
+    for (const auto &p: reference.words_) {
+        const std::wstring phrase(p.first.begin(), p.first.end());
+        check(phrase);
+        check(L"說" + phrase);
+        check(phrase + L"。");
+        check(phrase + phrase);
+        check(previous + phrase);
+        check(phrase.substr(0, phrase.size() - 1));
+        previous = phrase;
+    }
+    HOJY_CHECK_EQ(mismatches, 0U);
+}
+
+std::string readFile(const std::string &filename) {
+    std::ifstream file(filename, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+/* Every talk line, and every NUL-terminated Big5 run of the starting save and
+ * the war field table, which covers all the names */
+void gameTextMatchesReference(const ReferenceConv &reference, const std::string &dataDir) {
+    const auto index = readFile(dataDir + "/TALK.IDX");
+    auto talks = readFile(dataDir + "/TALK.GRP");
+    HOJY_CHECK_EQ(index.empty() || talks.empty(), false);
+    for (auto &c: talks) {
+        if (c) { c = static_cast<char>(~static_cast<unsigned char>(c)); }
+    }
+    std::size_t lines = 0, mismatches = 0;
+    std::uint32_t start = 0;
+    for (std::size_t i = 0; i + 4 <= index.size(); i += 4) {
+        std::uint32_t end = 0;
+        std::copy_n(index.data() + i, 4, reinterpret_cast<char *>(&end));
+        if (end < start || end > talks.size()) { break; }
+        if (!sameAsReference(reference, talks.substr(start, end - start))) { ++mismatches; }
+        ++lines;
+        start = end;
+    }
+    for (const auto *name: {"/RANGER.GRP", "/WAR.STA"}) {
+        const auto data = readFile(dataDir + name);
+        for (std::size_t i = 0; i < data.size();) {
+            const auto end = std::min(data.find('\0', i), data.size());
+            if (end > i) {
+                if (!sameAsReference(reference, data.substr(i, end - i))) { ++mismatches; }
+                ++lines;
+            }
+            i = end + 1;
+        }
+    }
+    std::cout << "compared " << lines << " lines of game text\n";
+    HOJY_CHECK_EQ(mismatches, 0U);
+}
+
+}
+
+/* Pass the game's data directory to also compare its text */
+int main(int argc, char *argv[]) {
+    try {
+        big5DecodesThroughRows();
+        big5EncodesFromUnicode();
+        simplifiedMatchesPhrasesAtTheEnd();
+        const ReferenceConv reference;
+        generatedTablesMatchReference(reference);
+        if (argc > 1) { gameTextMatchesReference(reference, argv[1]); }
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}
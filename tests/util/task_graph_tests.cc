@@ -0,0 +1,82 @@
+#include "util/taskgraph.hh"
+#include "util/threadpool.hh"
+#include "test_support.hh"
+
+#include <atomic>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+
+void jobsStartAfterTheirDependencies(std::size_t threads) {
+    std::mutex mutex;
+    std::vector<std::string> order;
+    auto record = [&](const char *name) {
+        return [&mutex, &order, name]() {
+            std::scoped_lock lk(mutex);
+            order.emplace_back(name);
+            return true;
+        };
+    };
+    hojy::util::TaskGraph graph;
+    const auto a = graph.add("a", record("a"));
+    const auto b = graph.add("b", record("b"));
+    const auto c = graph.add("c", record("c"), {a, b});
+    graph.add("d", record("d"), {c});
+    graph.add("e", record("e"));
+
+    hojy::util::ThreadPool pool(threads);
+    HOJY_CHECK_EQ(graph.run(pool), true);
+    HOJY_CHECK_EQ(order.size(), 5U);
+    auto position = [&order](const std::string &name) {
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            if (order[i] == name) { return i; }
+        }
+        return order.size();
+    };
+    HOJY_CHECK_EQ(position("c") > position("a"), true);
+    HOJY_CHECK_EQ(position("c") > position("b"), true);
+    HOJY_CHECK_EQ(position("d") > position("c"), true);
+    HOJY_CHECK_EQ(graph.timings().size(), 5U);
+    for (const auto &timing: graph.timings()) {
+        HOJY_CHECK_EQ(timing.ok, true);
+        HOJY_CHECK_EQ(timing.duration >= 0., true);
+    }
+}
+
+void failureStopsDependentJobs(std::size_t threads) {
+    std::atomic<int> ran {0};
+    hojy::util::TaskGraph graph;
+    const auto broken = graph.add("broken", []() { return false; });
+    const auto throwing = graph.add("throwing", []() -> bool { throw std::runtime_error("bad data"); });
+    graph.add("after broken", [&ran]() { ++ran; return true; }, {broken});
+    graph.add("after throwing", [&ran]() { ++ran; return true; }, {throwing});
+
+    hojy::util::ThreadPool pool(threads);
+    HOJY_CHECK_EQ(graph.run(pool), false);
+    HOJY_CHECK_EQ(ran.load(), 0);
+}
+
+void dependenciesMustBeAddedFirst() {
+    hojy::util::TaskGraph graph;
+    HOJY_CHECK_THROWS(std::invalid_argument, graph.add("early", []() { return true; }, {0}));
+}
+
+}
+
+int main() {
+    try {
+        for (std::size_t threads: {0U, 3U}) {
+            jobsStartAfterTheirDependencies(threads);
+            failureStopsDependentJobs(threads);
+        }
+        dependenciesMustBeAddedFirst();
+    } catch (const std::exception &error) {
+        std::cerr << error.what() << '\n';
+        return 1;
+    }
+    return 0;
+}